@@ -0,0 +1,124 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_AGENTINVENTORY
+#define ODC_CORE_AGENTINVENTORY
+
+#include <dds/Tools.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace odc::core {
+
+/// Cached agents of a DDS session and their slots.
+/// The content is replaced by a full listing of the agents, or confirmed by a cheaper slot count.
+/// Agents known to be gone are dropped right away, the next refresh lists the agents again.
+class AgentInventory
+{
+  public:
+    using Agents = std::map<uint64_t, dds::tools_api::SAgentInfoResponseData>; ///< by agent ID
+    /// Called with the IDs of the agents that appeared and disappeared
+    using ChangeCallback = std::function<void(const std::vector<uint64_t>& added, const std::vector<uint64_t>& removed)>;
+
+    void setChangeCallback(ChangeCallback callback) { mChangeCallback = std::move(callback); }
+
+    /// @brief Replace the content with a full listing of the agents
+    void update(const std::vector<dds::tools_api::SAgentInfoResponseData>& agents, const dds::tools_api::SAgentCountResponseData& slots)
+    {
+        Agents updated;
+        std::vector<uint64_t> added;
+        for (const auto& agent : agents) {
+            updated.emplace(agent.m_agentID, agent);
+            if (mAgents.count(agent.m_agentID) == 0) {
+                added.push_back(agent.m_agentID);
+            }
+        }
+        std::vector<uint64_t> removed;
+        for (const auto& [id, agent] : mAgents) {
+            if (updated.count(id) == 0) {
+                removed.push_back(id);
+            }
+        }
+        mAgents = std::move(updated);
+        mSlots = slots;
+        mUpdated = std::chrono::steady_clock::now();
+        mValid = true;
+        notify(added, removed);
+    }
+
+    /// @brief Confirm the content if none of the slot counts changed.
+    /// An agent replaced by one with the same number of slots keeps the active count, but not the idle and executing ones.
+    /// @return false if the agents have to be listed
+    bool confirm(const dds::tools_api::SAgentCountResponseData& slots)
+    {
+        if (slots.m_activeSlotsCount != mSlots.m_activeSlotsCount
+            || slots.m_idleSlotsCount != mSlots.m_idleSlotsCount
+            || slots.m_executingSlotsCount != mSlots.m_executingSlotsCount) {
+            return false;
+        }
+        mSlots = slots;
+        mUpdated = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    /// @brief Drop agents known to be gone, e.g. after shutting them down
+    void remove(const std::unordered_set<uint64_t>& agentIDs, uint32_t activeSlots)
+    {
+        std::vector<uint64_t> removed;
+        for (const auto id : agentIDs) {
+            if (mAgents.erase(id) > 0) {
+                removed.push_back(id);
+            }
+        }
+        mSlots.m_activeSlotsCount = activeSlots;
+        mValid = false;
+        notify({}, removed);
+    }
+
+    /// @brief Force the next refresh to list all agents, e.g. when an agent may be gone. Can be called from any thread.
+    void invalidate() { mValid = false; }
+
+    bool valid() const { return mValid; }
+    /// @brief Time since the content was last listed or confirmed
+    std::chrono::steady_clock::duration age() const { return std::chrono::steady_clock::now() - mUpdated; }
+
+    const Agents& agents() const { return mAgents; }
+    const dds::tools_api::SAgentCountResponseData& slots() const { return mSlots; }
+    /// @brief Number of slots of the agent, 0 if unknown
+    uint32_t slots(uint64_t agentID) const
+    {
+        auto it = mAgents.find(agentID);
+        return it == mAgents.end() ? 0 : it->second.m_nSlots;
+    }
+
+  private:
+    void notify(const std::vector<uint64_t>& added, const std::vector<uint64_t>& removed)
+    {
+        if (mChangeCallback && (!added.empty() || !removed.empty())) {
+            mChangeCallback(added, removed);
+        }
+    }
+
+    Agents mAgents;
+    dds::tools_api::SAgentCountResponseData mSlots;
+    std::chrono::steady_clock::time_point mUpdated;
+    std::atomic<bool> mValid{ false };
+    ChangeCallback mChangeCallback;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_AGENTINVENTORY */
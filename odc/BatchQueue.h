@@ -0,0 +1,61 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_BATCHQUEUE
+#define ODC_CORE_BATCHQUEUE
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace odc::core {
+
+/// Queue with lock-free pushes from many threads, drained in batches by one consumer
+template<typename T>
+class BatchQueue
+{
+  public:
+    BatchQueue() = default;
+    BatchQueue(const BatchQueue&) = delete;
+    BatchQueue& operator=(const BatchQueue&) = delete;
+    ~BatchQueue() { take(); }
+
+    void push(T value)
+    {
+        auto node = new Node{ std::move(value), mHead.load(std::memory_order_relaxed) };
+        while (!mHead.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    /// @brief Take all queued items, in the order they were pushed
+    std::vector<T> take()
+    {
+        Node* node = mHead.exchange(nullptr, std::memory_order_acquire);
+        std::vector<T> batch;
+        while (node != nullptr) {
+            batch.push_back(std::move(node->value));
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        std::reverse(batch.begin(), batch.end());
+        return batch;
+    }
+
+  private:
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+    std::atomic<Node*> mHead{ nullptr };
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_BATCHQUEUE */
@@ -27,9 +27,24 @@ class CliController : public odc::core::CliControllerHelper<CliController>
     void setHistoryDir(const std::string& dir) { mCtrl.setHistoryDir(dir); }
     void setZoneCfgs(const std::vector<std::string>& zonesStr) { mCtrl.setZoneCfgs(zonesStr); }
     void setRMS(const std::string& rms) { mCtrl.setRMS(rms); }
+    void setDirectChannelHost(const std::string& host) { mCtrl.setDirectChannelHost(host); }
+    void setPipelinedTransitions(bool pipelined) { mCtrl.setPipelinedTransitions(pipelined); }
+    void setSubmitWindow(size_t window) { mCtrl.setSubmitWindow(window); }
+    void setStreamingActivation(bool streaming) { mCtrl.setStreamingActivation(streaming); }
+    void setDifferentialUpdate(bool differential) { mCtrl.setDifferentialUpdate(differential); }
+    void setFailFast(bool failFast) { mCtrl.setFailFast(failFast); }
+    void setStragglerPolicy(double fraction, double latencyFactor) { mCtrl.setStragglerPolicy(fraction, latencyFactor); }
+    void setAdaptiveTimeout(double factor) { mCtrl.setAdaptiveTimeout(factor); }
+    void setTopologyStoreDir(const std::string& dir) { mCtrl.setTopologyStoreDir(dir); }
+    void setTopoScriptCache(size_t ttl, size_t maxBytes, const std::vector<std::string>& envVars, const std::vector<std::string>& inputFiles)
+    {
+        mCtrl.setTopoScriptCache(ttl, maxBytes, envVars, inputFiles);
+    }
 
     void registerResourcePlugins(const core::PluginManager::PluginMap& pluginMap) { mCtrl.registerResourcePlugins(pluginMap); }
+    void setPersistentPlugins(bool persistent) { mCtrl.setPersistentPlugins(persistent); }
     void restore(const std::string& restoreId, const std::string& restoreDir) { mCtrl.restore(restoreId, restoreDir); }
+    void setSessionPoolSize(size_t size) { mCtrl.setSessionPoolSize(size); }
 
     std::string requestInitialize(   const core::CommonParams& common, const core::InitializeParams& params)    { return generalReply(mCtrl.execInitialize(common, params)); }
     std::string requestSubmit(       const core::CommonParams& common, const core::SubmitParams& params)        { return generalReply(mCtrl.execSubmit(common, params)); }
@@ -109,6 +124,9 @@ class CliController : public odc::core::CliControllerHelper<CliController>
                << "; status: " << ((p.mDDSSessionStatus == core::DDSSessionStatus::running) ? "RUNNING" : "STOPPED")
                << "; state: " << core::GetAggregatedStateName(p.mAggregatedState) << "\n";
         }
+        const auto& cache = result.mTopoScriptCache;
+        ss << "  Topology script cache: hits: " << cache.mHits << "; misses: " << cache.mMisses << "; evictions: " << cache.mEvictions
+           << "; entries: " << cache.mEntries << "; bytes: " << cache.mBytes << "\n";
         ss << "  Execution time: " << result.mExecTime << " msec\n";
         return ss.str();
     }
@@ -173,7 +173,8 @@ class CliHelper
             ("topo", value<std::string>(&params.mTopoFile)->implicit_value(""), "Topology filepath")
             ("content", value<std::string>(&params.mTopoContent)->implicit_value(""), "Topology content")
             ("script", value<std::string>(&params.mTopoScript)->implicit_value(""), "Topology script")
-            ("extract-topo-resources", bool_switch(&params.mExtractTopoResources)->default_value(false), "Extract required resources from the topology file (plugin & resources fields are ignored)");
+            ("extract-topo-resources", bool_switch(&params.mExtractTopoResources)->default_value(false), "Extract required resources from the topology file (plugin & resources fields are ignored)")
+            ("reuse-agents", bool_switch(&params.mReuseAgents)->default_value(false), "On a repeated Run, keep the DDS session and its agents if they satisfy the new topology");
     }
 
     static void addOptions(boost::program_options::options_description& options, DeviceParams& params)
@@ -6,7 +6,9 @@
  *                  copied verbatim in the file "LICENSE"                       *
  ********************************************************************************/
 
+#include <odc/BatchQueue.h>
 #include <odc/Controller.h>
+#include <odc/DDSRequest.h>
 #include <odc/DDSSubmit.h>
 #include <odc/Error.h>
 #include <odc/Logger.h>
@@ -17,19 +19,159 @@
 #include <dds/TopoCreator.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_future.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
 
 #include <algorithm>
 #include <cctype> // std::tolower
 #include <filesystem>
+#include <optional>
+#include <utility>
 
 using namespace odc;
 using namespace odc::core;
 using namespace std;
 namespace bfs = boost::filesystem;
 
+namespace {
+
+const vector<TopoTransition> kConfigureTransitions{ TopoTransition::InitDevice, TopoTransition::CompleteInit, TopoTransition::Bind, TopoTransition::Connect, TopoTransition::InitTask };
+const vector<TopoTransition> kResetTransitions{ TopoTransition::ResetTask, TopoTransition::ResetDevice };
+
+string describeSelection(const string& path) { return toString("path ", quoted(path)); }
+string describeSelection(const unordered_set<DDSTask::Id>& tasks) { return toString(tasks.size(), " task(s)"); }
+string describeTransitions(const vector<TopoTransition>& transitions)
+{
+    stringstream ss;
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        ss << (i == 0 ? "" : "->") << transitions.at(i);
+    }
+    return ss.str();
+}
+string describeFailures(const vector<string>& failures) { return toString("failed and cannot be ignored: ", boost::algorithm::join(failures, "; ")); }
+
+// agents are listed again after this time even if the slot count did not change
+constexpr chrono::seconds kAgentListingMaxAge{ 60 };
+// adaptive deadlines of state change steps are not shorter than this, to tolerate jitter of fast steps
+constexpr chrono::milliseconds kMinAdaptiveTimeout{ 1000 };
+
+void logAgentChanges(Session& session)
+{
+    session.mAgentInventory.setChangeCallback([partitionID = session.mPartitionID](const vector<uint64_t>& added, const vector<uint64_t>& removed) {
+        OLOG(info, partitionID, 0) << "DDS agents changed: " << added.size() << " appeared, " << removed.size() << " disappeared";
+    });
+}
+
+// Log the messages DDS sent along with a reply
+template<typename Reply>
+void logDDSMessages(const CommonParams& common, const Reply& reply, const string& errorPrefix)
+{
+    for (const auto& msg : reply.messages) {
+        OLOG(info, common) << "DDS Server reports: " << msg;
+    }
+    for (const auto& msg : reply.errors) {
+        OLOG(error, common) << errorPrefix << msg;
+    }
+}
+
+// interval at which activation responses are applied to the session while waiting for the activation
+constexpr chrono::milliseconds kActivationBatchInterval{ 100 };
+// interval at which the active slot count is polled while waiting for the submitted agents
+constexpr chrono::milliseconds kSlotPollInterval{ 100 };
+// interval at which the agent groups are checked during streaming activation
+constexpr chrono::milliseconds kStreamingPollInterval{ 500 };
+
+// Step of a request chain, calls its argument with its result
+using AsyncStep = function<void(function<void(bool)>)>;
+
+// Run the steps one after the other until one of them fails, next is called with the result
+void runSteps(vector<AsyncStep> steps, function<void(bool)> next, size_t index = 0)
+{
+    if (index == steps.size()) {
+        next(true);
+        return;
+    }
+    AsyncStep step = steps.at(index);
+    step([steps = std::move(steps), next = std::move(next), index](bool success) {
+        if (!success) {
+            next(false);
+            return;
+        }
+        runSteps(steps, next, index + 1);
+    });
+}
+
+} // namespace
+
 RequestResult Controller::execInitialize(const CommonParams& common, const InitializeParams& params)
+{
+    return asyncExecInitialize(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execSubmit(const CommonParams& common, const SubmitParams& params)
+{
+    return asyncExecSubmit(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execActivate(const CommonParams& common, const ActivateParams& params)
+{
+    return asyncExecActivate(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execRun(const CommonParams& common, const RunParams& params)
+{
+    return asyncExecRun(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execUpdate(const CommonParams& common, const UpdateParams& params)
+{
+    return asyncExecUpdate(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execShutdown(const CommonParams& common)
+{
+    return asyncExecShutdown(common, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execSetProperties(const CommonParams& common, const SetPropertiesParams& params)
+{
+    return asyncExecSetProperties(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execGetState(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecGetState(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execConfigure(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecConfigure(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execStart(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecStart(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execStop(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecStop(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execReset(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecReset(common, params, boost::asio::use_future).get();
+}
+
+RequestResult Controller::execTerminate(const CommonParams& common, const DeviceParams& params)
+{
+    return asyncExecTerminate(common, params, boost::asio::use_future).get();
+}
+
+void Controller::initiateInitialize(const CommonParams& common, const InitializeParams& params, function<void(RequestResult)> done)
 {
     Error error;
     auto& partition = acquirePartition(common);
@@ -38,7 +180,7 @@ RequestResult Controller::execInitialize(const CommonParams& common, const Initi
         // Create new DDS session
         // Shutdown DDS session if it is running already
         shutdownDDSSession(common, partition, error)
-            && createDDSSession(common, *(partition.mSession), error);
+            && createDDSSession(common, partition, error);
     } else {
         // Attach to an existing DDS session
         bool success = attachToDDSSession(common, *(partition.mSession), error, params.mDDSSessionID);
@@ -53,22 +195,21 @@ RequestResult Controller::execInitialize(const CommonParams& common, const Initi
         }
     }
     updateRestore();
-    return createRequestResult(common, *(partition.mSession), error, "Initialize done", TopologyState(), {});
+    done(createRequestResult(common, *(partition.mSession), error, "Initialize done", TopologyState(), {}));
 }
 
-RequestResult Controller::execSubmit(const CommonParams& common, const SubmitParams& params)
+void Controller::initiateSubmit(const CommonParams& common, const SubmitParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, false);
     auto& partition = acquirePartition(common);
 
-    auto hosts = submit(common, *(partition.mSession), error, params.mPlugin, params.mResources, false);
-
-    return createRequestResult(common, *(partition.mSession), error, "Submit done", TopologyState(), hosts);
+    asyncSubmit(request->mCommon, *(partition.mSession), request->mError, params.mPlugin, params.mResources, false, false, request->mHosts, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Submit done", TopologyState(), request->mHosts));
+    });
 }
 
-unordered_set<string> Controller::submit(const CommonParams& common, Session& session, Error& error, const string& plugin, const string& res, bool extractResources)
+void Controller::asyncSubmit(const CommonParams& common, Session& session, Error& error, const string& plugin, const string& res, bool extractResources, bool streamActivation, unordered_set<string>& hosts, function<void(bool)> next)
 {
-    unordered_set<string> hosts;
     if (extractResources) {
         OLOG(info, common) << "Attempting submission with resources extracted from topology.";
     } else {
@@ -77,99 +218,120 @@ unordered_set<string> Controller::submit(const CommonParams& common, Session& se
 
     if (!session.mDDSSession.IsRunning()) {
         fillAndLogError(common, error, ErrorCode::DDSSubmitAgentsFailed, "DDS session is not running. Use Init or Run to start the session.");
-        return hosts;
+        next(false);
+        return;
     }
 
-    // Get DDS submit parameters from ODC resource plugin
-    vector<DDSSubmitParams> ddsParams;
+    // Get DDS submit parameters from ODC resource plugin, kept along the chain
+    auto ddsParams = make_shared<vector<DDSSubmitParams>>();
     if (!error.mCode) {
         try {
             if (extractResources) {
-                ddsParams = mSubmit.makeParams(mRMS, mZoneCfgs, session.mAgentGroupInfo);
+                *ddsParams = mSubmit.makeParams(mRMS, mZoneCfgs, session.mAgentGroupInfo);
             } else {
-                ddsParams = mSubmit.makeParams(plugin, res, common, session.mZoneInfo, session.mNinfo, requestTimeout(common, "submit::MakeParams"));
+                *ddsParams = mSubmit.makeParams(plugin, res, common, session.mZoneInfo, session.mNinfo, requestTimeout(common, "submit::MakeParams"));
             }
         } catch (Error& e) {
             error = e;
             OLOG(error, common) << "Resource plugin failed: " << e;
-            return hosts;
+            next(false);
+            return;
         } catch (exception& e) {
             fillAndLogError(common, error, ErrorCode::ResourcePluginFailed, toString("Resource plugin failed: ", e.what()));
-            return hosts;
+            next(false);
+            return;
         }
     }
 
-    size_t expectedNumSlots = session.mTotalSlots;
+    // list the launched agents, attempt a recovery if the submission failed
+    auto listAgents = [this, &common, &session, &error, &hosts, ddsParams, next]() {
+        if (session.mDDSSession.IsRunning()) {
+            map<string, uint32_t> agentCounts; // agent count sorted by their group name
 
-    if (!error.mCode) {
-        OLOG(info, common) << "Preparing to submit " << ddsParams.size() << " configurations:";
-        for (unsigned int i = 0; i < ddsParams.size(); ++i) {
-            OLOG(info, common) << "  [" << i + 1 << "/" << ddsParams.size() << "]: " << ddsParams.at(i);
-        }
+            for (const auto& p : *ddsParams) {
+                agentCounts[p.mAgentGroup] = 0;
+            }
 
-        for (unsigned int i = 0; i < ddsParams.size(); ++i) {
-            OLOG(info, common) << "Submitting [" << i + 1 << "/" << ddsParams.size() << "]: " << ddsParams.at(i);
-            if (submitDDSAgents(common, session, error, ddsParams.at(i))) {
-                expectedNumSlots += ddsParams.at(i).mNumAgents * ddsParams.at(i).mNumSlots;
-            } else {
-                OLOG(error, common) << "Submission failed";
-                break;
+            try {
+                const auto& inventory = getAgentInventory(common, session);
+                OLOG(info, common) << "Launched " << inventory.agents().size() << " DDS agents with " << inventory.slots().m_activeSlotsCount << " active slots:";
+                hosts.reserve(inventory.agents().size());
+                for (const auto& [agentID, ai] : inventory.agents()) {
+                    agentCounts[ai.m_groupName]++;
+                    hosts.emplace(ai.m_host);
+                    OLOG(info, common)
+                        << "  Agent ID: " << ai.m_agentID
+                        // << ", pid: " << ai.m_agentPid
+                        << "; host: " << ai.m_host
+                        << "; path: " << ai.m_DDSPath
+                        << "; group: " << ai.m_groupName
+                        // << "; index: " << ai.m_index
+                        // << "; username: " << ai.m_username
+                        << "; startup time: " << ai.m_startUpTime.count() << " ms"
+                        << "; slots: " << ai.m_nSlots;
+                        // << " (idle: " << ai.m_nIdleSlots
+                        // << ", executing: " << ai.m_nExecutingSlots << ").";
+                }
+                OLOG(info, common) << "Launched " << agentCounts.size() << " DDS agent groups:";
+                for (const auto& [groupName, count] : agentCounts) {
+                    OLOG(info, common) << "  " << std::quoted(groupName) << ": " << count << " agents";
+                }
+            } catch (Error& e) {
+                error = e;
+                OLOG(error, common) << "Failed getting agent info: " << e;
+            } catch (const exception& e) {
+                fillAndLogError(common, error, ErrorCode::DDSCommanderInfoFailed, toString("Failed getting agent info: ", e.what()));
             }
-        }
-        if (!error.mCode) {
-            OLOG(info, common) << "Waiting for " << expectedNumSlots << " slots...";
-            if (waitForNumActiveSlots(common, session, error, expectedNumSlots)) {
-                session.mTotalSlots = expectedNumSlots;
-                OLOG(info, common) << "Done waiting for " << expectedNumSlots << " slots.";
+
+            if (error.mCode) {
+                attemptSubmitRecovery(common, session, error, *ddsParams, agentCounts);
             }
         }
+        next(!error.mCode);
+    };
+
+    if (error.mCode) {
+        listAgents();
+        return;
     }
 
-    if (session.mDDSSession.IsRunning()) {
-        map<string, uint32_t> agentCounts; // agent count sorted by their group name
+    OLOG(info, common) << "Preparing to submit " << ddsParams->size() << " configurations:";
+    for (unsigned int i = 0; i < ddsParams->size(); ++i) {
+        OLOG(info, common) << "  [" << i + 1 << "/" << ddsParams->size() << "]: " << ddsParams->at(i);
+    }
 
-        for (const auto& p : ddsParams) {
-            agentCounts[p.mAgentGroup] = 0;
+    asyncSubmitDDSAgents(common, session, error, *ddsParams, [this, &common, &session, &error, ddsParams, streamActivation, listAgents](bool submitted, size_t submittedSlots) {
+        const size_t expectedNumSlots = session.mTotalSlots + submittedSlots;
+        if (submittedSlots == 0) {
+            listAgents();
+            return;
         }
-
-        try {
-            auto agentInfo = getAgentInfo(common, session);
-            OLOG(info, common) << "Launched " << agentInfo.size() << " DDS agents:";
-            hosts.reserve(agentInfo.size());
-            for (const auto& ai : agentInfo) {
-                agentCounts[ai.m_groupName]++;
-                session.mAgentSlots[ai.m_agentID] = ai.m_nSlots;
-                hosts.emplace(ai.m_host);
-                OLOG(info, common)
-                    << "  Agent ID: " << ai.m_agentID
-                    // << ", pid: " << ai.m_agentPid
-                    << "; host: " << ai.m_host
-                    << "; path: " << ai.m_DDSPath
-                    << "; group: " << ai.m_groupName
-                    // << "; index: " << ai.m_index
-                    // << "; username: " << ai.m_username
-                    << "; startup time: " << ai.m_startUpTime.count() << " ms"
-                    << "; slots: " << ai.m_nSlots;
-                    // << " (idle: " << ai.m_nIdleSlots
-                    // << ", executing: " << ai.m_nExecutingSlots << ").";
+        // wait also for the agents of successful submissions, so that the recovery sees them
+        OLOG(info, common) << "Waiting for " << expectedNumSlots << " slots...";
+        auto waitError = make_shared<Error>();
+        auto slotsReady = [&common, &session, &error, submitted, expectedNumSlots, waitError, listAgents](bool ready) {
+            if (ready) {
+                if (submitted) {
+                    session.mTotalSlots = expectedNumSlots;
+                }
+                OLOG(info, common) << "Done waiting for " << expectedNumSlots << " slots.";
+            } else if (!error.mCode) {
+                error = *waitError;
             }
-            OLOG(info, common) << "Launched " << agentCounts.size() << " DDS agent groups:";
-            for (const auto& [groupName, count] : agentCounts) {
-                OLOG(info, common) << "  " << std::quoted(groupName) << ": " << count << " agents";
+            listAgents();
+        };
+        if (streamActivation && submitted) {
+            asyncWaitForNumActiveSlotsStreaming(common, session, *waitError, *ddsParams, expectedNumSlots, slotsReady);
+        } else {
+            try {
+                asyncWaitForNumActiveSlots(common, session, *waitError, expectedNumSlots, chrono::steady_clock::now() + requestTimeout(common, "waitForNumActiveSlots"), slotsReady);
+            } catch (Error& e) {
+                *waitError = e;
+                OLOG(error, common) << "Error while waiting for DDS slots: " << e;
+                slotsReady(false);
             }
-        } catch (Error& e) {
-            error = e;
-            OLOG(error, common) << "Failed getting agent info: " << e;
-        } catch (const exception& e) {
-            fillAndLogError(common, error, ErrorCode::DDSCommanderInfoFailed, toString("Failed getting agent info: ", e.what()));
-        }
-
-        if (error.mCode) {
-            attemptSubmitRecovery(common, session, error, ddsParams, agentCounts);
         }
-
-    }
-    return hosts;
+    });
 }
 
 void Controller::attemptSubmitRecovery(const CommonParams& common,
@@ -248,133 +410,313 @@ void Controller::updateTopology(const CommonParams& common, Session& session)
         }
     }
 
-    string name("topo_" + session.mPartitionID + "_reduced.xml");
-    const bfs::path tmpPath{ bfs::temp_directory_path() / bfs::unique_path() };
-    bfs::create_directories(tmpPath);
-    const bfs::path filepath{ tmpPath / name };
+    const bfs::path filepath{ bfs::temp_directory_path() / bfs::unique_path("topo_%%%%-%%%%-%%%%-%%%%_reduced.xml") };
     creator.save(filepath.string());
 
-    session.mTopoFilePath = filepath.string();
+    replaceTopoFilePath(common, session, mTopoStore.addFile(common.mPartitionID, filepath.string()));
 
     OLOG(info, common) << "Saved updated topology file as " << session.mTopoFilePath;
 }
 
-RequestResult Controller::execActivate(const CommonParams& common, const ActivateParams& params)
+void Controller::replaceTopoFilePath(const CommonParams& common, Session& session, string filePath)
 {
-    Error error;
+    // the new file is referenced already, identical content stays in the store
+    const string replaced = std::exchange(session.mTopoFilePath, std::move(filePath));
+    if (!replaced.empty()) {
+        mTopoStore.release(common.mPartitionID, replaced);
+    }
+}
+
+string Controller::partialTopology(const CommonParams& common, const Session& session, const set<string>& agentGroups)
+{
+    using namespace dds::topology_api;
+
+    CTopoCreator creator;
+    creator.getMainGroup()->initFromXML(session.mTopoFilePath);
+
+    auto collections = creator.getMainGroup()->getElementsByType(CTopoBase::EType::COLLECTION);
+    for (auto& col : collections) {
+        auto it = session.mCollections.find(col->getName());
+        if (it == session.mCollections.end() || agentGroups.count(it->second.agentGroup) > 0) {
+            continue;
+        }
+        // leave out the groups with collections of agent groups that are not ready yet
+        auto parent = col->getParent();
+        if (parent->getType() == CTopoBase::EType::GROUP && parent->getName() != "main") {
+            static_cast<CTopoGroup*>(parent)->setN(0);
+        } else {
+            throw runtime_error(toString("Collection ", quoted(col->getName()), " of agent group ", quoted(it->second.agentGroup), " is not in a group, it cannot be activated separately"));
+        }
+    }
+
+    const bfs::path filepath{ bfs::temp_directory_path() / bfs::unique_path("topo_%%%%-%%%%-%%%%-%%%%_partial.xml") };
+    creator.save(filepath.string());
+
+    string storedPath = mTopoStore.addFile(common.mPartitionID, filepath.string());
+    OLOG(info, common) << "Saved partial topology file for agent groups " << boost::algorithm::join(agentGroups, ", ") << " as " << storedPath;
+    return storedPath;
+}
+
+void Controller::initiateActivate(const CommonParams& common, const ActivateParams& params, function<void(RequestResult)> done)
+{
+    auto request = make_shared<PendingRequest>(common, false);
+    const CommonParams& cparams = request->mCommon;
+    Error& error = request->mError;
     auto& partition = acquirePartition(common);
 
     if (!partition.mSession->mDDSSession.IsRunning()) {
-        fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, "DDS session is not running. Use Init or Run to start the session.");
+        fillAndLogError(cparams, error, ErrorCode::DDSActivateTopologyFailed, "DDS session is not running. Use Init or Run to start the session.");
     }
 
     try {
-        partition.mSession->mTopoFilePath = topoFilepath(common, params.mTopoFile, params.mTopoContent, params.mTopoScript);
-        extractRequirements(common, *(partition.mSession));
+        replaceTopoFilePath(cparams, *(partition.mSession), topoFilepath(cparams, params.mTopoFile, params.mTopoContent, params.mTopoScript));
+        loadRequirements(cparams, *(partition.mSession));
     } catch (Error& e) {
         error = e;
-        OLOG(error, common) << "Activate failed: " << e;
+        OLOG(error, cparams) << "Activate failed: " << e;
     } catch (exception& e) {
-        fillAndLogFatalError(common, error, ErrorCode::TopologyFailed, e.what());
+        fillAndLogFatalError(cparams, error, ErrorCode::TopologyFailed, e.what());
     }
 
-    if (!error.mCode) {
-        activate(common, partition, error);
+    auto finish = [this, request, &partition, done](bool) {
+        TopologyState topologyState(request->mError.mCode ? AggregatedState::Undefined : AggregatedState::Idle);
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Activate done", std::move(topologyState), {}));
+    };
+    if (error.mCode) {
+        finish(false);
+        return;
     }
-
-    TopologyState topologyState(error.mCode ? AggregatedState::Undefined : AggregatedState::Idle);
-    return createRequestResult(common, *(partition.mSession), error, "Activate done", std::move(topologyState), {});
+    asyncActivate(cparams, partition, error, finish);
 }
 
-void Controller::activate(const CommonParams& common, Partition& partition, Error& error)
+void Controller::asyncActivate(const CommonParams& common, Partition& partition, Error& error, function<void(bool)> next)
 {
-    activateDDSTopology(common, *(partition.mSession), error, dds::tools_api::STopologyRequest::request_t::EUpdateType::ACTIVATE)
-        && createDDSTopology(common, *(partition.mSession), error)
-        && createTopology(common, partition, error)
-        && waitForState(common, partition, error, "", DeviceState::Idle);
+    using EUpdateType = dds::tools_api::STopologyRequest::request_t::EUpdateType;
+    // tasks of some agent groups might be already running, add the remaining ones
+    const EUpdateType updateType = partition.mSession->mPartiallyActivated ? EUpdateType::UPDATE : EUpdateType::ACTIVATE;
+    partition.mSession->mPartiallyActivated = false;
+
+    runSteps({
+        [this, &common, &partition, &error, updateType](function<void(bool)> then) { asyncActivateDDSTopology(common, *(partition.mSession), error, updateType, then); },
+        [this, &common, &partition, &error](function<void(bool)> then) { then(createDDSTopology(common, *(partition.mSession), error) && createTopology(common, partition, error)); },
+        [this, &common, &partition, &error](function<void(bool)> then) { asyncWaitForState(common, partition, error, string(), DeviceState::Idle, then); }
+    }, std::move(next));
 }
 
-RequestResult Controller::execRun(const CommonParams& common, const RunParams& params)
+void Controller::initiateRun(const CommonParams& common, const RunParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, false);
     auto& partition = acquirePartition(common);
-    std::unordered_set<std::string> hosts;
 
-    if (!partition.mSession->mRunAttempted) {
+    auto finish = [this, request, &partition, done]() {
+        TopologyState topologyState(request->mError.mCode ? AggregatedState::Undefined : AggregatedState::Idle);
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Run done", std::move(topologyState), request->mHosts));
+    };
+
+    auto runNewSession = [this, request, &partition, params, finish]() {
+        const CommonParams& common = request->mCommon;
+        Error& error = request->mError;
         partition.mSession->mRunAttempted = true;
 
         // Create new DDS session
         // Shutdown DDS session if it is running already
         shutdownDDSSession(common, partition, error)
-            && createDDSSession(common, *(partition.mSession), error);
+            && createDDSSession(common, partition, error);
 
         updateRestore();
 
-        if (!error.mCode) {
-            try {
-                partition.mSession->mTopoFilePath = topoFilepath(common, params.mTopoFile, params.mTopoContent, params.mTopoScript);
-                extractRequirements(common, *(partition.mSession));
-            } catch (Error& e) {
-                error = e;
-                OLOG(error, common) << "Topology creation failed: " << e;
-            } catch (exception& e) {
-                fillAndLogFatalError(common, error, ErrorCode::TopologyFailed, toString("Incorrect topology provided: ", e.what()));
-            }
+        if (error.mCode) {
+            finish();
+            return;
+        }
 
-            if (!error.mCode) {
-                if (!partition.mSession->mDDSSession.IsRunning()) {
-                    fillAndLogError(common, error, ErrorCode::DDSSubmitAgentsFailed, "DDS session is not running. Use Init or Run to start the session.");
-                }
+        try {
+            replaceTopoFilePath(common, *(partition.mSession), topoFilepath(common, params.mTopoFile, params.mTopoContent, params.mTopoScript));
+            loadRequirements(common, *(partition.mSession));
+        } catch (Error& e) {
+            error = e;
+            OLOG(error, common) << "Topology creation failed: " << e;
+        } catch (exception& e) {
+            fillAndLogFatalError(common, error, ErrorCode::TopologyFailed, toString("Incorrect topology provided: ", e.what()));
+        }
 
-                hosts = submit(common, *(partition.mSession), error, params.mPlugin, params.mResources, params.mExtractTopoResources);
+        if (error.mCode) {
+            finish();
+            return;
+        }
 
-                if (!partition.mSession->mDDSSession.IsRunning()) {
-                    fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, "DDS session is not running. Use Init or Run to start the session.");
-                }
+        if (!partition.mSession->mDDSSession.IsRunning()) {
+            fillAndLogError(common, error, ErrorCode::DDSSubmitAgentsFailed, "DDS session is not running. Use Init or Run to start the session.");
+        }
 
-                if (!error.mCode) {
-                    activate(common, partition, error);
-                }
+        asyncSubmit(common, *(partition.mSession), error, params.mPlugin, params.mResources, params.mExtractTopoResources, mStreamingActivation, request->mHosts, [this, &common, &error, &partition, finish](bool) {
+            if (!partition.mSession->mDDSSession.IsRunning()) {
+                fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, "DDS session is not running. Use Init or Run to start the session.");
             }
-        }
+
+            if (error.mCode) {
+                finish();
+                return;
+            }
+            asyncActivate(common, partition, error, [finish](bool) { finish(); });
+        });
+    };
+
+    if (partition.mSession->mRunAttempted && params.mReuseAgents) {
+        asyncReuseAgents(request->mCommon, partition, request->mError, params, request->mHosts, [finish, runNewSession](bool reused) {
+            if (reused) {
+                // done on the agents of the previous run
+                finish();
+            } else {
+                runNewSession();
+            }
+        });
+    } else if (!partition.mSession->mRunAttempted) {
+        runNewSession();
     } else {
-        error = Error(MakeErrorCode(ErrorCode::RequestNotSupported), "Repeated Run request is not supported. Shutdown this partition to retry.");
+        request->mError = Error(MakeErrorCode(ErrorCode::RequestNotSupported), "Repeated Run request is not supported. Shutdown this partition to retry, or use reuseAgents.");
+        finish();
+    }
+}
+
+void Controller::asyncReuseAgents(const CommonParams& common, Partition& partition, Error& error, const RunParams& params, unordered_set<string>& hosts, function<void(bool)> next)
+{
+    using EUpdateType = dds::tools_api::STopologyRequest::request_t::EUpdateType;
+    Session& session = *(partition.mSession);
+
+    if (!session.mDDSSession.IsRunning()) {
+        OLOG(info, common) << "DDS session is not running, agents can not be reused. Starting a new session.";
+        next(false);
+        return;
     }
 
-    TopologyState topologyState(error.mCode ? AggregatedState::Undefined : AggregatedState::Idle);
-    return createRequestResult(common, *(partition.mSession), error, "Run done", std::move(topologyState), hosts);
+    auto reuse = [this, &common, &partition, &session, &error, params, &hosts, next]() {
+        resetTopologyState(common, partition);
+        session.clearDetails();
+        session.mPartiallyActivated = false;
+
+        try {
+            replaceTopoFilePath(common, session, topoFilepath(common, params.mTopoFile, params.mTopoContent, params.mTopoScript));
+            loadRequirements(common, session);
+        } catch (Error& e) {
+            error = e;
+            OLOG(error, common) << "Topology creation failed: " << e;
+            next(true);
+            return;
+        } catch (exception& e) {
+            fillAndLogFatalError(common, error, ErrorCode::TopologyFailed, toString("Incorrect topology provided: ", e.what()));
+            next(true);
+            return;
+        }
+
+        try {
+            getAgentInventory(common, session);
+        } catch (exception& e) {
+            OLOG(warning, common) << "Failed getting agent info (" << e.what() << "). Starting a new session.";
+            next(false);
+            return;
+        }
+        const auto& inventory = session.mAgentInventory;
+        if (!agentsSatisfyRequirements(common, session, inventory)) {
+            OLOG(info, common) << "Agents of the previous run do not satisfy the topology requirements. Starting a new session.";
+            next(false);
+            return;
+        }
+
+        OLOG(info, common) << "Reusing " << inventory.agents().size() << " DDS agents (" << inventory.slots().m_activeSlotsCount << " slots) of the previous run";
+        session.mTotalSlots = inventory.slots().m_activeSlotsCount;
+        for (const auto& [agentID, ai] : inventory.agents()) {
+            hosts.emplace(ai.m_host);
+        }
+
+        asyncActivate(common, partition, error, [next](bool) { next(true); });
+    };
+
+    // stop the tasks of the previous topology, the agents stay
+    partition.mTopology.reset();
+    if (session.mTopoFilePath.empty()) {
+        reuse();
+        return;
+    }
+    OLOG(info, common) << "Stopping tasks of topology " << quoted(session.mTopoFilePath) << " to reuse the agents";
+    auto stopError = make_shared<Error>();
+    asyncActivateDDSTopology(common, session, *stopError, EUpdateType::STOP, [&common, stopError, reuse, next](bool stopped) {
+        if (!stopped) {
+            OLOG(warning, common) << "Failed to stop the previous topology (" << *stopError << "). Starting a new session.";
+            next(false);
+            return;
+        }
+        reuse();
+    });
 }
 
-RequestResult Controller::execUpdate(const CommonParams& common, const UpdateParams& params)
+bool Controller::agentsSatisfyRequirements(const CommonParams& common, Session& session, const AgentInventory& inventory)
 {
-    Error error;
-    auto& partition = acquirePartition(common);
+    const auto taskIt = session.getParsedTopology(session.mTopoFilePath)->getRuntimeTaskIterator();
+    const size_t numTasks = std::distance(taskIt.first, taskIt.second);
+    if (inventory.slots().m_activeSlotsCount < numTasks) {
+        OLOG(info, common) << "Topology requires " << numTasks << " slots, " << inventory.slots().m_activeSlotsCount << " are active";
+        return false;
+    }
 
-    TopologyState topologyState;
+    for (const auto& [groupName, agi] : session.mAgentGroupInfo) {
+        if (groupName.empty()) {
+            continue;
+        }
+        // an agent of the group runs one collection
+        int32_t numAgents = 0;
+        for (const auto& [agentID, ai] : inventory.agents()) {
+            if (ai.m_groupName == groupName && static_cast<int32_t>(ai.m_nSlots) >= agi.numSlots) {
+                ++numAgents;
+            }
+        }
+        if (numAgents < agi.numAgents) {
+            OLOG(info, common) << "Agent group " << quoted(groupName) << " requires " << agi.numAgents << " agents with " << agi.numSlots << " slots, " << numAgents << " are available";
+            return false;
+        }
+    }
+    return true;
+}
+
+void Controller::initiateUpdate(const CommonParams& common, const UpdateParams& params, function<void(RequestResult)> done)
+{
+    using EUpdateType = dds::tools_api::STopologyRequest::request_t::EUpdateType;
+    auto request = make_shared<PendingRequest>(common, false);
+    const CommonParams& cparams = request->mCommon;
+    Error& error = request->mError;
+    TopologyState& topologyState = request->mTopologyState;
+    auto& partition = acquirePartition(common);
 
     try {
-        partition.mSession->mTopoFilePath = topoFilepath(common, params.mTopoFile, params.mTopoContent, params.mTopoScript);
-        extractRequirements(common, *(partition.mSession));
+        replaceTopoFilePath(cparams, *(partition.mSession), topoFilepath(cparams, params.mTopoFile, params.mTopoContent, params.mTopoScript));
+        loadRequirements(cparams, *(partition.mSession));
     } catch (Error& e) {
         error = e;
-        OLOG(error, common) << "Topology creation failed: " << e;
+        OLOG(error, cparams) << "Topology creation failed: " << e;
     } catch (exception& e) {
-        fillAndLogFatalError(common, error, ErrorCode::TopologyFailed, toString("Incorrect topology provided: ", e.what()));
+        fillAndLogFatalError(cparams, error, ErrorCode::TopologyFailed, toString("Incorrect topology provided: ", e.what()));
     }
 
-    if (!error.mCode) {
-        changeStateReset(common, partition, error, "", topologyState)
-            && resetTopology(partition)
-            && activateDDSTopology(common, *(partition.mSession), error, dds::tools_api::STopologyRequest::request_t::EUpdateType::UPDATE)
-            && createDDSTopology(common, *(partition.mSession), error)
-            && createTopology(common, partition, error)
-            && waitForState(common, partition, error, "", DeviceState::Idle)
-            && changeStateConfigure(common, partition, error, "", topologyState);
+    auto finish = [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Update done", std::move(request->mTopologyState), {}));
+    };
+
+    if (error.mCode) {
+        finish(false);
+    } else if (mDifferentialUpdate && partition.mTopology != nullptr && partition.mSession->mDDSTopo != nullptr) {
+        asyncUpdateTopologyDiff(cparams, partition, error, topologyState, finish);
+    } else {
+        runSteps({
+            [this, &cparams, &partition, &error, &topologyState](function<void(bool)> then) { asyncChangeStateReset(cparams, partition, error, "", topologyState, then); },
+            [this, &cparams, &partition, &error](function<void(bool)> then) { resetTopology(partition); asyncActivateDDSTopology(cparams, *(partition.mSession), error, EUpdateType::UPDATE, then); },
+            [this, &cparams, &partition, &error](function<void(bool)> then) { then(createDDSTopology(cparams, *(partition.mSession), error) && createTopology(cparams, partition, error)); },
+            [this, &cparams, &partition, &error](function<void(bool)> then) { asyncWaitForState(cparams, partition, error, string(), DeviceState::Idle, then); },
+            [this, &cparams, &partition, &error, &topologyState](function<void(bool)> then) { asyncChangeStateConfigure(cparams, partition, error, "", topologyState, then); }
+        }, finish);
     }
-    return createRequestResult(common, *(partition.mSession), error, "Update done", std::move(topologyState), {});
 }
 
-RequestResult Controller::execShutdown(const CommonParams& common)
+void Controller::initiateShutdown(const CommonParams& common, function<void(RequestResult)> done)
 {
     Error error;
 
@@ -389,84 +731,83 @@ RequestResult Controller::execShutdown(const CommonParams& common)
     removePartition(common);
     updateRestore();
 
-    return createRequestResult(common, ddsSessionId, error, "Shutdown done", TopologyState(), {});
+    done(createRequestResult(common, ddsSessionId, error, "Shutdown done", TopologyState(), {}));
 }
 
-RequestResult Controller::execSetProperties(const CommonParams& common, const SetPropertiesParams& params)
+void Controller::initiateGetState(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
     Error error;
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState;
-    setProperties(common, partition, error, params.mPath, params.mProperties, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "SetProperties done", std::move(topologyState), {});
+    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
+    getState(common, partition, error, params.mPath, topologyState);
+    done(createRequestResult(common, *(partition.mSession), error, "GetState done", std::move(topologyState), {}));
 }
 
-RequestResult Controller::execGetState(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateSetProperties(const CommonParams& common, const SetPropertiesParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, false);
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    getState(common, partition, error, params.mPath, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "GetState done", std::move(topologyState), {});
+    asyncSetProperties(request->mCommon, partition, request->mError, params.mPath, params.mProperties, request->mTopologyState, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "SetProperties done", std::move(request->mTopologyState), {}));
+    });
 }
 
-RequestResult Controller::execConfigure(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateConfigure(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, params.mDetailed);
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    changeStateConfigure(common, partition, error, params.mPath, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "Configure done", std::move(topologyState), {});
+    asyncChangeStateConfigure(request->mCommon, partition, request->mError, params.mPath, request->mTopologyState, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Configure done", std::move(request->mTopologyState), {}));
+    });
 }
 
-RequestResult Controller::execStart(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateStart(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, params.mDetailed);
     auto& partition = acquirePartition(common);
 
     // update run number
     partition.mSession->mLastRunNr.store(common.mRunNr);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    changeState(common, partition, error, params.mPath, TopoTransition::Run, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "Start done", std::move(topologyState), {});
+    asyncChangeState(request->mCommon, partition, request->mError, params.mPath, TopoTransition::Run, request->mTopologyState, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Start done", std::move(request->mTopologyState), {}));
+    });
 }
 
-RequestResult Controller::execStop(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateStop(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, params.mDetailed);
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    changeState(common, partition, error, params.mPath, TopoTransition::Stop, topologyState);
-
-    // reset the run number, which is valid only for the running state
-    partition.mSession->mLastRunNr.store(0);
+    asyncChangeState(request->mCommon, partition, request->mError, params.mPath, TopoTransition::Stop, request->mTopologyState, [this, request, &partition, done](bool) {
+        // reset the run number, which is valid only for the running state
+        partition.mSession->mLastRunNr.store(0);
 
-    return createRequestResult(common, *(partition.mSession), error, "Stop done", std::move(topologyState), {});
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Stop done", std::move(request->mTopologyState), {}));
+    });
 }
 
-RequestResult Controller::execReset(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateReset(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, params.mDetailed);
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    changeStateReset(common, partition, error, params.mPath, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "Reset done", std::move(topologyState), {});
+    asyncChangeStateReset(request->mCommon, partition, request->mError, params.mPath, request->mTopologyState, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Reset done", std::move(request->mTopologyState), {}));
+    });
 }
 
-RequestResult Controller::execTerminate(const CommonParams& common, const DeviceParams& params)
+void Controller::initiateTerminate(const CommonParams& common, const DeviceParams& params, function<void(RequestResult)> done)
 {
-    Error error;
+    auto request = make_shared<PendingRequest>(common, params.mDetailed);
     auto& partition = acquirePartition(common);
 
-    TopologyState topologyState(AggregatedState::Undefined, params.mDetailed ? std::make_optional<DetailedState>() : std::nullopt);
-    changeState(common, partition, error, params.mPath, TopoTransition::End, topologyState);
-    return createRequestResult(common, *(partition.mSession), error, "Terminate done", std::move(topologyState), {});
+    asyncChangeState(request->mCommon, partition, request->mError, params.mPath, TopoTransition::End, request->mTopologyState, [this, request, &partition, done](bool) {
+        done(createRequestResult(request->mCommon, *(partition.mSession), request->mError, "Terminate done", std::move(request->mTopologyState), {}));
+    });
 }
 
 StatusRequestResult Controller::execStatus(const StatusParams& params)
@@ -500,6 +841,7 @@ StatusRequestResult Controller::execStatus(const StatusParams& params)
             result.mPartitions.push_back(status);
         }
     }
+    result.mTopoScriptCache = mTopoScriptCache.getStats();
     result.mStatusCode = StatusCode::ok;
     result.mMsg = "Status done";
     result.mExecTime = params.mTimer.duration().count();
@@ -525,6 +867,7 @@ void Controller::updateRestore()
             OLOG(warning, session->mPartitionID, 0) << "Failed to get session ID or session status: " << e.what();
         }
     }
+    data.mPooledSessions = mSessionPool.getSessionIDs();
 
     // Writing the file is locked by mPartitionMtx
     // This is done in order to prevent write failure in case of a parallel execution.
@@ -560,6 +903,37 @@ void Controller::updateHistory(const CommonParams& common, const std::string& se
     }
 }
 
+pair<chrono::milliseconds, bool> Controller::stepTimeout(const CommonParams& common, const Partition& partition, const string& step) const
+{
+    const chrono::milliseconds remaining = requestTimeout(common, step);
+    if (mAdaptiveTimeoutFactor <= 0 || partition.mSession == nullptr) {
+        return { remaining, false };
+    }
+
+    const string key = TransitionHistory::key(partition.mID, partition.mSession->mParsedTopoHash, step);
+    const auto deadline = mTransitionHistory.adaptiveDeadline(key, mAdaptiveTimeoutFactor, kMinAdaptiveTimeout, remaining);
+    if (!deadline.has_value()) {
+        OLOG(debug, common) << step << ": no adaptive deadline shorter than the remaining request time (" << mTransitionHistory.numSamples(key) << " previous completions recorded)";
+        return { remaining, false };
+    }
+    OLOG(info, common) << step << ": adaptive deadline of " << deadline.value().count() << " ms from " << mTransitionHistory.numSamples(key) << " previous completions, remaining request time: " << remaining.count() << " ms";
+    return { deadline.value(), true };
+}
+
+void Controller::recordStep(const Partition& partition, const string& step, chrono::steady_clock::duration duration, bool timedOut)
+{
+    if (partition.mSession == nullptr) {
+        return;
+    }
+    const string key = TransitionHistory::key(partition.mID, partition.mSession->mParsedTopoHash, step);
+    if (timedOut) {
+        // without it, the history of a step that slowed down would keep expiring its deadline
+        mTransitionHistory.recordTimeout(key, chrono::duration_cast<chrono::milliseconds>(duration));
+    } else {
+        mTransitionHistory.record(key, chrono::duration_cast<chrono::milliseconds>(duration));
+    }
+}
+
 RequestResult Controller::createRequestResult(const CommonParams& common, const Session& session, const Error& error, const string& msg, TopologyState&& topologyState, const std::unordered_set<std::string>& hosts)
 {
     string sidStr = to_string(session.mDDSSession.getSessionID());
@@ -573,8 +947,26 @@ RequestResult Controller::createRequestResult(const CommonParams& common, const
     return RequestResult(status, msg, common.mTimer.duration().count(), error, common.mPartitionID, common.mRunNr, sessionId, std::move(topologyState), hosts);
 }
 
-bool Controller::createDDSSession(const CommonParams& common, Session& session, Error& error)
+bool Controller::createDDSSession(const CommonParams& common, Partition& partition, Error& error)
 {
+    auto pooled = mSessionPool.claim();
+    if (pooled != nullptr) {
+        pooled->mPartitionID = partition.mSession->mPartitionID;
+        pooled->mRunAttempted = partition.mSession->mRunAttempted;
+        pooled->mLastRunNr = partition.mSession->mLastRunNr.load();
+        logAgentChanges(*pooled);
+        {
+            // execStatus() iterates the sessions of all partitions
+            lock_guard<mutex> lock(mPartitionMtx);
+            partition.mSession.swap(pooled);
+        }
+        const string sessionID = to_string(partition.mSession->mDDSSession.getSessionID());
+        OLOG(info, common) << "Using pre-created DDS session with session ID: " << sessionID;
+        updateHistory(common, sessionID);
+        return true;
+    }
+
+    Session& session = *(partition.mSession);
     try {
         boost::uuids::uuid sessionID = session.mDDSSession.create();
         OLOG(info, common) << "DDS session created with session ID: " << to_string(sessionID);
@@ -598,24 +990,33 @@ bool Controller::attachToDDSSession(const CommonParams& common, Session& session
     return true;
 }
 
+void Controller::resetTopologyState(const CommonParams& common, Partition& partition)
+{
+    partition.mTopology.reset();
+    partition.mSession->mDDSTopo.reset();
+    partition.mSession->mParsedTopo.reset();
+    partition.mSession->mNinfo.clear();
+    partition.mSession->mZoneInfo.clear();
+    partition.mSession->mStandaloneTasks.clear();
+    partition.mSession->mCollections.clear();
+    partition.mSession->mAgentGroupInfo.clear();
+    partition.mSession->mRuntimeCollectionIndex.clear();
+    partition.mSession->mTopoFilePath.clear();
+    mTopoStore.release(common.mPartitionID);
+    partition.mSession->mExpendableTasks.clear();
+}
+
 bool Controller::shutdownDDSSession(const CommonParams& common, Partition& partition, Error& error)
 {
     try {
-        partition.mTopology.reset();
-        partition.mSession->mDDSTopo.reset();
-        partition.mSession->mNinfo.clear();
-        partition.mSession->mZoneInfo.clear();
-        partition.mSession->mStandaloneTasks.clear();
-        partition.mSession->mCollections.clear();
-        partition.mSession->mAgentGroupInfo.clear();
-        partition.mSession->mTopoFilePath.clear();
-        partition.mSession->mExpendableTasks.clear();
+        resetTopologyState(common, partition);
 
         if (partition.mSession->mDDSSession.getSessionID() != boost::uuids::nil_uuid()) {
             if (partition.mSession->mDDSOnTaskDoneRequest) {
                 partition.mSession->mDDSOnTaskDoneRequest->unsubscribeResponseCallback();
             }
             partition.mSession->mDDSSession.shutdown();
+            partition.mSession->mAgentInventory.invalidate();
             if (partition.mSession->mDDSSession.getSessionID() == boost::uuids::nil_uuid()) {
                 OLOG(info, common) << "DDS session has been shut down";
             } else {
@@ -636,13 +1037,13 @@ std::string Controller::getActiveDDSTopology(const CommonParams& common, Session
 {
     using namespace dds::tools_api;
     try {
-        dds::tools_api::SCommanderInfoRequest::response_t commanderInfo;
-        stringstream ss;
-        session.mDDSSession.syncSendRequest<SCommanderInfoRequest>(SCommanderInfoRequest::request_t(),
-                                                                    commanderInfo,
-                                                                    requestTimeout(common, "getActiveDDSTopology..syncSendRequest<SCommanderInfoRequest>"),
-                                                                    &ss);
-        OLOG(info, common) << ss.str();
+        DDSRequest<SCommanderInfoRequest> request;
+        auto reply = request.send(session.mDDSSession).get(requestTimeout(common, "getActiveDDSTopology"));
+        logDDSMessages(common, reply, "DDS commander info error: ");
+        if (reply.responses.empty()) {
+            throw runtime_error("No commander info received");
+        }
+        const auto& commanderInfo = reply.responses.front();
         OLOG(debug, common) << "Commander info: " << commanderInfo;
         return commanderInfo.m_activeTopologyPath;
     } catch (Error& e) {
@@ -655,230 +1056,570 @@ std::string Controller::getActiveDDSTopology(const CommonParams& common, Session
     }
 }
 
-bool Controller::submitDDSAgents(const CommonParams& common, Session& session, Error& error, const DDSSubmitParams& params)
+void Controller::asyncWaitUntil(chrono::steady_clock::time_point deadline, function<void(function<void()>)> subscribe, function<void()> next)
+{
+    // the timer is only touched on its strand, the notification cancels it, which completes the wait early
+    auto strand = boost::asio::make_strand(getExecExecutor());
+    auto timer = make_shared<boost::asio::steady_timer>(strand, deadline);
+    boost::asio::dispatch(strand, [timer, next = std::move(next)]() {
+        timer->async_wait([timer, next](const boost::system::error_code&) { next(); });
+    });
+    if (subscribe) {
+        // posted after the wait was started
+        subscribe([timer]() { boost::asio::post(timer->get_executor(), [timer]() { timer->cancel(); }); });
+    }
+}
+
+struct Controller::Submissions
+{
+    Submissions(const CommonParams& common, Session& session, Error& error, const vector<DDSSubmitParams>& params, size_t window, function<void(bool, size_t)> next)
+        : mCommon(common)
+        , mSession(session)
+        , mError(error)
+        , mParams(params)
+        , mWindow(window)
+        , mNext(std::move(next))
+        , mRequests(params.size())
+        , mDone(params.size(), false)
+        , mErrors(params.size())
+    {}
+
+    // the callbacks may outlive the submission in case of a timeout, they only touch the members below the mutex
+    CommonParams mCommon;
+    Session& mSession;
+    Error& mError;
+    vector<DDSSubmitParams> mParams;
+    size_t mWindow;
+    function<void(bool, size_t)> mNext;
+    function<void()> mNotifyDone; ///< completes the wait for the submissions
+
+    mutex mMtx;
+    size_t mNumSent = 0;
+    size_t mInFlight = 0;
+    bool mFinished = false;
+    vector<dds::tools_api::SSubmitRequest::ptr_t> mRequests;
+    vector<bool> mDone;
+    vector<Error> mErrors;
+};
+
+void Controller::asyncSubmitDDSAgents(const CommonParams& common, Session& session, Error& error, const vector<DDSSubmitParams>& params, function<void(bool, size_t)> next)
+{
+    chrono::steady_clock::time_point deadline;
+    try {
+        deadline = chrono::steady_clock::now() + requestTimeout(common, "submitDDSAgents");
+    } catch (Error& e) {
+        error = e;
+        OLOG(error, common) << "Agent submission failed: " << e;
+        next(false, 0);
+        return;
+    }
+
+    auto subs = make_shared<Submissions>(common, session, error, params, max<size_t>(mSubmitWindow, 1), std::move(next));
+    // finished at the deadline, or once all submissions are done
+    asyncWaitUntil(deadline, [subs](function<void()> notify) {
+        lock_guard<mutex> lock(subs->mMtx);
+        subs->mNotifyDone = std::move(notify);
+    }, [this, subs]() { finishSubmissions(subs); });
+    sendSubmissions(subs);
+}
+
+void Controller::sendSubmissions(shared_ptr<Submissions> subs)
 {
-    bool success = true;
     using namespace dds::tools_api;
 
-    SSubmitRequest::request_t requestInfo;
-    requestInfo.m_submissionTag = common.mPartitionID;
-    requestInfo.m_rms = params.mRMS;
-    requestInfo.m_instances = params.mNumAgents;
-    // requestInfo.m_minInstances = params.mMinAgents;
-    requestInfo.m_minInstances = 0;
-    OLOG(debug, common) << "Ignoring params.mMinAgents for DDS submission to avoid nMin handling temporarily";
-    requestInfo.m_slots = params.mNumSlots;
-    requestInfo.m_config = params.mConfigFile;
-    requestInfo.m_envCfgFilePath = params.mEnvFile;
-    requestInfo.m_groupName = params.mAgentGroup;
+    vector<size_t> toSend;
+    function<void()> notifyDone;
+    {
+        lock_guard<mutex> lock(subs->mMtx);
+        if (subs->mFinished) {
+            return;
+        }
+        // keep the window of submissions in flight
+        while (subs->mNumSent < subs->mParams.size() && subs->mInFlight < subs->mWindow) {
+            toSend.push_back(subs->mNumSent++);
+            ++(subs->mInFlight);
+        }
+        if (subs->mNumSent == subs->mParams.size() && subs->mInFlight == 0) {
+            notifyDone = std::move(subs->mNotifyDone);
+        }
+    }
+    if (notifyDone) {
+        notifyDone();
+        return;
+    }
+
+    const CommonParams& common = subs->mCommon;
+    for (const auto i : toSend) {
+        const DDSSubmitParams& p = subs->mParams.at(i);
+
+        SSubmitRequest::request_t requestInfo;
+        requestInfo.m_submissionTag = common.mPartitionID;
+        requestInfo.m_rms = p.mRMS;
+        requestInfo.m_instances = p.mNumAgents;
+        // requestInfo.m_minInstances = p.mMinAgents;
+        requestInfo.m_minInstances = 0;
+        OLOG(debug, common) << "Ignoring params.mMinAgents for DDS submission to avoid nMin handling temporarily";
+        requestInfo.m_slots = p.mNumSlots;
+        requestInfo.m_config = p.mConfigFile;
+        requestInfo.m_envCfgFilePath = p.mEnvFile;
+        requestInfo.m_groupName = p.mAgentGroup;
+
+        // DDS does not support ncores parameter directly, set it here through additional config in case of Slurm
+        if (p.mRMS == "slurm" && p.mNumCores > 0) {
+            // the following disables `#SBATCH --cpus-per-task=%DDS_NSLOTS%` of DDS for Slurm
+            requestInfo.setFlag(SSubmitRequestData::ESubmitRequestFlags::enable_overbooking, true);
+
+            requestInfo.m_inlineConfig = string("#SBATCH --cpus-per-task=" + to_string(p.mNumCores));
+        }
+
+        OLOG(info, common) << "Submitting [" << i + 1 << "/" << subs->mParams.size() << "]: " << requestInfo;
+
+        SSubmitRequest::ptr_t requestPtr = SSubmitRequest::makeRequest(requestInfo);
 
-    // DDS does not support ncores parameter directly, set it here through additional config in case of Slurm
-    if (params.mRMS == "slurm" && params.mNumCores > 0) {
-        // the following disables `#SBATCH --cpus-per-task=%DDS_NSLOTS%` of DDS for Slurm
-        requestInfo.setFlag(SSubmitRequestData::ESubmitRequestFlags::enable_overbooking, true);
+        requestPtr->setMessageCallback([subs, i, this](const SMessageResponseData& msg) {
+            if (msg.m_severity == dds::intercom_api::EMsgSeverity::error) {
+                lock_guard<mutex> lock(subs->mMtx);
+                fillAndLogError(subs->mCommon, subs->mErrors.at(i), ErrorCode::DDSSubmitAgentsFailed, toString("Submit error: ", msg.m_msg));
+            } else {
+                OLOG(info, subs->mCommon) << "...Submit: " << msg.m_msg;
+            }
+        });
+
+        auto onDone = [this, subs, i]() {
+            {
+                lock_guard<mutex> lock(subs->mMtx);
+                if (subs->mDone.at(i)) {
+                    return;
+                }
+                subs->mDone.at(i) = true;
+                --(subs->mInFlight);
+            }
+            // send the next submission, or complete the wait
+            postExec([this, subs]() { sendSubmissions(subs); });
+        };
+        requestPtr->setDoneCallback(onDone);
 
-        requestInfo.m_inlineConfig = string("#SBATCH --cpus-per-task=" + to_string(params.mNumCores));
+        {
+            lock_guard<mutex> lock(subs->mMtx);
+            subs->mRequests.at(i) = requestPtr;
+        }
+        try {
+            subs->mSession.mDDSSession.sendRequest<SSubmitRequest>(requestPtr);
+        } catch (exception& e) {
+            {
+                lock_guard<mutex> lock(subs->mMtx);
+                fillAndLogError(common, subs->mErrors.at(i), ErrorCode::DDSSubmitAgentsFailed, toString("Submit error: ", e.what()));
+            }
+            onDone();
+        }
     }
+}
 
-    OLOG(info, common) << "Submitting: " << requestInfo;
+void Controller::finishSubmissions(shared_ptr<Submissions> subs)
+{
+    const CommonParams& common = subs->mCommon;
+    Error& error = subs->mError;
 
-    bool done = false;
-    mutex mtx;
-    condition_variable cv;
+    vector<dds::tools_api::SSubmitRequest::ptr_t> pending;
+    size_t numSent = 0;
+    {
+        lock_guard<mutex> lock(subs->mMtx);
+        subs->mFinished = true;
+        numSent = subs->mNumSent;
+        for (size_t i = 0; i < numSent; ++i) {
+            if (!subs->mDone.at(i)) {
+                pending.push_back(subs->mRequests.at(i));
+            }
+        }
+    }
+    // not under the lock, a callback might be waiting for it
+    for (const auto& request : pending) {
+        request->unsubscribeAll();
+    }
 
-    SSubmitRequest::ptr_t requestPtr = SSubmitRequest::makeRequest(requestInfo);
+    lock_guard<mutex> lock(subs->mMtx);
+    bool timedOut = numSent < subs->mParams.size();
+    for (size_t i = 0; i < numSent; ++i) {
+        if (!subs->mDone.at(i)) {
+            timedOut = true;
+            subs->mErrors.at(i) = Error(MakeErrorCode(ErrorCode::RequestTimeout), "Timed out waiting for agent submission");
+        }
+    }
 
-    requestPtr->setMessageCallback([&success, &error, &common, this](const SMessageResponseData& msg) {
-        if (msg.m_severity == dds::intercom_api::EMsgSeverity::error) {
+    bool success = !timedOut;
+    size_t numSlots = 0;
+    for (size_t i = 0; i < numSent; ++i) {
+        const Error& e = subs->mErrors.at(i);
+        if (e.mCode) {
             success = false;
-            fillAndLogError(common, error, ErrorCode::DDSSubmitAgentsFailed, toString("Submit error: ", msg.m_msg));
+            OLOG(error, common) << "Submission [" << i + 1 << "/" << subs->mParams.size() << "] failed: " << e;
+            if (!error.mCode) {
+                error = e;
+            }
         } else {
-            OLOG(info, common) << "...Submit: " << msg.m_msg;
-        }
-    });
-
-    requestPtr->setDoneCallback([&mtx, &cv, &done]() {
-        {
-            lock_guard<mutex> lock(mtx);
-            done = true;
+            numSlots += subs->mParams.at(i).mNumAgents * subs->mParams.at(i).mNumSlots;
         }
-        cv.notify_all();
-    });
+    }
+    if (numSent < subs->mParams.size()) {
+        OLOG(error, common) << "Submissions [" << numSent + 1 << "-" << subs->mParams.size() << "/" << subs->mParams.size() << "] were not sent";
+    }
+    if (timedOut && !error.mCode) {
+        fillAndLogError(common, error, ErrorCode::RequestTimeout, "Timed out waiting for agent submission");
+    }
 
-    session.mDDSSession.sendRequest<SSubmitRequest>(requestPtr);
+    auto next = std::move(subs->mNext);
+    postExec([next, success, numSlots]() { next(success, numSlots); });
+}
 
+void Controller::asyncWaitForNumActiveSlots(const CommonParams& common, Session& session, Error& error, size_t numSlots, chrono::steady_clock::time_point deadline, function<void(bool)> next)
+{
+    using namespace dds::tools_api;
+    // TODO: DDS notifies about active slots only via the blocking CSession::waitForNumSlots(), poll the slot count instead
+    auto request = make_shared<DDSRequest<SAgentCountRequest>>();
     try {
-        unique_lock<mutex> lock(mtx);
-        cv.wait_for(lock, requestTimeout(common, "wait_for lock in submitDDSAgents"), [&done]{ return done; });
+        request->send(session.mDDSSession);
+    } catch (exception& e) {
+        fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Error while waiting for DDS slots: ", e.what()));
+        next(false);
+        return;
+    }
 
-        if (!done) {
-            success = false;
-            fillAndLogError(common, error, ErrorCode::RequestTimeout, "Timed out waiting for agent submission");
+    asyncWaitUntil(deadline, [request](function<void()> notify) { request->onDone(std::move(notify)); }, [this, &common, &session, &error, numSlots, deadline, request, next]() {
+        optional<bool> result;
+        try {
+            auto reply = request->get(chrono::steady_clock::now());
+            if (reply.responses.empty()) {
+                throw runtime_error("No agent count received");
+            }
+            const size_t activeSlots = reply.responses.front().m_activeSlotsCount;
+            if (activeSlots >= numSlots) {
+                result = true;
+            } else if (chrono::steady_clock::now() + kSlotPollInterval >= deadline) {
+                fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timeout waiting for DDS slots: ", activeSlots, "/", numSlots, " slots active"));
+                result = false;
+            }
+        } catch (Error& e) {
+            error = e;
+            OLOG(error, common) << "Error while waiting for DDS slots: " << e;
+            result = false;
+        } catch (exception& e) {
+            fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timeout waiting for DDS slots: ", e.what()));
+            result = false;
+        }
 
-            requestPtr->unsubscribeAll();
-        } else {
-            // OLOG(info, common) << "Agent submission done successfully";
+        if (result.has_value()) {
+            next(result.value());
+            return;
         }
+        asyncWaitUntil(chrono::steady_clock::now() + kSlotPollInterval, nullptr, [this, &common, &session, &error, numSlots, deadline, next]() {
+            asyncWaitForNumActiveSlots(common, session, error, numSlots, deadline, next);
+        });
+    });
+}
+
+struct Controller::StreamingWait
+{
+    StreamingWait(const CommonParams& common, Session& session, Error& error, size_t numSlots, function<void(bool)> next)
+        : mCommon(common)
+        , mSession(session)
+        , mError(error)
+        , mNumSlots(numSlots)
+        , mNext(std::move(next))
+    {}
+
+    const CommonParams& mCommon;
+    Session& mSession;
+    Error& mError;
+    size_t mNumSlots;
+    function<void(bool)> mNext;
+    chrono::steady_clock::time_point mDeadline;
+    map<string, uint32_t> mRequestedAgents; ///< by agent group
+    set<string> mActivatedGroups;
+};
+
+void Controller::asyncWaitForNumActiveSlotsStreaming(const CommonParams& common, Session& session, Error& error, const vector<DDSSubmitParams>& ddsParams, size_t numSlots, function<void(bool)> next)
+{
+    auto wait = make_shared<StreamingWait>(common, session, error, numSlots, std::move(next));
+    for (const auto& p : ddsParams) {
+        wait->mRequestedAgents[p.mAgentGroup] += p.mNumAgents;
+    }
+
+    try {
+        wait->mDeadline = chrono::steady_clock::now() + requestTimeout(common, "waitForNumActiveSlotsStreaming");
     } catch (Error& e) {
         error = e;
-        OLOG(error, common) << "Agent submission error: " << e;
-        success = false;
+        OLOG(error, common) << "Error while waiting for DDS slots: " << e;
+        wait->mNext(false);
+        return;
     }
-    return success;
+    if (wait->mRequestedAgents.size() < 2) {
+        asyncWaitForNumActiveSlots(common, session, error, numSlots, wait->mDeadline, std::move(wait->mNext));
+        return;
+    }
+    pollNumActiveSlotsStreaming(wait);
 }
 
-bool Controller::waitForNumActiveSlots(const CommonParams& common, Session& session, Error& error, size_t numSlots)
+void Controller::pollNumActiveSlotsStreaming(shared_ptr<StreamingWait> wait)
 {
+    using EUpdateType = dds::tools_api::STopologyRequest::request_t::EUpdateType;
+    const CommonParams& common = wait->mCommon;
+    Session& session = wait->mSession;
+    Error& error = wait->mError;
+
+    set<string> readyGroups;
+    optional<bool> result;
     try {
-        session.mDDSSession.waitForNumSlots<dds::tools_api::CSession::EAgentState::active>(numSlots, requestTimeout(common, "waitForNumActiveSlots..waitForNumSlots<dds::tools_api::CSession::EAgentState::active>"));
+        const auto& inventory = getAgentInventory(common, session);
+        size_t currentSlots = 0;
+        map<string, uint32_t> currentAgents;
+        for (const auto& [agentID, ai] : inventory.agents()) {
+            currentSlots += ai.m_nSlots;
+            currentAgents[ai.m_groupName]++;
+        }
+        if (currentSlots >= wait->mNumSlots) {
+            result = true;
+        } else if (chrono::steady_clock::now() >= wait->mDeadline) {
+            fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timeout waiting for DDS slots: ", currentSlots, "/", wait->mNumSlots, " slots active"));
+            result = false;
+        } else {
+            for (const auto& [group, count] : wait->mRequestedAgents) {
+                if (currentAgents[group] >= count) {
+                    readyGroups.insert(group);
+                }
+            }
+            if (!readyGroups.empty() && readyGroups != wait->mActivatedGroups) {
+                OLOG(info, common) << "Agent groups " << boost::algorithm::join(readyGroups, ", ") << " are ready (" << currentSlots << "/" << wait->mNumSlots << " slots), activating their tasks while waiting for the remaining groups";
+            } else {
+                readyGroups.clear();
+            }
+        }
     } catch (Error& e) {
         error = e;
         OLOG(error, common) << "Error while waiting for DDS slots: " << e;
-        return false;
+        result = false;
     } catch (exception& e) {
-        fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timeout waiting for DDS slots: ", e.what()));
-        return false;
+        fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Error while waiting for DDS slots: ", e.what()));
+        result = false;
     }
-    return true;
+    if (result.has_value()) {
+        wait->mNext(result.value());
+        return;
+    }
+
+    auto pollLater = [this, wait]() {
+        asyncWaitUntil(chrono::steady_clock::now() + kStreamingPollInterval, nullptr, [this, wait]() { pollNumActiveSlotsStreaming(wait); });
+    };
+    if (readyGroups.empty()) {
+        pollLater();
+        return;
+    }
+
+    const string topoFilePath = session.mTopoFilePath;
+    try {
+        session.mTopoFilePath = partialTopology(common, session, readyGroups);
+    } catch (exception& e) {
+        fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("Error while waiting for DDS slots: ", e.what()));
+        wait->mNext(false);
+        return;
+    }
+    asyncActivateDDSTopology(common, session, error, wait->mActivatedGroups.empty() ? EUpdateType::ACTIVATE : EUpdateType::UPDATE, [this, wait, topoFilePath, readyGroups, pollLater](bool activated) {
+        // the partial topology is not needed after its activation
+        replaceTopoFilePath(wait->mCommon, wait->mSession, topoFilePath);
+        wait->mSession.mPartiallyActivated = true;
+        if (!activated) {
+            wait->mNext(false);
+            return;
+        }
+        wait->mActivatedGroups = readyGroups;
+        pollLater();
+    });
 }
 
-bool Controller::activateDDSTopology(const CommonParams& common, Session& session, Error& error, dds::tools_api::STopologyRequest::request_t::EUpdateType updateType)
+struct Controller::Activation
+{
+    Activation(const CommonParams& common, Session& session, Error& error, const dds::tools_api::STopologyRequest::request_t& topoInfo, function<void(bool)> next)
+        : mCommon(common)
+        , mSession(session)
+        , mError(error)
+        , mRequest(topoInfo)
+        , mNext(std::move(next))
+    {}
+
+    const CommonParams& mCommon;
+    Session& mSession;
+    Error& mError;
+    DDSRequest<dds::tools_api::STopologyRequest> mRequest;
+    function<void(bool)> mNext;
+    chrono::steady_clock::time_point mDeadline;
+    // Responses arrive concurrently, possibly tens of thousands of them. They are queued without locking and applied in batches.
+    // The queue is shared with the response callback, which may outlive the activation in case of a timeout.
+    shared_ptr<BatchQueue<dds::tools_api::STopologyResponseData>> mResponses = make_shared<BatchQueue<dds::tools_api::STopologyResponseData>>();
+    shared_ptr<dds::topology_api::CTopology> mTopo; ///< null when stopping the topology
+};
+
+void Controller::asyncActivateDDSTopology(const CommonParams& common, Session& session, Error& error, dds::tools_api::STopologyRequest::request_t::EUpdateType updateType, function<void(bool)> next)
 {
-    bool success = true;
-
     dds::tools_api::STopologyRequest::request_t topoInfo;
     topoInfo.m_topologyFile = session.mTopoFilePath;
     topoInfo.m_disableValidation = true;
     topoInfo.m_updateType = updateType;
 
-    bool done = false;
-    mutex mtx;
-    condition_variable cv;
-
-    dds::tools_api::STopologyRequest::ptr_t requestPtr = dds::tools_api::STopologyRequest::makeRequest(topoInfo);
-
-    requestPtr->setMessageCallback([&success, &error, &common, this](const dds::tools_api::SMessageResponseData& msg) {
-        if (msg.m_severity == dds::intercom_api::EMsgSeverity::error) {
-            success = false;
-            fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("DDS Activate error: ", msg.m_msg));
-        } else {
-            // OLOG(debug, common) << "DDS Activate Message: " << msg.m_msg;
+    auto activation = make_shared<Activation>(common, session, error, topoInfo, std::move(next));
+    if (updateType != dds::tools_api::STopologyRequest::request_t::EUpdateType::STOP) {
+        try {
+            activation->mTopo = session.getParsedTopology(session.mTopoFilePath);
+            session.layoutTasks(*(activation->mTopo));
+            const auto collectionIt = activation->mTopo->getRuntimeCollectionIterator();
+            const size_t numCollections = distance(collectionIt.first, collectionIt.second);
+            session.mCollectionDetails.reserve(numCollections);
+            session.mCollectionIndex.reserve(numCollections);
+        } catch (exception& e) {
+            fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("Failed to parse topology ", quoted(session.mTopoFilePath), ": ", e.what()));
+            activation->mNext(false);
+            return;
         }
-    });
+    }
+
+    auto& requestPtr = activation->mRequest.request();
 
-    requestPtr->setProgressCallback([&common](const dds::tools_api::SProgressResponseData& progress) {
+    // the callbacks may outlive the activation in case of a timeout
+    requestPtr->setProgressCallback([common](const dds::tools_api::SProgressResponseData& progress) {
         uint32_t completed{ progress.m_completed + progress.m_errors };
         if (completed == progress.m_total) {
             OLOG(debug, common) << "DDS Activated tasks (" << progress.m_completed << "), errors (" << progress.m_errors << "), total (" << progress.m_total << ")";
         }
     });
 
-    requestPtr->setResponseCallback([&common, &session, &mtx](const dds::tools_api::STopologyResponseData& res) {
-        OLOG(debug, common) << "DDS Activate Response: "
-            << "agentID: " << res.m_agentID
-            << "; slotID: " << res.m_slotID
-            << "; taskID: " << res.m_taskID
-            << "; collectionID: " << res.m_collectionID
-            << "; host: " << res.m_host
-            << "; path: " << res.m_path
-            << "; workDir: " << res.m_wrkDir
-            << "; activated: " << res.m_activated;
+    const bool logResponses = Logger::instance().enabled(ESeverity::debug);
+    requestPtr->setResponseCallback([common, responses = activation->mResponses, logResponses](const dds::tools_api::STopologyResponseData& res) {
+        if (logResponses) {
+            OLOG(debug, common) << "DDS Activate Response: "
+                << "agentID: " << res.m_agentID
+                << "; slotID: " << res.m_slotID
+                << "; taskID: " << res.m_taskID
+                << "; collectionID: " << res.m_collectionID
+                << "; host: " << res.m_host
+                << "; path: " << res.m_path
+                << "; workDir: " << res.m_wrkDir
+                << "; activated: " << res.m_activated;
+        }
 
         // We are not interested in stopped tasks
         if (res.m_activated) {
-            // response callbacks can be called in parallel - protect session access with a lock
-            lock_guard<mutex> lock(mtx);
-            session.mTaskDetails.emplace(res.m_taskID, TaskDetails{res.m_agentID, res.m_slotID, res.m_taskID, res.m_collectionID, res.m_path, res.m_host, res.m_wrkDir});
-
-            if (res.m_collectionID > 0) {
-                if (session.mCollectionDetails.find(res.m_collectionID) == session.mCollectionDetails.end()) {
-                    string path = res.m_path;
-                    auto pos = path.rfind('/');
-                    if (pos != string::npos) {
-                        path.erase(pos);
-                    }
-                    session.mCollectionDetails.emplace(res.m_collectionID, CollectionDetails{res.m_agentID, res.m_collectionID, path, res.m_host, res.m_wrkDir});
-                    session.mRuntimeCollectionIndex.at(res.m_collectionID)->mRuntimeCollectionAgents[res.m_collectionID] = res.m_agentID;
-                }
-            }
+            responses->push(res);
         }
     });
 
-    requestPtr->setDoneCallback([&mtx, &cv, &done]() {
-        {
-            lock_guard<mutex> lock(mtx);
-            done = true;
-        }
-        cv.notify_all();
-    });
-
-    session.mDDSSession.sendRequest<dds::tools_api::STopologyRequest>(requestPtr);
-
     try {
-        unique_lock<mutex> lock(mtx);
-        cv.wait_for(lock, requestTimeout(common, "wait_for lock in activateDDSTopology"), [&done]{ return done; });
+        activation->mDeadline = chrono::steady_clock::now() + requestTimeout(common, "activateDDSTopology");
+        activation->mRequest.send(session.mDDSSession);
+    } catch (Error& e) {
+        error = e;
+        OLOG(error, common) << "Error during topology activation: " << e;
+        activation->mNext(false);
+        return;
+    } catch (exception& e) {
+        fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("Failed to activate topology: ", e.what()));
+        activation->mNext(false);
+        return;
+    }
+    collectActivation(activation);
+}
+
+void Controller::collectActivation(shared_ptr<Activation> activation)
+{
+    // apply the responses received so far at each interval, until the activation is done
+    const auto until = min(activation->mDeadline, chrono::steady_clock::now() + kActivationBatchInterval);
+    asyncWaitUntil(until, [activation](function<void()> notify) { activation->mRequest.onDone(std::move(notify)); }, [this, activation]() {
+        const CommonParams& common = activation->mCommon;
+        Session& session = activation->mSession;
+        Error& error = activation->mError;
+        optional<bool> success;
 
-        if (!done) {
+        try {
+            const bool done = activation->mRequest.wait(chrono::steady_clock::now());
+            auto batch = activation->mResponses->take();
+            if (activation->mTopo != nullptr) {
+                session.applyActivationResponses(*(activation->mTopo), batch);
+            }
+            if (done || chrono::steady_clock::now() >= activation->mDeadline) {
+                auto reply = activation->mRequest.get(activation->mDeadline);
+                success = true;
+                for (const auto& msg : reply.errors) {
+                    success = false;
+                    fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("DDS Activate error: ", msg));
+                }
+            }
+        } catch (Error& e) {
+            error = e;
+            OLOG(error, common) << "Error during topology activation: " << e;
+            success = false;
+        } catch (exception& e) {
             success = false;
             fillAndLogError(common, error, ErrorCode::RequestTimeout, "Timed out waiting for topology activation");
-            OLOG(error, common) << error;
-
-            requestPtr->unsubscribeAll();
-
-            auto agentInfo = getAgentInfo(common, session);
-            OLOG(info, common) << agentInfo.size() << " DDS agents active:";
-            for (const auto& ai : agentInfo) {
-                OLOG(info, common)
-                    << "  Agent ID: " << ai.m_agentID
-                    << "; host: " << ai.m_host
-                    << "; path: " << ai.m_DDSPath
-                    << "; group: " << ai.m_groupName
-                    << "; slots: " << ai.m_nSlots
-                    << " (idle: " << ai.m_nIdleSlots
-                    << ", executing: " << ai.m_nExecutingSlots << ").";
+
+            try {
+                const auto& inventory = getAgentInventory(common, session);
+                OLOG(info, common) << inventory.agents().size() << " DDS agents active"
+                    << " (slots active: " << inventory.slots().m_activeSlotsCount
+                    << ", idle: " << inventory.slots().m_idleSlotsCount
+                    << ", executing: " << inventory.slots().m_executingSlotsCount << "):";
+                for (const auto& [agentID, ai] : inventory.agents()) {
+                    OLOG(info, common)
+                        << "  Agent ID: " << ai.m_agentID
+                        << "; host: " << ai.m_host
+                        << "; path: " << ai.m_DDSPath
+                        << "; group: " << ai.m_groupName
+                        << "; slots: " << ai.m_nSlots
+                        << " (idle: " << ai.m_nIdleSlots
+                        << ", executing: " << ai.m_nExecutingSlots << ").";
+                }
+            } catch (exception& e) {
+                OLOG(error, common) << "Failed getting agent info: " << e.what();
             }
-        } else {
-            // try {
-            //     if (!session.mCollections.empty()) {
-            //         OLOG(info, common) << "Collections:";
-            //         for (const auto& [id, colInfo] : session.mCollections) {
-            //             OLOG(info, common) << "  " << colInfo;
-            //             for (const auto& [colId, agentId] : colInfo.mRuntimeCollectionAgents) {
-            //                 OLOG(info, common) << "    runtime collection: id: " << colId << ", agent id: " << agentId;
-            //             }
-            //         }
-            //     }
-            // } catch (const exception& e) {
-            //     fillAndLogError(common, error, ErrorCode::DDSActivateTopologyFailed, toString("Failed getting slot info: ", e.what()));
-            // }
         }
-    } catch (Error& e) {
-        error = e;
-        OLOG(error, common) << "Error during topology activation: " << e;
-        success = false;
-    }
 
-    // session.debug();
+        if (!success.has_value()) {
+            collectActivation(activation);
+            return;
+        }
+
+        // session.debug();
 
-    OLOG(info, common) << "Topology " << quoted(session.mTopoFilePath) << ((success) ? " activated successfully" : " failed to activate");
-    return success;
+        OLOG(info, common) << "Topology " << quoted(session.mTopoFilePath) << ((success.value()) ? " activated successfully" : " failed to activate");
+        activation->mNext(success.value());
+    });
+}
+
+void Controller::loadRequirements(const CommonParams& common, Session& session)
+{
+    auto requirements = mTopoStore.getRequirements(session.mTopoFilePath);
+    if (requirements != nullptr) {
+        OLOG(info, common) << "Reusing requirements previously extracted from " << std::quoted(session.mTopoFilePath);
+        requirements->ApplyTo(session);
+        return;
+    }
+    extractRequirements(common, session);
+    mTopoStore.setRequirements(session.mTopoFilePath, make_shared<const TopologyRequirements>(session));
 }
 
 void Controller::extractRequirements(const CommonParams& common, Session& session)
 {
     using namespace dds::topology_api;
 
-    CTopology ddsTopo(session.mTopoFilePath);
+    // parsed once, reused by createDDSTopology()
+    auto ddsTopo = session.getParsedTopology(session.mTopoFilePath);
 
     session.mNinfo.clear();
     session.mZoneInfo.clear();
     session.mStandaloneTasks.clear();
     session.mCollections.clear();
     session.mAgentGroupInfo.clear();
+    session.mRuntimeCollectionIndex.clear();
 
     OLOG(info, common) << "Extracting requirements from " << std::quoted(session.mTopoFilePath) << "...";
 
-    auto taskIt = ddsTopo.getRuntimeTaskIterator();
+    auto taskIt = ddsTopo->getRuntimeTaskIterator();
 
     std::for_each(taskIt.first, taskIt.second, [&](const dds::topology_api::STopoRuntimeTask::FilterIterator_t::value_type& v) {
         auto& task = v.second;
@@ -901,7 +1642,7 @@ void Controller::extractRequirements(const CommonParams& common, Session& sessio
         }
     });
 
-    auto tasks = ddsTopo.getMainGroup()->getElementsByType(CTopoBase::EType::TASK);
+    auto tasks = ddsTopo->getMainGroup()->getElementsByType(CTopoBase::EType::TASK);
 
     for (const auto& task : tasks) {
         CTopoTask::Ptr_t t = dynamic_pointer_cast<CTopoTask>(task);
@@ -934,7 +1675,7 @@ void Controller::extractRequirements(const CommonParams& common, Session& sessio
         session.mStandaloneTasks.emplace_back(TaskInfo{ t->getName(), zone, agentGroup, topoParent, n });
     }
 
-    auto collections = ddsTopo.getMainGroup()->getElementsByType(CTopoBase::EType::COLLECTION);
+    auto collections = ddsTopo->getMainGroup()->getElementsByType(CTopoBase::EType::COLLECTION);
 
     for (const auto& collection : collections) {
         CTopoCollection::Ptr_t c = dynamic_pointer_cast<CTopoCollection>(collection);
@@ -1036,7 +1777,7 @@ void Controller::extractRequirements(const CommonParams& common, Session& sessio
         }
     }
 
-    auto colIt = ddsTopo.getRuntimeCollectionIterator();
+    auto colIt = ddsTopo->getRuntimeCollectionIterator();
 
     std::for_each(colIt.first, colIt.second, [&](const dds::topology_api::STopoRuntimeCollection::FilterIterator_t::value_type& v) {
         auto& col = v.second;
@@ -1090,7 +1831,7 @@ bool Controller::createDDSTopology(const CommonParams& common, Session& session,
 {
     using namespace dds::topology_api;
     try {
-        session.mDDSTopo = make_unique<CTopology>(session.mTopoFilePath);
+        session.mDDSTopo = session.getParsedTopology(session.mTopoFilePath);
         OLOG(info, common) << "DDS CTopology for " << quoted(session.mTopoFilePath) << " created successfully";
     } catch (exception& e) {
         fillAndLogError(common, error, ErrorCode::DDSCreateTopologyFailed, toString("Failed to initialize DDS topology: ", e.what()));
@@ -1103,10 +1844,21 @@ bool Controller::createTopology(const CommonParams& common, Partition& partition
 {
     try {
         partition.mTopology = make_unique<Topology>(*(partition.mSession->mDDSTopo), *(partition.mSession), false);
+        partition.mTopology->SetFailFast(mFailFast);
+        partition.mTopology->SetStragglerPolicy(mStragglerPolicy);
     } catch (exception& e) {
         partition.mTopology = nullptr;
         fillAndLogError(common, error, ErrorCode::FairMQCreateTopologyFailed, toString("Failed to initialize FairMQ topology: ", e.what()));
     }
+
+    if (partition.mTopology != nullptr && !mDirectChannelHost.empty()) {
+        try {
+            partition.mTopology->EnableDirectChannel(mDirectChannelHost);
+        } catch (exception& e) {
+            // not fatal, device communication continues via DDS
+            OLOG(warning, common) << "Failed to open direct channel on " << quoted(mDirectChannelHost) << ": " << e.what();
+        }
+    }
     return partition.mTopology != nullptr;
 }
 
@@ -1116,7 +1868,42 @@ bool Controller::resetTopology(Partition& partition)
     return true;
 }
 
-bool Controller::changeState(const CommonParams& common, Partition& partition, Error& error, const string& path, TopoTransition transition, TopologyState& topologyState)
+void Controller::asyncChangeState(const CommonParams& common, Partition& partition, Error& error, const string& path, TopoTransition transition, TopologyState& topologyState, function<void(bool)> next)
+{
+    auto step = make_shared<StateStep>();
+    if (!beginChangeState(common, partition, error, path, transition, *step)) {
+        next(false);
+        return;
+    }
+
+    try {
+        partition.mTopology->AsyncChangeState(transition, path, step->mTimeout, [this, &common, &partition, &error, &topologyState, transition, step, next](std::error_code errorCode, TopoState topoState) {
+            // the topology completes its operations with its state locked, continue on the thread pool
+            postExec([this, &common, &partition, &error, &topologyState, transition, step, next, errorCode, topoState = std::move(topoState)]() {
+                next(endChangeState(common, partition, error, transition, *step, errorCode, topoState, topologyState));
+            });
+        });
+    } catch (...) {
+        next(failStateChange(common, partition, error, step->mExpState));
+    }
+}
+
+void Controller::asyncChangeStates(const CommonParams& common, Partition& partition, Error& error, const string& path, const vector<TopoTransition>& transitions, size_t index, TopologyState& topologyState, function<void(bool)> next)
+{
+    if (index == transitions.size()) {
+        next(true);
+        return;
+    }
+    asyncChangeState(common, partition, error, path, transitions.at(index), topologyState, [this, &common, &partition, &error, &topologyState, path, transitions, index, next](bool success) {
+        if (!success) {
+            next(false);
+            return;
+        }
+        asyncChangeStates(common, partition, error, path, transitions, index + 1, topologyState, next);
+    });
+}
+
+bool Controller::beginChangeState(const CommonParams& common, Partition& partition, Error& error, const string& path, TopoTransition transition, StateStep& step)
 {
     if (partition.mTopology == nullptr) {
         fillAndLogError(common, error, ErrorCode::FairMQChangeStateFailed, "FairMQ topology is not initialized");
@@ -1126,23 +1913,38 @@ bool Controller::changeState(const CommonParams& common, Partition& partition, E
     OLOG(info, common) << "Requesting transition " << toString(transition) << " for path " << quoted(path);
 
     auto it = gExpectedState.find(transition);
-    DeviceState expState{ it != gExpectedState.end() ? it->second : DeviceState::Undefined };
-    if (expState == DeviceState::Undefined) {
+    step.mExpState = it != gExpectedState.end() ? it->second : DeviceState::Undefined;
+    if (step.mExpState == DeviceState::Undefined) {
         fillAndLogError(common, error, ErrorCode::FairMQChangeStateFailed, toString("Unexpected FairMQ transition ", transition));
         return false;
     }
 
-    bool success = true;
-
     try {
-        auto [errorCode, topoState] = partition.mTopology->ChangeState(transition, path, requestTimeout(common, toString("ChangeState(", transition, ")")));
+        step.mName = toString("ChangeState(", transition, ")", path.empty() ? "" : " " + path);
+        tie(step.mTimeout, step.mAdaptive) = stepTimeout(common, partition, step.mName);
+        step.mStart = chrono::steady_clock::now();
+    } catch (...) {
+        return failStateChange(common, partition, error, step.mExpState);
+    }
+    return true;
+}
 
-        success = !errorCode;
-        if (!success) {
-            stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
+bool Controller::endChangeState(const CommonParams& common, Partition& partition, Error& error, TopoTransition transition, const StateStep& step, std::error_code errorCode, const TopoState& topoState, TopologyState& topologyState)
+{
+    bool success = !errorCode;
+
+    try {
+        if (success) {
+            recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart);
+        } else {
+            stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), step.mExpState);
             switch (static_cast<ErrorCode>(errorCode.value())) {
                 case ErrorCode::OperationTimeout:
-                    fillAndLogFatalError(common, error, ErrorCode::RequestTimeout, toString("Timed out waiting for ", transition, " transition"));
+                    recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart, true);
+                    fillAndLogFatalError(common, error, ErrorCode::RequestTimeout, toString("Timed out waiting for ", transition, " transition", step.mAdaptive ? " (adaptive deadline)" : ""));
+                    break;
+                case ErrorCode::TargetStateUnreachable:
+                    fillAndLogFatalError(common, error, ErrorCode::TargetStateUnreachable, toString(transition, " transition aborted, ", describeFailures(partition.mTopology->GetUnignorableFailures())));
                     break;
                 default:
                     fillAndLogFatalError(common, error, ErrorCode::FairMQChangeStateFailed, toString("Change state failed: ", errorCode.message()));
@@ -1160,6 +1962,21 @@ bool Controller::changeState(const CommonParams& common, Partition& partition, E
         }
 
         printStateStats(common, topoState);
+        printTransitionStats(common, partition, transition);
+    } catch (...) {
+        return failStateChange(common, partition, error, step.mExpState);
+    }
+
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return success;
+}
+
+bool Controller::failStateChange(const CommonParams& common, Partition& partition, Error& error, DeviceState expState)
+{
+    try {
+        throw;
     } catch (Error& e) {
         error = e;
         stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
@@ -1167,40 +1984,80 @@ bool Controller::changeState(const CommonParams& common, Partition& partition, E
     } catch (exception& e) {
         stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
         fillAndLogFatalError(common, error, ErrorCode::FairMQChangeStateFailed, toString("Change state failed: ", e.what()));
-        success = false;
     }
 
-    return success;
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return false;
 }
 
-bool Controller::waitForState(const CommonParams& common, Partition& partition, Error& error, const string& path, DeviceState expState)
+template<typename Selection>
+void Controller::asyncWaitForState(const CommonParams& common, Partition& partition, Error& error, const Selection& selection, DeviceState expState, function<void(bool)> next)
 {
     if (partition.mTopology == nullptr) {
         fillAndLogError(common, error, ErrorCode::FairMQWaitForStateFailed, "FairMQ topology is not initialized");
-        return false;
+        next(false);
+        return;
     }
 
-    OLOG(info, common) << "Waiting for the topology to reach " << expState << " state.";
-
-    bool success = false;
+    OLOG(info, common) << "Waiting for " << describeSelection(selection) << " to reach " << expState << " state.";
 
+    auto step = make_shared<StateStep>();
+    step->mExpState = expState;
     try {
-        auto [errorCode, failedDevices] = partition.mTopology->WaitForState(DeviceState::Undefined, expState, path, requestTimeout(common, toString("WaitForState(", expState, ")")));
+        step->mName = toString("WaitForState(", expState, ") ", describeSelection(selection));
+        tie(step->mTimeout, step->mAdaptive) = stepTimeout(common, partition, step->mName);
+        step->mStart = chrono::steady_clock::now();
+        partition.mTopology->AsyncWaitForState(DeviceState::Undefined, expState, selection, step->mTimeout, [this, &common, &partition, &error, step, next](std::error_code errorCode, FailedDevices) {
+            // the topology completes its operations with its state locked, continue on the thread pool
+            postExec([this, &common, &partition, &error, step, next, errorCode]() {
+                next(endWaitForState(common, partition, error, *step, errorCode));
+            });
+        });
+    } catch (...) {
+        next(failWaitForState(common, partition, error, expState));
+    }
+}
 
-        success = !errorCode;
-        if (!success) {
+bool Controller::endWaitForState(const CommonParams& common, Partition& partition, Error& error, const StateStep& step, std::error_code errorCode)
+{
+    const DeviceState expState = step.mExpState;
+    bool success = !errorCode;
+
+    try {
+        if (success) {
+            recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart);
+            OLOG(info, common) << "Topology state is now " << expState;
+        } else {
             stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
             switch (static_cast<ErrorCode>(errorCode.value())) {
                 case ErrorCode::OperationTimeout:
-                    fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timed out waiting for ", expState, " state"));
+                    recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart, true);
+                    fillAndLogError(common, error, ErrorCode::RequestTimeout, toString("Timed out waiting for ", expState, " state", step.mAdaptive ? " (adaptive deadline)" : ""));
+                    break;
+                case ErrorCode::TargetStateUnreachable:
+                    fillAndLogError(common, error, ErrorCode::TargetStateUnreachable, toString("Aborted waiting for ", expState, " state, ", describeFailures(partition.mTopology->GetUnignorableFailures())));
                     break;
                 default:
                     fillAndLogError(common, error, ErrorCode::FairMQWaitForStateFailed, toString("Failed waiting for ", expState, " state: ", errorCode.message()));
                     break;
             }
-        } else {
-            OLOG(info, common) << "Topology state is now " << expState;
         }
+    } catch (...) {
+        return failWaitForState(common, partition, error, expState);
+    }
+
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return success;
+}
+
+bool Controller::failWaitForState(const CommonParams& common, Partition& partition, Error& error, DeviceState expState)
+{
+    try {
+        throw;
     } catch (Error& e) {
         error = e;
         stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
@@ -1208,25 +2065,189 @@ bool Controller::waitForState(const CommonParams& common, Partition& partition,
     } catch (exception& e) {
         stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), expState);
         fillAndLogError(common, error, ErrorCode::FairMQChangeStateFailed, toString("Wait for state failed: ", e.what()));
-        success = false;
     }
 
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return false;
+}
+
+template<typename Selection>
+void Controller::asyncChangeStateSequence(const CommonParams& common, Partition& partition, Error& error, const Selection& selection, const vector<TopoTransition>& transitions, TopologyState& topologyState, function<void(bool)> next)
+{
+    if (transitions.empty()) {
+        next(true);
+        return;
+    }
+    auto step = make_shared<StateStep>();
+    if (!beginChangeStateSequence(common, partition, error, selection, transitions, *step)) {
+        next(false);
+        return;
+    }
+
+    try {
+        partition.mTopology->AsyncChangeStateSequence(transitions, selection, step->mTimeout, [this, &common, &partition, &error, &topologyState, transitions, step, next](std::error_code errorCode, TopoState topoState, PhaseTimings phaseTimings) {
+            // the topology completes its operations with its state locked, continue on the thread pool
+            postExec([this, &common, &partition, &error, &topologyState, transitions, step, next, errorCode, topoState = std::move(topoState), phaseTimings = std::move(phaseTimings)]() {
+                next(endChangeStateSequence(common, partition, error, transitions, *step, errorCode, topoState, phaseTimings, topologyState));
+            });
+        });
+    } catch (...) {
+        next(failStateChange(common, partition, error, step->mExpState));
+    }
+}
+
+template<typename Selection>
+bool Controller::beginChangeStateSequence(const CommonParams& common, Partition& partition, Error& error, const Selection& selection, const vector<TopoTransition>& transitions, StateStep& step)
+{
+    if (partition.mTopology == nullptr) {
+        fillAndLogError(common, error, ErrorCode::FairMQChangeStateFailed, "FairMQ topology is not initialized");
+        return false;
+    }
+
+    OLOG(info, common) << "Requesting pipelined transitions " << describeTransitions(transitions) << " for " << describeSelection(selection);
+
+    step.mExpState = gExpectedState.at(transitions.back());
+    try {
+        step.mName = toString("ChangeStateSequence(", describeTransitions(transitions), ") ", describeSelection(selection));
+        tie(step.mTimeout, step.mAdaptive) = stepTimeout(common, partition, step.mName);
+        step.mStart = chrono::steady_clock::now();
+    } catch (...) {
+        return failStateChange(common, partition, error, step.mExpState);
+    }
+    return true;
+}
+
+bool Controller::endChangeStateSequence(const CommonParams& common, Partition& partition, Error& error, const vector<TopoTransition>& transitions, const StateStep& step, std::error_code errorCode, const TopoState& topoState, const PhaseTimings& phaseTimings, TopologyState& topologyState)
+{
+    const string transitionsStr = describeTransitions(transitions);
+    bool success = !errorCode;
+
+    try {
+        if (success) {
+            recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart);
+        } else {
+            stateSummaryOnFailure(common, *(partition.mSession), partition.mTopology->GetCurrentState(), step.mExpState);
+            switch (static_cast<ErrorCode>(errorCode.value())) {
+                case ErrorCode::OperationTimeout:
+                    recordStep(partition, step.mName, chrono::steady_clock::now() - step.mStart, true);
+                    fillAndLogFatalError(common, error, ErrorCode::RequestTimeout, toString("Timed out waiting for ", transitionsStr, " transitions", step.mAdaptive ? " (adaptive deadline)" : ""));
+                    break;
+                case ErrorCode::TargetStateUnreachable:
+                    fillAndLogFatalError(common, error, ErrorCode::TargetStateUnreachable, toString(transitionsStr, " transitions aborted, ", describeFailures(partition.mTopology->GetUnignorableFailures())));
+                    break;
+                default:
+                    fillAndLogFatalError(common, error, ErrorCode::FairMQChangeStateFailed, toString("Change state failed: ", errorCode.message()));
+                    break;
+            }
+        }
+
+        if (topologyState.detailed.has_value()) {
+            partition.mSession->fillDetailedState(topoState, topologyState.detailed.value());
+        }
+
+        topologyState.aggregated = AggregateState(topoState);
+        if (success) {
+            OLOG(info, common) << "State changed to " << topologyState.aggregated << " via " << transitionsStr << " transitions";
+        }
+
+        printStateStats(common, topoState);
+        // phases overlap, report when each of them was completed by all devices
+        for (const auto& [transition, duration] : phaseTimings) {
+            OLOG(info, common) << transition << " completed by all devices after " << chrono::duration<double, milli>(duration).count() << " ms";
+        }
+        for (const auto& transition : transitions) {
+            printTransitionStats(common, partition, transition);
+        }
+    } catch (...) {
+        return failStateChange(common, partition, error, step.mExpState);
+    }
+
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
     return success;
 }
 
-bool Controller::changeStateConfigure(const CommonParams& common, Partition& partition, Error& error, const string& path, TopologyState& topologyState)
+void Controller::asyncChangeStateConfigure(const CommonParams& common, Partition& partition, Error& error, const string& path, TopologyState& topologyState, function<void(bool)> next)
+{
+    if (mPipelinedTransitions) {
+        asyncChangeStateSequence(common, partition, error, path, kConfigureTransitions, topologyState, std::move(next));
+    } else {
+        asyncChangeStates(common, partition, error, path, kConfigureTransitions, 0, topologyState, std::move(next));
+    }
+}
+
+void Controller::asyncChangeStateReset(const CommonParams& common, Partition& partition, Error& error, const string& path, TopologyState& topologyState, function<void(bool)> next)
 {
-    return changeState(common, partition, error, path, TopoTransition::InitDevice,   topologyState)
-        && changeState(common, partition, error, path, TopoTransition::CompleteInit, topologyState)
-        && changeState(common, partition, error, path, TopoTransition::Bind,         topologyState)
-        && changeState(common, partition, error, path, TopoTransition::Connect,      topologyState)
-        && changeState(common, partition, error, path, TopoTransition::InitTask,     topologyState);
+    if (mPipelinedTransitions) {
+        asyncChangeStateSequence(common, partition, error, path, kResetTransitions, topologyState, std::move(next));
+    } else {
+        asyncChangeStates(common, partition, error, path, kResetTransitions, 0, topologyState, std::move(next));
+    }
 }
 
-bool Controller::changeStateReset(const CommonParams& common, Partition& partition, Error& error, const string& path, TopologyState& topologyState)
+void Controller::asyncUpdateTopologyDiff(const CommonParams& common, Partition& partition, Error& error, TopologyState& topologyState, function<void(bool)> next)
 {
-    return changeState(common, partition, error, path, TopoTransition::ResetTask,   topologyState)
-        && changeState(common, partition, error, path, TopoTransition::ResetDevice, topologyState);
+    using EUpdateType = dds::tools_api::STopologyRequest::request_t::EUpdateType;
+    Session& session = *(partition.mSession);
+    // the FairMQ topology refers to the current DDS topology until it is updated
+    shared_ptr<dds::topology_api::CTopology> currentTopo = session.mDDSTopo;
+
+    auto diff = make_shared<TopologyDiff>();
+    try {
+        *diff = Topology::Diff(*currentTopo, *(session.getParsedTopology(session.mTopoFilePath)));
+    } catch (exception& e) {
+        fillAndLogError(common, error, ErrorCode::DDSCreateTopologyFailed, toString("Failed to compare the current and the new topology: ", e.what()));
+        next(false);
+        return;
+    }
+    OLOG(info, common) << "Differential update: " << diff->removed.size() << " task(s) removed, " << diff->added.size() << " added, " << diff->unchanged << " unchanged";
+
+    runSteps({
+        // removed tasks are reset, so that their exit is expected
+        [this, &common, &partition, &error, &topologyState, diff](function<void(bool)> then) {
+            if (diff->removed.empty()) {
+                then(true);
+                return;
+            }
+            asyncChangeStateSequence(common, partition, error, diff->removed, kResetTransitions, topologyState, then);
+        },
+        [this, &common, &session, &error](function<void(bool)> then) { asyncActivateDDSTopology(common, session, error, EUpdateType::UPDATE, then); },
+        [this, &common, &partition, &session, &error, diff, currentTopo](function<void(bool)> then) {
+            if (!createDDSTopology(common, session, error)) {
+                then(false);
+                return;
+            }
+            try {
+                partition.mTopology->ApplyUpdate(*(session.mDDSTopo), *diff);
+            } catch (exception& e) {
+                fillAndLogError(common, error, ErrorCode::FairMQCreateTopologyFailed, toString("Failed to update FairMQ topology: ", e.what()));
+                then(false);
+                return;
+            }
+            then(true);
+        },
+        [this, &common, &partition, &error, diff](function<void(bool)> then) {
+            if (diff->added.empty()) {
+                then(true);
+                return;
+            }
+            asyncWaitForState(common, partition, error, diff->added, DeviceState::Idle, then);
+        },
+        [this, &common, &partition, &error, &topologyState, diff](function<void(bool)> then) {
+            if (diff->added.empty()) {
+                then(true);
+                return;
+            }
+            asyncChangeStateSequence(common, partition, error, diff->added, kConfigureTransitions, topologyState, then);
+        },
+        [this, &common, &partition, &error, &topologyState](function<void(bool)> then) {
+            getState(common, partition, error, "", topologyState);
+            then(true);
+        }
+    }, std::move(next));
 }
 
 void Controller::getState(const CommonParams& common, Partition& partition, Error& error, const string& path, TopologyState& topologyState)
@@ -1250,15 +2271,29 @@ void Controller::getState(const CommonParams& common, Partition& partition, Erro
     printStateStats(common, topoState, true);
 }
 
-bool Controller::setProperties(const CommonParams& common, Partition& partition, Error& error, const string& path, const SetPropertiesParams::Props& props, TopologyState& topologyState)
+void Controller::asyncSetProperties(const CommonParams& common, Partition& partition, Error& error, const string& path, const SetPropertiesParams::Props& props, TopologyState& topologyState, function<void(bool)> next)
 {
     if (partition.mTopology == nullptr) {
         fillAndLogError(common, error, ErrorCode::FairMQSetPropertiesFailed, "FairMQ topology is not initialized");
-        return false;
+        next(false);
+        return;
+    }
+
+    try {
+        partition.mTopology->AsyncSetProperties(props, path, requestTimeout(common, "SetProperties"), [this, &common, &partition, &error, &topologyState, next](std::error_code errorCode, FailedDevices failedDevices) {
+            // the topology completes its operations with its state locked, continue on the thread pool
+            postExec([this, &common, &partition, &error, &topologyState, next, errorCode, failedDevices = std::move(failedDevices)]() {
+                next(endSetProperties(common, partition, error, errorCode, failedDevices, topologyState));
+            });
+        });
+    } catch (...) {
+        next(failSetProperties(common, partition, error));
     }
+}
 
+bool Controller::endSetProperties(const CommonParams& common, Partition& partition, Error& error, std::error_code errorCode, const FailedDevices& failedDevices, TopologyState& topologyState)
+{
     try {
-        auto [errorCode, failedDevices] = partition.mTopology->SetProperties(props, path, requestTimeout(common, "SetProperties"));
         if (!errorCode) {
             OLOG(info, common) << "Set property finished successfully";
         } else {
@@ -1279,6 +2314,20 @@ bool Controller::setProperties(const CommonParams& common, Partition& partition,
         }
 
         topologyState.aggregated = AggregateState(partition.mTopology->GetCurrentState());
+    } catch (...) {
+        return failSetProperties(common, partition, error);
+    }
+
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return !error.mCode;
+}
+
+bool Controller::failSetProperties(const CommonParams& common, Partition& partition, Error& error)
+{
+    try {
+        throw;
     } catch (Error& e) {
         error = e;
         OLOG(error, common) << "Set properties failed: " << e;
@@ -1286,7 +2335,10 @@ bool Controller::setProperties(const CommonParams& common, Partition& partition,
         fillAndLogError(common, error, ErrorCode::FairMQSetPropertiesFailed, toString("Set properties failed: ", e.what()));
     }
 
-    return !error.mCode;
+    // collections dropped under nMin while handling the request
+    accountShutdownAgents(common, partition);
+
+    return false;
 }
 
 AggregatedState Controller::aggregateStateForPath(const dds::topology_api::CTopology* ddsTopo, const TopoState& topoState, const string& path)
@@ -1389,6 +2441,7 @@ Partition& Controller::acquirePartition(const CommonParams& common)
         auto ret = mPartitions.try_emplace(common.mPartitionID, Partition(common.mPartitionID));
         ret.first->second.mSession = make_unique<Session>();
         ret.first->second.mSession->mPartitionID = common.mPartitionID;
+        logAgentChanges(*(ret.first->second.mSession));
         // OLOG(debug, common) << "Created partition " << quoted(common.mPartitionID);
         return ret.first->second;
     }
@@ -1407,6 +2460,61 @@ void Controller::removePartition(const CommonParams& common)
     }
 }
 
+boost::asio::thread_pool::executor_type Controller::getExecExecutor()
+{
+    lock_guard<mutex> lock(mExecMtx);
+    if (!mExecPool) {
+        mExecPool = make_unique<boost::asio::thread_pool>(mExecThreads > 0 ? mExecThreads : max(1U, thread::hardware_concurrency()));
+    }
+    return mExecPool->get_executor();
+}
+
+void Controller::postExec(function<void()> func)
+{
+    boost::asio::post(getExecExecutor(), std::move(func));
+}
+
+void Controller::queueExec(const string& partitionID, ExecStart start)
+{
+    if (partitionID.empty()) {
+        postExec([start = std::move(start)]() { start([]() {}); });
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mExecMtx);
+        auto& queue = mExecQueues[partitionID];
+        queue.push_back(std::move(start));
+        if (queue.size() > 1) {
+            // started when the requests queued before it completed
+            return;
+        }
+    }
+    startExec(partitionID);
+}
+
+void Controller::startExec(const string& partitionID)
+{
+    postExec([this, partitionID]() {
+        ExecStart start;
+        {
+            lock_guard<mutex> lock(mExecMtx);
+            start = mExecQueues.at(partitionID).front();
+        }
+        start([this, partitionID]() {
+            {
+                lock_guard<mutex> lock(mExecMtx);
+                auto it = mExecQueues.find(partitionID);
+                it->second.pop_front();
+                if (it->second.empty()) {
+                    mExecQueues.erase(it);
+                    return;
+                }
+            }
+            startExec(partitionID);
+        });
+    });
+}
+
 void Controller::stateSummaryOnFailure(const CommonParams& common, Session& session, const TopoState& topoState, DeviceState expectedState)
 {
     std::vector<CollectionDetails*> failedCollections;
@@ -1452,119 +2560,109 @@ void Controller::stateSummaryOnFailure(const CommonParams& common, Session& sess
             }
         }
 
-        size_t numOkTasks = session.mTaskDetails.size() - numFailedTasks;
-        size_t numOkCollections = session.mCollectionDetails.size() - failedCollections.size();
+        size_t numOkTasks = session.numTaskDetails() - numFailedTasks;
+        size_t numOkCollections = session.numCollectionDetails() - failedCollections.size();
         OLOG(error, common) << "Summary after transitioning to " << expectedState << " state:";
-        OLOG(error, common) << "  [tasks] total: " << session.mTaskDetails.size() << ", successful: " << numOkTasks << ", failed: " << numFailedTasks;
-        OLOG(error, common) << "  [collections] total: " << session.mCollectionDetails.size() << ", successful: " << numOkCollections << ", failed: " << failedCollections.size();
+        OLOG(error, common) << "  [tasks] total: " << session.numTaskDetails() << ", successful: " << numOkTasks << ", failed: " << numFailedTasks;
+        OLOG(error, common) << "  [collections] total: " << session.numCollectionDetails() << ", successful: " << numOkCollections << ", failed: " << failedCollections.size();
     } catch (const exception& e) {
         OLOG(error, common) << "State summary error: " << e.what();
     }
 }
 
-void Controller::ShutdownDDSAgent(const CommonParams& common, Session& session, uint64_t agentID)
+void Controller::waitForAgentShutdown(const CommonParams& common, Session& session, const unordered_set<uint64_t>& agentIDs)
 {
+    if (agentIDs.empty()) {
+        return;
+    }
+
     try {
-        size_t currentSlotCount = session.mTotalSlots;
-        size_t numSlotsToRemove = session.mAgentSlots.at(agentID);
-        size_t expectedNumSlots = session.mTotalSlots - numSlotsToRemove;
-        OLOG(info, common) << "Current number of slots: " << session.mTotalSlots << ", expecting to reduce to " << expectedNumSlots;
-
-        using namespace dds::tools_api;
-        OLOG(info, common) << "Sending shutdown signal to agent " << agentID;;
-        SAgentCommandRequest::request_t agentCmd;
-        agentCmd.m_commandType = SAgentCommandRequestData::EAgentCommandType::shutDownByID;
-        agentCmd.m_arg1 = agentID;
-        session.mDDSSession.syncSendRequest<SAgentCommandRequest>(agentCmd, requestTimeout(common, "ShutdownDDSAgent..syncSendRequest<SAgentCommandRequest>"));
-
-        // TODO: notification on agent shutdown in development in DDS
-        currentSlotCount = getNumSlots(common, session);
-        OLOG(info, common) << "Current number of slots: " << currentSlotCount;
-
-        if (currentSlotCount != expectedNumSlots) {
-            int64_t secondsLeft = requestTimeout(common, "ShutdownDDSAgent..measure remaining time").count();
-            if (secondsLeft > 0) {
-                int64_t maxAttempts = (secondsLeft * 1000) / 50;
-                while (currentSlotCount != expectedNumSlots && maxAttempts > 0) {
-                    this_thread::sleep_for(chrono::milliseconds(50));
-                    currentSlotCount = getNumSlots(common, session);
-                    // OLOG(info, common) << "Current number of slots: " << currentSlotCount;
-                    --maxAttempts;
-                }
-            }
+        size_t numSlotsToRemove = 0;
+        for (const auto agentID : agentIDs) {
+            numSlotsToRemove += session.mAgentInventory.slots(agentID);
         }
-        if (currentSlotCount != expectedNumSlots) {
+        const size_t expectedNumSlots = session.mTotalSlots > numSlotsToRemove ? session.mTotalSlots - numSlotsToRemove : 0;
+        OLOG(info, common) << "Waiting for " << agentIDs.size() << " agent(s) to shut down, expecting to reduce the number of slots from " << session.mTotalSlots << " to " << expectedNumSlots;
+
+        const auto deadline = chrono::steady_clock::now() + requestTimeout(common, "waitForAgentShutdown");
+
+        // TODO: notification on agent shutdown in development in DDS, until then wait for the slot count with a growing interval
+        uint32_t currentSlotCount = getNumSlots(common, session);
+        chrono::milliseconds interval(50);
+        while (currentSlotCount > expectedNumSlots && chrono::steady_clock::now() + interval < deadline) {
+            this_thread::sleep_for(interval);
+            interval = min(interval * 2, chrono::milliseconds(1000));
+            currentSlotCount = getNumSlots(common, session);
+        }
+        if (currentSlotCount > expectedNumSlots) {
             OLOG(warning, common) << "Could not reduce the number of slots to " << expectedNumSlots << ", current count is: " << currentSlotCount;
         } else {
             OLOG(info, common) << "Successfully reduced number of slots to " << currentSlotCount;
         }
+
+        session.mAgentInventory.remove(agentIDs, currentSlotCount);
         session.mTotalSlots = currentSlotCount;
     } catch (Error& e) {
         OLOG(error, common) << "Agent Shutdown failed: " << e;
     } catch (exception& e) {
-        OLOG(error, common) << "Failed updating nubmer of slots: " << e.what();
+        OLOG(error, common) << "Agent Shutdown failed: " << e.what();
     }
 }
 
-dds::tools_api::SAgentInfoRequest::responseVector_t Controller::getAgentInfo(const CommonParams& common, Session& session) const
+void Controller::accountShutdownAgents(const CommonParams& common, Partition& partition)
 {
-    using namespace dds::tools_api;
-    SAgentInfoRequest::responseVector_t agentInfo;
-    SAgentInfoRequest::request_t infoRequest;
-    SAgentInfoRequest::ptr_t requestPtr = SAgentInfoRequest::makeRequest(infoRequest);
-
-    bool done = false;
-    mutex mtx;
-    condition_variable cv;
-
-    requestPtr->setResponseCallback([&agentInfo](const SAgentInfoResponseData& response) {
-        agentInfo.push_back(response);
-    });
-
-    requestPtr->setMessageCallback([&common](const SMessageResponseData& msg) {
-        if (msg.m_severity == dds::intercom_api::EMsgSeverity::error) {
-            OLOG(error, common) << "DDS Failed to collect agent info agents: " << msg.m_msg;
-        } else {
-            OLOG(info, common) << "DDS Server reports: " << msg.m_msg;
-        }
-    });
-
-    requestPtr->setDoneCallback([&mtx, &cv, &done]() {
-        {
-            lock_guard<mutex> lock(mtx);
-            done = true;
-        }
-        cv.notify_all();
-    });
+    if (partition.mTopology != nullptr) {
+        waitForAgentShutdown(common, *(partition.mSession), partition.mTopology->TakeShutdownAgents());
+    }
+}
 
-    session.mDDSSession.sendRequest<SAgentInfoRequest>(requestPtr);
+uint32_t Controller::getNumSlots(const CommonParams& common, Session& session) const
+{
+    using namespace dds::tools_api;
+    DDSRequest<SAgentCountRequest> request;
+    auto reply = request.send(session.mDDSSession).get(requestTimeout(common, "getNumSlots"));
+    if (reply.responses.empty()) {
+        throw runtime_error("No agent count received");
+    }
+    return reply.responses.front().m_activeSlotsCount;
+}
 
-    try {
-        unique_lock<mutex> lock(mtx);
-        cv.wait_for(lock, requestTimeout(common, "wait_for lock in getAgentInfo"), [&done]{ return done; });
+const AgentInventory& Controller::getAgentInventory(const CommonParams& common, Session& session, chrono::milliseconds maxAge /* = 0 */) const
+{
+    using namespace dds::tools_api;
+    AgentInventory& inventory = session.mAgentInventory;
+    if (inventory.valid() && inventory.age() <= maxAge) {
+        return inventory;
+    }
 
-        if (!done) {
-            OLOG(error, common) << "Timed out waiting for DDS agent info";
+    const auto deadline = chrono::steady_clock::now() + requestTimeout(common, "getAgentInventory");
+    // the slot count is cheap, the agents are listed only if it changed (or the listing is too old), both requests are processed concurrently by DDS
+    const bool listAgents = !inventory.valid() || inventory.age() > kAgentListingMaxAge;
+    DDSRequest<SAgentCountRequest> countRequest;
+    countRequest.send(session.mDDSSession);
+    optional<DDSRequest<SAgentInfoRequest>> infoRequest;
+    if (listAgents) {
+        infoRequest.emplace().send(session.mDDSSession);
+    }
 
-            requestPtr->unsubscribeAll();
-        } else {
-            // OLOG(info, common) << "Agent submission done successfully";
-        }
-    } catch (Error& e) {
-        OLOG(error, common) << "Agent submission error: " << e;
+    auto countReply = countRequest.get(deadline);
+    if (countReply.responses.empty()) {
+        throw runtime_error("No agent count received");
+    }
+    const auto& slots = countReply.responses.front();
+    if (!listAgents && inventory.confirm(slots)) {
+        return inventory;
     }
 
-    // session.mDDSSession.syncSendRequest<SAgentInfoRequest>(SAgentInfoRequest::request_t(), agentInfo, requestTimeout(common, "getAgentInfo..syncSendRequest<SAgentInfoRequest>"));
-    return agentInfo;
+    if (!infoRequest) {
+        infoRequest.emplace().send(session.mDDSSession);
+    }
+    auto infoReply = infoRequest->get(deadline);
+    logDDSMessages(common, infoReply, "DDS Failed to collect agent info: ");
+    inventory.update(infoReply.responses, slots);
+    return inventory;
 }
 
-uint32_t Controller::getNumSlots(const CommonParams& common, Session& session) const
-{
-    using namespace dds::tools_api;
-    SAgentCountRequest::response_t agentCountInfo;
-    session.mDDSSession.syncSendRequest<SAgentCountRequest>(SAgentCountRequest::request_t(), agentCountInfo, requestTimeout(common, "getNumSlots..syncSendRequest<SAgentCountRequest>"));
-    return agentCountInfo.m_activeSlotsCount;
-}
 
 string Controller::topoFilepath(const CommonParams& common, const string& topologyFile, const string& topologyContent, const string& topologyScript)
 {
@@ -1579,7 +2677,11 @@ string Controller::topoFilepath(const CommonParams& common, const string& topolo
     string content{ topologyContent };
 
     // Execute topology script if needed
-    if (!topologyScript.empty()) {
+    optional<string> cached = topologyScript.empty() ? nullopt : mTopoScriptCache.get(topologyScript);
+    if (cached) {
+        OLOG(info, common) << "Using cached result of topology generation script: " << topologyScript;
+        content = std::move(*cached);
+    } else if (!topologyScript.empty()) {
         string out;
         string err;
         int exitCode = EXIT_SUCCESS;
@@ -1603,20 +2705,12 @@ string Controller::topoFilepath(const CommonParams& common, const string& topolo
 
         OLOG(info, common) << "Topology generation script successfull. stderr: " << quoted(err) << ", stdout: " << quoted(shortOut) << shortSuffix;
 
+        mTopoScriptCache.put(topologyScript, out);
         content = out;
     }
 
-    // Create temp topology file with `content`
-    const bfs::path tmpPath{ bfs::temp_directory_path() / bfs::unique_path() };
-    bfs::create_directories(tmpPath);
-    const bfs::path filepath{ tmpPath / "topology.xml" };
-    ofstream file(filepath.string());
-    if (!file.is_open()) {
-        throw runtime_error(toString("Failed to create temporary topology file ", quoted(filepath.string())));
-    }
-    file << content;
-    OLOG(info, common) << "Temp topology file " << quoted(filepath.string()) << " created successfully";
-    return filepath.string();
+    // Store topology file with `content`, identical content is stored only once
+    return mTopoStore.add(common.mPartitionID, content);
 }
 
 void Controller::registerResourcePlugins(const DDSSubmit::PluginMap& pluginMap)
@@ -1633,6 +2727,9 @@ void Controller::restore(const string& id, const string& dir)
 
     OLOG(info) << "Restoring sessions for " << quoted(id);
     auto data{ RestoreFile(id, dir).read() };
+    for (const auto& sessionID : data.mPooledSessions) {
+        mSessionPool.adopt(sessionID);
+    }
     for (const auto& v : data.mPartitions) {
         OLOG(info, v.mPartitionID, 0) << "Restoring (" << quoted(v.mPartitionID) << "/" << quoted(v.mDDSSessionId) << ")";
         auto result{ execInitialize(CommonParams(v.mPartitionID, 0, 0), InitializeParams(v.mDDSSessionId)) };
@@ -1699,3 +2796,29 @@ void Controller::printStateStats(const CommonParams& common, const TopoState& to
         OLOG(info, common) << ss.str();
     }
 }
+
+void Controller::printTransitionStats(const CommonParams& common, Partition& partition, TopoTransition transition, size_t numSlowest /* = 5 */)
+{
+    TransitionStats stats = ComputeTransitionStats(partition.mTopology->GetTransitionTimings(transition), numSlowest);
+    if (stats.numDevices == 0) {
+        OLOG(debug, common) << "No devices reported the duration of the " << transition << " transition";
+        return;
+    }
+
+    auto toMs = [](Duration d) { return chrono::duration<double, milli>(d).count(); };
+
+    OLOG(info, common) << transition << " transition duration (" << stats.numDevices << " devices):"
+                       << " p50: " << toMs(stats.p50) << " ms"
+                       << ", p99: " << toMs(stats.p99) << " ms"
+                       << ", max: " << toMs(stats.max) << " ms";
+
+    OLOG(info, common) << "Slowest " << stats.slowest.size() << " device(s) in " << transition << ":";
+    for (const auto& [taskId, duration] : stats.slowest) {
+        const TaskDetails* taskDetails = partition.mSession->findTaskDetails(taskId);
+        if (taskDetails != nullptr) {
+            OLOG(info, common) << "  " << toMs(duration) << " ms, task: " << taskId << ", path: " << taskDetails->mPath << ", host: " << taskDetails->mHost;
+        } else {
+            OLOG(info, common) << "  " << toMs(duration) << " ms, task: " << taskId;
+        }
+    }
+}
@@ -12,16 +12,35 @@
 #include <odc/DDSSubmit.h>
 #include <odc/Params.h>
 #include <odc/Session.h>
+#include <odc/SessionPool.h>
 #include <odc/Topology.h>
+#include <odc/TopoScriptCache.h>
+#include <odc/TopologyStore.h>
+#include <odc/TransitionHistory.h>
 
 #include <dds/Tools.h>
 #include <dds/Topology.h>
 
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 namespace odc::core
 {
@@ -41,6 +60,15 @@ class Controller
 {
   public:
     Controller() {}
+    /// Waits for the asynchronous requests in progress
+    ~Controller()
+    {
+        if (mExecPool) {
+            mExecPool->join();
+        }
+        // without a restore file the idle sessions could not be reused by the next instance
+        mSessionPool.stop(mRestoreId.empty());
+    }
     // Disable copy constructors and assignment operators
     Controller(const Controller&) = delete;
     Controller(Controller&&) = delete;
@@ -54,6 +82,9 @@ class Controller
     /// \brief Register resource plugins
     /// \param [in] pluginMap Map of plugin name to path
     void registerResourcePlugins(const PluginManager::PluginMap& pluginMap);
+    /// \brief Keep resource plugins running between requests, instead of executing them once per request. Plugins that do not support it are executed once per request.
+    /// \param [in] persistent true to enable persistent resource plugins
+    void setPersistentPlugins(bool persistent) { mSubmit.setPersistent(persistent); }
 
     /// \brief Restore sessions for the specified ID
     ///  The function has to be called before the service start accepting request.
@@ -61,9 +92,13 @@ class Controller
     /// \param [in] dir directory to store restore files in
     void restore(const std::string& id, const std::string& dir);
 
-    /// \brief Set directory where history file is stored
+    /// \brief Set directory where history file is stored, along with the completion times of previous state changes
     /// \param [in] dir directory path
-    void setHistoryDir(const std::string& dir) { mHistoryDir = dir; }
+    void setHistoryDir(const std::string& dir)
+    {
+        mHistoryDir = dir;
+        mTransitionHistory.setFile(dir.empty() ? "" : toString(dir, "/odc_transition_history.json"));
+    }
 
     /// \brief Set zone configs
     /// \param [in] zonesStr string representations of zone configs: "<name>:<cfgFilePath>:<envFilePath>"
@@ -73,6 +108,76 @@ class Controller
     /// \param [in] rms name of the RMS
     void setRMS(const std::string& rms) { mRMS = rms; }
 
+    /// \brief Enable the direct controller <-> device channel
+    /// \param [in] host host name or address of this machine to listen on, must be reachable from the devices. Empty disables the channel.
+    void setDirectChannelHost(const std::string& host) { mDirectChannelHost = host; }
+
+    /// \brief Pipeline Configure and Reset transitions per device, instead of waiting for all devices after each transition
+    /// \param [in] pipelined true to enable pipelining
+    void setPipelinedTransitions(bool pipelined) { mPipelinedTransitions = pipelined; }
+
+    /// \brief Set the maximum number of DDS agent submissions in flight at the same time
+    /// \param [in] window maximum number of concurrent submissions
+    void setSubmitWindow(size_t window) { mSubmitWindow = window; }
+
+    /// \brief During Run, activate the tasks of agent groups that are ready while the remaining groups are still being allocated
+    /// \param [in] streaming true to enable streaming activation
+    void setStreamingActivation(bool streaming) { mStreamingActivation = streaming; }
+
+    /// \brief On Update, reset and reconfigure only the tasks that were removed, added or modified, instead of the whole topology
+    /// \param [in] differential true to enable differential updates
+    void setDifferentialUpdate(bool differential) { mDifferentialUpdate = differential; }
+
+    /// \brief Abort pending state changes as soon as a device fails that cannot be ignored (e.g. nMin of its collection is violated), instead of waiting for the request timeout
+    /// \param [in] failFast true to enable the fail-fast policy
+    void setFailFast(bool failFast) { mFailFast = failFast; }
+
+    /// \brief Shed the devices that are late to complete Configure/Start/Stop/Reset/Terminate, if they are expendable or nMin allows to lose their collections
+    /// \param [in] fraction fraction of the devices that must complete before stragglers are shed, 0 disables the shedding
+    /// \param [in] latencyFactor time budget of the remaining devices, relative to the p95 latency of the completed devices
+    /// \throw std::runtime_error if the fraction is not in [0, 1] or the latency factor is negative
+    void setStragglerPolicy(double fraction, double latencyFactor)
+    {
+        // a fraction above 1 is never reached, it would silently disable the shedding
+        if (fraction < 0 || fraction > 1) {
+            throw std::runtime_error(toString("Straggler fraction must be in [0, 1], got ", fraction));
+        }
+        if (latencyFactor < 0) {
+            throw std::runtime_error(toString("Straggler latency factor must not be negative, got ", latencyFactor));
+        }
+        mStragglerPolicy = StragglerPolicy{ fraction, latencyFactor };
+    }
+
+    /// \brief Set adaptive deadlines of the state change steps, derived from the completion times of the same steps in previous requests
+    /// \param [in] factor deadline of a step relative to the p99 of its previous completion times, 0 disables adaptive deadlines
+    void setAdaptiveTimeout(double factor) { mAdaptiveTimeoutFactor = factor; }
+
+    /// \brief Set directory of the topology store, where topology content and generated topologies are kept
+    /// \param [in] dir directory path
+    void setTopologyStoreDir(const std::string& dir) { mTopoStore.setDir(dir); }
+
+    /// \brief Configure the cache of topology generation script results
+    /// \param [in] ttl time to live of cached results in seconds, 0 disables the cache
+    /// \param [in] maxBytes maximum total size of cached results
+    /// \param [in] envVars environment variables that are part of the cache key, in addition to the script command line
+    /// \param [in] inputFiles input files whose modification times are part of the cache key
+    void setTopoScriptCache(size_t ttl, size_t maxBytes, const std::vector<std::string>& envVars, const std::vector<std::string>& inputFiles)
+    {
+        mTopoScriptCache.setTTL(std::chrono::seconds(ttl));
+        mTopoScriptCache.setMaxBytes(maxBytes);
+        mTopoScriptCache.setEnvVars(envVars);
+        mTopoScriptCache.setInputFiles(inputFiles);
+    }
+
+    /// \brief Set number of idle DDS sessions created in advance in the background, to be claimed by Initialize and Run.
+    /// Call after restore(), pooled sessions recorded in the restore file are reused (or shut down if above the size).
+    /// \param [in] size number of idle sessions, 0 disables the pool
+    void setSessionPoolSize(size_t size)
+    {
+        mSessionPool.setChangeCallback([this]() { updateRestore(); });
+        mSessionPool.setSize(size);
+    }
+
     // DDS topology and session requests
 
     /// \brief Initialize DDS session
@@ -110,8 +215,139 @@ class Controller
     StatusRequestResult execStatus(const StatusParams& params);
 
     static void extractRequirements(const CommonParams& common, Session& session);
+    /// \brief Check whether the agents can run the topology of the session without a new submission
+    static bool agentsSatisfyRequirements(const CommonParams& common, Session& session, const AgentInventory& inventory);
+
+    // Asynchronous requests.
+    // The handler is called with the result on its associated executor, or on the thread pool of the controller.
+    // Requests for the same partition are executed in the order of their initiation, one at a time, the synchronous exec* requests included.
+    // The requests are continuation chains, no thread waits for DDS or for the devices: submitting the agents, waiting for their slots,
+    // activating the topology and waiting for the devices continue on the thread pool once DDS or the topology completed the step.
+    // Steps that do not wait for agents or devices are executed in one go on the thread pool: creating, attaching to and shutting down
+    // the DDS session, running resource plugins and topology scripts, listing the agents, and waiting for the agents shut down after
+    // their collections were dropped (nMin).
+    // The synchronous exec* requests wait for their asynchronous counterparts, they must not be called from the thread pool.
+
+    /// \brief Set number of threads executing asynchronous requests, must be called before the first asynchronous request
+    /// \param [in] numThreads number of threads, 0 uses the number of hardware threads
+    void setExecThreads(size_t numThreads) { mExecThreads = numThreads; }
+
+    template<typename CompletionToken>
+    auto asyncExecInitialize(const CommonParams& common, const InitializeParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateInitialize(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecSubmit(const CommonParams& common, const SubmitParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateSubmit(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecActivate(const CommonParams& common, const ActivateParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateActivate(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecRun(const CommonParams& common, const RunParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateRun(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecUpdate(const CommonParams& common, const UpdateParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateUpdate(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecShutdown(const CommonParams& common, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common](std::function<void(RequestResult)> done) { initiateShutdown(common, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecSetProperties(const CommonParams& common, const SetPropertiesParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateSetProperties(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecGetState(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateGetState(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecConfigure(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateConfigure(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecStart(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateStart(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecStop(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateStop(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecReset(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateReset(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecTerminate(const CommonParams& common, const DeviceParams& params, CompletionToken&& token)
+    {
+        return asyncExecChain<RequestResult>(common.mPartitionID, [this, common, params](std::function<void(RequestResult)> done) { initiateTerminate(common, params, std::move(done)); }, std::forward<CompletionToken>(token));
+    }
+    template<typename CompletionToken>
+    auto asyncExecStatus(const StatusParams& params, CompletionToken&& token)
+    {
+        // not bound to a partition
+        return asyncExec<StatusRequestResult>("", [this, params]() { return execStatus(params); }, std::forward<CompletionToken>(token));
+    }
 
   private:
+    using ExecDone = std::function<void()>;            ///< called when a request completed
+    using ExecStart = std::function<void(ExecDone)>;   ///< starts a request
+
+    // Initiate a request that completes by calling the function it is given, possibly from another thread
+    template<typename Result, typename Func, typename CompletionToken>
+    auto asyncExecChain(const std::string& partitionID, Func&& func, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, void(Result)>(
+            [this, partitionID](auto handler, auto f) {
+                auto executor = getExecExecutor();
+                auto work = boost::asio::make_work_guard(boost::asio::get_associated_executor(handler, executor));
+                // keeps the pool running until the request completed, it may wait for the topology meanwhile
+                auto poolWork = boost::asio::make_work_guard(executor);
+                // std::function requires a copyable callable
+                auto completion = std::make_shared<std::tuple<decltype(handler), decltype(work), decltype(poolWork)>>(std::move(handler), std::move(work), std::move(poolWork));
+                queueExec(partitionID, [f = std::move(f), completion](ExecDone execDone) {
+                    f([completion, execDone](Result result) {
+                        auto ex = std::get<1>(*completion).get_executor();
+                        boost::asio::dispatch(ex, [completion, result = std::move(result)]() mutable { std::get<0>(*completion)(std::move(result)); });
+                        std::get<1>(*completion).reset();
+                        std::get<2>(*completion).reset();
+                        execDone();
+                    });
+                });
+            },
+            token,
+            std::forward<Func>(func));
+    }
+
+    // Initiate a request executed in one go on the thread pool
+    template<typename Result, typename Func, typename CompletionToken>
+    auto asyncExec(const std::string& partitionID, Func&& func, CompletionToken&& token)
+    {
+        return asyncExecChain<Result>(partitionID, [f = std::forward<Func>(func)](std::function<void(Result)> done) { done(f()); }, std::forward<CompletionToken>(token));
+    }
+
+    boost::asio::thread_pool::executor_type getExecExecutor();
+    /// \brief Execute a step of a request on the thread pool
+    void postExec(std::function<void()> func);
+    /// \brief Start the request when the previous requests of the partition completed, requests without a partition are started right away
+    void queueExec(const std::string& partitionID, ExecStart start);
+    void startExec(const std::string& partitionID);
+
     std::map<std::string, Partition> mPartitions; ///< Map of partition ID to Partition object
     std::mutex mPartitionMtx;                     ///< Mutex for the partition map
     std::chrono::seconds mTimeout{ 30 };          ///< Request timeout in sec
@@ -121,34 +357,132 @@ class Controller
     std::string mHistoryDir;                      ///< History file directory
     std::map<std::string, ZoneConfig> mZoneCfgs;  ///< stores zones configuration (cfgFilePath/envFilePath) by zone name
     std::string mRMS{ "localhost" };              ///< resource management system to be used by DDS
+    std::string mDirectChannelHost;               ///< host to listen on for direct device connections, empty if disabled
+    bool mPipelinedTransitions{ false };          ///< advance each device through Configure/Reset as soon as it is ready
+    size_t mSubmitWindow{ 8 };                    ///< maximum number of concurrent DDS agent submissions
+    bool mStreamingActivation{ false };           ///< activate ready agent groups while waiting for the others during Run
+    bool mDifferentialUpdate{ false };            ///< on Update, touch only the removed, added and modified tasks
+    bool mFailFast{ false };                      ///< abort state changes as soon as the target state is unreachable
+    StragglerPolicy mStragglerPolicy;             ///< shedding of the devices that are late to complete a state change
+    double mAdaptiveTimeoutFactor{ 0 };           ///< deadline of a state change step relative to the p99 of its history, 0 if disabled
+    TransitionHistory mTransitionHistory;         ///< completion times of the state change steps of previous requests
+    TopologyStore mTopoStore;                     ///< content addressed store of the topology files
+    TopoScriptCache mTopoScriptCache;             ///< results of topology generation scripts
+    SessionPool mSessionPool;                     ///< idle pre-created DDS sessions
+    size_t mExecThreads{ 0 };                     ///< number of threads executing asynchronous requests, 0 for the number of hardware threads
+    std::mutex mExecMtx;                          ///< Mutex for the asynchronous request execution
+    std::map<std::string, std::deque<ExecStart>> mExecQueues; ///< asynchronous requests by partition ID, the first one is running
+    std::unique_ptr<boost::asio::thread_pool> mExecPool; ///< executes asynchronous requests, declared last to be stopped first
 
     void updateRestore();
     void updateHistory(const CommonParams& common, const std::string& sessionId);
 
-    std::unordered_set<std::string> submit(const CommonParams& common, Session& session, Error& error, const std::string& plugin, const std::string& res, bool extractResources);
-    void activate(const CommonParams& common, Partition& partition, Error& error);
-
-    bool createDDSSession(           const CommonParams& common, Session& session, Error& error);
+    bool createDDSSession(           const CommonParams& common, Partition& partition, Error& error);
     bool attachToDDSSession(         const CommonParams& common, Session& session, Error& error, const std::string& sessionID);
     bool shutdownDDSSession(         const CommonParams& common, Partition& partition, Error& error);
+    void resetTopologyState(const CommonParams& common, Partition& partition);
     std::string getActiveDDSTopology(const CommonParams& common, Session& session, Error& error);
 
-    bool submitDDSAgents(      const CommonParams& common, Session& session, Error& error, const DDSSubmitParams& params);
-    bool waitForNumActiveSlots(const CommonParams& common, Session& session, Error& error, size_t numSlots);
-    void ShutdownDDSAgent(     const CommonParams& common, Session& session, uint64_t agentID);
-
-    bool activateDDSTopology(const CommonParams& common, Session& session, Error& error, dds::tools_api::STopologyRequest::request_t::EUpdateType updateType);
-    bool createDDSTopology(  const CommonParams& common, Session& session, Error& error);
+    /// \brief Wait for the slots of the given agents, which were sent the shutdown signal, to disappear. The slot accounting of the session is updated once at the end
+    void waitForAgentShutdown( const CommonParams& common, Session& session, const std::unordered_set<uint64_t>& agentIDs);
+    /// \brief Account for the agents the topology shut down after dropping their collections (nMin)
+    void accountShutdownAgents(const CommonParams& common, Partition& partition);
 
+    bool createDDSTopology(const CommonParams& common, Session& session, Error& error);
     bool createTopology(const CommonParams& common, Partition& partition, Error& error);
     bool resetTopology(Partition& partition);
 
-    bool changeState(         const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopoTransition transition, TopologyState& topologyState);
-    bool changeStateConfigure(const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& topologyState);
-    bool changeStateReset(    const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& topologyState);
-    bool waitForState(        const CommonParams& common, Partition& partition, Error& error, const std::string& path, DeviceState expState);
-    bool setProperties(       const CommonParams& common, Partition& partition, Error& error, const std::string& path, const SetPropertiesParams::Props& props, TopologyState& topologyState);
-    void getState(            const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& state);
+    /// \brief Request in progress, kept alive by the continuations of its chain
+    struct PendingRequest
+    {
+        PendingRequest(const CommonParams& common, bool detailed)
+            : mCommon(common)
+            , mTopologyState(AggregatedState::Undefined, detailed ? std::make_optional<DetailedState>() : std::nullopt)
+        {}
+
+        CommonParams mCommon;
+        Error mError;
+        TopologyState mTopologyState;
+        std::unordered_set<std::string> mHosts; ///< hosts of the agents, for Submit and Run
+    };
+
+    struct Submissions;   ///< DDS agent submissions in progress, see asyncSubmitDDSAgents()
+    struct StreamingWait; ///< waiting for the slots while activating the ready agent groups, see asyncWaitForNumActiveSlotsStreaming()
+    struct Activation;    ///< DDS topology activation in progress, see asyncActivateDDSTopology()
+
+    /// \brief State change step in progress
+    struct StateStep
+    {
+        std::string mName;                                ///< key of its completion times, see stepTimeout()
+        DeviceState mExpState{ DeviceState::Undefined };  ///< state the devices are expected to reach
+        std::chrono::milliseconds mTimeout{ 0 };
+        bool mAdaptive{ false };                          ///< whether the timeout is the adaptive deadline of the step
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    // Start the requests, done is called with the result
+    void initiateInitialize(   const CommonParams& common, const InitializeParams& params, std::function<void(RequestResult)> done);
+    void initiateSubmit(       const CommonParams& common, const SubmitParams& params, std::function<void(RequestResult)> done);
+    void initiateActivate(     const CommonParams& common, const ActivateParams& params, std::function<void(RequestResult)> done);
+    void initiateRun(          const CommonParams& common, const RunParams& params, std::function<void(RequestResult)> done);
+    void initiateUpdate(       const CommonParams& common, const UpdateParams& params, std::function<void(RequestResult)> done);
+    void initiateShutdown(     const CommonParams& common, std::function<void(RequestResult)> done);
+    void initiateSetProperties(const CommonParams& common, const SetPropertiesParams& params, std::function<void(RequestResult)> done);
+    void initiateGetState(     const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+    void initiateConfigure(    const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+    void initiateStart(        const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+    void initiateStop(         const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+    void initiateReset(        const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+    void initiateTerminate(    const CommonParams& common, const DeviceParams& params, std::function<void(RequestResult)> done);
+
+    // Steps of the requests, next is called on the thread pool with the result.
+    // The referenced arguments must outlive the call of next.
+    void asyncSubmit(  const CommonParams& common, Session& session, Error& error, const std::string& plugin, const std::string& res, bool extractResources, bool streamActivation, std::unordered_set<std::string>& hosts, std::function<void(bool)> next);
+    void asyncActivate(const CommonParams& common, Partition& partition, Error& error, std::function<void(bool)> next);
+    /// \brief Run the topology on the agents of the previous Run of the partition
+    /// next is called with false if the agents can not be reused and a new session has to be started
+    void asyncReuseAgents(const CommonParams& common, Partition& partition, Error& error, const RunParams& params, std::unordered_set<std::string>& hosts, std::function<void(bool)> next);
+
+    /// \brief next is called with whether all submissions succeeded and the number of slots of the successful ones
+    void asyncSubmitDDSAgents(              const CommonParams& common, Session& session, Error& error, const std::vector<DDSSubmitParams>& params, std::function<void(bool, size_t)> next);
+    void asyncWaitForNumActiveSlots(        const CommonParams& common, Session& session, Error& error, size_t numSlots, std::chrono::steady_clock::time_point deadline, std::function<void(bool)> next);
+    void asyncWaitForNumActiveSlotsStreaming(const CommonParams& common, Session& session, Error& error, const std::vector<DDSSubmitParams>& ddsParams, size_t numSlots, std::function<void(bool)> next);
+    void asyncActivateDDSTopology(          const CommonParams& common, Session& session, Error& error, dds::tools_api::STopologyRequest::request_t::EUpdateType updateType, std::function<void(bool)> next);
+    void sendSubmissions(std::shared_ptr<Submissions> subs);
+    void finishSubmissions(std::shared_ptr<Submissions> subs);
+    void pollNumActiveSlotsStreaming(std::shared_ptr<StreamingWait> wait);
+    void collectActivation(std::shared_ptr<Activation> activation);
+    /// \brief Continue with next on the thread pool once subscribe notified the completion, or at the deadline, whichever comes first
+    /// \param [in] subscribe called with the notification of the completion, empty to wait for the deadline only
+    void asyncWaitUntil(std::chrono::steady_clock::time_point deadline, std::function<void(std::function<void()>)> subscribe, std::function<void()> next);
+
+    void asyncChangeState(         const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopoTransition transition, TopologyState& topologyState, std::function<void(bool)> next);
+    /// \brief Transitions one after the other, starting at the given index
+    void asyncChangeStates(        const CommonParams& common, Partition& partition, Error& error, const std::string& path, const std::vector<TopoTransition>& transitions, size_t index, TopologyState& topologyState, std::function<void(bool)> next);
+    /// \brief Pipelined transitions, see Topology::ChangeStateSequence(). Devices are selected by a path or by a set of task IDs.
+    template<typename Selection>
+    void asyncChangeStateSequence( const CommonParams& common, Partition& partition, Error& error, const Selection& selection, const std::vector<TopoTransition>& transitions, TopologyState& topologyState, std::function<void(bool)> next);
+    void asyncChangeStateConfigure(const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& topologyState, std::function<void(bool)> next);
+    void asyncChangeStateReset(    const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& topologyState, std::function<void(bool)> next);
+    void asyncSetProperties(       const CommonParams& common, Partition& partition, Error& error, const std::string& path, const SetPropertiesParams::Props& props, TopologyState& topologyState, std::function<void(bool)> next);
+    /// \brief Wait for devices selected by a path or by a set of task IDs to reach the given state
+    template<typename Selection>
+    void asyncWaitForState(        const CommonParams& common, Partition& partition, Error& error, const Selection& selection, DeviceState expState, std::function<void(bool)> next);
+    void asyncUpdateTopologyDiff(  const CommonParams& common, Partition& partition, Error& error, TopologyState& topologyState, std::function<void(bool)> next);
+
+    // Begin and end of the state change steps
+    bool beginChangeState(const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopoTransition transition, StateStep& step);
+    bool endChangeState(  const CommonParams& common, Partition& partition, Error& error, TopoTransition transition, const StateStep& step, std::error_code errorCode, const TopoState& topoState, TopologyState& topologyState);
+    template<typename Selection>
+    bool beginChangeStateSequence(const CommonParams& common, Partition& partition, Error& error, const Selection& selection, const std::vector<TopoTransition>& transitions, StateStep& step);
+    bool endChangeStateSequence(  const CommonParams& common, Partition& partition, Error& error, const std::vector<TopoTransition>& transitions, const StateStep& step, std::error_code errorCode, const TopoState& topoState, const PhaseTimings& phaseTimings, TopologyState& topologyState);
+    bool endSetProperties(const CommonParams& common, Partition& partition, Error& error, std::error_code errorCode, const FailedDevices& failedDevices, TopologyState& topologyState);
+    /// \brief Handle the exception in flight, returns false
+    bool failStateChange(  const CommonParams& common, Partition& partition, Error& error, DeviceState expState);
+    bool failSetProperties(const CommonParams& common, Partition& partition, Error& error);
+    bool endWaitForState(  const CommonParams& common, Partition& partition, Error& error, const StateStep& step, std::error_code errorCode);
+    bool failWaitForState( const CommonParams& common, Partition& partition, Error& error, DeviceState expState);
+    void getState(const CommonParams& common, Partition& partition, Error& error, const std::string& path, TopologyState& state);
 
     void fillAndLogError(               const CommonParams& common, Error& error, ErrorCode errorCode, const std::string& msg);
     void fillAndLogFatalError(          const CommonParams& common, Error& error, ErrorCode errorCode, const std::string& msg);
@@ -166,6 +500,10 @@ class Controller
     void stateSummaryOnFailure(const CommonParams& common, Session& session, const TopoState& topoState, DeviceState expectedState);
     void attemptSubmitRecovery(const CommonParams& common, Session& session, Error& error, const std::vector<DDSSubmitParams>& ddsParams, const std::map<std::string, uint32_t>& agentCounts);
     void updateTopology(const CommonParams& common, Session& session);
+    void loadRequirements(const CommonParams& common, Session& session);
+    std::string partialTopology(const CommonParams& common, const Session& session, const std::set<std::string>& agentGroups);
+    /// \brief Set the topology file of the session, releasing the reference of the partition to the replaced file in the topology store
+    void replaceTopoFilePath(const CommonParams& common, Session& session, std::string filePath);
 
     std::string topoFilepath(const CommonParams& common, const std::string& topologyFile, const std::string& topologyContent, const std::string& topologyScript);
 
@@ -184,10 +522,19 @@ class Controller
         return std::chrono::duration_cast<std::chrono::seconds>(realTimeoutMs);
     }
 
+    /// \brief Timeout of a state change step: the remaining request time, or the adaptive deadline of the step if it is shorter
+    /// \return timeout and whether the adaptive deadline applies
+    std::pair<std::chrono::milliseconds, bool> stepTimeout(const CommonParams& common, const Partition& partition, const std::string& step) const;
+    /// \brief Record the completion time of a successful state change step, or the time until a step timed out
+    void recordStep(const Partition& partition, const std::string& step, std::chrono::steady_clock::duration duration, bool timedOut = false);
+
     uint32_t getNumSlots(const CommonParams& common, Session& session) const;
-    dds::tools_api::SAgentInfoRequest::responseVector_t getAgentInfo(const CommonParams& common, Session& session) const;
+    /// \brief Agents of the session. The cached inventory is used if it is not older than maxAge, otherwise it is refreshed:
+    /// the agents are listed again only if the active slot count changed.
+    const AgentInventory& getAgentInventory(const CommonParams& common, Session& session, std::chrono::milliseconds maxAge = std::chrono::milliseconds(0)) const;
 
     void printStateStats(const CommonParams& common, const TopoState& topoState, bool debugLog = false);
+    void printTransitionStats(const CommonParams& common, Partition& partition, TopoTransition transition, size_t numSlowest = 5);
 };
 
 } // namespace odc::core
@@ -0,0 +1,156 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_DDSREQUEST
+#define ODC_CORE_DDSREQUEST
+
+#include <dds/Tools.h>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace odc::core {
+
+/// Future based adapter around a DDS tools API request.
+/// Several requests can be sent to a session before waiting for any of them, independent requests are then processed concurrently by DDS:
+///
+///     DDSRequest<SAgentInfoRequest> info;
+///     DDSRequest<SAgentCountRequest> count;
+///     info.send(session);
+///     count.send(session);
+///     const auto deadline = std::chrono::steady_clock::now() + timeout;
+///     auto agents = info.get(deadline).responses;
+///     auto slots = count.get(deadline).responses;
+///
+/// Instead of waiting, onDone() continues once the request is done.
+/// The callbacks only touch state shared with the adapter, a request that timed out can be abandoned safely.
+template<typename Request>
+class DDSRequest
+{
+  public:
+    using Response = typename Request::response_t;
+
+    struct Reply
+    {
+        std::vector<Response> responses;   ///< responses in the order of their arrival
+        std::vector<std::string> messages; ///< informational messages of DDS
+        std::vector<std::string> errors;   ///< error messages of DDS
+    };
+
+    explicit DDSRequest(const typename Request::request_t& data = typename Request::request_t())
+        : mRequest(Request::makeRequest(data))
+        , mState(std::make_shared<State>())
+        , mFuture(mState->promise.get_future())
+    {
+        mRequest->setResponseCallback([state = mState](const Response& response) {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            state->reply.responses.push_back(response);
+        });
+        mRequest->setMessageCallback([state = mState](const dds::tools_api::SMessageResponseData& msg) {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            if (msg.m_severity == dds::intercom_api::EMsgSeverity::error) {
+                state->reply.errors.push_back(msg.m_msg);
+            } else {
+                state->reply.messages.push_back(msg.m_msg);
+            }
+        });
+        mRequest->setDoneCallback([state = mState]() {
+            std::function<void()> onDone;
+            {
+                std::lock_guard<std::mutex> lk(state->mtx);
+                if (state->done) {
+                    return;
+                }
+                state->done = true;
+                state->promise.set_value(std::move(state->reply));
+                onDone = std::move(state->onDone);
+            }
+            if (onDone) {
+                onDone();
+            }
+        });
+    }
+
+    DDSRequest(const DDSRequest&) = delete;
+    DDSRequest& operator=(const DDSRequest&) = delete;
+    DDSRequest(DDSRequest&&) = default;
+    DDSRequest& operator=(DDSRequest&&) = default;
+
+    /// @brief Underlying request, e.g. to set a progress callback before sending.
+    /// Replacing the response callback leaves Reply::responses empty.
+    typename Request::ptr_t& request() { return mRequest; }
+
+    /// @brief Send the request to the session, does not wait for its completion
+    DDSRequest& send(dds::tools_api::CSession& session)
+    {
+        session.sendRequest<Request>(mRequest);
+        return *this;
+    }
+
+    /// @brief Call the handler once the request is done, right away if it is done already. Replaces a previously set handler.
+    /// The handler is called from the DDS thread completing the request, it must not block.
+    void onDone(std::function<void()> handler)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mState->mtx);
+            if (!mState->done) {
+                mState->onDone = std::move(handler);
+                return;
+            }
+        }
+        handler();
+    }
+
+    /// @brief Wait for the request to be done, without consuming the reply
+    /// @return false if the request is not done before the deadline
+    bool wait(std::chrono::steady_clock::time_point deadline) const { return mFuture.wait_until(deadline) == std::future_status::ready; }
+
+    /// @brief Wait for the request to be done
+    /// @throws std::runtime_error if the request is not done before the deadline, the request is unsubscribed
+    Reply get(std::chrono::steady_clock::time_point deadline)
+    {
+        if (mFuture.wait_until(deadline) != std::future_status::ready) {
+            mRequest->unsubscribeAll();
+            throw std::runtime_error("Timed out waiting for DDS request to complete");
+        }
+        return mFuture.get();
+    }
+
+    /// @brief Wait for the request to be done
+    /// @throws std::runtime_error if the request is not done within the timeout, the request is unsubscribed
+    template<typename Rep, typename Period>
+    Reply get(std::chrono::duration<Rep, Period> timeout)
+    {
+        return get(std::chrono::steady_clock::now() + timeout);
+    }
+
+  private:
+    struct State
+    {
+        std::mutex mtx;
+        bool done = false;
+        Reply reply;
+        std::promise<Reply> promise;
+        std::function<void()> onDone; ///< see onDone()
+    };
+
+    typename Request::ptr_t mRequest;
+    std::shared_ptr<State> mState;
+    std::future<Reply> mFuture;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_DDSREQUEST */
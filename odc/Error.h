@@ -53,6 +53,7 @@ enum class ErrorCode
     DeviceSetPropertiesFailed,
     DeviceWaitForStateFailed,
     TopologyFailed,
+    TargetStateUnreachable,
 
     DDSCreateSessionFailed = 200,
     DDSShutdownSessionFailed,
@@ -90,6 +91,7 @@ struct ErrorCategory : std::error_category
             case ErrorCode::DeviceGetPropertiesFailed:          return "Failed to get FairMQ device properties";
             case ErrorCode::DeviceSetPropertiesFailed:          return "Failed to set FairMQ device properties";
             case ErrorCode::TopologyFailed:                     return "Failed topology";
+            case ErrorCode::TargetStateUnreachable:             return "Target state is unreachable, failed devices cannot be ignored";
 
             case ErrorCode::DDSCreateSessionFailed:             return "Failed to create a DDS session";
             case ErrorCode::DDSShutdownSessionFailed:           return "Failed to shutdown a DDS session";
@@ -32,6 +32,8 @@
 
 #include <unistd.h> // getpid
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <ostream>
 
@@ -81,6 +83,9 @@ class Logger
 
     logger_t& logger() { return mLogger; }
 
+    /// \brief Check whether records of the given severity reach any sink, to skip preparing expensive messages that would be dropped
+    bool enabled(ESeverity severity) const { return severity >= mMinSeverity.load(std::memory_order_relaxed); }
+
     /// \brief Initialization of log. Has to be called in main.
     void init(const Config& cfg = Config())
     {
@@ -96,6 +101,15 @@ class Logger
         CInfoLogger::instance().setContext(cfg.mInfologgerFacility, cfg.mInfologgerSystem, cfg.mInfologgerRole);
         CInfoLogger::instance().registerSink(cfg.mInfologgerSeverity, cfg.mInfologger);
 
+        // without any of the sinks above the default sink of boost log takes all records
+        if (!cfg.mLogDir.empty()) {
+            ESeverity minSeverity = cfg.mSeverity;
+            if (cfg.mInfologger) {
+                minSeverity = std::min(minSeverity, cfg.mInfologgerSeverity);
+            }
+            mMinSeverity = minSeverity;
+        }
+
         boost::log::add_common_attributes();
         boost::log::core::get()->add_global_attribute("Process", boost::log::attributes::current_process_name());
 
@@ -152,6 +166,7 @@ class Logger
 
   private:
     logger_t mLogger; ///> Main logger object
+    std::atomic<ESeverity> mMinSeverity{ ESeverity::trace }; ///> Lowest severity accepted by any sink
 };
 } // namespace odc::core
 
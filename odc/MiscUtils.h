@@ -20,12 +20,14 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include <cstdint>
 #include <ctime>
 #include <initializer_list>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 namespace odc::core
 {
@@ -58,6 +60,17 @@ inline std::size_t uuidHash()
     return uuid_hasher(u);
 }
 
+// FNV-1a hash of the content, unlike std::hash stable across runs, builds and standard libraries
+inline uint64_t hashContent(std::string_view content)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 inline bool strStartsWith(std::string const& str, std::string const& start)
 {
     if (str.length() >= start.length()) {
@@ -97,6 +97,15 @@ struct RequestResult : public BaseRequestResult
     std::unordered_set<std::string> mHosts; ///< List of used hosts
 };
 
+struct TopoScriptCacheStats
+{
+    uint64_t mHits = 0;      ///< Number of requests served from the cache
+    uint64_t mMisses = 0;    ///< Number of requests that executed the script
+    uint64_t mEvictions = 0; ///< Number of results dropped because of TTL or size limits
+    uint64_t mEntries = 0;   ///< Number of cached results
+    uint64_t mBytes = 0;     ///< Total size of cached results
+};
+
 struct StatusRequestResult : public BaseRequestResult
 {
     StatusRequestResult() {}
@@ -105,6 +114,7 @@ struct StatusRequestResult : public BaseRequestResult
     {}
 
     std::vector<PartitionStatus> mPartitions; ///< Statuses of partitions
+    TopoScriptCacheStats mTopoScriptCache;    ///< Topology generation script cache statistics
 };
 
 struct CommonParams
@@ -192,13 +202,15 @@ struct RunParams
               const std::string& topoFile,
               const std::string& topoContent,
               const std::string& topoScript,
-              bool extractTopoResources)
+              bool extractTopoResources,
+              bool reuseAgents = false)
         : mPlugin(plugin)
         , mResources(resources)
         , mTopoFile(topoFile)
         , mTopoContent(topoContent)
         , mTopoScript(topoScript)
         , mExtractTopoResources(extractTopoResources)
+        , mReuseAgents(reuseAgents)
     {}
 
     std::string mPlugin;                ///< ODC resource plugin name. Plugin has to be registered in ODC server.
@@ -207,6 +219,7 @@ struct RunParams
     std::string mTopoContent;           ///< Content of the XML topology
     std::string mTopoScript;            ///< Script that generates topology content
     bool mExtractTopoResources = false; ///< Submit resource request based on topology content
+    bool mReuseAgents = false;          ///< Repeated Run keeps the DDS session and its agents, if they satisfy the new topology
 
     friend std::ostream& operator<<(std::ostream& os, const RunParams& p)
     {
@@ -216,7 +229,8 @@ struct RunParams
                   << "; topologyFile: "         << quoted(p.mTopoFile)
                   << "; topologyContent: "      << quoted(p.mTopoContent)
                   << "; topologyScript: "       << quoted(p.mTopoScript)
-                  << "; extractTopoResources: " << p.mExtractTopoResources;
+                  << "; extractTopoResources: " << p.mExtractTopoResources
+                  << "; reuseAgents: "          << p.mReuseAgents;
     }
 };
 
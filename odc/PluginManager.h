@@ -11,18 +11,179 @@
 
 #include <odc/Logger.h>
 #include <odc/MiscUtils.h>
+#include <odc/PluginProtocol.h>
 #include <odc/Process.h>
 
+#include <boost/algorithm/string.hpp>
+#include <boost/asio.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/process.hpp>
 #include <boost/program_options/parsers.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace odc::core {
 
+/// Resource plugin process kept alive between requests, see PluginProtocol.h
+class PersistentPlugin
+{
+  public:
+    /// Error reported by the plugin itself, as opposed to a failure of the plugin process or of the protocol
+    struct PluginError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+    /// Plugin did not reply in time
+    struct TimeoutError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    /// @brief Start the plugin process and wait for its handshake
+    /// @throws std::runtime_error if the plugin does not start or does not support the persistent mode
+    PersistentPlugin(const std::string& cmd, std::chrono::steady_clock::duration timeout)
+        : mIn(mIos)
+        , mOut(mIos)
+    {
+        std::vector<std::string> args{ boost::program_options::split_unix(cmd) };
+        if (args.empty()) {
+            throw std::runtime_error("Empty plugin command");
+        }
+        const std::string exe{ args.front() };
+        args.erase(args.begin());
+        args.push_back(toString("--", rp::kPersistentOption));
+
+        // started directly, without a shell in between
+        mChild = bp::child(bp::exe = exe, bp::args = args, bp::std_in < mIn, bp::std_out > mOut);
+        if (!mChild.valid()) {
+            throw std::runtime_error("Can't execute the given process.");
+        }
+
+        const std::string handshake{ readLine(std::chrono::steady_clock::now() + timeout) };
+        if (handshake != rp::kHandshake) {
+            throw std::runtime_error(toString("Unexpected handshake ", std::quoted(handshake)));
+        }
+    }
+
+    PersistentPlugin(const PersistentPlugin&) = delete;
+    PersistentPlugin& operator=(const PersistentPlugin&) = delete;
+
+    ~PersistentPlugin()
+    {
+        try {
+            // plugin exits on closed stdin, kill it if it doesn't
+            boost::system::error_code ec;
+            mIn.close(ec);
+            mOut.close(ec);
+            for (int i = 0; i < 10 && mChild.running(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            if (mChild.running()) {
+                mChild.terminate();
+            }
+            mChild.wait();
+        } catch (const std::exception& e) {
+            OLOG(warning) << "Failed to stop resource plugin process: " << e.what();
+        }
+    }
+
+    /// @brief Send a request to the plugin and wait for its reply
+    /// @param deadline time by which the reply has to be received
+    /// @return plugin output
+    /// @throws PluginError if the plugin reported an error, TimeoutError if the deadline passed,
+    /// std::runtime_error if the plugin process or the protocol failed
+    std::string request(const std::string& resources, const std::string& partitionID, std::chrono::steady_clock::time_point deadline)
+    {
+        const std::string req{ toString("RUN ", partitionID.size(), " ", resources.size(), "\n", partitionID, resources) };
+        bool done = false;
+        boost::system::error_code ec;
+        boost::asio::async_write(mIn, boost::asio::buffer(req), [&](const boost::system::error_code& e, size_t /*size*/) {
+            ec = e;
+            done = true;
+        });
+        runUntil(done, deadline);
+        if (ec) {
+            throw std::runtime_error(toString("Failed to send request: ", ec.message()));
+        }
+
+        std::stringstream header{ readLine(deadline) };
+        std::string status;
+        size_t length = 0;
+        if (!(header >> status >> length) || (status != "OK" && status != "ERR")) {
+            throw std::runtime_error(toString("Invalid reply header ", std::quoted(header.str())));
+        }
+        std::string payload{ read(length, deadline) };
+        if (status == "ERR") {
+            throw PluginError(payload);
+        }
+        return payload;
+    }
+
+  private:
+    // Run the io_context until the operation is done
+    void runUntil(bool& done, std::chrono::steady_clock::time_point deadline)
+    {
+        mIos.restart();
+        while (!done && mIos.run_one_until(deadline) > 0) {}
+        if (!done) {
+            throw TimeoutError("Timeout has been reached waiting for the resource plugin");
+        }
+    }
+
+    std::string readLine(std::chrono::steady_clock::time_point deadline)
+    {
+        bool done = false;
+        boost::system::error_code ec;
+        size_t size = 0;
+        boost::asio::async_read_until(mOut, mBuf, '\n', [&](const boost::system::error_code& e, size_t s) {
+            ec = e;
+            size = s;
+            done = true;
+        });
+        runUntil(done, deadline);
+        if (ec) {
+            throw std::runtime_error(toString("Failed to read from resource plugin: ", ec.message()));
+        }
+        std::string line{ read(size, deadline) };
+        line.pop_back(); // '\n'
+        return line;
+    }
+
+    std::string read(size_t size, std::chrono::steady_clock::time_point deadline)
+    {
+        if (mBuf.size() < size) {
+            bool done = false;
+            boost::system::error_code ec;
+            boost::asio::async_read(mOut, mBuf, boost::asio::transfer_at_least(size - mBuf.size()), [&](const boost::system::error_code& e, size_t /*size*/) {
+                ec = e;
+                done = true;
+            });
+            runUntil(done, deadline);
+            if (ec) {
+                throw std::runtime_error(toString("Failed to read from resource plugin: ", ec.message()));
+            }
+        }
+        std::string result(boost::asio::buffers_begin(mBuf.data()), boost::asio::buffers_begin(mBuf.data()) + size);
+        mBuf.consume(size);
+        return result;
+    }
+
+    boost::asio::io_context mIos;
+    bp::async_pipe mIn;
+    bp::async_pipe mOut;
+    boost::asio::streambuf mBuf;
+    bp::child mChild;
+};
+
 class PluginManager
 {
   public:
@@ -57,6 +218,9 @@ class PluginManager
             boost::algorithm::replace_first(correctedCmd, path, pluginPath.string());
             OLOG(info) << "Registered resource plugin " << std::quoted(correctedCmd) << " as " << std::quoted(plugin);
             mPlugins.insert(make_pair(plugin, correctedCmd));
+            if (mPersistent) {
+                startPersistent(plugin, correctedCmd);
+            }
         } catch (const std::exception& _e) {
             std::stringstream ss;
             ss << "Failed to register resource plugin " << std::quoted(plugin) << ": " << _e.what();
@@ -66,19 +230,72 @@ class PluginManager
 
     std::string execPlugin(const std::string& plugin, const std::string& resources, const std::string& partitionID, uint64_t runNr, std::chrono::seconds timeout) const
     {
+        // the whole execution, including the wait for a plugin process, counts against the timeout
+        const auto deadline{ std::chrono::steady_clock::now() + timeout };
+
         // Check if plugin exists
         auto it = mPlugins.find(plugin);
         if (it == mPlugins.end()) {
             throw std::runtime_error(toString("Failed to execute resource plugin ", std::quoted(plugin), ". Plugin not found."));
         }
 
+        // Ask a persistent plugin process, if any is available
+        auto persistent = mPersistentPlugins.find(plugin);
+        if (persistent != mPersistentPlugins.end()) {
+            PersistentEntry& entry{ *(persistent->second) };
+            std::unique_ptr<PersistentPlugin> process;
+            bool acquired = false;
+            {
+                std::lock_guard<std::mutex> lock(entry.mMtx);
+                if (!entry.mIdle.empty()) {
+                    process = std::move(entry.mIdle.back());
+                    entry.mIdle.pop_back();
+                    acquired = true;
+                } else if (entry.mNumProcesses < kMaxProcesses) {
+                    // started below, outside of the lock
+                    ++entry.mNumProcesses;
+                    acquired = true;
+                }
+            }
+            if (!acquired) {
+                // all processes are busy with requests of other partitions, do not wait for them
+                OLOG(debug, partitionID, runNr) << "All " << kMaxProcesses << " processes of persistent plugin " << std::quoted(plugin) << " are busy, executing it once";
+            } else {
+                try {
+                    if (!process) {
+                        process = std::make_unique<PersistentPlugin>(it->second, std::min<std::chrono::steady_clock::duration>(kStartTimeout, deadline - std::chrono::steady_clock::now()));
+                    }
+                    OLOG(debug, partitionID, runNr) << "Sending request to persistent plugin " << std::quoted(plugin);
+                    std::string out{ process->request(resources, partitionID, deadline) };
+                    entry.release(std::move(process));
+                    return out;
+                } catch (const PersistentPlugin::PluginError& e) {
+                    // the process is fine, only the request failed
+                    entry.release(std::move(process));
+                    throw std::runtime_error(toString("Execution of plugin ", std::quoted(plugin), " failed, error: ", e.what()));
+                } catch (const PersistentPlugin::TimeoutError& e) {
+                    // the request timeout is used up, do not retry
+                    entry.release(nullptr);
+                    throw std::runtime_error(toString("Execution of plugin ", std::quoted(plugin), " failed: ", e.what()));
+                } catch (const std::exception& e) {
+                    entry.release(nullptr);
+                    OLOG(warning, partitionID, runNr) << "Persistent plugin " << std::quoted(plugin) << " failed: " << e.what() << ". Falling back to one-shot execution.";
+                }
+            }
+        }
+
+        const auto remaining{ std::chrono::duration_cast<std::chrono::seconds>(deadline - std::chrono::steady_clock::now()) };
+        if (remaining <= std::chrono::seconds(0)) {
+            throw std::runtime_error(toString("Execution of plugin ", std::quoted(plugin), " failed: timeout has been reached"));
+        }
+
         // Execute plugin
         const std::string cmd{ toString(it->second, " --res ", std::quoted(resources), " --id ", std::quoted(partitionID)) };
         std::string out;
         std::string err;
         int exitCode{ EXIT_SUCCESS };
         OLOG(debug, partitionID, runNr) << "Executing plugin " << std::quoted(cmd);
-        execute(cmd, timeout, &out, &err, &exitCode);
+        execute(cmd, remaining, &out, &err, &exitCode);
 
         if (exitCode != EXIT_SUCCESS) {
             throw std::runtime_error(toString("Execution of plugin ", std::quoted(plugin), " failed with exit code: ", exitCode, ", error: ", err));
@@ -88,8 +305,63 @@ class PluginManager
 
     bool isPluginRegistered(const std::string& plugin) const { return mPlugins.find(plugin) != mPlugins.end(); }
 
+    /// @brief Keep plugins running between requests, for the already registered and all further registered plugins.
+    /// Plugins that do not support the persistent mode are executed once per request.
+    void setPersistent(bool persistent)
+    {
+        mPersistent = persistent;
+        if (mPersistent) {
+            for (const auto& [plugin, cmd] : mPlugins) {
+                startPersistent(plugin, cmd);
+            }
+        } else {
+            mPersistentPlugins.clear();
+        }
+    }
+
   private:
+    /// Processes of a persistent plugin, each serves one request at a time
+    struct PersistentEntry
+    {
+        /// @brief Return a process after a request, nullptr if it failed and is dropped
+        void release(std::unique_ptr<PersistentPlugin> process)
+        {
+            std::lock_guard<std::mutex> lock(mMtx);
+            if (process) {
+                mIdle.push_back(std::move(process));
+            } else {
+                --mNumProcesses;
+            }
+        }
+
+        std::mutex mMtx;
+        std::vector<std::unique_ptr<PersistentPlugin>> mIdle; ///< processes waiting for a request
+        size_t mNumProcesses = 0;                            ///< idle and busy processes, and the ones being started
+    };
+
+    static constexpr std::chrono::seconds kStartTimeout{ 10 };
+    static constexpr size_t kMaxProcesses = 4; ///< processes per persistent plugin, requests beyond that are executed once
+
+    void startPersistent(const std::string& plugin, const std::string& cmd)
+    {
+        if (mPersistentPlugins.count(plugin) > 0) {
+            return;
+        }
+        try {
+            auto entry{ std::make_unique<PersistentEntry>() };
+            // further processes are started on demand, for concurrent requests
+            entry->mIdle.push_back(std::make_unique<PersistentPlugin>(cmd, kStartTimeout));
+            entry->mNumProcesses = 1;
+            mPersistentPlugins.emplace(plugin, std::move(entry));
+            OLOG(info) << "Started persistent resource plugin " << std::quoted(plugin);
+        } catch (const std::exception& e) {
+            OLOG(info) << "Resource plugin " << std::quoted(plugin) << " does not support the persistent mode (" << e.what() << "), it is executed once per request";
+        }
+    }
+
     PluginMap mPlugins; ///< Plugin map
+    bool mPersistent{ false };
+    std::map<std::string, std::unique_ptr<PersistentEntry>> mPersistentPlugins; ///< running plugin processes by plugin name
 };
 
 } // namespace odc::core
@@ -0,0 +1,69 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_PLUGINPROTOCOL
+#define ODC_CORE_PLUGINPROTOCOL
+
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <string>
+
+// Protocol of persistent resource plugins, see docs/rp.md.
+//
+// The plugin is started once with `--persistent` and announces itself with the handshake line.
+// Each request is a header line followed by the partition ID and the resource description:
+//     RUN <partition ID length> <resources length>\n<partition ID><resources>
+// Each reply is a header line followed by the plugin output or an error message:
+//     OK <output length>\n<output>
+//     ERR <message length>\n<message>
+// The plugin exits when its stdin is closed.
+
+namespace odc::core::rp {
+
+constexpr const char* kPersistentOption = "persistent";
+constexpr const char* kHandshake = "ODC-RP 1";
+
+/// @brief Serve requests of ODC until stdin is closed
+/// @param handler called with the resource description and the partition ID, returns the plugin output. Exceptions are reported to ODC as errors.
+/// @return exit code of the plugin
+inline int servePersistent(const std::function<std::string(const std::string& resources, const std::string& partitionID)>& handler,
+                           std::istream& in = std::cin,
+                           std::ostream& out = std::cout)
+{
+    out << kHandshake << '\n' << std::flush;
+
+    std::string cmd;
+    size_t idLength = 0;
+    size_t resLength = 0;
+    while (in >> cmd >> idLength >> resLength) {
+        in.ignore(); // '\n' after the header
+        std::string partitionID(idLength, '\0');
+        std::string resources(resLength, '\0');
+        in.read(partitionID.data(), idLength);
+        in.read(resources.data(), resLength);
+        if (!in || cmd != "RUN") {
+            std::cerr << "Invalid request received, exiting" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        try {
+            const std::string output = handler(resources, partitionID);
+            out << "OK " << output.size() << '\n' << output << std::flush;
+        } catch (const std::exception& e) {
+            const std::string msg = e.what();
+            out << "ERR " << msg.size() << '\n' << msg << std::flush;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+} // namespace odc::core::rp
+
+#endif /* ODC_CORE_PLUGINPROTOCOL */
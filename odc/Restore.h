@@ -56,8 +56,15 @@ struct RestoreData
         for (const auto& v : mPartitions) {
             children.push_back(make_pair("", v.toPT()));
         }
+        boost::property_tree::ptree pool;
+        for (const auto& id : mPooledSessions) {
+            boost::property_tree::ptree session;
+            session.put<std::string>("session", id);
+            pool.push_back(make_pair("", session));
+        }
         boost::property_tree::ptree pt;
         pt.add_child("sessions", children);
+        pt.add_child("pool", pool);
         return pt;
     }
     void fromPT(const boost::property_tree::ptree& _pt)
@@ -68,9 +75,16 @@ struct RestoreData
                 mPartitions.push_back(RestorePartition(v.second));
             }
         }
+        auto ppt{ _pt.get_child_optional("pool") };
+        if (ppt) {
+            for (const auto& v : ppt.get()) {
+                mPooledSessions.push_back(v.second.get<std::string>("session", ""));
+            }
+        }
     }
 
     std::vector<RestorePartition> mPartitions;
+    std::vector<std::string> mPooledSessions; ///< IDs of idle pre-created DDS sessions
 };
 
 class RestoreFile
@@ -9,6 +9,9 @@
 #ifndef ODC_CORE_SESSION
 #define ODC_CORE_SESSION
 
+#include <odc/AgentInventory.h>
+#include <odc/Logger.h>
+#include <odc/MiscUtils.h>
 #include <odc/TopologyDefs.h>
 
 #include <dds/Tools.h>
@@ -16,11 +19,18 @@
 
 #include <atomic>
 #include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace odc::core
 {
@@ -29,50 +39,223 @@ struct Session
 {
     TaskDetails& getTaskDetails(uint64_t taskID)
     {
-        auto it = mTaskDetails.find(taskID);
-        if (it == mTaskDetails.end()) {
+        TaskDetails* details = findTaskDetails(taskID);
+        if (details == nullptr) {
             throw std::runtime_error(toString("Failed to get additional task info for ID (", taskID, ")"));
         }
-        return it->second;
+        return *details;
+    }
+
+    /// @brief Additional information about the task, nullptr if the task is not activated
+    TaskDetails* findTaskDetails(uint64_t taskID)
+    {
+        if (mTaskIndex == nullptr) {
+            return nullptr;
+        }
+        auto it = mTaskIndex->find(taskID);
+        if (it == mTaskIndex->end() || mTaskDetails[it->second].mTaskID == 0) {
+            return nullptr;
+        }
+        return &mTaskDetails[it->second];
     }
 
     CollectionDetails& getCollectionDetails(uint64_t collectionID)
     {
-        auto it = mCollectionDetails.find(collectionID);
-        if (it == mCollectionDetails.end()) {
+        auto it = mCollectionIndex.find(collectionID);
+        if (it == mCollectionIndex.end()) {
             throw std::runtime_error(toString("Failed to get additional collection info for ID (", collectionID, ")"));
         }
-        return it->second;
+        return mCollectionDetails[it->second];
+    }
+
+    size_t numTaskDetails() const { return mNumTaskDetails; }
+    size_t numCollectionDetails() const { return mCollectionDetails.size(); }
+
+    /// @brief Lay the task details out in the runtime task order of the topology, which is the order of the BasicTopology state.
+    /// Details of tasks that are not in the topology are dropped.
+    /// @return index of the details by task ID, to be shared with the BasicTopology state
+    std::shared_ptr<const TopoStateIndex> layoutTasks(dds::topology_api::CTopology& topo)
+    {
+        auto index = std::make_shared<TopoStateIndex>();
+        std::vector<TaskDetails> details;
+        auto itPair = topo.getRuntimeTaskIterator(nullptr);
+        for (auto it = itPair.first; it != itPair.second; ++it) {
+            index->emplace(it->first, static_cast<int>(details.size()));
+            details.emplace_back();
+        }
+        mNumTaskDetails = 0;
+        for (auto& td : mTaskDetails) {
+            if (td.mTaskID == 0) {
+                continue;
+            }
+            auto it = index->find(td.mTaskID);
+            if (it != index->end()) {
+                details[it->second] = std::move(td);
+                ++mNumTaskDetails;
+            }
+        }
+        mTaskDetails = std::move(details);
+        mTaskIndex = std::move(index);
+        ++mDetailsVersion;
+        return mTaskIndex;
+    }
+
+    /// @brief Store the details of an activated task and of its collection, if not known yet.
+    /// @param collectionPath path of the runtime collection of the task
+    /// @return false if the task is not in the layout, see layoutTasks()
+    bool addActivatedTask(const dds::tools_api::STopologyResponseData& res, const std::string& collectionPath)
+    {
+        if (mTaskIndex == nullptr) {
+            return false;
+        }
+        auto it = mTaskIndex->find(res.m_taskID);
+        if (it == mTaskIndex->end()) {
+            return false;
+        }
+
+        const InternedString host = mHosts.intern(res.m_host);
+        const InternedPath wrkDir = mPaths.internPath(res.m_wrkDir);
+        TaskDetails& td = mTaskDetails[it->second];
+        if (td.mTaskID == 0) {
+            ++mNumTaskDetails;
+        }
+        ++mDetailsVersion;
+        td = TaskDetails{ res.m_agentID, res.m_slotID, res.m_taskID, res.m_collectionID, mPaths.internPath(res.m_path), host, wrkDir };
+
+        if (res.m_collectionID > 0 && mCollectionIndex.count(res.m_collectionID) == 0) {
+            mCollectionIndex.emplace(res.m_collectionID, mCollectionDetails.size());
+            mCollectionDetails.push_back(CollectionDetails{ res.m_agentID, res.m_collectionID, mPaths.internPath(collectionPath), host, wrkDir });
+        }
+        return true;
+    }
+
+    /// @brief Apply a batch of activated tasks to the details, in the order of the batch.
+    /// Collection paths are taken from the activated topology.
+    void applyActivationResponses(dds::topology_api::CTopology& topo, const std::vector<dds::tools_api::STopologyResponseData>& batch)
+    {
+        for (const auto& res : batch) {
+            const bool newCollection = res.m_collectionID > 0 && mCollectionIndex.count(res.m_collectionID) == 0;
+            std::string collectionPath;
+            if (newCollection) {
+                try {
+                    collectionPath = topo.getRuntimeCollectionById(res.m_collectionID).m_collectionPath;
+                } catch (std::exception& e) {
+                    OLOG(warning, mPartitionID, 0) << "Collection " << res.m_collectionID << " of activated task " << res.m_taskID << " not found in the topology: " << e.what();
+                }
+            }
+            if (!addActivatedTask(res, collectionPath)) {
+                OLOG(warning, mPartitionID, 0) << "Activated task " << res.m_taskID << " (" << res.m_path << ") not found in the topology";
+                continue;
+            }
+            if (newCollection) {
+                auto it = mRuntimeCollectionIndex.find(res.m_collectionID);
+                if (it != mRuntimeCollectionIndex.end()) {
+                    it->second->mRuntimeCollectionAgents[res.m_collectionID] = res.m_agentID;
+                }
+            }
+        }
     }
 
+    /// @brief Drop the details of all tasks and collections, the layout of the tasks is kept
+    void clearDetails()
+    {
+        for (auto& td : mTaskDetails) {
+            td = TaskDetails();
+        }
+        mNumTaskDetails = 0;
+        ++mDetailsVersion;
+        mCollectionDetails.clear();
+        mCollectionIndex.clear();
+        mHosts.clear();
+        mPaths.clear();
+    }
+
+    /// @brief Detailed view of the topology state.
+    /// The view is cached: when the task details did not change, only the entries of devices whose status differs from the previous call are refreshed,
+    /// and the previous view, with its version, is returned if nothing changed.
     void fillDetailedState(const TopoState& topoState, DetailedState& detailedState)
     {
-        detailedState.clear();
-        detailedState.reserve(topoState.size());
-
-        for (const auto& state : topoState) {
-            auto it = mTaskDetails.find(state.taskId);
-            if (it != mTaskDetails.end()) {
-                detailedState.emplace_back(DetailedTaskStatus(state, it->second.mPath, it->second.mHost));
-            } else {
-                detailedState.emplace_back(DetailedTaskStatus(state, "unknown", "unknown"));
+        static const InternedPath unknownPath{ InternedString(), StringTable().intern("unknown") };
+        static const InternedString unknownHost = StringTable().intern("unknown");
+        static std::atomic<uint64_t> lastVersion{ 0 };
+
+        std::lock_guard<std::mutex> lk(mDetailedStateMtx);
+
+        const bool sameDetails = mDetailedEntries != nullptr && mDetailedEntries->size() == topoState.size() && mDetailedDetailsVersion == mDetailsVersion;
+        std::vector<size_t> changed;
+        if (sameDetails) {
+            for (size_t i = 0; i < topoState.size(); ++i) {
+                if ((*mDetailedEntries)[i].mStatus != topoState[i]) {
+                    changed.push_back(i);
+                }
             }
+            if (changed.empty()) {
+                detailedState = DetailedState(mDetailedEntries, mDetailedVersion);
+                return;
+            }
+            // entries handed out earlier are not modified
+            if (mDetailedEntries.use_count() > 1) {
+                mDetailedEntries = std::make_shared<DetailedState::Entries>(*mDetailedEntries);
+            }
+            for (const auto i : changed) {
+                (*mDetailedEntries)[i].mStatus = topoState[i];
+            }
+        } else {
+            auto entries = std::make_shared<DetailedState::Entries>();
+            entries->reserve(topoState.size());
+            for (size_t i = 0; i < topoState.size(); ++i) {
+                const auto& state = topoState[i];
+                // the topology state is laid out like the task details, unless it has not been laid out for the same topology
+                const TaskDetails* td = (i < mTaskDetails.size() && mTaskDetails[i].mTaskID == state.taskId) ? &mTaskDetails[i] : findTaskDetails(state.taskId);
+                if (td != nullptr) {
+                    entries->emplace_back(state, td->mPath, td->mHost);
+                } else {
+                    entries->emplace_back(state, unknownPath, unknownHost);
+                }
+            }
+            mDetailedEntries = std::move(entries);
+            mDetailedDetailsVersion = mDetailsVersion;
         }
+        mDetailedVersion = ++lastVersion;
+        detailedState = DetailedState(mDetailedEntries, mDetailedVersion);
+    }
+
+    /// @brief DDS topology parsed from the given file. The parsed topology is reused as long as the file content does not change.
+    /// @param filePath topology file path
+    std::shared_ptr<dds::topology_api::CTopology> getParsedTopology(const std::string& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error(toString("Failed to open topology file ", std::quoted(filePath)));
+        }
+        // hashing the content is much cheaper than parsing it
+        const uint64_t hash = hashContent(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+        if (mParsedTopo == nullptr || mParsedTopoHash != hash) {
+            mParsedTopo = std::make_shared<dds::topology_api::CTopology>(filePath);
+            mParsedTopoHash = hash;
+        } else {
+            OLOG(debug) << "Reusing parsed topology for " << std::quoted(filePath);
+        }
+        return mParsedTopo;
     }
 
     void debug()
     {
         OLOG(info) << "tasks:";
         for (const auto& t : mTaskDetails) {
-            OLOG(info) << t.second;
+            if (t.mTaskID != 0) {
+                OLOG(info) << t;
+            }
         }
         OLOG(info) << "collections:";
         for (const auto& c : mCollectionDetails) {
-            OLOG(info) << c.second;
+            OLOG(info) << c;
         }
     }
 
-    std::unique_ptr<dds::topology_api::CTopology> mDDSTopo = nullptr; ///< DDS topology
+    std::shared_ptr<dds::topology_api::CTopology> mDDSTopo = nullptr; ///< DDS topology
+    std::shared_ptr<dds::topology_api::CTopology> mParsedTopo = nullptr; ///< Last parsed DDS topology, see getParsedTopology()
+    uint64_t mParsedTopoHash = 0; ///< Content hash of the topology file mParsedTopo was parsed from, see hashContent()
     dds::tools_api::CSession mDDSSession; ///< DDS session
     std::string mPartitionID; ///< External partition ID of this DDS session
     std::string mTopoFilePath;
@@ -84,12 +267,24 @@ struct Session
     std::unordered_map<uint64_t, CollectionInfo*> mRuntimeCollectionIndex; ///< Collection index by collection ID
     std::unordered_set<uint64_t> mExpendableTasks; ///< List of expandable task IDs
     size_t mTotalSlots = 0; ///< total number of DDS slots
-    std::unordered_map<uint64_t, uint32_t> mAgentSlots;
+    AgentInventory mAgentInventory; ///< cached agents of the DDS session
     bool mRunAttempted = false;
+    bool mPartiallyActivated = false; ///< topology is activated only for the agent groups that were ready during the submission
     dds::tools_api::SOnTaskDoneRequest::ptr_t mDDSOnTaskDoneRequest;
     std::atomic<uint64_t> mLastRunNr = 0;
-    std::unordered_map<uint64_t, TaskDetails> mTaskDetails; ///< Additional information about task
-    std::unordered_map<uint64_t, CollectionDetails> mCollectionDetails; ///< Additional information about collection
+    StringTable mHosts; ///< Host names of the task and collection details
+    StringTable mPaths; ///< Parent paths and names of the task and collection paths and working directories
+    std::shared_ptr<const TopoStateIndex> mTaskIndex; ///< Index of mTaskDetails by task ID, shared with the state of BasicTopology, see layoutTasks()
+    std::vector<TaskDetails> mTaskDetails; ///< Additional information about tasks, laid out by mTaskIndex. Tasks that are not activated have task ID 0.
+    size_t mNumTaskDetails = 0; ///< Number of activated tasks in mTaskDetails
+    std::vector<CollectionDetails> mCollectionDetails; ///< Additional information about collections
+    std::unordered_map<uint64_t, size_t> mCollectionIndex; ///< Index of mCollectionDetails by collection ID
+    uint64_t mDetailsVersion = 0; ///< Incremented whenever the task details change
+
+    std::mutex mDetailedStateMtx; ///< Protects the cached detailed state below
+    std::shared_ptr<DetailedState::Entries> mDetailedEntries; ///< Cached detailed state, see fillDetailedState()
+    uint64_t mDetailedVersion = 0; ///< Version of mDetailedEntries
+    uint64_t mDetailedDetailsVersion = 0; ///< mDetailsVersion mDetailedEntries were built from
 };
 
 } // namespace odc::core
@@ -0,0 +1,213 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_SESSIONPOOL
+#define ODC_CORE_SESSIONPOOL
+
+#include <odc/Logger.h>
+#include <odc/Session.h>
+
+#include <boost/uuid/uuid_io.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace odc::core {
+
+/// Pool of idle DDS sessions, created in advance in the background to take the DDS commander startup off the Initialize/Run path.
+class SessionPool
+{
+  public:
+    SessionPool() {}
+    ~SessionPool() { stop(false); }
+
+    SessionPool(const SessionPool&) = delete;
+    SessionPool& operator=(const SessionPool&) = delete;
+
+    /// @brief Set callback invoked whenever the set of idle sessions changes. Called from the maintenance thread, without internal locks held.
+    void setChangeCallback(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mChangeCallback = std::move(callback);
+    }
+
+    /// @brief Add a running session created earlier, e.g. by a previous server instance
+    /// @return false if the session could not be attached to
+    bool adopt(const std::string& sessionID)
+    {
+        auto session = std::make_unique<Session>();
+        try {
+            session->mDDSSession.attach(sessionID);
+            if (!session->mDDSSession.IsRunning()) {
+                return false;
+            }
+        } catch (const std::exception& e) {
+            OLOG(warning) << "Failed to attach to pooled DDS session " << sessionID << ": " << e.what();
+            return false;
+        }
+        OLOG(info) << "Adopted pooled DDS session " << sessionID;
+        std::lock_guard<std::mutex> lk(mMtx);
+        mIdle.push_back(std::move(session));
+        return true;
+    }
+
+    /// @brief Set number of idle sessions to maintain and start the maintenance thread. Sessions above the size are shut down.
+    void setSize(size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            mSize = size;
+            if (!mThread.joinable() && (mSize > 0 || !mIdle.empty())) {
+                mStop = false;
+                mThread = std::thread(&SessionPool::maintain, this);
+            }
+        }
+        mCV.notify_all();
+    }
+
+    /// @brief Take an idle session out of the pool, the pool is refilled in the background
+    /// @return nullptr if no running idle session is available
+    std::unique_ptr<Session> claim()
+    {
+        std::unique_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            while (!mIdle.empty() && session == nullptr) {
+                session = std::move(mIdle.front());
+                mIdle.pop_front();
+                try {
+                    if (!session->mDDSSession.IsRunning()) {
+                        OLOG(warning) << "Dropping pooled DDS session " << session->mDDSSession.getSessionID() << ", it is not running anymore";
+                        session.reset();
+                    }
+                } catch (const std::exception& e) {
+                    OLOG(warning) << "Dropping pooled DDS session: " << e.what();
+                    session.reset();
+                }
+            }
+        }
+        mCV.notify_all();
+        return session;
+    }
+
+    /// @brief IDs of the idle sessions
+    std::vector<std::string> getSessionIDs() const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        std::vector<std::string> ids;
+        for (const auto& session : mIdle) {
+            ids.push_back(boost::uuids::to_string(session->mDDSSession.getSessionID()));
+        }
+        return ids;
+    }
+
+    /// @brief Stop the maintenance thread
+    /// @param shutdownSessions shut the idle sessions down, otherwise they keep running (e.g. to be adopted after a restart)
+    void stop(bool shutdownSessions)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            mStop = true;
+        }
+        mCV.notify_all();
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        std::lock_guard<std::mutex> lk(mMtx);
+        if (shutdownSessions) {
+            for (auto& session : mIdle) {
+                shutdown(*session);
+            }
+        }
+        mIdle.clear();
+    }
+
+  private:
+    void maintain()
+    {
+        std::unique_lock<std::mutex> lk(mMtx);
+        while (!mStop) {
+            if (mIdle.size() > mSize) {
+                auto session = std::move(mIdle.back());
+                mIdle.pop_back();
+                lk.unlock();
+                shutdown(*session);
+                notifyChange();
+                lk.lock();
+            } else if (mIdle.size() < mSize) {
+                lk.unlock();
+                auto session = std::make_unique<Session>();
+                bool created = false;
+                try {
+                    auto sessionID = session->mDDSSession.create();
+                    OLOG(info) << "Pooled DDS session created with session ID: " << sessionID;
+                    created = true;
+                } catch (const std::exception& e) {
+                    OLOG(error) << "Failed to create a pooled DDS session: " << e.what();
+                }
+                lk.lock();
+                if (created) {
+                    mIdle.push_back(std::move(session));
+                    lk.unlock();
+                    notifyChange();
+                    lk.lock();
+                } else {
+                    // DDS may be temporarily unavailable, do not spin
+                    mCV.wait_for(lk, kRetryInterval, [this] { return mStop; });
+                }
+            } else {
+                mCV.wait(lk, [this] { return mStop || mIdle.size() != mSize; });
+            }
+        }
+    }
+
+    static void shutdown(Session& session)
+    {
+        try {
+            const auto sessionID = session.mDDSSession.getSessionID();
+            session.mDDSSession.shutdown();
+            OLOG(info) << "Pooled DDS session " << sessionID << " has been shut down";
+        } catch (const std::exception& e) {
+            OLOG(error) << "Failed to shut down pooled DDS session: " << e.what();
+        }
+    }
+
+    // precondition: mMtx is not locked
+    void notifyChange()
+    {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            callback = mChangeCallback;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+
+    static constexpr std::chrono::seconds kRetryInterval{ 5 };
+
+    mutable std::mutex mMtx;
+    std::condition_variable mCV;
+    size_t mSize = 0;
+    bool mStop = false;
+    std::deque<std::unique_ptr<Session>> mIdle; ///< idle running sessions, oldest first
+    std::function<void()> mChangeCallback;
+    std::thread mThread;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_SESSIONPOOL */
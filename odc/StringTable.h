@@ -0,0 +1,98 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_STRINGTABLE
+#define ODC_CORE_STRINGTABLE
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace odc::core {
+
+/// Handle of a string stored once in a StringTable.
+/// Copying a handle does not copy the string, the string stays alive as long as a handle refers to it, also after the table is cleared.
+class InternedString
+{
+  public:
+    InternedString() = default;
+
+    const std::string& str() const { return mStr ? *mStr : emptyString(); }
+    bool empty() const { return str().empty(); }
+
+    friend bool operator==(const InternedString& lhs, const InternedString& rhs) { return lhs.mStr == rhs.mStr || lhs.str() == rhs.str(); }
+    friend bool operator!=(const InternedString& lhs, const InternedString& rhs) { return !(lhs == rhs); }
+    friend std::ostream& operator<<(std::ostream& os, const InternedString& s) { return os << s.str(); }
+
+  private:
+    friend class StringTable;
+    explicit InternedString(std::shared_ptr<const std::string> str)
+        : mStr(std::move(str))
+    {}
+
+    static const std::string& emptyString()
+    {
+        static const std::string e;
+        return e;
+    }
+
+    std::shared_ptr<const std::string> mStr;
+};
+
+/// Path stored as an interned parent (including the trailing '/') and an interned last element.
+/// Siblings share the parent, equally named elements of different parents share the name.
+struct InternedPath
+{
+    InternedString mParent;
+    InternedString mName;
+
+    std::string str() const { return mParent.str() + mName.str(); }
+
+    friend bool operator==(const InternedPath& lhs, const InternedPath& rhs) { return lhs.mParent == rhs.mParent && lhs.mName == rhs.mName; }
+    friend bool operator!=(const InternedPath& lhs, const InternedPath& rhs) { return !(lhs == rhs); }
+    friend std::ostream& operator<<(std::ostream& os, const InternedPath& p) { return os << p.mParent << p.mName; }
+};
+
+/// Set of unique strings, e.g. host names repeated in the details of many tasks
+class StringTable
+{
+  public:
+    /// @brief Handle of the given string, the string is stored if it is not in the table yet
+    InternedString intern(std::string_view str)
+    {
+        auto it = mStrings.find(str);
+        if (it == mStrings.end()) {
+            auto stored = std::make_shared<const std::string>(str);
+            it = mStrings.emplace(std::string_view(*stored), std::move(stored)).first;
+        }
+        return InternedString(it->second);
+    }
+
+    /// @brief Handle of the given path, split at the last '/'
+    InternedPath internPath(std::string_view path)
+    {
+        const auto pos = path.rfind('/');
+        if (pos == std::string_view::npos) {
+            return InternedPath{ InternedString(), intern(path) };
+        }
+        return InternedPath{ intern(path.substr(0, pos + 1)), intern(path.substr(pos + 1)) };
+    }
+
+    size_t size() const { return mStrings.size(); }
+    /// @brief Remove all strings from the table, existing handles stay valid
+    void clear() { mStrings.clear(); }
+
+  private:
+    std::unordered_map<std::string_view, std::shared_ptr<const std::string>> mStrings; ///< keys view the stored strings
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_STRINGTABLE */
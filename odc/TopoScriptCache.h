@@ -0,0 +1,187 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_TOPOSCRIPTCACHE
+#define ODC_CORE_TOPOSCRIPTCACHE
+
+#include <odc/Params.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace odc::core {
+
+/// Cache of topology generation script results.
+/// A result is keyed on the script command line, the values of the configured environment variables and the modification times of the configured input files.
+/// Results expire after the TTL, the least recently used ones are dropped when the size limit is exceeded.
+class TopoScriptCache
+{
+  public:
+    TopoScriptCache() {}
+
+    TopoScriptCache(const TopoScriptCache&) = delete;
+    TopoScriptCache& operator=(const TopoScriptCache&) = delete;
+
+    /// @brief Set time to live of cached results, 0 disables the cache
+    void setTTL(std::chrono::seconds ttl)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mTTL = ttl;
+        evict();
+    }
+    /// @brief Set maximum total size of cached results in bytes
+    void setMaxBytes(size_t maxBytes)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mMaxBytes = maxBytes;
+        evict();
+    }
+    /// @brief Set environment variables that are part of the cache key
+    void setEnvVars(const std::vector<std::string>& envVars)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mEnvVars = envVars;
+    }
+    /// @brief Set input files whose modification times are part of the cache key
+    void setInputFiles(const std::vector<std::string>& inputFiles)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mInputFiles = inputFiles;
+    }
+
+    bool enabled() const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        return mTTL.count() > 0;
+    }
+
+    /// @brief Cached result of the script, if any
+    std::optional<std::string> get(const std::string& script)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        if (mTTL.count() == 0) {
+            return std::nullopt;
+        }
+        evict();
+        auto it = mEntries.find(key(script));
+        if (it == mEntries.end()) {
+            ++mStats.mMisses;
+            return std::nullopt;
+        }
+        ++mStats.mHits;
+        mLRU.splice(mLRU.begin(), mLRU, it->second.lruIt);
+        return it->second.content;
+    }
+
+    /// @brief Cache the result of the script
+    void put(const std::string& script, const std::string& content)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        if (mTTL.count() == 0 || content.size() > mMaxBytes) {
+            return;
+        }
+        std::string k = key(script);
+        auto it = mEntries.find(k);
+        if (it != mEntries.end()) {
+            erase(it);
+        }
+        mLRU.push_front(k);
+        mEntries.emplace(std::move(k), Entry{ content, std::chrono::steady_clock::now(), mLRU.begin() });
+        mStats.mBytes += content.size();
+        evict();
+    }
+
+    TopoScriptCacheStats getStats() const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        TopoScriptCacheStats stats(mStats);
+        stats.mEntries = mEntries.size();
+        return stats;
+    }
+
+  private:
+    struct Entry
+    {
+        std::string content;
+        std::chrono::steady_clock::time_point created;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    // precondition: mMtx is locked
+    std::string key(const std::string& script) const
+    {
+        std::stringstream ss;
+        ss << script << '\0';
+        for (const auto& var : mEnvVars) {
+            const char* value = std::getenv(var.c_str());
+            ss << var << '=' << (value ? value : "<unset>") << '\0';
+        }
+        for (const auto& file : mInputFiles) {
+            std::error_code ec;
+            auto mtime = std::filesystem::last_write_time(file, ec);
+            ss << file << '@';
+            if (ec) {
+                ss << "<missing>";
+            } else {
+                ss << mtime.time_since_epoch().count();
+            }
+            ss << '\0';
+        }
+        return ss.str();
+    }
+
+    // precondition: mMtx is locked
+    void erase(std::unordered_map<std::string, Entry>::iterator it)
+    {
+        mStats.mBytes -= it->second.content.size();
+        mLRU.erase(it->second.lruIt);
+        mEntries.erase(it);
+    }
+
+    // precondition: mMtx is locked
+    void evict()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            if (mTTL.count() == 0 || now - it->second.created > mTTL) {
+                auto next = std::next(it);
+                erase(it);
+                ++mStats.mEvictions;
+                it = next;
+            } else {
+                ++it;
+            }
+        }
+        while (mStats.mBytes > mMaxBytes && !mLRU.empty()) {
+            erase(mEntries.find(mLRU.back()));
+            ++mStats.mEvictions;
+        }
+    }
+
+    mutable std::mutex mMtx;
+    std::chrono::seconds mTTL{ 0 };
+    size_t mMaxBytes{ 256 * 1024 * 1024 };
+    std::vector<std::string> mEnvVars;
+    std::vector<std::string> mInputFiles;
+    std::unordered_map<std::string, Entry> mEntries; ///< cache key -> result
+    std::list<std::string> mLRU;                     ///< cache keys, most recently used first
+    TopoScriptCacheStats mStats;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_TOPOSCRIPTCACHE */
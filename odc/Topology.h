@@ -17,9 +17,11 @@
 #include <odc/Session.h>
 #include <odc/TopologyDefs.h>
 #include <odc/TopologyOpChangeState.h>
+#include <odc/TopologyOpChangeStateSequence.h>
 #include <odc/TopologyOpGetProperties.h>
 #include <odc/TopologyOpSetProperties.h>
 #include <odc/TopologyOpWaitForState.h>
+#include <odc/cc/DirectChannel.h>
 
 #include <boost/asio/associated_executor.hpp>
 #include <boost/asio/async_result.hpp>
@@ -34,6 +36,7 @@
 #include <condition_variable>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -41,9 +44,11 @@
 #include <string>
 #include <sstream>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace odc::core
 {
@@ -84,27 +89,30 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         : AsioBase<Executor, Allocator>(ex, std::move(alloc))
         , mSession(session)
         , mDDSCustomCmd(mDDSService)
-        , mDDSTopo(topo)
+        , mDDSTopo(&topo)
         , mMtx(std::make_unique<std::mutex>())
         , mStateChangeSubscriptionsCV(std::make_unique<std::condition_variable>())
         , mNumStateChangePublishers(0)
         , mHeartbeatsTimer(boost::asio::system_executor())
         , mHeartbeatInterval(600000)
+        , mSubscriptionReplySpacing(10)
+        , mSubscriptionReplyWindow(0)
+        , mPropertiesChunkSize(256 * 1024)
         , mPartitionID(mSession.mPartitionID)
     {
         // TODO: resources should be extracted from the topology file here, not in the Controller
 
-        // prepare topology state
+        // prepare topology state, laid out like the task details of the session
+        mStateIndex = mSession.layoutTasks(*mDDSTopo);
         dds::topology_api::STopoRuntimeTask::FilterIteratorPair_t itPair;
-        itPair = mDDSTopo.getRuntimeTaskIterator(nullptr);
+        itPair = mDDSTopo->getRuntimeTaskIterator(nullptr);
         auto tasks = boost::make_iterator_range(itPair.first, itPair.second);
-        mStateData.reserve(boost::size(tasks));
-        int index = 0;
+        mStateData.reserve(mStateIndex->size());
         for (const auto& [id, task] : tasks) {
             bool expendable = mSession.mExpendableTasks.find(id) != mSession.mExpendableTasks.end();
             mStateData.push_back(DeviceStatus(expendable, id, task.m_taskCollectionId));
-            mStateIndex.emplace(id, index++);
         }
+        mTransitionDurations.resize(mStateData.size(), TransitionDurations{});
 
         SubscribeToCommands();
         SubscribeToTaskDoneEvents();
@@ -112,7 +120,7 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         mDDSService.start(to_string(mSession.mDDSSession.getSessionID()));
         SubscribeToStateChanges();
         if (blockUntilConnected) {
-            WaitForPublisherCount(mStateIndex.size());
+            WaitForPublisherCount(mStateIndex->size());
         }
     }
 
@@ -128,12 +136,20 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     {
         UnsubscribeFromStateChanges();
 
+        if (mDirectChannel) {
+            // no more frame handlers from here on
+            mDirectChannel->Stop();
+        }
+
         mDDSCustomCmd.unsubscribe();
         try {
             std::lock_guard<std::mutex> lk(*mMtx);
             for (auto& op : mChangeStateOps) {
                 op.second.Complete(MakeErrorCode(ErrorCode::OperationCanceled));
             }
+            for (auto& op : mChangeStateSequenceOps) {
+                op.second.Complete(MakeErrorCode(ErrorCode::OperationCanceled));
+            }
         } catch (...) {
         }
         mDDSOnTaskDoneRequest->unsubscribeResponseCallback();
@@ -146,9 +162,9 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
         dds::topology_api::STopoRuntimeTask::FilterIteratorPair_t itPair;
         if (path.empty()) {
-            itPair = mDDSTopo.getRuntimeTaskIterator(nullptr); // passing nullptr will get all tasks
+            itPair = mDDSTopo->getRuntimeTaskIterator(nullptr); // passing nullptr will get all tasks
         } else {
-            itPair = mDDSTopo.getRuntimeTaskIteratorMatchingPath(path);
+            itPair = mDDSTopo->getRuntimeTaskIteratorMatchingPath(path);
         }
         auto tasks = boost::make_iterator_range(itPair.first, itPair.second);
 
@@ -160,7 +176,7 @@ class BasicTopology : public AsioBase<Executor, Allocator>
             //            << "Path: " << task.second.m_taskPath << ", "
             //            << "Collection id: " << task.second.m_taskCollectionId << ", "
             //            << "Name: " << task.second.m_task->getName() << "_" << task.second.m_taskIndex;
-            const DeviceStatus& ds = mStateData.at(mStateIndex.at(task.first));
+            const DeviceStatus& ds = mStateData.at(mStateIndex->at(task.first));
             if (ds.ignored) {
                 // OLOG(debug, mPartitionID, mSession.mLastRunNr.load()) << "GetTasks(): Task " << ds.taskId << " has failed and is set to be ignored, skipping";
                 continue;
@@ -174,7 +190,9 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     void SubscribeToStateChanges()
     {
         // FAIR_LOG(debug) << "Subscribing to state change";
-        cc::Cmds cmds(cc::make<cc::SubscribeToStateChange>(mHeartbeatInterval.count()));
+        // let the devices spread their replies, instead of all of them replying at once
+        mSubscriptionReplyWindow = std::chrono::milliseconds(mStateIndex->size() * mSubscriptionReplySpacing.count() / 1000);
+        cc::Cmds cmds(cc::make<cc::SubscribeToStateChange>(mHeartbeatInterval.count(), mSubscriptionReplyWindow.count()));
         mDDSCustomCmd.send(cmds.Serialize(), "");
 
         mHeartbeatsTimer.expires_after(mHeartbeatInterval);
@@ -192,7 +210,12 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
             {
                 std::unique_lock<std::mutex> lk(*mMtx);
-                DeviceStatus& device = mStateData.at(mStateIndex.at(task.m_taskID));
+                auto index = mStateIndex->find(task.m_taskID);
+                if (index == mStateIndex->end()) {
+                    // task was removed from the topology by an update
+                    return;
+                }
+                DeviceStatus& device = mStateData.at(index->second);
                 if (device.subscribedToStateChanges) {
                     device.subscribedToStateChanges = false;
                     --mNumStateChangePublishers;
@@ -219,12 +242,12 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                     device.state = DeviceState::Exiting;
                 }
 
-                for (auto& op : mChangeStateOps) {
-                    op.second.Update(device.taskId, device.state, expendable);
-                }
-                for (auto& op : mWaitForStateOps) {
-                    op.second.Update(device.taskId, device.lastState, device.state, expendable);
-                }
+                UpdateStateOps(device.taskId, device.lastState, device.state, expendable, unexpected && !expendable);
+            }
+
+            if (unexpected) {
+                // the agent of the task may be gone
+                mSession.mAgentInventory.invalidate();
             }
 
             std::stringstream ss;
@@ -248,11 +271,45 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     void CheckExpendable(FailedDevices failed)
     {
         for (auto& deviceId : failed) {
-            DeviceStatus& device = mStateData.at(mStateIndex.at(deviceId));
+            DeviceStatus& device = mStateData.at(mStateIndex->at(deviceId));
             IgnoreExpendable(device);
         }
     }
 
+    // Ignore the stragglers of a state operation that can be lost: expendable devices and collections that nMin allows to lose
+    // precondition: mMtx is locked
+    void ShedStragglers(FailedDevices stragglers)
+    {
+        for (auto& deviceId : stragglers) {
+            DeviceStatus& device = mStateData.at(mStateIndex->at(deviceId));
+            if (device.ignored) {
+                // e.g. by shedding its collection
+                continue;
+            }
+            if (device.expendable) {
+                OLOG(info, mPartitionID, mSession.mLastRunNr.load()) << "Shedding straggling expendable device " << device.taskId;
+                IgnoreDevice(device);
+            } else if (device.collectionId != 0 && CanLoseCollection(device.collectionId)) {
+                OLOG(info, mPartitionID, mSession.mLastRunNr.load()) << "Shedding straggling collection " << device.collectionId << " of device " << device.taskId;
+                IgnoreExpendable(device);
+            }
+        }
+    }
+
+    // Whether the collection can fail without violating nMin
+    // precondition: mMtx is locked
+    bool CanLoseCollection(DDSCollection::Id collectionId)
+    {
+        auto col = mDDSTopo->getRuntimeCollectionById(collectionId).m_collection;
+        auto it = mSession.mCollections.find(col->getName());
+        if (it == mSession.mCollections.end() || it->second.nMin == -1) {
+            return false;
+        }
+        const CollectionInfo& colInfo = it->second;
+        const bool alreadyFailed = colInfo.mFailedRuntimeCollections.count(collectionId) > 0;
+        return alreadyFailed || colInfo.nCurrent - 1 >= colInfo.nMin;
+    }
+
     // precondition: mMtx is locked
     bool IgnoreExpendable(odc::core::DeviceStatus& device)
     {
@@ -270,7 +327,7 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
         // if task is not expendable, but is in a collection, check nMin condition
         if (device.collectionId != 0) {
-            auto runtimeCollection = mDDSTopo.getRuntimeCollectionById(device.collectionId);
+            auto runtimeCollection = mDDSTopo->getRuntimeCollectionById(device.collectionId);
             auto col = runtimeCollection.m_collection;
             auto it = mSession.mCollections.find(col->getName());
             if (it != mSession.mCollections.end()) {
@@ -286,17 +343,70 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
                     // TODO: shutdown agent only if it has no tasks left
                     uint64_t agentId = colInfo.mRuntimeCollectionAgents.at(device.collectionId);
-                    ShutdownDDSAgent(agentId);
+                    ScheduleAgentShutdown(agentId);
 
                     return true;
                 }
+                AddUnignorableFailure(toString("collection '", runtimeCollection.m_collectionPath, "' (id: ", device.collectionId, ")",
+                                               colInfo.nMin == -1 ? toString(", no nMin defined") : toString(", ", colInfo.nCurrent, " left of nMin ", colInfo.nMin)));
+                return false;
             }
         }
 
         // otherwise it is not expendable
+        AddUnignorableFailure(toString("task ", device.taskId));
         return false;
     }
 
+    // precondition: mMtx is locked.
+    void AddUnignorableFailure(const std::string& failure)
+    {
+        if (std::find(mUnignorableFailures.begin(), mUnignorableFailures.end(), failure) == mUnignorableFailures.end()) {
+            mUnignorableFailures.push_back(failure);
+        }
+    }
+
+    // Update the pending state operations with the state of a device.
+    // unignorableFailure: the device failed and the failure cannot be ignored (see IgnoreExpendable()).
+    // With the fail-fast policy, the operations involving the device are completed right away then, as their target state became unreachable,
+    // instead of waiting for their timeout. Operations on other devices are not affected.
+    // precondition: mMtx is locked.
+    void UpdateStateOps(DDSTask::Id taskId, DeviceState lastState, DeviceState state, bool expendable, bool unignorableFailure)
+    {
+        const auto ec = MakeErrorCode(ErrorCode::TargetStateUnreachable);
+        // the op forgets the failed task in Update(), check for it beforehand
+        auto failFast = [&](auto& op, bool involved) {
+            if (mFailFast && unignorableFailure && involved && !op.IsCompleted()) {
+                op.Complete(ec);
+            }
+        };
+        for (auto& op : mChangeStateOps) {
+            const bool involved = op.second.ContainsTask(taskId);
+            op.second.Update(taskId, state, expendable);
+            failFast(op.second, involved);
+        }
+        for (auto& op : mChangeStateSequenceOps) {
+            const bool involved = op.second.ContainsTask(taskId);
+            op.second.Update(taskId, state, expendable);
+            failFast(op.second, involved);
+        }
+        for (auto& op : mWaitForStateOps) {
+            const bool involved = op.second.ContainsTask(taskId);
+            op.second.Update(taskId, lastState, state, expendable);
+            failFast(op.second, involved);
+        }
+    }
+
+    // A new state operation starts, forget the failures reported for the previous ones, unless one of them is still pending.
+    // precondition: mMtx is locked.
+    void ResetUnignorableFailures()
+    {
+        auto pending = [](auto& ops) { return std::any_of(ops.begin(), ops.end(), [](auto& op) { return !op.second.IsCompleted(); }); };
+        if (!pending(mChangeStateOps) && !pending(mChangeStateSequenceOps) && !pending(mWaitForStateOps)) {
+            mUnignorableFailures.clear();
+        }
+    }
+
     bool CheckNmin(int32_t nCurrent, int32_t nMin, const std::string& runtimeColPath, const std::string& colPath, DDSCollection::Id colId)
     {
         if (nMin == -1) {
@@ -336,6 +446,16 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         IgnoreTaskForAllOps(device.taskId);
     }
 
+    // The agent of a failed collection is sent the shutdown signal right away (the request is asynchronous).
+    // Waiting for its slots to go away and updating the slot accounting is left to the owner, see TakeShutdownAgents().
+    // precondition: mMtx is locked.
+    void ScheduleAgentShutdown(uint64_t agentID)
+    {
+        if (mShutdownAgents.insert(agentID).second) {
+            ShutdownDDSAgents({ agentID });
+        }
+    }
+
     // precondition: mMtx is locked.
     void IgnoreCollectionDevices(odc::core::DDSCollection::Id id)
     {
@@ -351,6 +471,9 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         for (auto& op : mChangeStateOps) {
             op.second.Ignore(id);
         }
+        for (auto& op : mChangeStateSequenceOps) {
+            op.second.Ignore(id);
+        }
         for (auto& op : mWaitForStateOps) {
             op.second.Ignore(id);
         }
@@ -368,12 +491,16 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         std::unique_lock<std::mutex> lk(*mMtx);
         auto publisherCountReached = [&]() { return mNumStateChangePublishers == number; };
         auto count = 0;
+        auto start = std::chrono::steady_clock::now();
         constexpr auto checkInterval(50ms);
-        constexpr auto maxCount(30s / checkInterval);
+        // replies are spread over the reply window, wait for that much longer
+        const auto maxCount((30s + mSubscriptionReplyWindow) / checkInterval);
         while (!publisherCountReached() && mSession.mDDSSession.IsRunning() && count < maxCount) {
             mStateChangeSubscriptionsCV->wait_for(lk, checkInterval, publisherCountReached);
             ++count;
         }
+        OLOG(debug, mPartitionID, mSession.mLastRunNr.load()) << "Waited " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+            << " ms for " << number << " state change publishers (reply window: " << mSubscriptionReplyWindow.count() << " ms), current count: " << mNumStateChangePublishers;
     }
 
     void SendSubscriptionHeartbeats(const boost::system::error_code& ec)
@@ -404,39 +531,107 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     void SubscribeToCommands()
     {
         mDDSCustomCmd.subscribe([&](const std::string& msg, const std::string& /* condition */, uint64_t ddsSenderChannelId) {
-            cc::Cmds inCmds;
-            inCmds.Deserialize(msg);
-            // OLOG(debug) << "Received " << inCmds.Size() << " command(s) with total size of " <<
-            // msg.length() << " bytes: ";
+            HandleCmds(msg, std::to_string(ddsSenderChannelId));
+        });
+    }
 
-            for (const auto& cmd : inCmds) {
-                // OLOG(debug) << " > " << cmd->GetType();
-                switch (cmd->GetType()) {
-                    case cc::Type::state_change_subscription:
-                        HandleCmd(static_cast<cc::StateChangeSubscription&>(*cmd));
-                        break;
-                    case cc::Type::state_change_unsubscription:
-                        HandleCmd(static_cast<cc::StateChangeUnsubscription&>(*cmd));
-                        break;
-                    case cc::Type::state_change:
-                        HandleCmd(static_cast<cc::StateChange&>(*cmd));
-                        break;
-                    case cc::Type::transition_status:
-                        HandleCmd(static_cast<cc::TransitionStatus&>(*cmd));
-                        break;
-                    case cc::Type::properties:
-                        HandleCmd(static_cast<cc::Properties&>(*cmd));
-                        break;
-                    case cc::Type::properties_set:
-                        HandleCmd(static_cast<cc::PropertiesSet&>(*cmd));
-                        break;
-                    default:
-                        OLOG(warning) << "Unexpected/unknown command received: " << cmd->GetType();
-                        OLOG(warning) << "Origin: " << ddsSenderChannelId;
-                        break;
-                }
+    /// @brief Handle commands received from the devices, via DDS or via the direct channel
+    /// @param msg serialized commands
+    /// @param origin sender description, for logging
+    void HandleCmds(const std::string& msg, const std::string& origin)
+    {
+        cc::Cmds inCmds;
+        inCmds.Deserialize(msg);
+        // OLOG(debug) << "Received " << inCmds.Size() << " command(s) with total size of " <<
+        // msg.length() << " bytes: ";
+        HandleCmds(inCmds, origin);
+    }
+
+    void HandleCmds(const cc::Cmds& inCmds, const std::string& origin)
+    {
+        for (const auto& cmd : inCmds) {
+            // OLOG(debug) << " > " << cmd->GetType();
+            switch (cmd->GetType()) {
+                case cc::Type::state_change_subscription:
+                    HandleCmd(static_cast<cc::StateChangeSubscription&>(*cmd));
+                    break;
+                case cc::Type::state_change_unsubscription:
+                    HandleCmd(static_cast<cc::StateChangeUnsubscription&>(*cmd));
+                    break;
+                case cc::Type::state_change:
+                    HandleCmd(static_cast<cc::StateChange&>(*cmd));
+                    break;
+                case cc::Type::state_change_batch:
+                    HandleCmd(static_cast<cc::StateChangeBatch&>(*cmd));
+                    break;
+                case cc::Type::transition_status:
+                    HandleCmd(static_cast<cc::TransitionStatus&>(*cmd));
+                    break;
+                case cc::Type::properties:
+                    HandleCmd(static_cast<cc::Properties&>(*cmd));
+                    break;
+                case cc::Type::properties_set:
+                    HandleCmd(static_cast<cc::PropertiesSet&>(*cmd));
+                    break;
+                case cc::Type::transition_timing:
+                    HandleCmd(static_cast<cc::TransitionTiming&>(*cmd));
+                    break;
+                default:
+                    OLOG(warning) << "Unexpected/unknown command received: " << cmd->GetType();
+                    OLOG(warning) << "Origin: " << origin;
+                    break;
             }
+        }
+    }
+
+    /// @brief Open a direct TCP channel to the devices, bypassing the DDS commander for device commands.
+    /// The endpoint is advertised to the devices via DDS, which connect to it on their own.
+    /// Commands go via DDS for as long as not all of the addressed devices are connected.
+    /// Together with the endpoint the devices receive a token, which they have to present when connecting.
+    /// @param host host name or address of this machine, reachable from the devices
+    /// @throws std::system_error if the listening socket cannot be opened
+    void EnableDirectChannel(const std::string& host)
+    {
+        mDirectChannelToken = uuid();
+        mDirectChannel = std::make_unique<cc::DirectChannelServer>(host);
+        mDirectChannel->Start([this](std::shared_ptr<cc::DirectChannelConnection> connection) {
+            std::weak_ptr<cc::DirectChannelConnection> weakConnection = connection;
+            // nothing but the identification is accepted from a connection before it is authenticated
+            connection->SetFrameSizeLimit(cc::DirectChannelConnection::fMaxHelloFrameSize);
+            connection->Start(
+                [this, weakConnection, boundTaskId = DDSTask::Id(0)](const std::string& frame) mutable {
+                    if (auto conn = weakConnection.lock()) {
+                        HandleDirectChannelFrame(conn, boundTaskId, frame);
+                    }
+                },
+                [this, weakConnection]() {
+                    std::lock_guard<std::mutex> lk(*mMtx);
+                    for (auto it = mDirectConnections.begin(); it != mDirectConnections.end();) {
+                        if (it->second.owner_before(weakConnection) || weakConnection.owner_before(it->second)) {
+                            ++it;
+                        } else {
+                            it = mDirectConnections.erase(it);
+                        }
+                    }
+                });
         });
+
+        const std::string endpoint = mDirectChannel->GetEndpoint();
+        OLOG(info, mPartitionID, mSession.mLastRunNr.load()) << "Direct channel listening on " << endpoint;
+        mDDSCustomCmd.send(cc::Cmds(cc::make<cc::DirectChannel>("", 0, endpoint, mDirectChannelToken)).Serialize(), "");
+    }
+
+    /// @brief Number of devices currently connected via the direct channel
+    size_t GetNumDirectConnections() const
+    {
+        std::lock_guard<std::mutex> lk(*mMtx);
+        return mDirectConnections.size();
+    }
+
+    size_t GetNumStateChangePublishers() const
+    {
+        std::lock_guard<std::mutex> lk(*mMtx);
+        return mNumStateChangePublishers;
     }
 
     void HandleCmd(cc::StateChangeSubscription const& cmd)
@@ -446,7 +641,7 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
             try {
                 std::unique_lock<std::mutex> lk(*mMtx);
-                DeviceStatus& task = mStateData.at(mStateIndex.at(taskId));
+                DeviceStatus& task = mStateData.at(mStateIndex->at(taskId));
                 if (!task.subscribedToStateChanges) {
                     task.subscribedToStateChanges = true;
                     ++mNumStateChangePublishers;
@@ -471,7 +666,7 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
             try {
                 std::unique_lock<std::mutex> lk(*mMtx);
-                DeviceStatus& task = mStateData.at(mStateIndex.at(taskId));
+                DeviceStatus& task = mStateData.at(mStateIndex->at(taskId));
                 if (task.subscribedToStateChanges) {
                     task.subscribedToStateChanges = false;
                     --mNumStateChangePublishers;
@@ -494,35 +689,77 @@ class BasicTopology : public AsioBase<Executor, Allocator>
 
         try {
             std::lock_guard<std::mutex> lk(*mMtx);
-            DeviceStatus& device = mStateData.at(mStateIndex.at(taskId));
-            DeviceState lastState = device.state;
-            device.lastState = cmd.GetLastState();
-            device.state = cmd.GetCurrentState();
-            // OLOG(debug, mPartitionID, mSession.mLastRunNr.load()) << "Updated state entry: taskId=" << taskId << ", state=" << device.state;
-
-            bool expendable = false;
-            // check if we have an unexpected exit
-            if (device.state == DeviceState::Error || (device.state == DeviceState::Exiting && lastState != DeviceState::Idle)) {
-                auto& deviceDetails = mSession.getTaskDetails(device.taskId);
-                OLOG(error, mPartitionID, mSession.mLastRunNr.load()) << "Device " << device.taskId << " unexpectedly reached " << device.state << " state. On host: " << deviceDetails.mHost << ", working directory: " << deviceDetails.mWrkDir;
-                // check if the device is expendable
-                expendable = IgnoreExpendable(device);
-                // Update SetProperties OPs only if unexpected exit
-                for (auto& op : mSetPropertiesOps) {
-                    op.second.Update(device.taskId, cc::Result::Failure, expendable);
-                }
+            UpdateDeviceState(taskId, cmd.GetLastState(), cmd.GetCurrentState(), cmd.GetSequence());
+        } catch (const std::exception& e) {
+            OLOG(error) << "Exception in HandleCmd(cmd::StateChange const&): " << e.what();
+            OLOG(error) << "Possibly no task with id '" << taskId << "'?";
+        }
+    }
+
+    void HandleCmd(cc::StateChangeBatch const& cmd)
+    {
+        // a device with several changes in the batch appears in several groups, apply its changes in the order they happened
+        std::vector<std::tuple<uint64_t, DDSTask::Id, DeviceState, DeviceState>> changes; // (sequence, task id, last state, current state)
+        for (const auto& group : cmd.GetGroups()) {
+            for (size_t i = 0; i < group.fTaskIds.size(); ++i) {
+                changes.emplace_back(i < group.fSequences.size() ? group.fSequences[i] : 0, group.fTaskIds[i], group.fLastState, group.fCurrentState);
             }
+        }
+        std::stable_sort(changes.begin(), changes.end(), [](const auto& lhs, const auto& rhs) { return std::get<0>(lhs) < std::get<0>(rhs); });
 
-            for (auto& op : mChangeStateOps) {
-                op.second.Update(taskId, cmd.GetCurrentState(), expendable);
+        // apply all state changes collected by the aggregator under one lock
+        std::lock_guard<std::mutex> lk(*mMtx);
+        for (const auto& [sequence, taskId, lastState, currentState] : changes) {
+            try {
+                UpdateDeviceState(taskId, lastState, currentState, sequence);
+            } catch (const std::exception& e) {
+                OLOG(error) << "Exception in HandleCmd(cmd::StateChangeBatch const&) from " << cmd.GetDeviceId() << ": " << e.what();
+                OLOG(error) << "Possibly no task with id '" << taskId << "'?";
             }
-            for (auto& op : mWaitForStateOps) {
-                op.second.Update(taskId, cmd.GetLastState(), cmd.GetCurrentState(), expendable);
+        }
+    }
+
+    // sequence: sequence number of the state change (see cc::StateChange), 0 if unknown
+    // precondition: mMtx is locked.
+    void UpdateDeviceState(DDSTask::Id taskId, DeviceState reportedLastState, DeviceState reportedState, uint64_t sequence = 0)
+    {
+        auto index = mStateIndex->find(taskId);
+        if (index == mStateIndex->end()) {
+            if (mRemovedTasks.count(taskId) > 0) {
+                // late state change of a task removed from the topology by an update
+                return;
             }
-        } catch (const std::exception& e) {
-            OLOG(error) << "Exception in HandleCmd(cmd::StateChange const&): " << e.what();
-            OLOG(error) << "Possibly no task with id '" << taskId << "'?";
+            throw std::out_of_range(toString("Unknown task ", taskId));
+        }
+        DeviceStatus& device = mStateData.at(index->second);
+        if (sequence != 0) {
+            if (sequence <= device.stateSequence) {
+                // overtaken by a newer state change, e.g. via the direct channel while this one was delayed in DDS
+                // OLOG(debug, mPartitionID, mSession.mLastRunNr.load()) << "Discarding outdated state change of task " << taskId << ": " << reportedState;
+                return;
+            }
+            device.stateSequence = sequence;
         }
+        DeviceState lastState = device.state;
+        device.lastState = reportedLastState;
+        device.state = reportedState;
+        // OLOG(debug, mPartitionID, mSession.mLastRunNr.load()) << "Updated state entry: taskId=" << taskId << ", state=" << device.state;
+
+        bool expendable = false;
+        // check if we have an unexpected exit
+        const bool unexpected = device.state == DeviceState::Error || (device.state == DeviceState::Exiting && lastState != DeviceState::Idle);
+        if (unexpected) {
+            auto& deviceDetails = mSession.getTaskDetails(device.taskId);
+            OLOG(error, mPartitionID, mSession.mLastRunNr.load()) << "Device " << device.taskId << " unexpectedly reached " << device.state << " state. On host: " << deviceDetails.mHost << ", working directory: " << deviceDetails.mWrkDir;
+            // check if the device is expendable
+            expendable = IgnoreExpendable(device);
+            // Update SetProperties OPs only if unexpected exit
+            for (auto& op : mSetPropertiesOps) {
+                op.second.Update(device.taskId, cc::Result::Failure, expendable);
+            }
+        }
+
+        UpdateStateOps(taskId, reportedLastState, reportedState, expendable, unexpected && !expendable);
     }
 
     void HandleCmd(cc::TransitionStatus const& cmd)
@@ -533,7 +770,17 @@ class BasicTopology : public AsioBase<Executor, Allocator>
             // TODO: check if this can be done from within the OP
             for (auto& op : mChangeStateOps) {
                 if (!op.second.IsCompleted() && op.second.ContainsTask(taskId)) {
-                    if (mStateData.at(mStateIndex.at(taskId)).state != op.second.GetTargetState()) {
+                    if (mStateData.at(mStateIndex->at(taskId)).state != op.second.GetTargetState()) {
+                        OLOG(error) << cmd.GetTransition() << " transition failed for " << cmd.GetDeviceId() << ", device is in " << cmd.GetCurrentState() << " state.";
+                        op.second.Complete(MakeErrorCode(ErrorCode::DeviceChangeStateInvalidTransition));
+                    } else {
+                        OLOG(debug) << cmd.GetTransition() << " transition failed for " << cmd.GetDeviceId() << ", device is already in " << cmd.GetCurrentState() << " state.";
+                    }
+                }
+            }
+            for (auto& op : mChangeStateSequenceOps) {
+                if (!op.second.IsCompleted() && op.second.ContainsTask(taskId)) {
+                    if (mStateData.at(mStateIndex->at(taskId)).state != op.second.GetTargetState(taskId)) {
                         OLOG(error) << cmd.GetTransition() << " transition failed for " << cmd.GetDeviceId() << ", device is in " << cmd.GetCurrentState() << " state.";
                         op.second.Complete(MakeErrorCode(ErrorCode::DeviceChangeStateInvalidTransition));
                     } else {
@@ -544,12 +791,13 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         }
     }
 
-    void HandleCmd(cc::Properties const& cmd)
+    void HandleCmd(cc::Properties& cmd)
     {
         try {
             std::unique_lock<std::mutex> lk(*mMtx);
             auto& op(mGetPropertiesOps.at(cmd.GetRequestId()));
-            op.Update(cmd.GetTaskId(), cmd.GetResult(), cmd.GetProps());
+            // the command is discarded after handling, move the (possibly large) properties into the result
+            op.Update(cmd.GetTaskId(), cmd.GetResult(), std::move(cmd).GetProps(), cmd.GetChunk(), cmd.IsLastChunk());
         } catch (std::out_of_range& e) {
             OLOG(debug) << "GetProperties operation (request id: " << cmd.GetRequestId() << ") not found (probably completed or timed out), "
                         << "discarding reply of device " << cmd.GetDeviceId() << ", task id: " << cmd.GetTaskId();
@@ -568,6 +816,18 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         }
     }
 
+    void HandleCmd(cc::TransitionTiming const& cmd)
+    {
+        try {
+            std::lock_guard<std::mutex> lk(*mMtx);
+            uint64_t duration = std::min<uint64_t>(cmd.GetDuration(), std::numeric_limits<uint32_t>::max());
+            // a reported zero would be indistinguishable from a missing report
+            mTransitionDurations.at(mStateIndex->at(cmd.GetTaskId())).at(static_cast<size_t>(cmd.GetTransition())) = std::max<uint64_t>(duration, 1);
+        } catch (const std::exception& e) {
+            OLOG(debug) << "Discarding transition timing of device " << cmd.GetDeviceId() << ", task id: " << cmd.GetTaskId() << ": " << e.what();
+        }
+    }
+
     /// @brief Initiate state transition on all FairMQ devices in this topology
     /// @param transition FairMQ device state machine transition
     /// @param path Select a subset of FairMQ devices in this topology, empty selects all
@@ -592,22 +852,31 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                     }
                 }
 
+                auto tasks = GetTasks(path);
+                // forget timings of the previous execution of this transition
+                for (const auto& taskId : tasks) {
+                    mTransitionDurations.at(mStateIndex->at(taskId)).at(static_cast<size_t>(transition)) = 0;
+                }
+
+                cc::Cmds cmds(cc::make<cc::ChangeState>(transition));
+                SendToTasks(cmds, path, tasks);
+
+                ResetUnignorableFailures();
                 auto [it, inserted] = mChangeStateOps.try_emplace(id,
                                                                   transition,
-                                                                  GetTasks(path),
-                                                                  mStateIndex,
+                                                                  std::move(tasks),
+                                                                  *mStateIndex,
                                                                   mStateData,
                                                                   timeout,
                                                                   *mMtx,
                                                                   std::bind(&BasicTopology::CheckExpendable, this, std::placeholders::_1),
+                                                                  mStragglerPolicy,
+                                                                  std::bind(&BasicTopology::ShedStragglers, this, std::placeholders::_1),
                                                                   AsioBase<Executor, Allocator>::GetExecutor(),
                                                                   AsioBase<Executor, Allocator>::GetAllocator(),
                                                                   std::move(handler)
                 );
 
-                cc::Cmds cmds(cc::make<cc::ChangeState>(transition));
-                mDDSCustomCmd.send(cmds.Serialize(), path);
-
                 // TODO: make sure following operation properly queues the completion and not doing it directly out of initiation call.
                 it->second.TryCompletion();
             },
@@ -633,6 +902,97 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         return { ec, state };
     }
 
+    /// @brief Initiate a sequence of state transitions on all FairMQ devices in this topology, pipelined per device
+    /// Each device receives its next transition as soon as it completed the previous one.
+    /// Only Connect waits for all devices, to make sure the peers have bound their channels.
+    /// @param transitions FairMQ device state machine transitions, in order
+    /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+    /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+    /// @param token Asio completion token
+    /// @tparam CompletionToken Asio completion token type
+    /// @throws std::system_error
+    template<typename CompletionToken>
+    auto AsyncChangeStateSequence(const std::vector<TopoTransition>& transitions, const std::string& path, Duration timeout, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, ChangeStateSequenceCompletionSignature>(
+            [&](auto handler) {
+                std::lock_guard<std::mutex> lk(*mMtx);
+                StartChangeStateSequence(transitions,
+                                         GetTasks(path),
+                                         std::bind(&BasicTopology::SendChangeState, this, path, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+                                         timeout,
+                                         std::move(handler));
+            },
+            token);
+    }
+
+    /// @brief Initiate a sequence of state transitions on the given FairMQ devices, pipelined per device
+    /// @param transitions FairMQ device state machine transitions, in order
+    /// @param tasks Select a subset of FairMQ devices in this topology by task ID
+    /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+    /// @param token Asio completion token
+    /// @tparam CompletionToken Asio completion token type
+    /// @throws std::system_error
+    template<typename CompletionToken>
+    auto AsyncChangeStateSequence(const std::vector<TopoTransition>& transitions, const std::unordered_set<DDSTask::Id>& tasks, Duration timeout, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, ChangeStateSequenceCompletionSignature>(
+            [&](auto handler) {
+                std::lock_guard<std::mutex> lk(*mMtx);
+                // the tasks are not selected by a path, address each of them
+                StartChangeStateSequence(transitions,
+                                         GetTasks(tasks),
+                                         [this](TopoTransition transition, const std::unordered_set<DDSTask::Id>& selected, bool /* all */) { SendChangeState("", transition, selected, false); },
+                                         timeout,
+                                         std::move(handler));
+            },
+            token);
+    }
+
+    /// @brief Perform a sequence of state transitions on FairMQ devices in this topology, pipelined per device
+    /// @param transitions FairMQ device state machine transitions, in order
+    /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+    /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+    /// @return error code, resulting state and the time until each transition was completed by all devices
+    /// @throws std::system_error
+    std::tuple<std::error_code, TopoState, PhaseTimings> ChangeStateSequence(const std::vector<TopoTransition>& transitions, const std::string& path = "", Duration timeout = Duration(0))
+    {
+        SharedSemaphore blocker;
+        std::error_code ec;
+        TopoState state;
+        PhaseTimings timings;
+        AsyncChangeStateSequence(transitions, path, timeout, [&, blocker](std::error_code _ec, TopoState _state, PhaseTimings _timings) mutable {
+            ec = _ec;
+            state = _state;
+            timings = _timings;
+            blocker.Signal();
+        });
+        blocker.Wait();
+        return { ec, state, timings };
+    }
+
+    /// @brief Perform a sequence of state transitions on the given FairMQ devices, pipelined per device
+    /// @param transitions FairMQ device state machine transitions, in order
+    /// @param tasks Select a subset of FairMQ devices in this topology by task ID
+    /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+    /// @return error code, resulting state and the time until each transition was completed by all devices
+    /// @throws std::system_error
+    std::tuple<std::error_code, TopoState, PhaseTimings> ChangeStateSequence(const std::vector<TopoTransition>& transitions, const std::unordered_set<DDSTask::Id>& tasks, Duration timeout = Duration(0))
+    {
+        SharedSemaphore blocker;
+        std::error_code ec;
+        TopoState state;
+        PhaseTimings timings;
+        AsyncChangeStateSequence(transitions, tasks, timeout, [&, blocker](std::error_code _ec, TopoState _state, PhaseTimings _timings) mutable {
+            ec = _ec;
+            state = _state;
+            timings = _timings;
+            blocker.Signal();
+        });
+        blocker.Wait();
+        return { ec, state, timings };
+    }
+
     /// @brief Returns the current state of the topology
     /// @return map of id : DeviceStatus
     TopoState GetCurrentState() const
@@ -641,6 +1001,15 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         return mStateData;
     }
 
+    /// @brief Returns durations of the last execution of the given transition, as reported by the devices
+    /// @param transition FairMQ device state machine transition
+    /// @return (task id, duration) pairs of the devices that reported a duration, ignored devices are skipped
+    TransitionTimings GetTransitionTimings(const TopoTransition transition) const
+    {
+        std::lock_guard<std::mutex> lk(*mMtx);
+        return CollectTransitionTimings(mStateData, mTransitionDurations, transition);
+    }
+
     DeviceState AggregateState() const { return AggregateState(GetCurrentState()); }
 
     bool StateEqualsTo(DeviceState state) const { return StateEqualsTo(GetCurrentState(), state); }
@@ -658,34 +1027,27 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     {
         return boost::asio::async_initiate<CompletionToken, WaitForStateCompletionSignature>(
             [&](auto handler) {
-                const uint64_t id = uuidHash();
-
                 std::lock_guard<std::mutex> lk(*mMtx);
+                StartWaitForState(targetLastState, targetCurrentState, GetTasks(path), timeout, std::move(handler));
+            },
+            token);
+    }
 
-                for (auto it = begin(mWaitForStateOps); it != end(mWaitForStateOps);) {
-                    if (it->second.IsCompleted()) {
-                        it = mWaitForStateOps.erase(it);
-                    } else {
-                        ++it;
-                    }
-                }
-
-                auto [it, inserted] = mWaitForStateOps.try_emplace(id,
-                                                                   targetLastState,
-                                                                   targetCurrentState,
-                                                                   GetTasks(path),
-                                                                   mStateIndex,
-                                                                   mStateData,
-                                                                   timeout,
-                                                                   *mMtx,
-                                                                   std::bind(&BasicTopology::CheckExpendable, this, std::placeholders::_1),
-                                                                   AsioBase<Executor, Allocator>::GetExecutor(),
-                                                                   AsioBase<Executor, Allocator>::GetAllocator(),
-                                                                   std::move(handler)
-                );
-
-                // TODO: make sure following operation properly queues the completion and not doing it directly out of initiation call.
-                it->second.TryCompletion();
+    /// @brief Initiate waiting for the given FairMQ devices to reach given last & current state
+    /// @param targetLastState the target last device state to wait for
+    /// @param targetCurrentState the target device state to wait for
+    /// @param tasks Select a subset of FairMQ devices in this topology by task ID
+    /// @param timeout Timeout in milliseconds, 0 means no timeout
+    /// @param token Asio completion token
+    /// @tparam CompletionToken Asio completion token type
+    /// @throws std::system_error
+    template<typename CompletionToken>
+    auto AsyncWaitForState(const DeviceState targetLastState, const DeviceState targetCurrentState, const std::unordered_set<DDSTask::Id>& tasks, Duration timeout, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, WaitForStateCompletionSignature>(
+            [&](auto handler) {
+                std::lock_guard<std::mutex> lk(*mMtx);
+                StartWaitForState(targetLastState, targetCurrentState, GetTasks(tasks), timeout, std::move(handler));
             },
             token);
     }
@@ -710,6 +1072,26 @@ class BasicTopology : public AsioBase<Executor, Allocator>
         return { ec, failed };
     }
 
+    /// @brief Wait for the given FairMQ devices to reach given last & current state
+    /// @param targetLastState the target last device state to wait for
+    /// @param targetCurrentState the target device state to wait for
+    /// @param tasks Select a subset of FairMQ devices in this topology by task ID
+    /// @param timeout Timeout in milliseconds, 0 means no timeout
+    /// @throws std::system_error
+    std::pair<std::error_code, FailedDevices> WaitForState(const DeviceState targetLastState, const DeviceState targetCurrentState, const std::unordered_set<DDSTask::Id>& tasks, Duration timeout = Duration(0))
+    {
+        SharedSemaphore blocker;
+        std::error_code ec;
+        FailedDevices failed;
+        AsyncWaitForState(targetLastState, targetCurrentState, tasks, timeout, [&, blocker](std::error_code _ec, FailedDevices _failed) mutable {
+            ec = _ec;
+            failed = _failed;
+            blocker.Signal();
+        });
+        blocker.Wait();
+        return { ec, failed };
+    }
+
     /// @brief Initiate property query on selected FairMQ devices in this topology
     /// @param query Key(s) to be queried (regex)
     /// @param path Select a subset of FairMQ devices in this topology, empty selects all
@@ -734,8 +1116,12 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                     }
                 }
 
+                auto tasks = GetTasks(path);
+                cc::Cmds const cmds(cc::make<cc::GetProperties>(id, query, mPropertiesChunkSize));
+                SendToTasks(cmds, path, tasks);
+
                 mGetPropertiesOps.try_emplace(id,
-                                              GetTasks(path),
+                                              std::move(tasks),
                                               timeout,
                                               *mMtx,
                                               std::bind(&BasicTopology::CheckExpendable, this, std::placeholders::_1),
@@ -744,8 +1130,6 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                                               std::move(handler)
                 );
 
-                cc::Cmds const cmds(cc::make<cc::GetProperties>(id, query));
-                mDDSCustomCmd.send(cmds.Serialize(), path);
             },
             token);
     }
@@ -793,9 +1177,13 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                     }
                 }
 
+                auto tasks = GetTasks(path);
+                cc::Cmds const cmds(cc::make<cc::SetProperties>(id, props));
+                SendToTasks(cmds, path, tasks);
+
                 auto [it, inserted] = mSetPropertiesOps.try_emplace(id,
-                                                                    GetTasks(path),
-                                                                    mStateIndex,
+                                                                    std::move(tasks),
+                                                                    *mStateIndex,
                                                                     mStateData,
                                                                     timeout,
                                                                     *mMtx,
@@ -805,9 +1193,6 @@ class BasicTopology : public AsioBase<Executor, Allocator>
                                                                     std::move(handler)
                 );
 
-                cc::Cmds const cmds(cc::make<cc::SetProperties>(id, props));
-                mDDSCustomCmd.send(cmds.Serialize(), path);
-
                 // TODO: make sure following operation properly queues the completion and not doing it directly out of initiation call.
                 it->second.TryCompletion();
             },
@@ -836,42 +1221,369 @@ class BasicTopology : public AsioBase<Executor, Allocator>
     std::chrono::milliseconds GetHeartbeatInterval() const { return mHeartbeatInterval; }
     void SetHeartbeatInterval(std::chrono::milliseconds duration) { mHeartbeatInterval = duration; }
 
-    void ShutdownDDSAgent(uint64_t agentID)
+    /// @brief Fail-fast policy: complete the pending state operations involving a device with ErrorCode::TargetStateUnreachable as soon as it fails and the failure cannot be ignored, e.g. because nMin of its collection is violated
+    bool GetFailFast() const { return mFailFast; }
+    void SetFailFast(bool failFast) { mFailFast = failFast; }
+
+    /// @brief Straggler policy of the state operations started after this call, see StragglerPolicy
+    StragglerPolicy GetStragglerPolicy() const { return mStragglerPolicy; }
+    void SetStragglerPolicy(const StragglerPolicy& policy) { mStragglerPolicy = policy; }
+
+    /// @brief Failed collections and tasks that could not be ignored, e.g. because nMin of the collection is violated,
+    /// since the start of the last state operation (ChangeState, ChangeStateSequence, WaitForState)
+    std::vector<std::string> GetUnignorableFailures() const
     {
-        try {
-            using namespace dds::tools_api;
-            OLOG(info, mPartitionID, mSession.mLastRunNr.load()) << "Sending shutdown signal to agent " << agentID;;
-            SAgentCommandRequest::request_t agentCmd;
-            agentCmd.m_commandType = SAgentCommandRequestData::EAgentCommandType::shutDownByID;
-            agentCmd.m_arg1 = agentID;
-            SAgentCommandRequest::ptr_t requestPtr{ SAgentCommandRequest::makeRequest(agentCmd) };
-            mSession.mDDSSession.sendRequest<SAgentCommandRequest>(requestPtr);
-        } catch (std::exception& e) {
-            OLOG(error, mPartitionID, mSession.mLastRunNr.load()) << "Failed sending shutdown signal to agent with id " << agentID << ": " << e.what();
+        std::lock_guard<std::mutex> lk(*mMtx);
+        return mUnignorableFailures;
+    }
+
+    /// @brief Max. size in bytes of a single properties reply message, larger replies are streamed in chunks. 0 disables chunking.
+    uint32_t GetPropertiesChunkSize() const { return mPropertiesChunkSize; }
+    void SetPropertiesChunkSize(uint32_t size) { mPropertiesChunkSize = size; }
+
+    /// @brief Agents sent the shutdown signal since the last call, after their collections were dropped (nMin)
+    std::unordered_set<uint64_t> TakeShutdownAgents()
+    {
+        std::unordered_set<uint64_t> agentIDs;
+        std::lock_guard<std::mutex> lk(*mMtx);
+        agentIDs.swap(mShutdownAgents);
+        return agentIDs;
+    }
+
+    /// @brief Send the shutdown signal to the given agents, without waiting for them to shut down
+    void ShutdownDDSAgents(const std::unordered_set<uint64_t>& agentIDs)
+    {
+        using namespace dds::tools_api;
+        OLOG(info, mPartitionID, mSession.mLastRunNr.load()) << "Sending shutdown signal to " << agentIDs.size() << " agent(s)";
+        for (const auto agentID : agentIDs) {
+            try {
+                SAgentCommandRequest::request_t agentCmd;
+                agentCmd.m_commandType = SAgentCommandRequestData::EAgentCommandType::shutDownByID;
+                agentCmd.m_arg1 = agentID;
+                SAgentCommandRequest::ptr_t requestPtr{ SAgentCommandRequest::makeRequest(agentCmd) };
+                mSession.mDDSSession.sendRequest<SAgentCommandRequest>(requestPtr);
+            } catch (std::exception& e) {
+                OLOG(error, mPartitionID, mSession.mLastRunNr.load()) << "Failed sending shutdown signal to agent with id " << agentID << ": " << e.what();
+            }
+        }
+        if (!agentIDs.empty()) {
+            mSession.mAgentInventory.invalidate();
+        }
+    }
+
+    /// @brief Compare the runtime tasks of two DDS topologies
+    /// @param from current topology
+    /// @param to new topology
+    static TopologyDiff Diff(dds::topology_api::CTopology& from, dds::topology_api::CTopology& to)
+    {
+        TopologyDiff diff;
+        std::unordered_set<DDSTask::Id> fromTasks;
+        auto fromIt = from.getRuntimeTaskIterator(nullptr);
+        for (const auto& [id, task] : boost::make_iterator_range(fromIt.first, fromIt.second)) {
+            fromTasks.emplace(id);
+        }
+        auto toIt = to.getRuntimeTaskIterator(nullptr);
+        for (const auto& [id, task] : boost::make_iterator_range(toIt.first, toIt.second)) {
+            if (fromTasks.erase(id) > 0) {
+                ++diff.unchanged;
+            } else {
+                diff.added.emplace(id);
+            }
+        }
+        diff.removed = std::move(fromTasks);
+        return diff;
+    }
+
+    /// @brief Follow an update of the DDS topology, without disturbing the devices that are part of both topologies.
+    /// State tracking of the unchanged devices is kept, the added devices are subscribed to.
+    /// Late messages of the removed devices are ignored until the next update.
+    /// @param topo updated DDS topology, must outlive this object or the next update
+    /// @param diff difference between the current and the updated topology, see Diff()
+    /// @throw std::runtime_error if operations are in progress
+    void ApplyUpdate(dds::topology_api::CTopology& topo, const TopologyDiff& diff)
+    {
+        {
+            std::lock_guard<std::mutex> lk(*mMtx);
+
+            // the operations refer to the state layout that is replaced here
+            auto pending = [](auto& ops) { return std::any_of(ops.begin(), ops.end(), [](auto& op) { return !op.second.IsCompleted(); }); };
+            if (pending(mChangeStateOps) || pending(mChangeStateSequenceOps) || pending(mWaitForStateOps) || pending(mGetPropertiesOps) || pending(mSetPropertiesOps)) {
+                throw std::runtime_error("Cannot update the topology while operations are in progress");
+            }
+
+            TopoState stateData;
+            std::shared_ptr<const TopoStateIndex> stateIndex = mSession.layoutTasks(topo);
+            std::vector<TransitionDurations> transitionDurations;
+            auto itPair = topo.getRuntimeTaskIterator(nullptr);
+            auto tasks = boost::make_iterator_range(itPair.first, itPair.second);
+            stateData.reserve(stateIndex->size());
+            transitionDurations.reserve(stateIndex->size());
+            for (const auto& [id, task] : tasks) {
+                bool expendable = mSession.mExpendableTasks.find(id) != mSession.mExpendableTasks.end();
+                auto current = mStateIndex->find(id);
+                if (current != mStateIndex->end()) {
+                    stateData.push_back(mStateData.at(current->second));
+                    stateData.back().expendable = expendable;
+                    transitionDurations.push_back(mTransitionDurations.at(current->second));
+                } else {
+                    stateData.push_back(DeviceStatus(expendable, id, task.m_taskCollectionId));
+                    transitionDurations.push_back(TransitionDurations{});
+                }
+            }
+
+            mRemovedTasks.clear();
+            for (const auto& taskId : diff.removed) {
+                auto current = mStateIndex->find(taskId);
+                if (current != mStateIndex->end() && mStateData.at(current->second).subscribedToStateChanges) {
+                    --mNumStateChangePublishers;
+                }
+                mDirectConnections.erase(taskId);
+                mRemovedTasks.insert(taskId);
+            }
+
+            mStateData = std::move(stateData);
+            mStateIndex = std::move(stateIndex);
+            mTransitionDurations = std::move(transitionDurations);
+            mDDSTopo = &topo;
+        }
+
+        // the unchanged devices are already subscribed
+        cc::Cmds cmds(cc::make<cc::SubscribeToStateChange>(mHeartbeatInterval.count(), mSubscriptionReplyWindow.count()));
+        const std::string msg = cmds.Serialize();
+        for (const auto& taskId : diff.added) {
+            mDDSCustomCmd.send(msg, std::to_string(taskId));
         }
     }
 
   private:
+    // Called on the strand of the connection.
+    // boundTaskId: task the connection is authenticated for, 0 until the device identified itself.
+    void HandleDirectChannelFrame(const std::shared_ptr<cc::DirectChannelConnection>& connection, DDSTask::Id& boundTaskId, const std::string& frame)
+    {
+        try {
+            cc::Cmds inCmds;
+            inCmds.Deserialize(frame);
+            if (boundTaskId == 0) {
+                // the device identifies itself with the first frame, presenting the token of the direct_channel command
+                if (inCmds.Size() != 1 || inCmds.At(0).GetType() != cc::Type::direct_channel) {
+                    OLOG(warning, mPartitionID, mSession.mLastRunNr.load()) << "Direct channel connection did not identify itself, closing";
+                    connection->Close();
+                    return;
+                }
+                auto& hello = static_cast<const cc::DirectChannel&>(inCmds.At(0));
+                std::lock_guard<std::mutex> lk(*mMtx);
+                if (!cc::DirectChannelTokenMatches(hello.GetToken(), mDirectChannelToken)) {
+                    OLOG(warning, mPartitionID, mSession.mLastRunNr.load()) << "Direct channel connection of task " << hello.GetTaskId() << " presented an invalid token, closing";
+                    connection->Close();
+                    return;
+                }
+                if (hello.GetTaskId() == 0 || mStateIndex->find(hello.GetTaskId()) == mStateIndex->end()) {
+                    OLOG(warning, mPartitionID, mSession.mLastRunNr.load()) << "Direct channel connection from unknown task " << hello.GetTaskId() << ", closing";
+                    connection->Close();
+                    return;
+                }
+                auto& bound = mDirectConnections[hello.GetTaskId()];
+                if (bound && bound != connection) {
+                    // the device reconnected, the previous connection is stale
+                    bound->Close();
+                }
+                bound = connection;
+                boundTaskId = hello.GetTaskId();
+                connection->SetFrameSizeLimit(cc::DirectChannelConnection::fMaxFrameSize);
+                return;
+            }
+            // a connection carries the commands of its own device only
+            for (const auto& cmd : inCmds) {
+                if (!IsSentByTask(*cmd, boundTaskId)) {
+                    OLOG(warning, mPartitionID, mSession.mLastRunNr.load()) << "Direct channel connection of task " << boundTaskId << " sent " << cmd->GetType() << " of another task, closing";
+                    connection->Close();
+                    return;
+                }
+            }
+            HandleCmds(inCmds, "direct channel");
+        } catch (const std::exception& e) {
+            OLOG(error, mPartitionID, mSession.mLastRunNr.load()) << "Failed to handle direct channel frame: " << e.what();
+            if (boundTaskId == 0) {
+                connection->Close();
+            }
+        }
+    }
+
+    // Whether the command is one a device sends, and was sent by the given task
+    static bool IsSentByTask(const cc::Cmd& cmd, DDSTask::Id taskId)
+    {
+        switch (cmd.GetType()) {
+            case cc::Type::state_change_subscription: return static_cast<const cc::StateChangeSubscription&>(cmd).GetTaskId() == taskId;
+            case cc::Type::state_change_unsubscription: return static_cast<const cc::StateChangeUnsubscription&>(cmd).GetTaskId() == taskId;
+            case cc::Type::state_change: return static_cast<const cc::StateChange&>(cmd).GetTaskId() == taskId;
+            // the state changes and transition timings of other devices are forwarded by aggregating devices
+            case cc::Type::state_change_batch: return static_cast<const cc::StateChangeBatch&>(cmd).GetTaskId() == taskId;
+            case cc::Type::transition_timing: return true;
+            case cc::Type::transition_status: return static_cast<const cc::TransitionStatus&>(cmd).GetTaskId() == taskId;
+            case cc::Type::properties: return static_cast<const cc::Properties&>(cmd).GetTaskId() == taskId;
+            case cc::Type::properties_set: return static_cast<const cc::PropertiesSet&>(cmd).GetTaskId() == taskId;
+            case cc::Type::direct_channel: return static_cast<const cc::DirectChannel&>(cmd).GetTaskId() == taskId;
+            default: return false;
+        }
+    }
+
+    // Send to the given tasks, via the direct channel if all of them are connected to it, otherwise via DDS.
+    // precondition: mMtx is locked.
+    void SendToTasks(const cc::Cmds& cmds, const std::string& path, const std::unordered_set<DDSTask::Id>& tasks)
+    {
+        const std::string msg = cmds.Serialize();
+        if (mDirectChannel && !tasks.empty() && msg.size() <= cc::DirectChannelConnection::fMaxFrameSize) {
+            bool allConnected = std::all_of(tasks.cbegin(), tasks.cend(), [&](DDSTask::Id taskId) {
+                auto it = mDirectConnections.find(taskId);
+                return it != mDirectConnections.end() && it->second->IsOpen();
+            });
+            if (allConnected) {
+                for (const auto& taskId : tasks) {
+                    mDirectConnections.at(taskId)->Send(msg);
+                }
+                return;
+            }
+        }
+        mDDSCustomCmd.send(msg, path);
+    }
+
+    // precondition: mMtx is locked.
+    template<typename Handler>
+    void StartChangeStateSequence(const std::vector<TopoTransition>& transitions, std::unordered_set<DDSTask::Id> tasks, SequenceSender sender, Duration timeout, Handler&& handler)
+    {
+        const uint64_t id = uuidHash();
+
+        for (auto it = begin(mChangeStateSequenceOps); it != end(mChangeStateSequenceOps);) {
+            if (it->second.IsCompleted()) {
+                it = mChangeStateSequenceOps.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // forget timings of the previous execution of these transitions
+        for (const auto& taskId : tasks) {
+            for (const auto& transition : transitions) {
+                mTransitionDurations.at(mStateIndex->at(taskId)).at(static_cast<size_t>(transition)) = 0;
+            }
+        }
+
+        ResetUnignorableFailures();
+        auto [it, inserted] = mChangeStateSequenceOps.try_emplace(id,
+                                                                  transitions,
+                                                                  std::move(tasks),
+                                                                  *mStateIndex,
+                                                                  mStateData,
+                                                                  timeout,
+                                                                  *mMtx,
+                                                                  std::bind(&BasicTopology::CheckExpendable, this, std::placeholders::_1),
+                                                                  std::move(sender),
+                                                                  mStragglerPolicy,
+                                                                  std::bind(&BasicTopology::ShedStragglers, this, std::placeholders::_1),
+                                                                  AsioBase<Executor, Allocator>::GetExecutor(),
+                                                                  AsioBase<Executor, Allocator>::GetAllocator(),
+                                                                  std::forward<Handler>(handler)
+        );
+
+        it->second.Start();
+    }
+
+    // precondition: mMtx is locked.
+    template<typename Handler>
+    void StartWaitForState(const DeviceState targetLastState, const DeviceState targetCurrentState, std::unordered_set<DDSTask::Id> tasks, Duration timeout, Handler&& handler)
+    {
+        const uint64_t id = uuidHash();
+
+        for (auto it = begin(mWaitForStateOps); it != end(mWaitForStateOps);) {
+            if (it->second.IsCompleted()) {
+                it = mWaitForStateOps.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        ResetUnignorableFailures();
+        auto [it, inserted] = mWaitForStateOps.try_emplace(id,
+                                                           targetLastState,
+                                                           targetCurrentState,
+                                                           std::move(tasks),
+                                                           *mStateIndex,
+                                                           mStateData,
+                                                           timeout,
+                                                           *mMtx,
+                                                           std::bind(&BasicTopology::CheckExpendable, this, std::placeholders::_1),
+                                                           mStragglerPolicy,
+                                                           std::bind(&BasicTopology::ShedStragglers, this, std::placeholders::_1),
+                                                           AsioBase<Executor, Allocator>::GetExecutor(),
+                                                           AsioBase<Executor, Allocator>::GetAllocator(),
+                                                           std::forward<Handler>(handler)
+        );
+
+        // TODO: make sure following operation properly queues the completion and not doing it directly out of initiation call.
+        it->second.TryCompletion();
+    }
+
+    // The given tasks that are part of this topology and not ignored.
+    // precondition: mMtx is locked.
+    std::unordered_set<DDSTask::Id> GetTasks(const std::unordered_set<DDSTask::Id>& tasks) const
+    {
+        std::unordered_set<DDSTask::Id> set;
+        set.reserve(tasks.size());
+        for (const auto& taskId : tasks) {
+            auto index = mStateIndex->find(taskId);
+            if (index != mStateIndex->end() && !mStateData.at(index->second).ignored) {
+                set.emplace(taskId);
+            }
+        }
+        return set;
+    }
+
+    // Send a transition of a pipelined sequence to the tasks of the path.
+    // If only some of them are ready for it, one command listing them is sent to the path, the other tasks ignore it.
+    // precondition: mMtx is locked.
+    void SendChangeState(const std::string& path, TopoTransition transition, const std::unordered_set<DDSTask::Id>& tasks, bool all)
+    {
+        if (all) {
+            SendToTasks(cc::Cmds(cc::make<cc::ChangeState>(transition)), path, tasks);
+            return;
+        }
+        SendToTasks(cc::Cmds(cc::make<cc::ChangeState>(transition, std::vector<uint64_t>(tasks.cbegin(), tasks.cend()))), path, tasks);
+    }
+
     Session& mSession;
     dds::intercom_api::CIntercomService mDDSService;
     dds::intercom_api::CCustomCmd mDDSCustomCmd;
-    dds::topology_api::CTopology& mDDSTopo;
+    dds::topology_api::CTopology* mDDSTopo; ///< replaced by ApplyUpdate()
     dds::tools_api::SOnTaskDoneRequest::ptr_t mDDSOnTaskDoneRequest;
     TopoState mStateData;
-    TopoStateIndex mStateIndex;
+    std::shared_ptr<const TopoStateIndex> mStateIndex; ///< task ID -> index in mStateData, shared with the task details of the session
+    std::vector<TransitionDurations> mTransitionDurations; ///< reported transition durations, indexed like mStateData
+    std::unordered_set<DDSTask::Id> mRemovedTasks;         ///< tasks removed by the last update, their late messages are ignored
 
     mutable std::unique_ptr<std::mutex> mMtx;
 
     std::unique_ptr<std::condition_variable> mStateChangeSubscriptionsCV;
     unsigned int mNumStateChangePublishers;
     boost::asio::steady_timer mHeartbeatsTimer;
+    std::unordered_set<uint64_t> mShutdownAgents; ///< agents of failed collections sent the shutdown signal, see TakeShutdownAgents(), guarded by mMtx
     std::chrono::milliseconds mHeartbeatInterval;
+    std::chrono::microseconds mSubscriptionReplySpacing; ///< average spacing of the subscription replies, the reply window grows with the topology size
+    std::chrono::milliseconds mSubscriptionReplyWindow;
+    uint32_t mPropertiesChunkSize;
+    bool mFailFast = false; ///< see SetFailFast()
+    StragglerPolicy mStragglerPolicy; ///< see SetStragglerPolicy()
+    std::vector<std::string> mUnignorableFailures; ///< see GetUnignorableFailures(), reset when a state operation starts, guarded by mMtx
 
     std::unordered_map<uint64_t, ChangeStateOp<Executor, Allocator>> mChangeStateOps;
+    std::unordered_map<uint64_t, ChangeStateSequenceOp<Executor, Allocator>> mChangeStateSequenceOps;
     std::unordered_map<uint64_t, WaitForStateOp<Executor, Allocator>> mWaitForStateOps;
     std::unordered_map<uint64_t, SetPropertiesOp<Executor, Allocator>> mSetPropertiesOps;
     std::unordered_map<uint64_t, GetPropertiesOp<Executor, Allocator>> mGetPropertiesOps;
 
+    std::unique_ptr<cc::DirectChannelServer> mDirectChannel; ///< direct channel to the devices, if enabled
+    std::unordered_map<DDSTask::Id, std::shared_ptr<cc::DirectChannelConnection>> mDirectConnections; ///< authenticated connections of the devices, guarded by mMtx
+    std::string mDirectChannelToken; ///< token the devices authenticate with on the direct channel, sent with its endpoint via DDS
+
     std::string mPartitionID;
 
     // precodition: mMtx is locked.
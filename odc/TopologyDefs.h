@@ -10,12 +10,15 @@
 #define ODC_TOPOLOGYDEFS
 
 #include <fairmq/States.h>
+#include <odc/StringTable.h>
 #include <odc/cc/CustomCommands.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <functional>
 #include <map>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <string>
@@ -130,11 +133,26 @@ struct DeviceStatus
                   << "; signal: " << ds.signal;
     }
 
+    friend bool operator==(const DeviceStatus& lhs, const DeviceStatus& rhs)
+    {
+        return lhs.ignored == rhs.ignored
+            && lhs.expendable == rhs.expendable
+            && lhs.subscribedToStateChanges == rhs.subscribedToStateChanges
+            && lhs.lastState == rhs.lastState
+            && lhs.state == rhs.state
+            && lhs.taskId == rhs.taskId
+            && lhs.collectionId == rhs.collectionId
+            && lhs.exitCode == rhs.exitCode
+            && lhs.signal == rhs.signal;
+    }
+    friend bool operator!=(const DeviceStatus& lhs, const DeviceStatus& rhs) { return !(lhs == rhs); }
+
     bool ignored = false;
     bool expendable = false;
     bool subscribedToStateChanges = false;
     DeviceState lastState = DeviceState::Undefined;
     DeviceState state = DeviceState::Undefined;
+    uint64_t stateSequence = 0; ///< sequence number of the last applied state change, older ones are discarded
     DDSTask::Id taskId;
     DDSCollection::Id collectionId;
     int exitCode = -1;
@@ -144,18 +162,45 @@ struct DeviceStatus
 struct DetailedTaskStatus
 {
     DetailedTaskStatus() {}
-    DetailedTaskStatus(const DeviceStatus& status, const std::string& path, const std::string& host)
+    DetailedTaskStatus(const DeviceStatus& status, const InternedPath& path, const InternedString& host)
         : mStatus(status)
         , mPath(path)
         , mHost(host)
     {}
 
     DeviceStatus mStatus;
-    std::string mPath;
-    std::string mHost;
+    InternedPath mPath;
+    InternedString mHost;
 };
 
-using DetailedState = std::vector<DetailedTaskStatus>;
+/// Detailed state of the devices of a topology.
+/// Copies share the entries, which are not modified once handed out, see Session::fillDetailedState().
+class DetailedState
+{
+  public:
+    using Entries = std::vector<DetailedTaskStatus>;
+
+    DetailedState()
+        : mEntries(std::make_shared<const Entries>())
+    {}
+    DetailedState(std::shared_ptr<const Entries> entries, uint64_t version)
+        : mEntries(std::move(entries))
+        , mVersion(version)
+    {}
+
+    Entries::const_iterator begin() const { return mEntries->begin(); }
+    Entries::const_iterator end() const { return mEntries->end(); }
+    size_t size() const { return mEntries->size(); }
+    bool empty() const { return mEntries->empty(); }
+    const DetailedTaskStatus& operator[](size_t i) const { return (*mEntries)[i]; }
+
+    /// @brief Version of the entries, unique within the process. Equal versions have equal entries, 0 for no entries.
+    uint64_t version() const { return mVersion; }
+
+  private:
+    std::shared_ptr<const Entries> mEntries;
+    uint64_t mVersion = 0;
+};
 
 struct TopologyState
 {
@@ -250,15 +295,88 @@ inline TopoStateByTask GroupByTaskId(const TopoState& topoState)
 
 using Duration = std::chrono::microseconds;
 
+/// Duration of the last execution of each transition as reported by a device, in microseconds, indexed by transition (0 - not reported)
+using TransitionDurations = std::array<uint32_t, static_cast<size_t>(DeviceTransition::ErrorFound) + 1>;
+using TransitionTimings = std::vector<std::pair<DDSTask::Id, Duration>>;
+
+/// @brief Durations of the last execution of the given transition, as reported by the devices
+/// @param topoState state of the devices, ignored devices are skipped
+/// @param durations transition durations of the devices, in the order of topoState
+/// @return (task id, duration) pairs of the devices that reported a duration
+inline TransitionTimings CollectTransitionTimings(const TopoState& topoState, const std::vector<TransitionDurations>& durations, const TopoTransition transition)
+{
+    TransitionTimings timings;
+    timings.reserve(topoState.size());
+    for (size_t i = 0; i < topoState.size(); ++i) {
+        uint32_t duration = durations.at(i).at(static_cast<size_t>(transition));
+        if (duration != 0 && !topoState[i].ignored) {
+            timings.emplace_back(topoState[i].taskId, Duration(duration));
+        }
+    }
+    return timings;
+}
+
+/// Distribution of the durations of a transition over the devices
+struct TransitionStats
+{
+    size_t numDevices = 0;
+    Duration p50{ 0 };
+    Duration p99{ 0 };
+    Duration max{ 0 };
+    TransitionTimings slowest; ///< slowest devices first
+};
+
+/// @brief Nearest-rank p50/p99/max of the transition durations and the slowest devices
+/// @param timings (task id, duration) pairs of the devices that reported a duration
+/// @param numSlowest max number of the slowest devices to return
+inline TransitionStats ComputeTransitionStats(TransitionTimings timings, size_t numSlowest)
+{
+    TransitionStats stats;
+    stats.numDevices = timings.size();
+    if (timings.empty()) {
+        return stats;
+    }
+
+    std::sort(timings.begin(), timings.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+    auto percentile = [&](size_t p) { return timings.at((p * timings.size() + 99) / 100 - 1).second; };
+    stats.p50 = percentile(50);
+    stats.p99 = percentile(99);
+    stats.max = timings.back().second;
+    stats.slowest.assign(timings.rbegin(), timings.rbegin() + std::min(numSlowest, timings.size()));
+    return stats;
+}
+/// Time from the start of a transition sequence until the last device completed the given transition
+using PhaseTimings = std::vector<std::pair<DeviceTransition, Duration>>;
+
+/// Shedding of the devices that are late to complete a state operation.
+/// Once the given fraction of the devices completed, the remaining devices get a time budget of latencyFactor times the p95 latency of the completed devices, counted from the start of the operation.
+/// When it expires, the remaining expendable devices and the remaining collections that nMin allows to lose are ignored, and their agents are shut down.
+struct StragglerPolicy
+{
+    double fraction = 0;      ///< fraction of the devices that must complete before stragglers are shed, 0 disables the shedding
+    double latencyFactor = 2; ///< time budget of the remaining devices, relative to the p95 latency of the completed devices
+
+    bool Enabled() const { return fraction > 0; }
+};
+
+/// Difference between the runtime tasks of two topologies.
+/// DDS derives the runtime task ID from the task path and definition, a modified task therefore appears as removed and added.
+struct TopologyDiff
+{
+    std::unordered_set<DDSTask::Id> removed;
+    std::unordered_set<DDSTask::Id> added;
+    size_t unchanged = 0;
+};
+
 struct TaskDetails
 {
     uint64_t mAgentID = 0;       ///< Agent ID
     uint64_t mSlotID = 0;        ///< Slot ID
-    uint64_t mTaskID = 0;        ///< Task ID
+    uint64_t mTaskID = 0;        ///< Task ID, 0 if the task is not activated
     uint64_t mCollectionID = 0;  ///< Collection ID, 0 if not assigned
-    std::string mPath;           ///< Path in the topology
-    std::string mHost;           ///< Hostname
-    std::string mWrkDir;         ///< Wrk directory
+    InternedPath mPath;          ///< Path in the topology
+    InternedString mHost;        ///< Hostname
+    InternedPath mWrkDir;        ///< Wrk directory
 
     friend std::ostream& operator<<(std::ostream& os, const TaskDetails& td)
     {
@@ -276,9 +394,9 @@ struct CollectionDetails
 {
     uint64_t mAgentID = 0;       ///< Agent ID
     uint64_t mCollectionID = 0;  ///< Collection ID
-    std::string mPath;           ///< Path in the topology
-    std::string mHost;           ///< Hostname
-    std::string mWrkDir;         ///< Wrk directory
+    InternedPath mPath;          ///< Path in the topology
+    InternedString mHost;        ///< Hostname
+    InternedPath mWrkDir;        ///< Wrk directory
 
     friend std::ostream& operator<<(std::ostream& os, const CollectionDetails& cd)
     {
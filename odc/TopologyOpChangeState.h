@@ -12,6 +12,7 @@
 #include <odc/AsioAsyncOp.h>
 #include <odc/Error.h>
 #include <odc/TopologyDefs.h>
+#include <odc/TopologyOpStragglers.h>
 
 #include <boost/asio/steady_timer.hpp>
 
@@ -41,6 +42,8 @@ struct ChangeStateOp
                   Duration timeout,
                   std::mutex& mutex,
                   TimeoutHandler timeoutHandler,
+                  const StragglerPolicy& stragglerPolicy,
+                  TimeoutHandler stragglerHandler,
                   Executor const& ex,
                   Allocator const& alloc,
                   Handler&& handler)
@@ -48,6 +51,7 @@ struct ChangeStateOp
         , mTimeoutHandler(std::move(timeoutHandler))
         , mStateData(stateData)
         , mTimer(ex)
+        , mStragglers(stragglerPolicy, tasks.size(), std::move(stragglerHandler), ex)
         , mTasks(std::move(tasks))
         , mTargetState(gExpectedState.at(transition))
         , mMtx(mutex)
@@ -94,12 +98,14 @@ struct ChangeStateOp
         if (!mOp.IsCompleted() && ContainsTask(taskId)) {
             if (currentState == mTargetState) {
                 mTasks.erase(taskId);
+                mStragglers.Completed();
             } else if (currentState == DeviceState::Error || currentState == DeviceState::Exiting) {
                 // if expendable - ignore it, by not returning an error
                 mErrored = expendable ? false : true;
                 mTasks.erase(taskId);
             }
             TryCompletion();
+            mStragglers.Check(mTasks.size(), mMtx, [this]() { return mOp.IsCompleted(); }, [this]() { return mTasks; });
         }
     }
 
@@ -128,6 +134,7 @@ struct ChangeStateOp
     void Complete(std::error_code ec)
     {
         mTimer.cancel();
+        mStragglers.Cancel();
         mOp.Complete(ec, mStateData);
     }
 
@@ -143,6 +150,7 @@ struct ChangeStateOp
     TimeoutHandler mTimeoutHandler;
     TopoState& mStateData;
     boost::asio::steady_timer mTimer;
+    StragglerTracker mStragglers;
     std::unordered_set<DDSTask::Id> mTasks;
     DeviceState mTargetState;
     std::mutex& mMtx;
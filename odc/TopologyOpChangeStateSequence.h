@@ -0,0 +1,303 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_TOPOLOGYOPCHANGESTATESEQUENCE
+#define ODC_TOPOLOGYOPCHANGESTATESEQUENCE
+
+#include <odc/AsioAsyncOp.h>
+#include <odc/Error.h>
+#include <odc/TopologyDefs.h>
+#include <odc/TopologyOpStragglers.h>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <dds/Tools.h>
+#include <dds/Topology.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace odc::core
+{
+
+using ChangeStateSequenceCompletionSignature = void(std::error_code, TopoState, PhaseTimings);
+
+/// Sends a transition to the given tasks. `all` is true when the tasks are all remaining tasks of the operation.
+using SequenceSender = std::function<void(TopoTransition, const std::unordered_set<DDSTask::Id>&, bool all)>;
+
+/// Performs a sequence of transitions, advancing each device to its next transition as soon as it completes the previous one.
+/// Transitions that require all devices to have completed the previous one (barriers) are sent only once all devices are there.
+/// Stragglers are tracked per phase between barriers: a device completes a phase when it reaches the next barrier or the end of the sequence.
+template<typename Executor, typename Allocator>
+struct ChangeStateSequenceOp
+{
+    template<typename Handler>
+    ChangeStateSequenceOp(std::vector<TopoTransition> transitions,
+                          std::unordered_set<DDSTask::Id> tasks,
+                          const TopoStateIndex& stateIndex,
+                          TopoState& stateData,
+                          Duration timeout,
+                          std::mutex& mutex,
+                          TimeoutHandler timeoutHandler,
+                          SequenceSender sender,
+                          const StragglerPolicy& stragglerPolicy,
+                          TimeoutHandler stragglerHandler,
+                          Executor const& ex,
+                          Allocator const& alloc,
+                          Handler&& handler)
+        : mOp(ex, alloc, std::move(handler))
+        , mTimeoutHandler(std::move(timeoutHandler))
+        , mSender(std::move(sender))
+        , mStateData(stateData)
+        , mTimer(ex)
+        , mStragglers(stragglerPolicy, 0, std::move(stragglerHandler), ex)
+        , mTransitions(std::move(transitions))
+        , mPhaseEnd(mTransitions.size())
+        , mStart(std::chrono::steady_clock::now())
+        , mMtx(mutex)
+    {
+        for (const auto& transition : mTransitions) {
+            mTargetStates.push_back(gExpectedState.at(transition));
+            // peers have to be bound before anyone can connect to them
+            mBarriers.push_back(transition == TopoTransition::Connect);
+        }
+
+        if (timeout > std::chrono::milliseconds(0)) {
+            mTimer.expires_after(timeout);
+            mTimer.async_wait([&](std::error_code ec) {
+                if (!ec) {
+                    std::lock_guard<std::mutex> lk(mMtx);
+                    mTimeoutHandler(GetTasks());
+                    if (!mOp.IsCompleted()) {
+                        mOp.Timeout(mStateData, GetPhaseTimings());
+                    }
+                }
+            });
+        }
+        if (tasks.empty()) {
+            OLOG(warning) << "ChangeState sequence initiated on an empty set of tasks, check the path argument.";
+        }
+
+        for (const auto& taskId : tasks) {
+            const DeviceStatus& ds = stateData.at(stateIndex.at(taskId));
+            if (ds.state == DeviceState::Error || ds.state == DeviceState::Exiting) {
+                // Do not wait for an errored/exited device that is not yet ignored (op is started without ignored devices)
+                mErrored = true;
+                continue;
+            }
+            // continue from where the device is, if it is already in one of the target states
+            size_t step = 0;
+            for (size_t i = mTargetStates.size(); i > 0; --i) {
+                if (ds.state == mTargetStates.at(i - 1)) {
+                    step = i;
+                    break;
+                }
+            }
+            if (step < mTransitions.size()) {
+                mSteps.emplace(taskId, step);
+            }
+        }
+        for (const auto& [taskId, step] : mSteps) {
+            Advance(taskId, step);
+        }
+        mStragglers.Restart(mSteps.size());
+    }
+    ChangeStateSequenceOp() = delete;
+    ChangeStateSequenceOp(const ChangeStateSequenceOp&) = delete;
+    ChangeStateSequenceOp& operator=(const ChangeStateSequenceOp&) = delete;
+    ChangeStateSequenceOp(ChangeStateSequenceOp&&) = default;
+    ChangeStateSequenceOp& operator=(ChangeStateSequenceOp&&) = default;
+    ~ChangeStateSequenceOp() = default;
+
+    /// @brief Send the first transitions
+    /// precondition: mMtx is locked.
+    void Start()
+    {
+        ReleaseBarrier();
+        Flush();
+        TryCompletion();
+    }
+
+    /// precondition: mMtx is locked.
+    void Update(const DDSTask::Id taskId, const DeviceState currentState, bool expendable)
+    {
+        if (mOp.IsCompleted()) {
+            return;
+        }
+        auto it = mSteps.find(taskId);
+        if (it == mSteps.end()) {
+            return;
+        }
+        if (currentState == DeviceState::Error || currentState == DeviceState::Exiting) {
+            // if expendable - ignore it, by not returning an error
+            mErrored = expendable ? mErrored : true;
+            Remove(taskId);
+        } else if (currentState == mTargetStates.at(it->second)) {
+            mPhaseEnd.at(it->second) = std::chrono::steady_clock::now();
+            const size_t step = ++(it->second);
+            if (step == mTransitions.size()) {
+                mSteps.erase(it);
+                mStragglers.Completed();
+            } else {
+                Advance(taskId, step);
+                if (mBarriers.at(step)) {
+                    mStragglers.Completed();
+                }
+            }
+        }
+        ReleaseBarrier();
+        Flush();
+        TryCompletion();
+        mStragglers.Check(mSteps.size() - mWaiting.size(), mMtx, [this]() { return mOp.IsCompleted(); }, [this]() { return GetStragglers(); });
+    }
+
+    /// precondition: mMtx is locked.
+    void Ignore(const DDSTask::Id taskId)
+    {
+        if (!mOp.IsCompleted() && ContainsTask(taskId)) {
+            Remove(taskId);
+            ReleaseBarrier();
+            Flush();
+            TryCompletion();
+        }
+    }
+
+    /// precondition: mMtx is locked.
+    void TryCompletion()
+    {
+        if (!mOp.IsCompleted() && mSteps.empty()) {
+            if (mErrored) {
+                Complete(MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
+            } else {
+                Complete(std::error_code());
+            }
+        }
+    }
+
+    /// precondition: mMtx is locked.
+    void Complete(std::error_code ec)
+    {
+        mTimer.cancel();
+        mStragglers.Cancel();
+        mOp.Complete(ec, mStateData, GetPhaseTimings());
+    }
+
+    /// precondition: mMtx is locked.
+    bool ContainsTask(DDSTask::Id id) { return mSteps.count(id) > 0; }
+
+    bool IsCompleted() { return mOp.IsCompleted(); }
+
+    /// @brief Target state of the transition the given task is currently performing (or waiting for)
+    /// precondition: mMtx is locked, ContainsTask(id)
+    DeviceState GetTargetState(DDSTask::Id id) const { return mTargetStates.at(mSteps.at(id)); }
+
+  private:
+    // Queue the transition of the given step for the task, or let the task wait for the others if the step is a barrier.
+    void Advance(DDSTask::Id taskId, size_t step)
+    {
+        if (mBarriers.at(step)) {
+            mWaiting.insert(taskId);
+        } else {
+            mPending[step].insert(taskId);
+        }
+    }
+
+    // Send the barrier transition once all remaining tasks wait for it.
+    // All waiting tasks are at the same step: no task can pass a barrier before the others reach it.
+    void ReleaseBarrier()
+    {
+        if (mWaiting.empty() || mWaiting.size() != mSteps.size()) {
+            return;
+        }
+        const size_t step = mSteps.at(*mWaiting.begin());
+        auto& pending = mPending[step];
+        pending.insert(mWaiting.begin(), mWaiting.end());
+        mWaiting.clear();
+        // a new phase starts
+        mStragglers.Restart(mSteps.size());
+    }
+
+    void Flush()
+    {
+        for (auto& [step, tasks] : mPending) {
+            if (!tasks.empty()) {
+                mSender(mTransitions.at(step), tasks, tasks.size() == mSteps.size());
+            }
+        }
+        mPending.clear();
+    }
+
+    void Remove(DDSTask::Id taskId)
+    {
+        mSteps.erase(taskId);
+        mWaiting.erase(taskId);
+        for (auto& [step, tasks] : mPending) {
+            tasks.erase(taskId);
+        }
+    }
+
+    FailedDevices GetTasks() const
+    {
+        FailedDevices tasks;
+        tasks.reserve(mSteps.size());
+        for (const auto& [taskId, step] : mSteps) {
+            tasks.insert(taskId);
+        }
+        return tasks;
+    }
+
+    // Tasks that did not complete the current phase yet
+    FailedDevices GetStragglers() const
+    {
+        FailedDevices tasks;
+        for (const auto& [taskId, step] : mSteps) {
+            if (mWaiting.count(taskId) == 0) {
+                tasks.insert(taskId);
+            }
+        }
+        return tasks;
+    }
+
+    PhaseTimings GetPhaseTimings() const
+    {
+        PhaseTimings timings;
+        for (size_t i = 0; i < mTransitions.size(); ++i) {
+            if (mPhaseEnd.at(i) != std::chrono::steady_clock::time_point()) {
+                timings.emplace_back(mTransitions.at(i), std::chrono::duration_cast<Duration>(mPhaseEnd.at(i) - mStart));
+            }
+        }
+        return timings;
+    }
+
+    AsioAsyncOp<Executor, Allocator, ChangeStateSequenceCompletionSignature> mOp;
+    TimeoutHandler mTimeoutHandler;
+    SequenceSender mSender;
+    TopoState& mStateData;
+    boost::asio::steady_timer mTimer;
+    StragglerTracker mStragglers;
+    std::vector<TopoTransition> mTransitions;
+    std::vector<DeviceState> mTargetStates;
+    std::vector<bool> mBarriers;                                           ///< step can be sent only once all tasks completed the previous step
+    std::unordered_map<DDSTask::Id, size_t> mSteps;                        ///< remaining tasks and the step they are currently performing
+    std::unordered_set<DDSTask::Id> mWaiting;                              ///< tasks waiting for the others at a barrier
+    std::map<size_t, std::unordered_set<DDSTask::Id>> mPending;            ///< transitions to be sent, by step
+    std::vector<std::chrono::steady_clock::time_point> mPhaseEnd;          ///< when the last device completed each step
+    std::chrono::steady_clock::time_point mStart;
+    std::mutex& mMtx;
+    bool mErrored = false;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_TOPOLOGYOPCHANGESTATESEQUENCE */
@@ -21,8 +21,11 @@
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <iterator>
+#include <map>
 #include <mutex>
 #include <utility>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace odc::core
@@ -55,6 +58,8 @@ struct GetPropertiesOp
                     mTimeoutHandler(mTasks);
                     if (!mOp.IsCompleted()) {
                         for (const auto& taskId : mTasks) {
+                            // drop incomplete chunked replies
+                            mResult.devices.erase(taskId);
                             mResult.failed.emplace(taskId);
                         }
                         mOp.Timeout(mResult);
@@ -73,23 +78,53 @@ struct GetPropertiesOp
     GetPropertiesOp& operator=(GetPropertiesOp&&) = default;
     ~GetPropertiesOp() = default;
 
+    /// @brief Add the (partial) reply of a device
+    /// @param chunk sequence number of the reply chunk, chunks may arrive in any order
+    /// @param lastChunk the device is done once all chunks up to its last one arrived
     /// precondition: mMtx is locked.
-    void Update(const DDSTask::Id taskId, cc::Result result, DeviceProperties props)
+    void Update(const DDSTask::Id taskId, cc::Result result, DeviceProperties props, uint32_t chunk = 0, bool lastChunk = true)
     {
         if (!mOp.IsCompleted() && ContainsTask(taskId)) {
+            bool done = true;
             if (result == cc::Result::Ok) {
-                mResult.devices.insert({ taskId, { std::move(props) } });
+                // chunks may overtake each other when sent over different paths (DDS, direct channel), reassemble them in order
+                ChunkedReply& reply = mChunkedReplies[taskId];
+                if (chunk < reply.nextChunk || reply.earlyChunks.count(chunk) > 0) {
+                    OLOG(warning) << "GetProperties: received reply chunk " << chunk << " from task " << taskId << " more than once, ignoring";
+                    return;
+                }
+                reply.earlyChunks.emplace(chunk, std::move(props));
+                if (lastChunk) {
+                    reply.numChunks = chunk + 1;
+                }
+                DeviceProperties& deviceProps = mResult.devices[taskId].props;
+                for (auto it = reply.earlyChunks.begin(); it != reply.earlyChunks.end() && it->first == reply.nextChunk; it = reply.earlyChunks.erase(it)) {
+                    if (deviceProps.empty()) {
+                        deviceProps = std::move(it->second);
+                    } else {
+                        deviceProps.insert(deviceProps.end(), std::make_move_iterator(it->second.begin()), std::make_move_iterator(it->second.end()));
+                    }
+                    ++reply.nextChunk;
+                }
+                done = reply.numChunks > 0 && reply.nextChunk >= reply.numChunks;
             } else {
+                mResult.devices.erase(taskId);
                 mResult.failed.emplace(taskId);
             }
-            mTasks.erase(taskId);
-            TryCompletion();
+
+            if (done) {
+                mChunkedReplies.erase(taskId);
+                mTasks.erase(taskId);
+                TryCompletion();
+            }
         }
     }
 
     void Ignore(const DDSTask::Id taskId)
     {
         if (!mOp.IsCompleted() && ContainsTask(taskId)) {
+            mResult.devices.erase(taskId);
+            mChunkedReplies.erase(taskId);
             mTasks.erase(taskId);
             TryCompletion();
         }
@@ -121,10 +156,18 @@ struct GetPropertiesOp
     bool IsCompleted() { return mOp.IsCompleted(); }
 
   private:
+    struct ChunkedReply
+    {
+        uint32_t nextChunk = 0;                           ///< next chunk to be appended to the result
+        uint32_t numChunks = 0;                           ///< number of chunks, known once the last one arrived, 0 until then
+        std::map<uint32_t, DeviceProperties> earlyChunks; ///< chunks received ahead of nextChunk, by chunk number
+    };
+
     AsioAsyncOp<Executor, Allocator, GetPropertiesCompletionSignature> mOp;
     TimeoutHandler mTimeoutHandler;
     boost::asio::steady_timer mTimer;
     std::unordered_set<DDSTask::Id> mTasks;
+    std::unordered_map<DDSTask::Id, ChunkedReply> mChunkedReplies; ///< devices with a partially received reply
     GetPropertiesResult mResult;
     std::mutex& mMtx;
 };
@@ -0,0 +1,115 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_TOPOLOGYOPSTRAGGLERS
+#define ODC_TOPOLOGYOPSTRAGGLERS
+
+#include <odc/Logger.h>
+#include <odc/TopologyDefs.h>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace odc::core
+{
+
+/// Tracks the progress of a state operation and triggers the shedding of its stragglers, see StragglerPolicy
+class StragglerTracker
+{
+  public:
+    template<typename Executor>
+    StragglerTracker(const StragglerPolicy& policy, size_t numTasks, TimeoutHandler stragglerHandler, Executor const& ex)
+        : mPolicy(policy)
+        , mNumTasks(numTasks)
+        , mStragglerHandler(std::move(stragglerHandler))
+        , mStart(std::chrono::steady_clock::now())
+        , mTimer(ex)
+    {}
+
+    /// @brief Record a device that reached the target state, with its latency since the start of the operation
+    /// precondition: mutex of the operation is locked.
+    void Completed() { mLatencies.push_back(std::chrono::steady_clock::now() - mStart); }
+
+    /// @brief Arm the shedding once enough devices completed. The handler is called with the remaining devices when the time budget expires.
+    /// precondition: mutex of the operation is locked.
+    /// @param numRemaining number of devices that did not complete yet
+    /// @param mutex mutex of the operation
+    /// @param isCompleted tells whether the operation is completed
+    /// @param remaining returns the devices that did not complete yet, called with the mutex locked
+    void Check(size_t numRemaining, std::mutex& mutex, std::function<bool()> isCompleted, std::function<FailedDevices()> remaining)
+    {
+        if (!mPolicy.Enabled() || mArmed || numRemaining == 0 || mNumTasks == 0) {
+            return;
+        }
+        if (static_cast<double>(mNumTasks - std::min(numRemaining, mNumTasks)) < mPolicy.fraction * mNumTasks) {
+            return;
+        }
+        mArmed = true;
+
+        std::chrono::steady_clock::duration p95(0);
+        if (!mLatencies.empty()) {
+            const size_t n = static_cast<size_t>(std::ceil(0.95 * mLatencies.size())) - 1;
+            std::nth_element(mLatencies.begin(), mLatencies.begin() + n, mLatencies.end());
+            p95 = mLatencies[n];
+        }
+        const auto budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(p95 * mPolicy.latencyFactor);
+        mTimer.expires_at(std::max(std::chrono::steady_clock::now(), mStart + budget));
+        mTimer.async_wait([this, generation = mGeneration, &mutex, isCompleted = std::move(isCompleted), remaining = std::move(remaining)](std::error_code ec) {
+            if (!ec) {
+                std::lock_guard<std::mutex> lk(mutex);
+                // the tracker may have been restarted after the timer expired
+                if (generation != mGeneration || isCompleted()) {
+                    return;
+                }
+                const FailedDevices stragglers = remaining();
+                if (!stragglers.empty()) {
+                    OLOG(info) << stragglers.size() << " device(s) did not complete the operation within the straggler budget, shedding the ones that can be ignored";
+                    mStragglerHandler(stragglers);
+                }
+            }
+        });
+    }
+
+    /// @brief Track a new phase of the operation, e.g. after a barrier of a transition sequence
+    /// precondition: mutex of the operation is locked.
+    /// @param numTasks number of devices taking part in the phase
+    void Restart(size_t numTasks)
+    {
+        mTimer.cancel();
+        ++mGeneration;
+        mArmed = false;
+        mNumTasks = numTasks;
+        mLatencies.clear();
+        mStart = std::chrono::steady_clock::now();
+    }
+
+    void Cancel() { mTimer.cancel(); }
+
+  private:
+    StragglerPolicy mPolicy;
+    size_t mNumTasks;
+    TimeoutHandler mStragglerHandler;
+    std::chrono::steady_clock::time_point mStart;
+    std::vector<std::chrono::steady_clock::duration> mLatencies; ///< latencies of the devices that reached the target state
+    boost::asio::steady_timer mTimer;
+    bool mArmed = false;
+    uint64_t mGeneration = 0; ///< incremented by Restart()
+};
+
+} // namespace odc::core
+
+#endif /* ODC_TOPOLOGYOPSTRAGGLERS */
@@ -12,6 +12,7 @@
 #include <odc/AsioAsyncOp.h>
 #include <odc/Error.h>
 #include <odc/TopologyDefs.h>
+#include <odc/TopologyOpStragglers.h>
 
 #include <boost/asio/steady_timer.hpp>
 
@@ -42,12 +43,15 @@ struct WaitForStateOp
                    Duration timeout,
                    std::mutex& mutex,
                    TimeoutHandler timeoutHandler,
+                   const StragglerPolicy& stragglerPolicy,
+                   TimeoutHandler stragglerHandler,
                    Executor const& ex,
                    Allocator const& alloc,
                    Handler&& handler)
         : mOp(ex, alloc, std::move(handler))
         , mTimeoutHandler(std::move(timeoutHandler))
         , mTimer(ex)
+        , mStragglers(stragglerPolicy, tasks.size(), std::move(stragglerHandler), ex)
         , mTasks(std::move(tasks))
         , mTargetLastState(targetLastState)
         , mTargetCurrentState(targetCurrentState)
@@ -94,12 +98,14 @@ struct WaitForStateOp
         if (!mOp.IsCompleted() && ContainsTask(taskId)) {
             if (currentState == mTargetCurrentState && (lastState == mTargetLastState || mTargetLastState == DeviceState::Undefined)) {
                 mTasks.erase(taskId);
+                mStragglers.Completed();
             } else if (currentState == DeviceState::Error || currentState == DeviceState::Exiting) {
                 // if expendable - ignore it, by not returning an error
                 mErrored = expendable ? false : true;
                 mTasks.erase(taskId);
             }
             TryCompletion();
+            mStragglers.Check(mTasks.size(), mMtx, [this]() { return mOp.IsCompleted(); }, [this]() { return mTasks; });
         }
     }
 
@@ -128,6 +134,7 @@ struct WaitForStateOp
     void Complete(std::error_code ec)
     {
         mTimer.cancel();
+        mStragglers.Cancel();
         mOp.Complete(ec, mTasks);
     }
 
@@ -140,6 +147,7 @@ struct WaitForStateOp
     AsioAsyncOp<Executor, Allocator, WaitForStateCompletionSignature> mOp;
     TimeoutHandler mTimeoutHandler;
     boost::asio::steady_timer mTimer;
+    StragglerTracker mStragglers;
     std::unordered_set<DDSTask::Id> mTasks;
     DeviceState mTargetLastState;
     DeviceState mTargetCurrentState;
@@ -0,0 +1,286 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_TOPOLOGYSTORE
+#define ODC_CORE_TOPOLOGYSTORE
+
+#include <odc/Logger.h>
+#include <odc/MiscUtils.h>
+#include <odc/Session.h>
+#include <odc/TopologyDefs.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace odc::core {
+
+/// Requirements extracted from a topology, see Controller::extractRequirements()
+struct TopologyRequirements
+{
+    /// @brief Take the requirements from a session that just extracted them
+    explicit TopologyRequirements(const Session& session)
+        : mNinfo(session.mNinfo)
+        , mZoneInfo(session.mZoneInfo)
+        , mAgentGroupInfo(session.mAgentGroupInfo)
+        , mStandaloneTasks(session.mStandaloneTasks)
+        , mCollections(session.mCollections)
+        , mExpendableTasks(session.mExpendableTasks)
+    {
+        for (const auto& [id, collection] : session.mRuntimeCollectionIndex) {
+            mRuntimeCollections.emplace(id, collection->name);
+        }
+    }
+
+    /// @brief Apply the requirements to a session, as if it extracted them itself
+    void ApplyTo(Session& session) const
+    {
+        session.mNinfo = mNinfo;
+        session.mZoneInfo = mZoneInfo;
+        session.mAgentGroupInfo = mAgentGroupInfo;
+        session.mStandaloneTasks = mStandaloneTasks;
+        session.mCollections = mCollections;
+        session.mExpendableTasks.insert(mExpendableTasks.begin(), mExpendableTasks.end());
+        session.mRuntimeCollectionIndex.clear();
+        for (const auto& [id, name] : mRuntimeCollections) {
+            session.mRuntimeCollectionIndex.emplace(id, &(session.mCollections.at(name)));
+        }
+    }
+
+    std::map<std::string, CollectionNInfo> mNinfo;
+    std::map<std::string, std::vector<ZoneGroup>> mZoneInfo;
+    std::unordered_map<std::string, AgentGroupInfo> mAgentGroupInfo;
+    std::vector<TaskInfo> mStandaloneTasks;
+    std::map<std::string, CollectionInfo> mCollections;
+    std::unordered_set<uint64_t> mExpendableTasks;
+    std::unordered_map<uint64_t, std::string> mRuntimeCollections; ///< runtime collection ID -> collection name
+};
+
+/// Content addressed store of topology files. Identical content is stored once and shared by the partitions referencing it.
+/// Files that are not referenced by any partition anymore are removed: a partition releases its file when it replaces its topology, and all its files when it is reset.
+class TopologyStore
+{
+  public:
+    TopologyStore()
+        : mDir(std::filesystem::temp_directory_path() / "odc-topologies")
+    {}
+
+    TopologyStore(const TopologyStore&) = delete;
+    TopologyStore& operator=(const TopologyStore&) = delete;
+
+    /// @brief Set the directory of the store, at startup. Topology files and temporary files left there by a previous run are removed,
+    /// the directory must not be shared with another running server.
+    void setDir(const std::string& dir)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mDir = smart_path(dir);
+        removeStaleFiles();
+    }
+
+    /// @brief Store topology content, or reuse the file with identical content
+    /// @param partitionID partition referencing the content
+    /// @param content topology content
+    /// @return path of the topology file
+    std::string add(const std::string& partitionID, const std::string& content)
+    {
+        uint64_t hash = hashContent(content);
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto it = mEntries.find(hash);
+        while (it != mEntries.end() && !hasContent(it->second, content)) {
+            // different content with the same hash, take the next free one
+            OLOG(warning, partitionID, 0) << "Topology content hash collision with " << std::quoted(it->second.path);
+            it = mEntries.find(++hash);
+        }
+        if (it == mEntries.end()) {
+            std::filesystem::create_directories(mDir);
+            const std::filesystem::path filepath{ mDir / toFileName(hash) };
+            // write to a temporary file first, a reader must never see a partially written topology
+            const std::filesystem::path tmpPath{ mDir / (toFileName(hash) + ".tmp") };
+            {
+                std::ofstream file(tmpPath, std::ios::binary);
+                if (!file.is_open()) {
+                    throw std::runtime_error(toString("Failed to create topology file ", std::quoted(tmpPath.string())));
+                }
+                file << content;
+            }
+            std::filesystem::rename(tmpPath, filepath);
+            it = mEntries.emplace(hash, Entry{ filepath.string(), content.size(), {}, nullptr }).first;
+            mPathIndex.emplace(filepath.string(), hash);
+            OLOG(info, partitionID, 0) << "Topology file " << std::quoted(filepath.string()) << " created successfully";
+        } else {
+            OLOG(info, partitionID, 0) << "Reusing topology file " << std::quoted(it->second.path) << " with identical content";
+        }
+        ++(it->second.refs[partitionID]);
+        return it->second.path;
+    }
+
+    /// @brief Store a topology file written elsewhere, the file is moved into the store or removed if the content is already stored
+    /// @param partitionID partition referencing the content
+    /// @param filePath path of the file to store
+    /// @return path of the topology file in the store
+    std::string addFile(const std::string& partitionID, const std::string& filePath)
+    {
+        std::string content;
+        {
+            std::ifstream file(filePath, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error(toString("Failed to open topology file ", std::quoted(filePath)));
+            }
+            content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::string path = add(partitionID, content);
+        std::error_code ec;
+        std::filesystem::remove(filePath, ec);
+        return path;
+    }
+
+    /// @brief Requirements stored for the given topology file
+    /// @return nullptr if the file is not in the store or has no stored requirements
+    std::shared_ptr<const TopologyRequirements> getRequirements(const std::string& filePath) const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto it = mPathIndex.find(filePath);
+        return it == mPathIndex.end() ? nullptr : mEntries.at(it->second).requirements;
+    }
+
+    /// @brief Store requirements extracted from the given topology file, ignored if the file is not in the store
+    void setRequirements(const std::string& filePath, std::shared_ptr<const TopologyRequirements> requirements)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto it = mPathIndex.find(filePath);
+        if (it != mPathIndex.end()) {
+            mEntries.at(it->second).requirements = std::move(requirements);
+        }
+    }
+
+    /// @brief Drop all references of the partition, remove the files that are not referenced anymore
+    void release(const std::string& partitionID)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            it->second.refs.erase(partitionID);
+            it = removeIfUnreferenced(partitionID, it);
+        }
+    }
+
+    /// @brief Drop one reference of the partition to the file, e.g. when the partition replaces its topology. Remove the file if it is not referenced anymore.
+    /// Files that are not in the store are ignored.
+    void release(const std::string& partitionID, const std::string& filePath)
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto pathIt = mPathIndex.find(filePath);
+        if (pathIt == mPathIndex.end()) {
+            return;
+        }
+        auto it = mEntries.find(pathIt->second);
+        auto ref = it->second.refs.find(partitionID);
+        if (ref == it->second.refs.end()) {
+            return;
+        }
+        if (--(ref->second) == 0) {
+            it->second.refs.erase(ref);
+        }
+        removeIfUnreferenced(partitionID, it);
+    }
+
+    /// @brief Number of references of the partition to the file, 0 if the file is not in the store
+    uint32_t refs(const std::string& partitionID, const std::string& filePath) const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto pathIt = mPathIndex.find(filePath);
+        if (pathIt == mPathIndex.end()) {
+            return 0;
+        }
+        const auto& refs = mEntries.at(pathIt->second).refs;
+        auto ref = refs.find(partitionID);
+        return ref == refs.end() ? 0 : ref->second;
+    }
+
+  private:
+    struct Entry
+    {
+        std::string path;
+        size_t size;                          ///< content size in bytes
+        std::map<std::string, uint32_t> refs; ///< number of references by partition ID
+        std::shared_ptr<const TopologyRequirements> requirements;
+    };
+
+    // Whether the stored file has the given content, compared in full as the hash is not collision free
+    static bool hasContent(const Entry& entry, const std::string& content)
+    {
+        if (entry.size != content.size()) {
+            return false;
+        }
+        std::ifstream file(entry.path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        std::string stored(entry.size, '\0');
+        return file.read(stored.data(), stored.size()) && file.gcount() == static_cast<std::streamsize>(stored.size()) && stored == content;
+    }
+
+    using Entries = std::unordered_map<uint64_t, Entry>;
+
+    // Remove the file of the entry if it is not referenced anymore
+    // precondition: mMtx is locked
+    // @return iterator following the entry
+    Entries::iterator removeIfUnreferenced(const std::string& partitionID, Entries::iterator it)
+    {
+        if (!it->second.refs.empty()) {
+            return std::next(it);
+        }
+        std::error_code ec;
+        std::filesystem::remove(it->second.path, ec);
+        OLOG(debug, partitionID, 0) << "Removed unreferenced topology file " << std::quoted(it->second.path);
+        mPathIndex.erase(it->second.path);
+        return mEntries.erase(it);
+    }
+
+    // precondition: mMtx is locked
+    void removeStaleFiles()
+    {
+        std::error_code ec;
+        for (const auto& file : std::filesystem::directory_iterator(mDir, ec)) {
+            const std::string name = file.path().filename().string();
+            const bool topology = name.rfind("topology_", 0) == 0 && file.path().extension() == ".xml";
+            if (file.is_regular_file(ec) && (topology || file.path().extension() == ".tmp") && mPathIndex.count(file.path().string()) == 0) {
+                std::error_code removeEc;
+                if (std::filesystem::remove(file.path(), removeEc)) {
+                    OLOG(debug) << "Removed stale topology store file " << std::quoted(file.path().string());
+                }
+            }
+        }
+    }
+
+    static std::string toFileName(uint64_t hash)
+    {
+        std::stringstream ss;
+        ss << "topology_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".xml";
+        return ss.str();
+    }
+
+    mutable std::mutex mMtx;
+    std::filesystem::path mDir;
+    Entries mEntries;
+    std::unordered_map<std::string, uint64_t> mPathIndex; ///< file path -> content hash
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_TOPOLOGYSTORE */
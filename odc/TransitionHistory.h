@@ -0,0 +1,292 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef ODC_CORE_TRANSITIONHISTORY
+#define ODC_CORE_TRANSITIONHISTORY
+
+#include <odc/Logger.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace odc::core {
+
+/// Completion times of the state change steps of previous requests, by partition, topology and step, timed out steps included.
+/// Used to give each step a deadline derived from its history. Persisted to a file to survive restarts,
+/// the file is written in the background shortly after recording, and on destruction.
+class TransitionHistory
+{
+  public:
+    using Duration = std::chrono::milliseconds;
+
+    TransitionHistory() {}
+    ~TransitionHistory() { stop(); }
+
+    TransitionHistory(const TransitionHistory&) = delete;
+    TransitionHistory& operator=(const TransitionHistory&) = delete;
+
+    static constexpr size_t kMaxSamples = 100; ///< most recent completion times kept per key
+    static constexpr size_t kMaxKeys = 1000;   ///< keys kept, the least recently recorded ones are dropped
+    static constexpr size_t kMinSamples = 5;   ///< completion times required before a quantile is given
+    static constexpr std::chrono::seconds kWriteDelay{ 5 }; ///< recorded completion times are written together after this delay
+
+    /// @brief Key of a step
+    /// @param partitionID partition ID
+    /// @param topoHash content hash of the topology, see hashContent()
+    /// @param step description of the step, e.g. transition and path
+    static std::string key(const std::string& partitionID, uint64_t topoHash, const std::string& step)
+    {
+        return toString(partitionID, "/", topoHash, "/", step);
+    }
+
+    /// @brief Set the file the history is persisted to and read it. An empty path disables the persistence.
+    void setFile(const std::string& filePath)
+    {
+        std::unique_lock<std::mutex> lk(mMtx);
+        writePending(lk);
+        mFilePath = filePath;
+        mEntries.clear();
+        if (!mFilePath.empty() && !mThread.joinable()) {
+            mStop = false;
+            mThread = std::thread(&TransitionHistory::writeInBackground, this);
+        }
+        if (mFilePath.empty() || !std::filesystem::exists(mFilePath)) {
+            return;
+        }
+        try {
+            boost::property_tree::ptree pt;
+            boost::property_tree::read_json(mFilePath, pt);
+            fromPT(pt);
+            OLOG(info) << "Read completion times of " << mEntries.size() << " state change step(s) from " << std::quoted(mFilePath);
+        } catch (const std::exception& e) {
+            mEntries.clear();
+            OLOG(error) << "Failed to read transition history file " << std::quoted(mFilePath) << ": " << e.what();
+        }
+    }
+
+    /// @brief Record a completion time of the step, the history is persisted in the background
+    void record(const std::string& key, Duration duration)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            add(key, duration);
+            mPending = true;
+        }
+        mCV.notify_all();
+    }
+
+    /// @brief Record that the step did not complete within the duration.
+    /// The duration is kept as a completion time, a lower bound of the actual one: after a slowdown the deadline
+    /// of the step grows with each timeout, until it is no longer shorter than the remaining request time.
+    void recordTimeout(const std::string& key, Duration duration) { record(key, duration); }
+
+    /// @brief Write the recorded completion times that are not persisted yet
+    void flush()
+    {
+        std::unique_lock<std::mutex> lk(mMtx);
+        writePending(lk);
+    }
+
+    /// @brief Stop the background writing and write the pending completion times
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mMtx);
+            mStop = true;
+        }
+        mCV.notify_all();
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        flush();
+    }
+
+    /// @brief Quantile of the recorded completion times of the step
+    /// @param q quantile, in (0, 1]
+    /// @return nullopt if fewer than kMinSamples completion times are recorded
+    std::optional<Duration> quantile(const std::string& key, double q) const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto it = mEntries.find(key);
+        if (it == mEntries.end() || it->second.mSamples.size() < kMinSamples) {
+            return std::nullopt;
+        }
+        std::vector<Duration> samples(it->second.mSamples.begin(), it->second.mSamples.end());
+        const size_t n = std::min(samples.size(), static_cast<size_t>(std::ceil(q * samples.size()))) - 1;
+        std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+        return samples[n];
+    }
+
+    /// @brief Deadline of the step derived from its history: factor times the p99 of its completion times, but at least minDeadline
+    /// @param remaining remaining time of the request, the deadline is used only if it is shorter
+    /// @return nullopt if adaptive deadlines are disabled (factor <= 0), fewer than kMinSamples completion times are recorded,
+    /// or the deadline is not shorter than the remaining time
+    std::optional<Duration> adaptiveDeadline(const std::string& key, double factor, Duration minDeadline, Duration remaining) const
+    {
+        if (factor <= 0) {
+            return std::nullopt;
+        }
+        const auto p99 = quantile(key, 0.99);
+        if (!p99.has_value()) {
+            return std::nullopt;
+        }
+        const auto deadline = std::max(minDeadline, std::chrono::duration_cast<Duration>(p99.value() * factor));
+        if (deadline >= remaining) {
+            return std::nullopt;
+        }
+        return deadline;
+    }
+
+    /// @brief Number of recorded completion times of the step
+    size_t numSamples(const std::string& key) const
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        auto it = mEntries.find(key);
+        return it == mEntries.end() ? 0 : it->second.mSamples.size();
+    }
+
+  private:
+    struct Entry
+    {
+        std::deque<Duration> mSamples; ///< most recent completion times, oldest first
+        uint64_t mSequence = 0;        ///< when the entry was last recorded
+    };
+
+    // precondition: mMtx is locked
+    void add(const std::string& key, Duration duration)
+    {
+        auto& entry = mEntries[key];
+        entry.mSamples.push_back(duration);
+        if (entry.mSamples.size() > kMaxSamples) {
+            entry.mSamples.pop_front();
+        }
+        entry.mSequence = ++mSequence;
+        if (mEntries.size() > kMaxKeys) {
+            auto oldest = std::min_element(mEntries.begin(), mEntries.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.mSequence < rhs.second.mSequence; });
+            mEntries.erase(oldest);
+        }
+    }
+
+    boost::property_tree::ptree toPT() const
+    {
+        boost::property_tree::ptree steps;
+        for (const auto& [key, entry] : mEntries) {
+            boost::property_tree::ptree samples;
+            for (const auto& d : entry.mSamples) {
+                boost::property_tree::ptree sample;
+                sample.put_value(d.count());
+                samples.push_back(std::make_pair("", sample));
+            }
+            boost::property_tree::ptree step;
+            step.put<std::string>("key", key);
+            step.put<uint64_t>("sequence", entry.mSequence);
+            step.add_child("ms", samples);
+            steps.push_back(std::make_pair("", step));
+        }
+        boost::property_tree::ptree pt;
+        pt.add_child("steps", steps);
+        return pt;
+    }
+
+    void fromPT(const boost::property_tree::ptree& pt)
+    {
+        auto steps{ pt.get_child_optional("steps") };
+        if (!steps) {
+            return;
+        }
+        for (const auto& v : steps.get()) {
+            auto& entry = mEntries[v.second.get<std::string>("key")];
+            entry.mSequence = v.second.get<uint64_t>("sequence", 0);
+            mSequence = std::max(mSequence, entry.mSequence);
+            auto samples{ v.second.get_child_optional("ms") };
+            if (samples) {
+                for (const auto& s : samples.get()) {
+                    entry.mSamples.push_back(Duration(s.second.get_value<Duration::rep>()));
+                }
+            }
+            while (entry.mSamples.size() > kMaxSamples) {
+                entry.mSamples.pop_front();
+            }
+        }
+    }
+
+    void writeInBackground()
+    {
+        std::unique_lock<std::mutex> lk(mMtx);
+        while (!mStop) {
+            mCV.wait(lk, [this] { return mStop || mPending; });
+            // collect the completion times of the following steps of the request
+            mCV.wait_for(lk, kWriteDelay, [this] { return mStop; });
+            writePending(lk);
+        }
+    }
+
+    // precondition: lk holds mMtx, it is released while writing the file
+    void writePending(std::unique_lock<std::mutex>& lk)
+    {
+        if (!mPending || mFilePath.empty()) {
+            return;
+        }
+        mPending = false;
+        const auto pt = toPT();
+        const auto snapshot = ++mSnapshots;
+        const std::filesystem::path filePath(mFilePath);
+        lk.unlock();
+        std::lock_guard<std::mutex> writeLk(mWriteMtx);
+        if (snapshot < mWrittenSnapshot) {
+            // a newer snapshot was written already
+            lk.lock();
+            return;
+        }
+        mWrittenSnapshot = snapshot;
+        try {
+            const auto dir = filePath.parent_path();
+            if (!dir.empty() && !std::filesystem::exists(dir) && !std::filesystem::create_directories(dir)) {
+                throw std::runtime_error(toString("failed to create directory ", std::quoted(dir.string())));
+            }
+            // write to a temporary file first, a crash while writing must not truncate the history
+            const std::filesystem::path tmpPath(filePath.string() + ".tmp");
+            boost::property_tree::write_json(tmpPath.string(), pt);
+            std::filesystem::rename(tmpPath, filePath);
+        } catch (const std::exception& e) {
+            OLOG(error) << "Failed to write transition history file " << std::quoted(filePath.string()) << ": " << e.what();
+        }
+        lk.lock();
+    }
+
+    mutable std::mutex mMtx;
+    std::condition_variable mCV;
+    std::map<std::string, Entry> mEntries; ///< by key, see key()
+    uint64_t mSequence = 0;
+    std::string mFilePath;
+    bool mPending = false; ///< completion times were recorded since the file was last written
+    bool mStop = false;
+    uint64_t mSnapshots = 0; ///< number of snapshots taken for writing
+    std::mutex mWriteMtx; ///< serializes the writing of the file
+    uint64_t mWrittenSnapshot = 0; ///< last written snapshot, guarded by mWriteMtx
+    std::thread mThread;
+};
+
+} // namespace odc::core
+
+#endif /* ODC_CORE_TRANSITIONHISTORY */
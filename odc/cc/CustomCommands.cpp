@@ -25,7 +25,7 @@ namespace odc::cc
 
     array<string, 2> resultNames = { { "Ok", "Failure" } };
 
-    array<string, 15> typeNames = { { "CheckState",
+    array<string, 19> typeNames = { { "CheckState",
                                       "ChangeState",
                                       "DumpConfig",
                                       "SubscribeToStateChange",
@@ -40,7 +40,11 @@ namespace odc::cc
                                       "StateChangeUnsubscription",
                                       "StateChange",
                                       "Properties",
-                                      "PropertiesSet" } };
+                                      "PropertiesSet",
+                                      "TransitionTiming",
+                                      "StateChangeBatch",
+                                      "DirectChannel",
+                                      "StateChangeAck" } };
 
     array<fair::mq::State, 16> fbStateToMQState = { { fair::mq::State::Undefined,
                                                       fair::mq::State::Ok,
@@ -102,7 +106,7 @@ namespace odc::cc
                                                              FBTransition_End,
                                                              FBTransition_ErrorFound } };
 
-    array<FBCmd, 15> typeToFBCmd = { { FBCmd::FBCmd_check_state,
+    array<FBCmd, 19> typeToFBCmd = { { FBCmd::FBCmd_check_state,
                                        FBCmd::FBCmd_change_state,
                                        FBCmd::FBCmd_dump_config,
                                        FBCmd::FBCmd_subscribe_to_state_change,
@@ -116,9 +120,13 @@ namespace odc::cc
                                        FBCmd::FBCmd_state_change_unsubscription,
                                        FBCmd::FBCmd_state_change,
                                        FBCmd::FBCmd_properties,
-                                       FBCmd::FBCmd_properties_set } };
+                                       FBCmd::FBCmd_properties_set,
+                                       FBCmd::FBCmd_transition_timing,
+                                       FBCmd::FBCmd_state_change_batch,
+                                       FBCmd::FBCmd_direct_channel,
+                                       FBCmd::FBCmd_state_change_ack } };
 
-    array<Type, 15> fbCmdToType = { { Type::check_state,
+    array<Type, 19> fbCmdToType = { { Type::check_state,
                                       Type::change_state,
                                       Type::dump_config,
                                       Type::subscribe_to_state_change,
@@ -132,7 +140,11 @@ namespace odc::cc
                                       Type::state_change_unsubscription,
                                       Type::state_change,
                                       Type::properties,
-                                      Type::properties_set } };
+                                      Type::properties_set,
+                                      Type::transition_timing,
+                                      Type::state_change_batch,
+                                      Type::direct_channel,
+                                      Type::state_change_ack } };
 
     fair::mq::State GetMQState(const FBState state)
     {
@@ -173,6 +185,12 @@ namespace odc::cc
         return typeToFBCmd.at(static_cast<int>(type));
     }
 
+    // absent (optional) string fields are read as empty strings
+    string GetString(const flatbuffers::String* str)
+    {
+        return str ? str->str() : string();
+    }
+
     string Cmds::Serialize() const
     {
         flatbuffers::FlatBufferBuilder fbb;
@@ -193,13 +211,23 @@ namespace odc::cc
                 break;
                 case Type::change_state:
                 {
+                    auto& _cmd = static_cast<ChangeState&>(*cmd);
+                    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> taskIds;
+                    if (!_cmd.GetTaskIds().empty()) {
+                        taskIds = fbb.CreateVector(_cmd.GetTaskIds());
+                    }
                     cmdBuilder = make_unique<FBCommandBuilder>(fbb);
-                    cmdBuilder->add_transition(GetFBTransition(static_cast<ChangeState&>(*cmd).GetTransition()));
+                    cmdBuilder->add_transition(GetFBTransition(_cmd.GetTransition()));
+                    if (!_cmd.GetTaskIds().empty()) {
+                        cmdBuilder->add_task_ids(taskIds);
+                    }
                 }
                 break;
                 case Type::dump_config:
                 {
+                    auto _cmd = static_cast<DumpConfig&>(*cmd);
                     cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder->add_chunk_size(_cmd.GetChunkSize());
                 }
                 break;
                     break;
@@ -208,6 +236,7 @@ namespace odc::cc
                     auto _cmd = static_cast<SubscribeToStateChange&>(*cmd);
                     cmdBuilder = make_unique<FBCommandBuilder>(fbb);
                     cmdBuilder->add_interval(_cmd.GetInterval());
+                    cmdBuilder->add_reply_window(_cmd.GetReplyWindow());
                 }
                 break;
                 case Type::unsubscribe_from_state_change:
@@ -222,6 +251,7 @@ namespace odc::cc
                     cmdBuilder = make_unique<FBCommandBuilder>(fbb);
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_property_query(query);
+                    cmdBuilder->add_chunk_size(_cmd.GetChunkSize());
                 }
                 break;
                 case Type::set_properties:
@@ -261,12 +291,14 @@ namespace odc::cc
                 break;
                 case Type::config:
                 {
-                    auto _cmd = static_cast<Config&>(*cmd);
+                    auto& _cmd = static_cast<Config&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
                     auto config = fbb.CreateString(_cmd.GetConfig());
                     cmdBuilder = make_unique<FBCommandBuilder>(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_config_string(config);
+                    cmdBuilder->add_chunk(_cmd.GetChunk());
+                    cmdBuilder->add_last_chunk(_cmd.IsLastChunk());
                 }
                 break;
                 case Type::state_change_subscription:
@@ -298,15 +330,18 @@ namespace odc::cc
                     cmdBuilder->add_task_id(_cmd.GetTaskId());
                     cmdBuilder->add_last_state(GetFBState(_cmd.GetLastState()));
                     cmdBuilder->add_current_state(GetFBState(_cmd.GetCurrentState()));
+                    cmdBuilder->add_sequence(_cmd.GetSequence());
                 }
                 break;
                 case Type::properties:
                 {
-                    auto _cmd = static_cast<Properties&>(*cmd);
+                    auto& _cmd = static_cast<Properties&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
 
+                    auto const& cmdProps = _cmd.GetProps();
                     std::vector<flatbuffers::Offset<FBProperty>> propsVector;
-                    for (const auto& e : _cmd.GetProps())
+                    propsVector.reserve(cmdProps.size());
+                    for (const auto& e : cmdProps)
                     {
                         auto key = fbb.CreateString(e.first);
                         auto val = fbb.CreateString(e.second);
@@ -320,6 +355,8 @@ namespace odc::cc
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
                     cmdBuilder->add_properties(props);
+                    cmdBuilder->add_chunk(_cmd.GetChunk());
+                    cmdBuilder->add_last_chunk(_cmd.IsLastChunk());
                 }
                 break;
                 case Type::properties_set:
@@ -333,6 +370,58 @@ namespace odc::cc
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
                 }
                 break;
+                case Type::transition_timing:
+                {
+                    auto _cmd = static_cast<TransitionTiming&>(*cmd);
+                    auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
+                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder->add_device_id(deviceId);
+                    cmdBuilder->add_task_id(_cmd.GetTaskId());
+                    cmdBuilder->add_transition(GetFBTransition(_cmd.GetTransition()));
+                    cmdBuilder->add_duration(_cmd.GetDuration());
+                }
+                break;
+                case Type::state_change_batch:
+                {
+                    auto& _cmd = static_cast<StateChangeBatch&>(*cmd);
+                    auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
+                    std::vector<flatbuffers::Offset<FBStateChangeGroup>> groupsVector;
+                    for (const auto& g : _cmd.GetGroups())
+                    {
+                        auto taskIds = fbb.CreateVector(g.fTaskIds);
+                        auto sequences = fbb.CreateVector(g.fSequences);
+                        groupsVector.push_back(CreateFBStateChangeGroup(fbb, GetFBState(g.fLastState), GetFBState(g.fCurrentState), taskIds, sequences));
+                    }
+                    auto groups = fbb.CreateVector(groupsVector);
+                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder->add_device_id(deviceId);
+                    cmdBuilder->add_task_id(_cmd.GetTaskId());
+                    cmdBuilder->add_state_change_groups(groups);
+                }
+                break;
+                case Type::direct_channel:
+                {
+                    auto _cmd = static_cast<DirectChannel&>(*cmd);
+                    auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
+                    auto endpoint = fbb.CreateString(_cmd.GetEndpoint());
+                    auto token = fbb.CreateString(_cmd.GetToken());
+                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder->add_device_id(deviceId);
+                    cmdBuilder->add_task_id(_cmd.GetTaskId());
+                    cmdBuilder->add_endpoint(endpoint);
+                    cmdBuilder->add_token(token);
+                }
+                break;
+                case Type::state_change_ack:
+                {
+                    auto _cmd = static_cast<StateChangeAck&>(*cmd);
+                    auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
+                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder->add_device_id(deviceId);
+                    cmdBuilder->add_task_id(_cmd.GetTaskId());
+                    cmdBuilder->add_sequence(_cmd.GetSequence());
+                }
+                break;
                 default:
                     throw CommandFormatError("unrecognized command type given to odc::cc::Cmds::Serialize()");
                     break;
@@ -357,9 +446,16 @@ namespace odc::cc
 
         const flatbuffers::Vector<flatbuffers::Offset<FBCommand>>* cmds = nullptr;
 
-        flatbuffers::Parser parser;
+        // the input may come from any peer of the direct channel, verify it before accessing it
+        flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+        if (!VerifyFBCommandsBuffer(verifier)) {
+            throw CommandFormatError("malformed buffer given to odc::cc::Cmds::Deserialize()");
+        }
 
         cmds = GetFBCommands(const_cast<char*>(str.c_str()))->commands();
+        if (cmds == nullptr) {
+            return;
+        }
 
         for (unsigned int i = 0; i < cmds->size(); ++i)
         {
@@ -370,27 +466,33 @@ namespace odc::cc
                     fCmds.emplace_back(make<CheckState>());
                     break;
                 case FBCmd_change_state:
-                    fCmds.emplace_back(make<ChangeState>(GetMQTransition(cmdPtr.transition())));
-                    break;
+                {
+                    std::vector<uint64_t> taskIds;
+                    if (cmdPtr.task_ids()) {
+                        taskIds.assign(cmdPtr.task_ids()->begin(), cmdPtr.task_ids()->end());
+                    }
+                    fCmds.emplace_back(make<ChangeState>(GetMQTransition(cmdPtr.transition()), std::move(taskIds)));
+                }
+                break;
                 case FBCmd_dump_config:
-                    fCmds.emplace_back(make<DumpConfig>());
+                    fCmds.emplace_back(make<DumpConfig>(cmdPtr.chunk_size()));
                     break;
                 case FBCmd_subscribe_to_state_change:
-                    fCmds.emplace_back(make<SubscribeToStateChange>(cmdPtr.interval()));
+                    fCmds.emplace_back(make<SubscribeToStateChange>(cmdPtr.interval(), cmdPtr.reply_window()));
                     break;
                 case FBCmd_unsubscribe_from_state_change:
                     fCmds.emplace_back(make<UnsubscribeFromStateChange>());
                     break;
                 case FBCmd_get_properties:
-                    fCmds.emplace_back(make<GetProperties>(cmdPtr.request_id(), cmdPtr.property_query()->str()));
+                    fCmds.emplace_back(make<GetProperties>(cmdPtr.request_id(), GetString(cmdPtr.property_query()), cmdPtr.chunk_size()));
                     break;
                 case FBCmd_set_properties:
                 {
                     std::vector<std::pair<std::string, std::string>> properties;
                     auto props = cmdPtr.properties();
-                    for (unsigned int j = 0; j < props->size(); ++j)
+                    for (unsigned int j = 0; props && j < props->size(); ++j)
                     {
-                        properties.emplace_back(props->Get(j)->key()->str(), props->Get(j)->value()->str());
+                        properties.emplace_back(GetString(props->Get(j)->key()), GetString(props->Get(j)->value()));
                     }
                     fCmds.emplace_back(make<SetProperties>(cmdPtr.request_id(), properties));
                 }
@@ -399,47 +501,85 @@ namespace odc::cc
                     fCmds.emplace_back(make<SubscriptionHeartbeat>(cmdPtr.interval()));
                     break;
                 case FBCmd_transition_status:
-                    fCmds.emplace_back(make<TransitionStatus>(cmdPtr.device_id()->str(),
+                    fCmds.emplace_back(make<TransitionStatus>(GetString(cmdPtr.device_id()),
                                                               cmdPtr.task_id(),
                                                               GetResult(cmdPtr.result()),
                                                               GetMQTransition(cmdPtr.transition()),
                                                               GetMQState(cmdPtr.current_state())));
                     break;
                 case FBCmd_config:
-                    fCmds.emplace_back(make<Config>(cmdPtr.device_id()->str(), cmdPtr.config_string()->str()));
+                    fCmds.emplace_back(make<Config>(GetString(cmdPtr.device_id()), GetString(cmdPtr.config_string()), cmdPtr.chunk(), cmdPtr.last_chunk()));
                     break;
                 case FBCmd_state_change_subscription:
                     fCmds.emplace_back(make<StateChangeSubscription>(
-                        cmdPtr.device_id()->str(), cmdPtr.task_id(), GetResult(cmdPtr.result())));
+                        GetString(cmdPtr.device_id()), cmdPtr.task_id(), GetResult(cmdPtr.result())));
                     break;
                 case FBCmd_state_change_unsubscription:
                     fCmds.emplace_back(make<StateChangeUnsubscription>(
-                        cmdPtr.device_id()->str(), cmdPtr.task_id(), GetResult(cmdPtr.result())));
+                        GetString(cmdPtr.device_id()), cmdPtr.task_id(), GetResult(cmdPtr.result())));
                     break;
                 case FBCmd_state_change:
-                    fCmds.emplace_back(make<StateChange>(cmdPtr.device_id()->str(),
+                    fCmds.emplace_back(make<StateChange>(GetString(cmdPtr.device_id()),
                                                          cmdPtr.task_id(),
                                                          GetMQState(cmdPtr.last_state()),
-                                                         GetMQState(cmdPtr.current_state())));
+                                                         GetMQState(cmdPtr.current_state()),
+                                                         cmdPtr.sequence()));
                     break;
                 case FBCmd_properties:
                 {
                     std::vector<std::pair<std::string, std::string>> properties;
                     auto props = cmdPtr.properties();
-                    for (unsigned int j = 0; j < props->size(); ++j)
+                    properties.reserve(props ? props->size() : 0);
+                    for (unsigned int j = 0; props && j < props->size(); ++j)
                     {
-                        properties.emplace_back(props->Get(j)->key()->str(), props->Get(j)->value()->str());
+                        properties.emplace_back(GetString(props->Get(j)->key()), GetString(props->Get(j)->value()));
                     }
-                    fCmds.emplace_back(make<Properties>(cmdPtr.device_id()->str(),
+                    fCmds.emplace_back(make<Properties>(GetString(cmdPtr.device_id()),
                                                         cmdPtr.task_id(),
                                                         cmdPtr.request_id(),
                                                         GetResult(cmdPtr.result()),
-                                                        properties));
+                                                        std::move(properties),
+                                                        cmdPtr.chunk(),
+                                                        cmdPtr.last_chunk()));
                 }
                 break;
                 case FBCmd_properties_set:
                     fCmds.emplace_back(make<PropertiesSet>(
-                        cmdPtr.device_id()->str(), cmdPtr.task_id(), cmdPtr.request_id(), GetResult(cmdPtr.result())));
+                        GetString(cmdPtr.device_id()), cmdPtr.task_id(), cmdPtr.request_id(), GetResult(cmdPtr.result())));
+                    break;
+                case FBCmd_transition_timing:
+                    fCmds.emplace_back(make<TransitionTiming>(GetString(cmdPtr.device_id()),
+                                                              cmdPtr.task_id(),
+                                                              GetMQTransition(cmdPtr.transition()),
+                                                              cmdPtr.duration()));
+                    break;
+                case FBCmd_state_change_batch:
+                {
+                    std::vector<StateChangeGroup> groups;
+                    auto fbGroups = cmdPtr.state_change_groups();
+                    groups.reserve(fbGroups ? fbGroups->size() : 0);
+                    for (unsigned int j = 0; fbGroups && j < fbGroups->size(); ++j)
+                    {
+                        auto fbGroup = fbGroups->Get(j);
+                        auto taskIds = fbGroup->task_ids();
+                        auto sequences = fbGroup->sequences();
+                        StateChangeGroup group{ GetMQState(fbGroup->last_state()), GetMQState(fbGroup->current_state()), {}, {} };
+                        if (taskIds) {
+                            group.fTaskIds.assign(taskIds->begin(), taskIds->end());
+                        }
+                        if (sequences && sequences->size() == group.fTaskIds.size()) {
+                            group.fSequences.assign(sequences->begin(), sequences->end());
+                        }
+                        groups.push_back(std::move(group));
+                    }
+                    fCmds.emplace_back(make<StateChangeBatch>(GetString(cmdPtr.device_id()), cmdPtr.task_id(), std::move(groups)));
+                }
+                break;
+                case FBCmd_direct_channel:
+                    fCmds.emplace_back(make<DirectChannel>(GetString(cmdPtr.device_id()), cmdPtr.task_id(), GetString(cmdPtr.endpoint()), GetString(cmdPtr.token())));
+                    break;
+                case FBCmd_state_change_ack:
+                    fCmds.emplace_back(make<StateChangeAck>(GetString(cmdPtr.device_id()), cmdPtr.task_id(), cmdPtr.sequence()));
                     break;
                 default:
                     throw CommandFormatError("unrecognized command type given to odc::cc::Cmds::Deserialize()");
@@ -11,6 +11,7 @@
 
 #include <fairmq/States.h>
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -36,21 +37,25 @@ namespace odc::cc
     enum class Type : int
     {
         check_state,                   // args: { }
-        change_state,                  // args: { transition }
-        dump_config,                   // args: { }
-        subscribe_to_state_change,     // args: { }
+        change_state,                  // args: { transition, task_ids }
+        dump_config,                   // args: { chunk_size }
+        subscribe_to_state_change,     // args: { interval, reply_window }
         unsubscribe_from_state_change, // args: { }
-        get_properties,                // args: { request_id, property_query }
+        get_properties,                // args: { request_id, property_query, chunk_size }
         set_properties,                // args: { request_id, properties }
         subscription_heartbeat,        // args: { interval }
 
         transition_status,           // args: { device_id, task_id, Result, transition, current_state }
-        config,                      // args: { device_id, config_string }
+        config,                      // args: { device_id, config_string, chunk, last_chunk }
         state_change_subscription,   // args: { device_id, task_id, Result }
         state_change_unsubscription, // args: { device_id, task_id, Result }
         state_change,                // args: { device_id, task_id, last_state, current_state }
-        properties,                  // args: { device_id, task_id, request_id, Result, properties }
-        properties_set               // args: { device_id, task_id, request_id, Result }
+        properties,                  // args: { device_id, task_id, request_id, Result, properties, chunk, last_chunk }
+        properties_set,              // args: { device_id, task_id, request_id, Result }
+        transition_timing,           // args: { device_id, task_id, transition, duration }
+        state_change_batch,          // args: { device_id, task_id, state_change_groups }
+        direct_channel,              // args: { device_id, task_id, endpoint }
+        state_change_ack             // args: { device_id, task_id, sequence }
     };
 
     struct Cmd
@@ -80,9 +85,11 @@ namespace odc::cc
 
     struct ChangeState : Cmd
     {
-        explicit ChangeState(fair::mq::Transition transition)
+        /// @param taskIds tasks that execute the transition, the other receivers ignore the command. Empty: all receivers
+        explicit ChangeState(fair::mq::Transition transition, std::vector<uint64_t> taskIds = {})
             : Cmd(Type::change_state)
             , fTransition(transition)
+            , fTaskIds(std::move(taskIds))
         {
         }
 
@@ -94,24 +101,54 @@ namespace odc::cc
         {
             fTransition = transition;
         }
+        const std::vector<uint64_t>& GetTaskIds() const
+        {
+            return fTaskIds;
+        }
+        void SetTaskIds(std::vector<uint64_t> taskIds)
+        {
+            fTaskIds = std::move(taskIds);
+        }
+        bool IsAddressedTo(const uint64_t taskId) const
+        {
+            return fTaskIds.empty() || std::find(fTaskIds.cbegin(), fTaskIds.cend(), taskId) != fTaskIds.cend();
+        }
 
       private:
         fair::mq::Transition fTransition;
+        std::vector<uint64_t> fTaskIds;
     };
 
     struct DumpConfig : Cmd
     {
-        explicit DumpConfig()
+        /// @param chunkSize max. size of a Config reply in bytes, larger configs are sent in chunks. 0: no chunking
+        explicit DumpConfig(const uint32_t chunkSize = 0)
             : Cmd(Type::dump_config)
+            , fChunkSize(chunkSize)
         {
         }
+
+        uint32_t GetChunkSize() const
+        {
+            return fChunkSize;
+        }
+        void SetChunkSize(const uint32_t chunkSize)
+        {
+            fChunkSize = chunkSize;
+        }
+
+      private:
+        uint32_t fChunkSize;
     };
 
     struct SubscribeToStateChange : Cmd
     {
-        explicit SubscribeToStateChange(int64_t interval)
+        /// @param interval heartbeat interval in ms
+        /// @param replyWindow window in ms over which the devices spread (randomly) their subscription replies. 0: reply immediately
+        explicit SubscribeToStateChange(int64_t interval, const uint32_t replyWindow = 0)
             : Cmd(Type::subscribe_to_state_change)
             , fInterval(interval)
+            , fReplyWindow(replyWindow)
         {
         }
 
@@ -123,9 +160,18 @@ namespace odc::cc
         {
             fInterval = interval;
         }
+        uint32_t GetReplyWindow() const
+        {
+            return fReplyWindow;
+        }
+        void SetReplyWindow(const uint32_t replyWindow)
+        {
+            fReplyWindow = replyWindow;
+        }
 
       private:
         int64_t fInterval;
+        uint32_t fReplyWindow;
     };
 
     struct UnsubscribeFromStateChange : Cmd
@@ -138,10 +184,12 @@ namespace odc::cc
 
     struct GetProperties : Cmd
     {
-        GetProperties(std::size_t request_id, std::string query)
+        /// @param chunkSize max. size of a Properties reply in bytes, larger replies are sent in chunks. 0: no chunking
+        GetProperties(std::size_t request_id, std::string query, const uint32_t chunkSize = 0)
             : Cmd(Type::get_properties)
             , fRequestId(request_id)
             , fQuery(std::move(query))
+            , fChunkSize(chunkSize)
         {
         }
 
@@ -161,10 +209,19 @@ namespace odc::cc
         {
             fQuery = std::move(query);
         }
+        uint32_t GetChunkSize() const
+        {
+            return fChunkSize;
+        }
+        void SetChunkSize(const uint32_t chunkSize)
+        {
+            fChunkSize = chunkSize;
+        }
 
       private:
         std::size_t fRequestId;
         std::string fQuery;
+        uint32_t fChunkSize;
     };
 
     struct SetProperties : Cmd
@@ -286,10 +343,14 @@ namespace odc::cc
 
     struct Config : Cmd
     {
-        explicit Config(std::string id, std::string config)
+        /// @param chunk sequence number of this part of the config, if chunked
+        /// @param lastChunk true if this is the last (or only) part of the config
+        explicit Config(std::string id, std::string config, const uint32_t chunk = 0, const bool lastChunk = true)
             : Cmd(Type::config)
             , fDeviceId(std::move(id))
             , fConfig(std::move(config))
+            , fChunk(chunk)
+            , fLastChunk(lastChunk)
         {
         }
 
@@ -309,10 +370,28 @@ namespace odc::cc
         {
             fConfig = config;
         }
+        uint32_t GetChunk() const
+        {
+            return fChunk;
+        }
+        void SetChunk(const uint32_t chunk)
+        {
+            fChunk = chunk;
+        }
+        bool IsLastChunk() const
+        {
+            return fLastChunk;
+        }
+        void SetLastChunk(const bool lastChunk)
+        {
+            fLastChunk = lastChunk;
+        }
 
       private:
         std::string fDeviceId;
         std::string fConfig;
+        uint32_t fChunk;
+        bool fLastChunk;
     };
 
     struct StateChangeSubscription : Cmd
@@ -399,15 +478,19 @@ namespace odc::cc
 
     struct StateChange : Cmd
     {
+        /// @param sequence per device sequence number of the state change, increasing with every change,
+        /// lets the receiver discard state changes arriving out of order over different paths. 0: unknown
         explicit StateChange(std::string deviceId,
                              const uint64_t taskId,
                              const fair::mq::State lastState,
-                             const fair::mq::State currentState)
+                             const fair::mq::State currentState,
+                             const uint64_t sequence = 0)
             : Cmd(Type::state_change)
             , fDeviceId(std::move(deviceId))
             , fTaskId(taskId)
             , fLastState(lastState)
             , fCurrentState(currentState)
+            , fSequence(sequence)
         {
         }
 
@@ -443,27 +526,42 @@ namespace odc::cc
         {
             fCurrentState = state;
         }
+        uint64_t GetSequence() const
+        {
+            return fSequence;
+        }
+        void SetSequence(const uint64_t sequence)
+        {
+            fSequence = sequence;
+        }
 
       private:
         std::string fDeviceId;
         uint64_t fTaskId;
         fair::mq::State fLastState;
         fair::mq::State fCurrentState;
+        uint64_t fSequence;
     };
 
     struct Properties : Cmd
     {
+        /// @param chunk sequence number of this part of the reply, if chunked
+        /// @param lastChunk true if this is the last (or only) part of the reply
         Properties(std::string deviceId,
                    const uint64_t taskId,
                    std::size_t requestId,
                    const Result result,
-                   std::vector<std::pair<std::string, std::string>> properties)
+                   std::vector<std::pair<std::string, std::string>> properties,
+                   const uint32_t chunk = 0,
+                   const bool lastChunk = true)
             : Cmd(Type::properties)
             , fDeviceId(std::move(deviceId))
             , fTaskId(taskId)
             , fRequestId(requestId)
             , fResult(result)
             , fProperties(std::move(properties))
+            , fChunk(chunk)
+            , fLastChunk(lastChunk)
         {
         }
 
@@ -499,14 +597,35 @@ namespace odc::cc
         {
             fResult = result;
         }
-        auto GetProps() const -> std::vector<std::pair<std::string, std::string>>
+        auto GetProps() const& -> const std::vector<std::pair<std::string, std::string>>&
         {
             return fProperties;
         }
+        /// @brief Take the properties out of a command that is no longer needed
+        auto GetProps() && -> std::vector<std::pair<std::string, std::string>>
+        {
+            return std::move(fProperties);
+        }
         auto SetProps(std::vector<std::pair<std::string, std::string>> properties) -> void
         {
             fProperties = std::move(properties);
         }
+        uint32_t GetChunk() const
+        {
+            return fChunk;
+        }
+        void SetChunk(const uint32_t chunk)
+        {
+            fChunk = chunk;
+        }
+        bool IsLastChunk() const
+        {
+            return fLastChunk;
+        }
+        void SetLastChunk(const bool lastChunk)
+        {
+            fLastChunk = lastChunk;
+        }
 
       private:
         std::string fDeviceId;
@@ -514,6 +633,8 @@ namespace odc::cc
         std::size_t fRequestId;
         Result fResult;
         std::vector<std::pair<std::string, std::string>> fProperties;
+        uint32_t fChunk;
+        bool fLastChunk;
     };
 
     struct PropertiesSet : Cmd
@@ -567,6 +688,212 @@ namespace odc::cc
         Result fResult;
     };
 
+    struct TransitionTiming : Cmd
+    {
+        /// @param duration time spent by the device in the transition, in microseconds (monotonic clock)
+        explicit TransitionTiming(std::string deviceId,
+                                  const uint64_t taskId,
+                                  const fair::mq::Transition transition,
+                                  const uint64_t duration)
+            : Cmd(Type::transition_timing)
+            , fDeviceId(std::move(deviceId))
+            , fTaskId(taskId)
+            , fTransition(transition)
+            , fDuration(duration)
+        {
+        }
+
+        std::string GetDeviceId() const
+        {
+            return fDeviceId;
+        }
+        void SetDeviceId(const std::string& deviceId)
+        {
+            fDeviceId = deviceId;
+        }
+        uint64_t GetTaskId() const
+        {
+            return fTaskId;
+        }
+        void SetTaskId(const uint64_t taskId)
+        {
+            fTaskId = taskId;
+        }
+        fair::mq::Transition GetTransition() const
+        {
+            return fTransition;
+        }
+        void SetTransition(const fair::mq::Transition transition)
+        {
+            fTransition = transition;
+        }
+        uint64_t GetDuration() const
+        {
+            return fDuration;
+        }
+        void SetDuration(const uint64_t duration)
+        {
+            fDuration = duration;
+        }
+
+      private:
+        std::string fDeviceId;
+        uint64_t fTaskId;
+        fair::mq::Transition fTransition;
+        uint64_t fDuration;
+    };
+
+    /// Devices that moved from the same last state to the same current state
+    struct StateChangeGroup
+    {
+        fair::mq::State fLastState;
+        fair::mq::State fCurrentState;
+        std::vector<uint64_t> fTaskIds;
+        std::vector<uint64_t> fSequences; ///< sequence numbers of the state changes (see StateChange), aligned with fTaskIds, empty if unknown
+
+        bool operator==(const StateChangeGroup& other) const
+        {
+            return fLastState == other.fLastState && fCurrentState == other.fCurrentState && fTaskIds == other.fTaskIds && fSequences == other.fSequences;
+        }
+    };
+
+    /// State changes of several devices, collected and forwarded by an aggregating device
+    struct StateChangeBatch : Cmd
+    {
+        explicit StateChangeBatch(std::string deviceId, const uint64_t taskId, std::vector<StateChangeGroup> groups)
+            : Cmd(Type::state_change_batch)
+            , fDeviceId(std::move(deviceId))
+            , fTaskId(taskId)
+            , fGroups(std::move(groups))
+        {
+        }
+
+        std::string GetDeviceId() const
+        {
+            return fDeviceId;
+        }
+        void SetDeviceId(const std::string& deviceId)
+        {
+            fDeviceId = deviceId;
+        }
+        uint64_t GetTaskId() const
+        {
+            return fTaskId;
+        }
+        void SetTaskId(const uint64_t taskId)
+        {
+            fTaskId = taskId;
+        }
+        const std::vector<StateChangeGroup>& GetGroups() const
+        {
+            return fGroups;
+        }
+        void SetGroups(std::vector<StateChangeGroup> groups)
+        {
+            fGroups = std::move(groups);
+        }
+
+      private:
+        std::string fDeviceId;
+        uint64_t fTaskId;
+        std::vector<StateChangeGroup> fGroups;
+    };
+
+    /// Controller -> device: endpoint of the direct channel to connect to and the token to authenticate with.
+    /// Device -> controller: first frame on the established channel, identifying the device, carrying the received token.
+    struct DirectChannel : Cmd
+    {
+        explicit DirectChannel(std::string deviceId, const uint64_t taskId, std::string endpoint, std::string token = "")
+            : Cmd(Type::direct_channel)
+            , fDeviceId(std::move(deviceId))
+            , fTaskId(taskId)
+            , fEndpoint(std::move(endpoint))
+            , fToken(std::move(token))
+        {
+        }
+
+        std::string GetDeviceId() const
+        {
+            return fDeviceId;
+        }
+        void SetDeviceId(const std::string& deviceId)
+        {
+            fDeviceId = deviceId;
+        }
+        uint64_t GetTaskId() const
+        {
+            return fTaskId;
+        }
+        void SetTaskId(const uint64_t taskId)
+        {
+            fTaskId = taskId;
+        }
+        std::string GetEndpoint() const
+        {
+            return fEndpoint;
+        }
+        void SetEndpoint(const std::string& endpoint)
+        {
+            fEndpoint = endpoint;
+        }
+        std::string GetToken() const
+        {
+            return fToken;
+        }
+        void SetToken(const std::string& token)
+        {
+            fToken = token;
+        }
+
+      private:
+        std::string fDeviceId;
+        uint64_t fTaskId;
+        std::string fEndpoint;
+        std::string fToken;
+    };
+
+    /// Aggregating device -> device: the state changes up to the given sequence number were received and will be forwarded
+    struct StateChangeAck : Cmd
+    {
+        explicit StateChangeAck(std::string deviceId, const uint64_t taskId, const uint64_t sequence)
+            : Cmd(Type::state_change_ack)
+            , fDeviceId(std::move(deviceId))
+            , fTaskId(taskId)
+            , fSequence(sequence)
+        {
+        }
+
+        std::string GetDeviceId() const
+        {
+            return fDeviceId;
+        }
+        void SetDeviceId(const std::string& deviceId)
+        {
+            fDeviceId = deviceId;
+        }
+        uint64_t GetTaskId() const
+        {
+            return fTaskId;
+        }
+        void SetTaskId(const uint64_t taskId)
+        {
+            fTaskId = taskId;
+        }
+        uint64_t GetSequence() const
+        {
+            return fSequence;
+        }
+        void SetSequence(const uint64_t sequence)
+        {
+            fSequence = sequence;
+        }
+
+      private:
+        std::string fDeviceId;
+        uint64_t fTaskId;
+        uint64_t fSequence;
+    };
+
     template <typename C, typename... Args>
     std::unique_ptr<Cmd> make(Args&&... args)
     {
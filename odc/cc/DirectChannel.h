@@ -0,0 +1,308 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef __ODC__DirectChannel
+#define __ODC__DirectChannel
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace odc::cc
+{
+
+    /// @brief One connection of the direct controller <-> device channel.
+    /// Carries serialized Cmds as frames, each prefixed with its 4 byte (big endian) length.
+    /// The socket must be created on a strand. Send/Close may be called from any thread,
+    /// handlers are called on the strand.
+    class DirectChannelConnection : public std::enable_shared_from_this<DirectChannelConnection>
+    {
+      public:
+        using FrameHandler = std::function<void(const std::string&)>;
+        using CloseHandler = std::function<void()>;
+
+        static constexpr uint32_t fMaxFrameSize = 16 * 1024 * 1024; ///< larger messages go via DDS
+        static constexpr uint32_t fMaxHelloFrameSize = 4 * 1024;   ///< limit until the peer is authenticated
+
+        explicit DirectChannelConnection(boost::asio::ip::tcp::socket socket)
+            : fSocket(std::move(socket))
+            , fOpen(true)
+            , fFrameSizeLimit(fMaxFrameSize)
+        {
+            boost::system::error_code ec;
+            fSocket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+        }
+
+        DirectChannelConnection(const DirectChannelConnection&) = delete;
+        DirectChannelConnection& operator=(const DirectChannelConnection&) = delete;
+
+        /// @brief Start reading frames
+        /// @param onFrame called for every received frame
+        /// @param onClose called once, when the connection is closed by either side or fails
+        void Start(FrameHandler onFrame, CloseHandler onClose)
+        {
+            boost::asio::post(fSocket.get_executor(), [self = shared_from_this(), onFrame = std::move(onFrame), onClose = std::move(onClose)]() mutable {
+                self->fOnFrame = std::move(onFrame);
+                self->fOnClose = std::move(onClose);
+                self->ReadHeader();
+            });
+        }
+
+        void Send(const std::string& frame)
+        {
+            std::string data;
+            data.reserve(frame.size() + 4);
+            const auto size = static_cast<uint32_t>(frame.size());
+            data.push_back(static_cast<char>((size >> 24) & 0xFF));
+            data.push_back(static_cast<char>((size >> 16) & 0xFF));
+            data.push_back(static_cast<char>((size >> 8) & 0xFF));
+            data.push_back(static_cast<char>(size & 0xFF));
+            data.append(frame);
+
+            boost::asio::post(fSocket.get_executor(), [self = shared_from_this(), data = std::move(data)]() mutable {
+                if (!self->fOpen) {
+                    return;
+                }
+                bool writing = !self->fWriteQueue.empty();
+                self->fWriteQueue.push_back(std::move(data));
+                if (!writing) {
+                    self->WriteNext();
+                }
+            });
+        }
+
+        void Close()
+        {
+            boost::asio::post(fSocket.get_executor(), [self = shared_from_this()]() { self->DoClose(); });
+        }
+
+        bool IsOpen() const
+        {
+            return fOpen;
+        }
+
+        /// @brief Limit the size of the received frames, the connection is closed when a larger frame arrives
+        /// @param limit max. frame size in bytes, at most fMaxFrameSize
+        void SetFrameSizeLimit(uint32_t limit)
+        {
+            fFrameSizeLimit = std::min(limit, fMaxFrameSize);
+        }
+
+      private:
+        void ReadHeader()
+        {
+            boost::asio::async_read(fSocket, boost::asio::buffer(fHeader), [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    self->DoClose();
+                    return;
+                }
+                const uint32_t size = (static_cast<uint32_t>(self->fHeader[0]) << 24)
+                                    | (static_cast<uint32_t>(self->fHeader[1]) << 16)
+                                    | (static_cast<uint32_t>(self->fHeader[2]) << 8)
+                                    |  static_cast<uint32_t>(self->fHeader[3]);
+                if (size > self->fFrameSizeLimit) {
+                    self->DoClose();
+                    return;
+                }
+                self->fBody.resize(size);
+                self->ReadBody();
+            });
+        }
+
+        void ReadBody()
+        {
+            boost::asio::async_read(fSocket, boost::asio::buffer(fBody), [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    self->DoClose();
+                    return;
+                }
+                if (self->fOnFrame) {
+                    self->fOnFrame(self->fBody);
+                }
+                self->ReadHeader();
+            });
+        }
+
+        void WriteNext()
+        {
+            boost::asio::async_write(fSocket, boost::asio::buffer(fWriteQueue.front()), [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    self->DoClose();
+                    return;
+                }
+                self->fWriteQueue.pop_front();
+                if (!self->fWriteQueue.empty()) {
+                    self->WriteNext();
+                }
+            });
+        }
+
+        void DoClose()
+        {
+            if (fOpen.exchange(false)) {
+                boost::system::error_code ec;
+                fSocket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+                fSocket.close(ec);
+                fWriteQueue.clear();
+                if (fOnClose) {
+                    fOnClose();
+                }
+                fOnFrame = nullptr;
+                fOnClose = nullptr;
+            }
+        }
+
+        boost::asio::ip::tcp::socket fSocket;
+        std::atomic<bool> fOpen;
+        std::atomic<uint32_t> fFrameSizeLimit;
+        std::array<unsigned char, 4> fHeader;
+        std::string fBody;
+        std::deque<std::string> fWriteQueue;
+        FrameHandler fOnFrame;
+        CloseHandler fOnClose;
+    };
+
+    /// @brief Listening side of the direct channel, accepts connections on its own I/O thread
+    class DirectChannelServer
+    {
+      public:
+        using ConnectionHandler = std::function<void(std::shared_ptr<DirectChannelConnection>)>;
+
+        /// @param host Host name or address to listen on, has to be reachable by the connecting side
+        /// @param port Port to listen on, 0 lets the system choose one
+        explicit DirectChannelServer(const std::string& host, unsigned short port = 0)
+            : fWorkGuard(fIoContext.get_executor())
+            , fAcceptor(fIoContext)
+            , fHost(host)
+        {
+            boost::asio::ip::tcp::resolver resolver(fIoContext);
+            auto endpoint = resolver.resolve(host, std::to_string(port)).begin()->endpoint();
+            fAcceptor.open(endpoint.protocol());
+            fAcceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+            fAcceptor.bind(endpoint);
+            fAcceptor.listen();
+        }
+
+        DirectChannelServer(const DirectChannelServer&) = delete;
+        DirectChannelServer& operator=(const DirectChannelServer&) = delete;
+
+        ~DirectChannelServer()
+        {
+            Stop();
+        }
+
+        void Start(ConnectionHandler onConnection)
+        {
+            fOnConnection = std::move(onConnection);
+            Accept();
+            fThread = std::thread([this]() { fIoContext.run(); });
+        }
+
+        /// @brief Stop accepting and stop the I/O thread. No handlers are called after this returns.
+        void Stop()
+        {
+            fWorkGuard.reset();
+            fIoContext.stop();
+            if (fThread.joinable()) {
+                fThread.join();
+            }
+        }
+
+        /// @brief Endpoint to be advertised to the connecting side, in "<host>:<port>" format
+        std::string GetEndpoint() const
+        {
+            return fHost + ":" + std::to_string(fAcceptor.local_endpoint().port());
+        }
+
+      private:
+        void Accept()
+        {
+            fAcceptor.async_accept(boost::asio::make_strand(fIoContext), [this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) {
+                if (ec) {
+                    return;
+                }
+                if (fOnConnection) {
+                    fOnConnection(std::make_shared<DirectChannelConnection>(std::move(socket)));
+                }
+                Accept();
+            });
+        }
+
+        boost::asio::io_context fIoContext;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> fWorkGuard;
+        boost::asio::ip::tcp::acceptor fAcceptor;
+        std::string fHost;
+        ConnectionHandler fOnConnection;
+        std::thread fThread;
+    };
+
+    /// @brief Compare the token presented by a peer with the expected one, in time independent of where they differ
+    inline bool DirectChannelTokenMatches(const std::string& token, const std::string& expected)
+    {
+        if (token.size() != expected.size() || expected.empty()) {
+            return false;
+        }
+        unsigned char diff = 0;
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            diff |= static_cast<unsigned char>(token[i] ^ expected[i]);
+        }
+        return diff == 0;
+    }
+
+    using DirectChannelConnectHandler = std::function<void(const boost::system::error_code&, std::shared_ptr<DirectChannelConnection>)>;
+
+    /// @brief Connect to a direct channel endpoint
+    /// @param ctx I/O context to run the connection on
+    /// @param endpoint Endpoint in "<host>:<port>" format, as advertised by DirectChannelServer::GetEndpoint()
+    /// @param handler Called with the established (not yet started) connection or with an error
+    inline void AsyncConnectDirectChannel(boost::asio::io_context& ctx, const std::string& endpoint, DirectChannelConnectHandler handler)
+    {
+        auto pos = endpoint.rfind(':');
+        if (pos == std::string::npos) {
+            boost::asio::post(ctx, [handler = std::move(handler)]() { handler(boost::asio::error::make_error_code(boost::asio::error::invalid_argument), nullptr); });
+            return;
+        }
+
+        auto resolver = std::make_shared<boost::asio::ip::tcp::resolver>(ctx);
+        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(boost::asio::make_strand(ctx));
+        resolver->async_resolve(endpoint.substr(0, pos), endpoint.substr(pos + 1),
+            [resolver, socket, handler = std::move(handler)](const boost::system::error_code& ec, boost::asio::ip::tcp::resolver::results_type results) mutable {
+                if (ec) {
+                    handler(ec, nullptr);
+                    return;
+                }
+                boost::asio::async_connect(*socket, results, [socket, handler = std::move(handler)](const boost::system::error_code& ec2, const boost::asio::ip::tcp::endpoint&) {
+                    if (ec2) {
+                        handler(ec2, nullptr);
+                        return;
+                    }
+                    handler(ec2, std::make_shared<DirectChannelConnection>(std::move(*socket)));
+                });
+            });
+    }
+
+} // namespace odc::cc
+
+#endif /* __ODC__DirectChannel */
@@ -0,0 +1,190 @@
+/********************************************************************************
+ * Copyright (C) 2019-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef __ODC__StateAggregation
+#define __ODC__StateAggregation
+
+#include <odc/cc/CustomCommands.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace odc::cc
+{
+
+    /// @brief State changes and transition timings collected by an aggregating device,
+    /// forwarded to the controllers as one message per aggregation interval. Not thread safe.
+    class StateChangeAggregation
+    {
+      public:
+        /// @brief Collect a state change of a device. All changes are kept, operations waiting for an intermediate state must see it.
+        /// @return false if the change is outdated, i.e. its sequence is not newer than the last collected one of the device
+        bool Add(const StateChange& cmd)
+        {
+            auto& changes = fStates[cmd.GetTaskId()];
+            if (cmd.GetSequence() != 0 && !changes.empty() && cmd.GetSequence() <= std::get<2>(changes.back())) {
+                return false;
+            }
+            changes.emplace_back(cmd.GetLastState(), cmd.GetCurrentState(), cmd.GetSequence());
+            return true;
+        }
+
+        void Add(const TransitionTiming& cmd)
+        {
+            fTimings.Add<TransitionTiming>(cmd);
+        }
+
+        bool Empty() const
+        {
+            return fStates.empty() && fTimings.Size() == 0;
+        }
+
+        /// @brief Take the collected commands: the transition timings first, same as for the individual state changes,
+        /// then one state_change_batch grouping the devices by their (last state, current state) pair.
+        /// A device with several changes appears in several groups, the controller applies them by sequence.
+        /// @param deviceId device ID of the aggregating device
+        /// @param taskId task ID of the aggregating device
+        Cmds Take(const std::string& deviceId, uint64_t taskId)
+        {
+            Cmds cmds;
+            for (auto& timing : fTimings) {
+                cmds.Add(std::move(timing));
+            }
+            fTimings.Reset();
+
+            std::map<std::pair<fair::mq::State, fair::mq::State>, StateChangeGroup> groupsByStates;
+            for (const auto& [changeTaskId, changes] : fStates) {
+                for (const auto& [lastState, currentState, sequence] : changes) {
+                    auto& group = groupsByStates.try_emplace(std::make_pair(lastState, currentState), StateChangeGroup{ lastState, currentState, {}, {} }).first->second;
+                    group.fTaskIds.push_back(changeTaskId);
+                    group.fSequences.push_back(sequence);
+                }
+            }
+            fStates.clear();
+
+            std::vector<StateChangeGroup> groups;
+            groups.reserve(groupsByStates.size());
+            for (auto& [states, group] : groupsByStates) {
+                groups.push_back(std::move(group));
+            }
+            if (!groups.empty()) {
+                cmds.Add<StateChangeBatch>(deviceId, taskId, std::move(groups));
+            }
+            return cmds;
+        }
+
+      private:
+        std::map<uint64_t, std::vector<std::tuple<fair::mq::State, fair::mq::State, uint64_t>>> fStates; ///< task id -> (last state, current state, sequence) of each change
+        Cmds fTimings;
+    };
+
+    /// @brief State changes a device sent to its aggregator that are not acknowledged yet. Not thread safe.
+    /// Changes not acknowledged within the timeout are to be reported directly, and so are the following ones until the aggregator acknowledges again.
+    /// The task ID of the aggregator is learned from its first acknowledgement, the aggregator is addressed by it from then on.
+    class AggregatorAcks
+    {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit AggregatorAcks(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+            : fTimeout(timeout)
+            , fResponsive(true)
+            , fAggregatorTaskId(0)
+        {
+        }
+
+        std::chrono::milliseconds GetTimeout() const
+        {
+            return fTimeout;
+        }
+        void SetTimeout(std::chrono::milliseconds timeout)
+        {
+            fTimeout = timeout;
+        }
+
+        /// @brief Track a state change sent to the aggregator
+        /// @param msg serialized commands of the change, reported directly if not acknowledged in time
+        /// @return false if the aggregator is unresponsive, the change is then not tracked and has to be reported directly.
+        /// It is still sent to the aggregator, to detect when it acknowledges again.
+        bool Sent(uint64_t sequence, std::string msg, Clock::time_point now)
+        {
+            if (fResponsive) {
+                fUnacknowledged.emplace(sequence, std::make_pair(now, std::move(msg)));
+            }
+            return fResponsive;
+        }
+
+        /// @brief Handle an acknowledgement of the aggregator, covering the changes up to the given sequence
+        /// @param aggregatorTaskId task ID of the acknowledging aggregator
+        /// @return true if the aggregator acknowledged again after a timeout
+        bool Acknowledged(uint64_t sequence, uint64_t aggregatorTaskId)
+        {
+            if (fAggregatorTaskId == 0) {
+                fAggregatorTaskId = aggregatorTaskId;
+            }
+            fUnacknowledged.erase(fUnacknowledged.begin(), fUnacknowledged.upper_bound(sequence));
+            const bool recovered = !fResponsive;
+            fResponsive = true;
+            return recovered;
+        }
+
+        /// @brief Take the changes if the oldest one was not acknowledged within the timeout, the aggregator is then unresponsive
+        /// @return serialized commands of the unacknowledged changes, oldest first, empty if none expired
+        std::vector<std::string> TakeExpired(Clock::time_point now)
+        {
+            std::vector<std::string> expired;
+            if (fUnacknowledged.empty() || fUnacknowledged.begin()->second.first + fTimeout > now) {
+                return expired;
+            }
+            fResponsive = false;
+            for (auto& change : fUnacknowledged) {
+                expired.push_back(std::move(change.second.second));
+            }
+            fUnacknowledged.clear();
+            return expired;
+        }
+
+        /// @brief Time at which the oldest unacknowledged change expires, nullopt if all changes are acknowledged
+        std::optional<Clock::time_point> NextExpiry() const
+        {
+            if (fUnacknowledged.empty()) {
+                return std::nullopt;
+            }
+            return fUnacknowledged.begin()->second.first + fTimeout;
+        }
+
+        bool IsResponsive() const
+        {
+            return fResponsive;
+        }
+        /// @brief Task ID of the aggregator, 0 until its first acknowledgement
+        uint64_t GetAggregatorTaskId() const
+        {
+            return fAggregatorTaskId;
+        }
+        size_t NumUnacknowledged() const
+        {
+            return fUnacknowledged.size();
+        }
+
+      private:
+        std::chrono::milliseconds fTimeout;
+        std::map<uint64_t, std::pair<Clock::time_point, std::string>> fUnacknowledged; ///< sequence -> (sent at, serialized commands)
+        bool fResponsive;
+        uint64_t fAggregatorTaskId;
+    };
+
+} // namespace odc::cc
+
+#endif /* __ODC__StateAggregation */
@@ -72,6 +72,7 @@ class GrpcClient : public odc::core::CliControllerHelper<GrpcClient>
         request.set_content(runParams.mTopoContent);
         request.set_script(runParams.mTopoScript);
         request.set_extracttoporesources(runParams.mExtractTopoResources);
+        request.set_reuseagents(runParams.mReuseAgents);
         odc::GeneralReply reply;
         grpc::ClientContext context;
         grpc::Status status = mStub->Run(&context, request, &reply);
@@ -253,6 +254,9 @@ class GrpcClient : public odc::core::CliControllerHelper<GrpcClient>
                        << "; Run Nr.: " << p.runnr()
                        << "; topology state: " << p.state() << "\n";
                 }
+                const auto& cache = rep.toposcriptcache();
+                ss << "  topology script cache: hits: " << cache.hits() << "; misses: " << cache.misses() << "; evictions: " << cache.evictions()
+                   << "; entries: " << cache.entries() << "; bytes: " << cache.bytes() << "\n";
                 ss << "  execution time: " << rep.exectime() << "ms\n";
             } else {
                 ss << "Status: " << rep.DebugString();
@@ -31,7 +31,7 @@
 
 namespace odc {
 
-class GrpcServer final : public odc::ODC::Service
+class GrpcServer final : public odc::ODC::CallbackService
 {
   public:
     GrpcServer() {}
@@ -49,12 +49,28 @@ class GrpcServer final : public odc::ODC::Service
     void setHistoryDir(const std::string& dir) { mController.setHistoryDir(dir); }
     void setZoneCfgs(const std::vector<std::string>& zonesStr) { mController.setZoneCfgs(zonesStr); }
     void setRMS(const std::string& rms) { mController.setRMS(rms); }
+    void setDirectChannelHost(const std::string& host) { mController.setDirectChannelHost(host); }
+    void setPipelinedTransitions(bool pipelined) { mController.setPipelinedTransitions(pipelined); }
+    void setSubmitWindow(size_t window) { mController.setSubmitWindow(window); }
+    void setExecThreads(size_t numThreads) { mController.setExecThreads(numThreads); }
+    void setStreamingActivation(bool streaming) { mController.setStreamingActivation(streaming); }
+    void setDifferentialUpdate(bool differential) { mController.setDifferentialUpdate(differential); }
+    void setFailFast(bool failFast) { mController.setFailFast(failFast); }
+    void setStragglerPolicy(double fraction, double latencyFactor) { mController.setStragglerPolicy(fraction, latencyFactor); }
+    void setAdaptiveTimeout(double factor) { mController.setAdaptiveTimeout(factor); }
+    void setTopologyStoreDir(const std::string& dir) { mController.setTopologyStoreDir(dir); }
+    void setTopoScriptCache(size_t ttl, size_t maxBytes, const std::vector<std::string>& envVars, const std::vector<std::string>& inputFiles)
+    {
+        mController.setTopoScriptCache(ttl, maxBytes, envVars, inputFiles);
+    }
 
     void registerResourcePlugins(const core::PluginManager::PluginMap& pluginMap) { mController.registerResourcePlugins(pluginMap); }
+    void setPersistentPlugins(bool persistent) { mController.setPersistentPlugins(persistent); }
     void restore(const std::string& restoreId, const std::string& restoreDir) { mController.restore(restoreId, restoreDir); }
+    void setSessionPoolSize(size_t size) { mController.setSessionPoolSize(size); }
 
   private:
-    ::grpc::Status Initialize(::grpc::ServerContext* ctx, const odc::InitializeRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Initialize(::grpc::CallbackServerContext* ctx, const odc::InitializeRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -63,17 +79,17 @@ class GrpcServer final : public odc::ODC::Service
         logCommonRequest("Initialize", client, common, req);
         OLOG(info, common) << "Initialize request session ID: " << req->sessionid();
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::InitializeParams initializeParams{ req->sessionid() };
-        const core::RequestResult res{ mController.execInitialize(common, initializeParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Initialize", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecInitialize(common, initializeParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Initialize", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Submit(::grpc::ServerContext* ctx, const odc::SubmitRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Submit(::grpc::CallbackServerContext* ctx, const odc::SubmitRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -82,17 +98,17 @@ class GrpcServer final : public odc::ODC::Service
         logCommonRequest("Submit", client, common, req);
         OLOG(info, common) << "Submit request plugin: " << req->plugin() << "; resources: " << req->resources();
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::SubmitParams submitParams{ req->plugin(), req->resources() };
-        const core::RequestResult res{ mController.execSubmit(common, submitParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Submit", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecSubmit(common, submitParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Submit", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Activate(::grpc::ServerContext* ctx, const odc::ActivateRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Activate(::grpc::CallbackServerContext* ctx, const odc::ActivateRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -113,17 +129,17 @@ class GrpcServer final : public odc::ODC::Service
             OLOG(info, common) << "Run request END OF TOPOLOGY SCRIPT";
         }
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::ActivateParams activateParams{ req->topology(), req->content(), req->script() };
-        const core::RequestResult res{ mController.execActivate(common, activateParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Activate", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecActivate(common, activateParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Activate", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Run(::grpc::ServerContext* ctx, const odc::RunRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Run(::grpc::CallbackServerContext* ctx, const odc::RunRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -132,7 +148,8 @@ class GrpcServer final : public odc::ODC::Service
         logCommonRequest("Run", client, common, req);
         OLOG(info, common) << "Run request plugin: " << req->plugin()
                            << "; resources: " << req->resources()
-                           << "; extractTopoResources: " << req->extracttoporesources();
+                           << "; extractTopoResources: " << req->extracttoporesources()
+                           << "; reuseAgents: " << req->reuseagents();
         OLOG(info, common) << "Run request topology file: " << req->topology();
         OLOG(info, common) << "Run request topology content: "  << req->content();
         if (req->script().empty()) {
@@ -147,17 +164,17 @@ class GrpcServer final : public odc::ODC::Service
             OLOG(info, common) << "Run request END OF TOPOLOGY SCRIPT";
         }
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
-        const core::RunParams runParams{ req->plugin(), req->resources(), req->topology(), req->content(), req->script(), req->extracttoporesources() };
-        const core::RequestResult res{ mController.execRun(common, runParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Run", common, *rep);
-        return ::grpc::Status::OK;
+        const core::RunParams runParams{ req->plugin(), req->resources(), req->topology(), req->content(), req->script(), req->extracttoporesources(), req->reuseagents() };
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecRun(common, runParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Run", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Update(::grpc::ServerContext* ctx, const odc::UpdateRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Update(::grpc::CallbackServerContext* ctx, const odc::UpdateRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -168,17 +185,17 @@ class GrpcServer final : public odc::ODC::Service
         OLOG(info, common) << "Update request content: "  << req->content();
         OLOG(info, common) << "Update request script: "   << req->script();
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::UpdateParams updateParams{ req->topology(), req->content(), req->script() };
-        const core::RequestResult res{ mController.execUpdate(common, updateParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Update", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecUpdate(common, updateParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Update", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status GetState(::grpc::ServerContext* ctx, const odc::StateRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* GetState(::grpc::CallbackServerContext* ctx, const odc::StateRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -188,14 +205,16 @@ class GrpcServer final : public odc::ODC::Service
         OLOG(debug, common) << "GetState request detailed: " << req->detailed() << "; path: " << std::quoted(req->path());
 
         const core::DeviceParams deviceParams{ req->path(), req->detailed() };
-        const core::RequestResult res{ mController.execGetState(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("GetState", common, *rep, true);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecGetState(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("GetState", common, *rep, true);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status SetProperties(::grpc::ServerContext* ctx, const odc::SetPropertiesRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* SetProperties(::grpc::CallbackServerContext* ctx, const odc::SetPropertiesRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -213,17 +232,17 @@ class GrpcServer final : public odc::ODC::Service
             props.push_back(core::SetPropertiesParams::Prop(prop.key(), prop.value()));
         }
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::SetPropertiesParams setPropertiesParams{ props, req->path() };
-        const core::RequestResult res{ mController.execSetProperties(common, setPropertiesParams) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("SetProperties", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecSetProperties(common, setPropertiesParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("SetProperties", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Configure(::grpc::ServerContext* ctx, const odc::ConfigureRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* Configure(::grpc::CallbackServerContext* ctx, const odc::ConfigureRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -231,17 +250,17 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Configure", client, common, &(req->request()));
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::DeviceParams deviceParams{ req->request().path(), req->request().detailed() };
-        const core::RequestResult res{ mController.execConfigure(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("Configure", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecConfigure(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("Configure", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Start(::grpc::ServerContext* ctx, const odc::StartRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* Start(::grpc::CallbackServerContext* ctx, const odc::StartRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -249,17 +268,17 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Start", client, common, &(req->request()));
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::DeviceParams deviceParams{ req->request().path(), req->request().detailed() };
-        const core::RequestResult res{ mController.execStart(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("Start", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecStart(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("Start", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Stop(::grpc::ServerContext* ctx, const odc::StopRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* Stop(::grpc::CallbackServerContext* ctx, const odc::StopRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -267,17 +286,17 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Stop", client, common, &(req->request()));
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::DeviceParams deviceParams{ req->request().path(), req->request().detailed() };
-        const core::RequestResult res{ mController.execStop(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("Stop", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecStop(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("Stop", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Reset(::grpc::ServerContext* ctx, const odc::ResetRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* Reset(::grpc::CallbackServerContext* ctx, const odc::ResetRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -285,17 +304,17 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Reset", client, common, &(req->request()));
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::DeviceParams deviceParams{ req->request().path(), req->request().detailed() };
-        const core::RequestResult res{ mController.execReset(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("Reset", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecReset(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("Reset", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Terminate(::grpc::ServerContext* ctx, const odc::TerminateRequest* req, odc::StateReply* rep) override
+    ::grpc::ServerUnaryReactor* Terminate(::grpc::CallbackServerContext* ctx, const odc::TerminateRequest* req, odc::StateReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -303,17 +322,17 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Terminate", client, common, &(req->request()));
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
         const core::DeviceParams deviceParams{ req->request().path(), req->request().detailed() };
-        const core::RequestResult res{ mController.execTerminate(common, deviceParams) };
-
-        setupStateReply(rep, res);
-        logStateReply("Terminate", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecTerminate(common, deviceParams, [this, common, rep, reactor](core::RequestResult res) {
+            setupStateReply(rep, res);
+            logStateReply("Terminate", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Shutdown(::grpc::ServerContext* ctx, const odc::ShutdownRequest* req, odc::GeneralReply* rep) override
+    ::grpc::ServerUnaryReactor* Shutdown(::grpc::CallbackServerContext* ctx, const odc::ShutdownRequest* req, odc::GeneralReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
@@ -321,26 +340,29 @@ class GrpcServer final : public odc::ODC::Service
 
         logCommonRequest("Shutdown", client, common, req);
 
-        std::lock_guard<std::mutex> lock(getMutex(common.mPartitionID));
-
-        const core::RequestResult res{ mController.execShutdown(common) };
-
-        setupGeneralReply(rep, res);
-        logGeneralReply("Shutdown", common, *rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecShutdown(common, [this, common, rep, reactor](core::RequestResult res) {
+            setupGeneralReply(rep, res);
+            logGeneralReply("Shutdown", common, *rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
-    ::grpc::Status Status(::grpc::ServerContext* ctx, const odc::StatusRequest* req, odc::StatusReply* rep) override
+    ::grpc::ServerUnaryReactor* Status(::grpc::CallbackServerContext* ctx, const odc::StatusRequest* req, odc::StatusReply* rep) override
     {
         assert(ctx);
         const std::string client{ clientMetadataAsString(*ctx) };
 
         OLOG(info) << "Status request for ODC " << ODC_VERSION << " (DDS " << DDS_VERSION_STRING << ") from " << client << ": runnning: " << req->running();
 
-        const core::StatusRequestResult res{ mController.execStatus(core::StatusParams(req->running())) };
-        setupStatusReply(rep, res);
-        logStatusReply(*rep);
-        return ::grpc::Status::OK;
+        auto reactor{ ctx->DefaultReactor() };
+        mController.asyncExecStatus(core::StatusParams(req->running()), [this, rep, reactor](core::StatusRequestResult res) {
+            setupStatusReply(rep, res);
+            logStatusReply(*rep);
+            reactor->Finish(::grpc::Status::OK);
+        });
+        return reactor;
     }
 
   private:
@@ -383,9 +405,9 @@ class GrpcServer final : public odc::ODC::Service
                 auto device{ rep->add_devices() };
                 device->set_id(state.mStatus.taskId);
                 device->set_state(fair::mq::GetStateName(state.mStatus.state));
-                device->set_path(state.mPath);
+                device->set_path(state.mPath.str());
                 device->set_ignored(state.mStatus.ignored);
-                device->set_host(state.mHost);
+                device->set_host(state.mHost.str());
             }
         }
     }
@@ -407,13 +429,12 @@ class GrpcServer final : public odc::ODC::Service
             partition->set_status((p.mDDSSessionStatus == core::DDSSessionStatus::running ? SessionStatus::RUNNING : SessionStatus::STOPPED));
             partition->set_state(GetAggregatedStateName(p.mAggregatedState));
         }
-    }
-
-    std::mutex& getMutex(const std::string& partitionID)
-    {
-        std::lock_guard<std::mutex> lock(mMutexMapMutex);
-        auto it{ mMutexMap.find(partitionID) };
-        return (it == mMutexMap.end()) ? mMutexMap[partitionID] : it->second;
+        auto cache{ rep->mutable_toposcriptcache() };
+        cache->set_hits(res.mTopoScriptCache.mHits);
+        cache->set_misses(res.mTopoScriptCache.mMisses);
+        cache->set_evictions(res.mTopoScriptCache.mEvictions);
+        cache->set_entries(res.mTopoScriptCache.mEntries);
+        cache->set_bytes(res.mTopoScriptCache.mBytes);
     }
 
     template<typename Request>
@@ -488,12 +509,15 @@ class GrpcServer final : public odc::ODC::Service
                            << "; Run Nr.: " << p.runnr()
                            << "; topology state: " << p.state();
             }
+            const auto& cache = rep.toposcriptcache();
+            OLOG(info) << "  topology script cache: hits: " << cache.hits() << "; misses: " << cache.misses() << "; evictions: " << cache.evictions()
+                       << "; entries: " << cache.entries() << "; bytes: " << cache.bytes();
         } else {
             OLOG(error) << "Status: " << rep.DebugString();
         }
     }
 
-    static std::string clientMetadataAsString(const ::grpc::ServerContext& ctx)
+    static std::string clientMetadataAsString(const ::grpc::ServerContextBase& ctx)
     {
         const auto clientMetadata{ ctx.client_metadata() };
         return core::toString("[", ctx.peer(), "] ",
@@ -502,11 +526,9 @@ class GrpcServer final : public odc::ODC::Service
             }));
     }
 
+    // The requests of a partition are processed sequentially by the controller, in the order of their arrival.
+    // The handlers return right away, the replies are finished on the threads of the controller once the requests completed.
     core::Controller mController; ///< Core ODC service
-
-    // Mutex for each partition - all requests for a certain partition are processed sequentially.
-    std::map<std::string, std::mutex> mMutexMap; ///< Mutex for each partition
-    std::mutex mMutexMapMutex;                   ///< Mutex of global mutex map
 };
 
 } // namespace odc::grpc
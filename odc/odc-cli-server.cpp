@@ -42,6 +42,22 @@ int main(int argc, char** argv)
         string restoreId;
         string restoreDir;
         string historyDir;
+        string directChannelHost;
+        bool pipelinedTransitions;
+        size_t submitWindow;
+        bool streamingActivation;
+        bool differentialUpdate;
+        bool failFast;
+        double stragglerFraction;
+        double stragglerLatencyFactor;
+        double adaptiveTimeoutFactor;
+        string topoStoreDir;
+        size_t topoScriptCacheTTL;
+        size_t topoScriptCacheSize;
+        vector<string> topoScriptCacheEnv;
+        vector<string> topoScriptCacheFiles;
+        size_t sessionPoolSize;
+        bool persistentPlugins;
 
         bpo::options_description options("odc-cli-server options");
         options.add_options()
@@ -49,11 +65,27 @@ int main(int argc, char** argv)
             ("version,v", "Print version")
             ("timeout", bpo::value<size_t>(&timeout)->default_value(30), "Timeout of requests in sec")
             ("rp", bpo::value<std::vector<std::string>>()->multitoken(), "Register resource plugins ( name1:cmd1 name2:cmd2 )")
+            ("rp-persistent", bpo::bool_switch(&persistentPlugins)->default_value(false), "Start resource plugins once and keep them running between requests. Plugins that do not support it are executed once per request.")
             ("zones", bpo::value<vector<string>>(&zonesStr)->multitoken()->composing(), "Zones in <name>:<cfgFilePath>:<envFilePath> format")
             ("rms", bpo::value<string>(&rms)->default_value("localhost"), "Resource management system to be used by DDS  (localhost/ssh/slurm)")
             ("restore", bpo::value<std::string>(&restoreId)->default_value(""), "If set ODC will restore the sessions from file with specified ID")
             ("restore-dir", bpo::value<std::string>(&restoreDir)->default_value(smart_path(toString("$HOME/.ODC/restore/"))), "Directory where restore files are kept")
-            ("history-dir", bpo::value<std::string>(&historyDir)->default_value(smart_path(toString("$HOME/.ODC/history/"))), "Directory where history file (timestamp, partitionId, sessionId) is kept");
+            ("history-dir", bpo::value<std::string>(&historyDir)->default_value(smart_path(toString("$HOME/.ODC/history/"))), "Directory where history file (timestamp, partitionId, sessionId) is kept")
+            ("direct-channel", bpo::value<std::string>(&directChannelHost)->default_value(""), "Host name/address to accept direct device connections on, bypassing DDS commander for device commands. Must be reachable from the devices. Empty disables it.")
+            ("pipelined-transitions", bpo::bool_switch(&pipelinedTransitions)->default_value(false), "Advance each device to its next Configure/Reset transition as soon as it completed the previous one, instead of waiting for all devices. Connect still waits for all devices.")
+            ("submit-window", bpo::value<size_t>(&submitWindow)->default_value(8), "Maximum number of DDS agent submissions in flight at the same time")
+            ("streaming-activation", bpo::bool_switch(&streamingActivation)->default_value(false), "During Run, activate the tasks of agent groups whose agents are ready while the remaining agent groups are still being allocated. Requires the collections of each agent group to be in their own topology group.")
+            ("differential-update", bpo::bool_switch(&differentialUpdate)->default_value(false), "On Update, reset and reconfigure only the tasks that were removed, added or modified. Unchanged devices stay in their current state.")
+            ("fail-fast", bpo::bool_switch(&failFast)->default_value(false), "Abort a state change as soon as a device fails that cannot be ignored, e.g. because nMin of its collection is violated, instead of waiting for the request timeout.")
+            ("straggler-fraction", bpo::value<double>(&stragglerFraction)->default_value(0), "Once this fraction (in [0, 1]) of the devices completed a state change, shed the remaining expendable devices and the remaining collections that nMin allows to lose, after the time budget set by --straggler-latency-factor. 0 disables the shedding.")
+            ("straggler-latency-factor", bpo::value<double>(&stragglerLatencyFactor)->default_value(2), "Time budget of the devices that did not complete a state change, relative to the p95 latency of the completed devices")
+            ("adaptive-timeout", bpo::value<double>(&adaptiveTimeoutFactor)->default_value(0), "Deadline of each state change step relative to the p99 of its completion times in previous requests of the same partition and topology, kept in the history directory. The request timeout still applies. 0 disables adaptive deadlines.")
+            ("topo-store-dir", bpo::value<std::string>(&topoStoreDir)->default_value(""), "Directory where topology content and generated topologies are kept, identical content is stored once. Empty uses <tmp>/odc-topologies")
+            ("topo-script-cache-ttl", bpo::value<size_t>(&topoScriptCacheTTL)->default_value(0), "Time to live in sec of cached topology generation script results. A cached result is used instead of executing the same script again. 0 disables the cache.")
+            ("topo-script-cache-size", bpo::value<size_t>(&topoScriptCacheSize)->default_value(256), "Maximum total size in MB of cached topology generation script results")
+            ("topo-script-cache-env", bpo::value<vector<string>>(&topoScriptCacheEnv)->multitoken()->composing(), "Environment variables whose values are part of the topology generation script cache key, in addition to the script command line")
+            ("topo-script-cache-files", bpo::value<vector<string>>(&topoScriptCacheFiles)->multitoken()->composing(), "Input files whose modification times are part of the topology generation script cache key")
+            ("session-pool-size", bpo::value<size_t>(&sessionPoolSize)->default_value(0), "Number of idle DDS sessions created in advance and claimed by Initialize/Run, 0 disables the pool");
         CliHelper::addLogOptions(options, logConfig);
         CliHelper::addBatchOptions(options, batchOptions, batch);
 
@@ -88,10 +120,24 @@ int main(int argc, char** argv)
         controller.setHistoryDir(historyDir);
         controller.setZoneCfgs(zonesStr);
         controller.setRMS(rms);
+        controller.setDirectChannelHost(directChannelHost);
+        controller.setPipelinedTransitions(pipelinedTransitions);
+        controller.setSubmitWindow(submitWindow);
+        controller.setStreamingActivation(streamingActivation);
+        controller.setDifferentialUpdate(differentialUpdate);
+        controller.setFailFast(failFast);
+        controller.setStragglerPolicy(stragglerFraction, stragglerLatencyFactor);
+        controller.setAdaptiveTimeout(adaptiveTimeoutFactor);
+        if (!topoStoreDir.empty()) {
+            controller.setTopologyStoreDir(topoStoreDir);
+        }
+        controller.setTopoScriptCache(topoScriptCacheTTL, topoScriptCacheSize * 1024 * 1024, topoScriptCacheEnv, topoScriptCacheFiles);
+        controller.setPersistentPlugins(persistentPlugins);
         controller.registerResourcePlugins(plugins);
         if (!restoreId.empty()) {
             controller.restore(restoreId, restoreDir);
         }
+        controller.setSessionPoolSize(sessionPoolSize);
         controller.run(batchOptions.mOutputCmds);
     } catch (exception& e) {
         std::cout << "Unhandled exception: " << e.what() << std::endl;
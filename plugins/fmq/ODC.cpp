@@ -15,6 +15,8 @@
 
 #include <cstdlib>
 #include <initializer_list>
+#include <memory>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 
@@ -24,6 +26,23 @@ using namespace fair::mq;
 namespace odc::plugins
 {
 
+/// @brief checks if the device passes through the given state on its way to the target state of a transition
+/// @param state device state
+/// @return true if the state is an intermediate (transitional) state
+bool IsIntermediateState(State state)
+{
+    switch (state) {
+        case State::Binding:
+        case State::Connecting:
+        case State::InitializingTask:
+        case State::ResettingTask:
+        case State::ResettingDevice:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /// @brief concatenates a variable number of args with the << operator via a stringstream
 /// @param t objects to be concatenated
 /// @return concatenated string
@@ -40,9 +59,17 @@ ODC::ODC(const string& name, const Plugin::Version version, const string& mainta
     , fDDSTaskId(dds::env_prop<dds::task_id>())
     , fCurrentState(DeviceState::Idle)
     , fLastState(DeviceState::Idle)
+    , fStateSequence(0)
+    , fPendingTransition(Transition::Auto)
     , fDeviceTerminationRequested(false)
     , fUpdatesAllowed(false)
     , fWorkGuard(fWorkerQueue.get_executor())
+    , fAggregationInterval(50)
+    , fAggregationFlushScheduled(false)
+    , fAggregationTimer(fWorkerQueue)
+    , fAggregatorAckCheckScheduled(false)
+    , fAggregatorAckTimer(fWorkerQueue)
+    , fDirectChannelAllowed(true)
 {
     try {
         TakeDeviceControl();
@@ -56,6 +83,21 @@ ODC::ODC(const string& name, const Plugin::Version version, const string& mainta
             SetProperty<string>("session", dds::env_prop<dds::dds_session_id>());
         }
 
+        string aggregatorTask(GetProperty<string>("aggregator-task"));
+        if (!aggregatorTask.empty()) {
+            // the aggregator is next to this task in the same collection, it is addressed by its path until its first acknowledgement tells its task ID
+            string taskPath(dds::env_prop<dds::task_path>());
+            auto pos = taskPath.rfind('/');
+            string aggregatorPath(pos == string::npos ? aggregatorTask : taskPath.substr(0, pos + 1) + aggregatorTask);
+            if (aggregatorPath != taskPath) {
+                fAggregatorPath = aggregatorPath;
+                LOG(debug) << "State changes are reported via aggregator '" << fAggregatorPath << "'";
+            }
+        }
+        fAggregationInterval = chrono::milliseconds(GetProperty<unsigned int>("aggregation-interval"));
+        fAggregatorAcks.SetTimeout(chrono::milliseconds(GetProperty<unsigned int>("aggregator-ack-timeout")));
+        fDirectChannelAllowed = GetProperty<bool>("direct-channel");
+
         auto control = GetProperty<string>("control");
         if (control == "static") {
             LOG(error) << "DDS Plugin: static mode is not supported";
@@ -97,9 +139,15 @@ ODC::ODC(const string& name, const Plugin::Version version, const string& mainta
 
                     EmptyChannelContainers();
                 } break;
+                case DeviceState::Error: {
+                    // the collected state changes must not wait for the next interval, the device may not get to it
+                    FlushAggregatedStateChanges();
+                } break;
                 case DeviceState::Exiting: {
+                    FlushAggregatedStateChanges();
                     fWorkGuard.reset();
                     fDeviceTerminationRequested = true;
+                    CloseDirectChannels();
                     UnsubscribeFromDeviceStateChange();
                     ReleaseDeviceControl();
                 } break;
@@ -112,7 +160,27 @@ ODC::ODC(const string& name, const Plugin::Version version, const string& mainta
             string id = GetProperty<string>("id");
             fLastState = fCurrentState;
             fCurrentState = newState;
+            // incremented after the states are set, readers take the sequence first (see check_state)
+            const uint64_t sequence = ++fStateSequence;
 
+            Cmds outCmds;
+            {
+                // the transition is complete once the device leaves the intermediate states
+                lock_guard<mutex> lock{ fTransitionMutex };
+                if (fPendingTransition != Transition::Auto && !IsIntermediateState(newState)) {
+                    auto duration = chrono::duration_cast<chrono::microseconds>(now - fTransitionStart).count();
+                    LOG(debug) << fPendingTransition << " transition took " << duration << " us";
+                    // timing goes before the state change, so that it is stored by the time the controller sees the target state
+                    outCmds.Add<TransitionTiming>(id, fDDSTaskId, fPendingTransition, duration);
+                    fPendingTransition = Transition::Auto;
+                }
+            }
+            outCmds.Add<StateChange>(id, fDDSTaskId, fLastState, fCurrentState, sequence);
+            const string outCmdsStr(outCmds.Serialize());
+
+            // errors are reported directly, they must not wait for the next flush of the aggregator
+            bool viaAggregator = !fAggregatorPath.empty() && fCurrentState != DeviceState::Error;
+            bool sentToAggregator = false;
             lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
             for (auto it = fStateChangeSubscribers.cbegin(); it != fStateChangeSubscribers.end();) {
                 // if a subscriber did not send a heartbeat in more than 3 times the promised interval,
@@ -123,9 +191,17 @@ ODC::ODC(const string& name, const Plugin::Version version, const string& mainta
                 } else {
                     // Do not publish Exiting state - controller should subsceibe for onTaskDone events.
                     if (fCurrentState != DeviceState::Exiting) {
-                        LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to " << it->first;
-                        Cmds cmds(make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState));
-                        fDDS.Send(cmds.Serialize(), to_string(it->first));
+                        if (viaAggregator && !sentToAggregator) {
+                            // the aggregator forwards to its own subscribers, which are the same controllers.
+                            // While it does not acknowledge, the state changes are reported directly as well.
+                            LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to aggregator " << fAggregatorPath;
+                            viaAggregator = SendToAggregator(outCmdsStr, sequence);
+                            sentToAggregator = true;
+                        }
+                        if (!viaAggregator) {
+                            LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to " << it->first;
+                            SendToController(outCmdsStr, it->first);
+                        }
                     }
                     ++it;
                 }
@@ -333,39 +409,75 @@ void ODC::HandleCmd(const string& id, odc::cc::Cmd& cmd, const string& cond, uin
     // LOG(info) << "Received command type: '" << cmd.GetType() << "' from " << senderId;
     switch (cmd.GetType()) {
         case Type::check_state: {
-            Cmds cmds(make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState));
-            fDDS.Send(cmds.Serialize(), to_string(senderId));
+            // a state change in between is sent again with a newer sequence
+            const uint64_t sequence = fStateSequence;
+            Cmds cmds(make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState, sequence));
+            SendToController(cmds.Serialize(), senderId);
         } break;
         case Type::change_state: {
-            Transition transition = static_cast<ChangeState&>(cmd).GetTransition();
+            auto& _cmd = static_cast<ChangeState&>(cmd);
+            // pipelined transitions are addressed to the devices ready for them, broadcast to the whole path
+            if (!_cmd.IsAddressedTo(fDDSTaskId)) {
+                break;
+            }
+            Transition transition = _cmd.GetTransition();
             // LOG(info) << "Transition requested: '" << static_cast<ChangeState&>(cmd).GetTransition() << "'";
+            {
+                // take the timestamp before the request, the state change callback may fire before ChangeDeviceState returns
+                lock_guard<mutex> lock{ fTransitionMutex };
+                fPendingTransition = transition;
+                fTransitionStart = chrono::steady_clock::now();
+            }
             if (ChangeDeviceState(transition)) {
                 // disable OK response for now - currently not used.
                 // Cmds outCmds(make<TransitionStatus>(id, fDDSTaskId, Result::Ok, transition, GetCurrentDeviceState()));
                 // fDDS.Send(outCmds.Serialize(), to_string(senderId));
             } else {
+                {
+                    lock_guard<mutex> lock{ fTransitionMutex };
+                    fPendingTransition = Transition::Auto;
+                }
                 Cmds outCmds(make<TransitionStatus>(id, fDDSTaskId, Result::Failure, transition, GetCurrentDeviceState()));
-                fDDS.Send(outCmds.Serialize(), to_string(senderId));
+                SendToController(outCmds.Serialize(), senderId);
             }
         } break;
         case Type::dump_config: {
+            const uint32_t chunkSize = static_cast<DumpConfig&>(cmd).GetChunkSize();
             stringstream ss;
+            uint32_t chunk = 0;
             for (const auto& pKey : GetPropertyKeys()) {
                 ss << id << ": " << pKey << " -> " << GetPropertyAsString(pKey) << "\n";
+                // stream the config in chunks of whole lines
+                if (chunkSize > 0 && ss.tellp() >= static_cast<streamoff>(chunkSize)) {
+                    SendToController(Cmds(make<Config>(id, ss.str(), chunk++, false)).Serialize(), senderId);
+                    ss.str("");
+                }
             }
-            Cmds outCmds(make<Config>(id, ss.str()));
-            fDDS.Send(outCmds.Serialize(), to_string(senderId));
+            Cmds outCmds(make<Config>(id, ss.str(), chunk, true));
+            SendToController(outCmds.Serialize(), senderId);
         } break;
         case Type::subscribe_to_state_change: {
             auto _cmd = static_cast<cc::SubscribeToStateChange&>(cmd);
             lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
             fStateChangeSubscribers.emplace(senderId, make_pair(chrono::steady_clock::now(), _cmd.GetInterval()));
 
-            LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to " << senderId;
-
-            Cmds outCmds(make<StateChangeSubscription>(id, fDDSTaskId, Result::Ok), make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState));
-
-            fDDS.Send(outCmds.Serialize(), to_string(senderId));
+            if (_cmd.GetReplyWindow() == 0) {
+                SendStateChangeSubscription(id, senderId);
+            } else {
+                // reply at a random point within the window, so that not all devices of the topology reply at once
+                mt19937_64 engine(fDDSTaskId ^ senderId);
+                chrono::microseconds delay(uniform_int_distribution<int64_t>(0, int64_t(_cmd.GetReplyWindow()) * 1000 - 1)(engine));
+                auto timer = make_shared<boost::asio::steady_timer>(fWorkerQueue, delay);
+                timer->async_wait([this, id, senderId, timer](const boost::system::error_code& ec) {
+                    if (!ec) {
+                        lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
+                        // skip if the controller unsubscribed in the meantime
+                        if (fStateChangeSubscribers.count(senderId) > 0) {
+                            SendStateChangeSubscription(id, senderId);
+                        }
+                    }
+                });
+            }
         } break;
         case Type::subscription_heartbeat: {
             try {
@@ -382,23 +494,50 @@ void ODC::HandleCmd(const string& id, odc::cc::Cmd& cmd, const string& cond, uin
                 fStateChangeSubscribers.erase(senderId);
             }
             Cmds outCmds(make<StateChangeUnsubscription>(id, fDDSTaskId, Result::Ok));
-            fDDS.Send(outCmds.Serialize(), to_string(senderId));
+            SendToController(outCmds.Serialize(), senderId);
+        } break;
+        case Type::state_change: {
+            // state change of a device that uses this one as its aggregator
+            AggregateStateChange(id, static_cast<cc::StateChange&>(cmd), senderId);
+        } break;
+        case Type::state_change_ack: {
+            HandleAggregatorAck(static_cast<cc::StateChangeAck&>(cmd));
+        } break;
+        case Type::transition_timing: {
+            AggregateTransitionTiming(static_cast<cc::TransitionTiming&>(cmd));
+        } break;
+        case Type::direct_channel: {
+            if (fDirectChannelAllowed) {
+                auto& _cmd = static_cast<cc::DirectChannel&>(cmd);
+                ConnectDirectChannel(id, _cmd.GetEndpoint(), _cmd.GetToken(), senderId);
+            }
         } break;
         case Type::get_properties: {
-            auto _cmd = static_cast<cc::GetProperties&>(cmd);
+            auto& _cmd = static_cast<cc::GetProperties&>(cmd);
             auto const request_id(_cmd.GetRequestId());
+            auto const chunkSize(_cmd.GetChunkSize());
             auto result(Result::Ok);
             vector<pair<string, string>> props;
+            uint32_t chunk = 0;
             try {
-                for (auto const& prop : GetPropertiesAsString(_cmd.GetQuery())) {
-                    props.push_back({ prop.first, prop.second });
+                size_t chunkBytes = 0;
+                for (auto& prop : GetPropertiesAsString(_cmd.GetQuery())) {
+                    chunkBytes += prop.first.size() + prop.second.size();
+                    props.emplace_back(prop.first, move(prop.second));
+                    // stream large replies in chunks, the controller assembles them in sequence
+                    if (chunkSize > 0 && chunkBytes >= chunkSize) {
+                        SendToController(Cmds(make<cc::Properties>(id, fDDSTaskId, request_id, Result::Ok, move(props), chunk++, false)).Serialize(), senderId);
+                        props.clear();
+                        chunkBytes = 0;
+                    }
                 }
             } catch (exception const& e) {
                 LOG(warn) << "Getting properties (request id: " << request_id << ") failed: " << e.what();
                 result = Result::Failure;
+                props.clear();
             }
-            Cmds const outCmds(make<cc::Properties>(id, fDDSTaskId, request_id, result, props));
-            fDDS.Send(outCmds.Serialize(), to_string(senderId));
+            Cmds const outCmds(make<cc::Properties>(id, fDDSTaskId, request_id, result, props, chunk, true));
+            SendToController(outCmds.Serialize(), senderId);
         } break;
         case Type::set_properties: {
             auto _cmd(static_cast<cc::SetProperties&>(cmd));
@@ -416,7 +555,7 @@ void ODC::HandleCmd(const string& id, odc::cc::Cmd& cmd, const string& cond, uin
                 result = Result::Failure;
             }
             Cmds const outCmds(make<PropertiesSet>(id, fDDSTaskId, request_id, result));
-            fDDS.Send(outCmds.Serialize(), to_string(senderId));
+            SendToController(outCmds.Serialize(), senderId);
         } break;
         default:
             LOG(warn) << "Unexpected/unknown command received: " << cmd.GetType();
@@ -426,11 +565,236 @@ void ODC::HandleCmd(const string& id, odc::cc::Cmd& cmd, const string& cond, uin
     }
 }
 
+// precondition: fStateChangeSubscriberMutex is locked
+void ODC::SendStateChangeSubscription(const string& id, uint64_t controllerId)
+{
+    using namespace odc::cc;
+    LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to " << controllerId;
+    const uint64_t sequence = fStateSequence;
+    Cmds outCmds(make<StateChangeSubscription>(id, fDDSTaskId, Result::Ok), make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState, sequence));
+    SendToController(outCmds.Serialize(), controllerId);
+}
+
+void ODC::AggregateStateChange(const string& id, const cc::StateChange& cmd, uint64_t senderId)
+{
+    {
+        // without subscribers the change could not be forwarded, leave it unacknowledged for the device to report it directly
+        lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
+        if (fDeviceTerminationRequested || fStateChangeSubscribers.empty()) {
+            return;
+        }
+    }
+    {
+        lock_guard<mutex> lock{ fAggregationMutex };
+        fAggregation.Add(cmd);
+        if (cmd.GetCurrentState() != DeviceState::Error) {
+            ScheduleAggregationFlush();
+        }
+    }
+    if (cmd.GetCurrentState() == DeviceState::Error) {
+        // errors are forwarded right away
+        FlushAggregatedStateChanges();
+    }
+    if (cmd.GetSequence() != 0) {
+        fDDS.Send(cc::Cmds(cc::make<cc::StateChangeAck>(id, fDDSTaskId, cmd.GetSequence())).Serialize(), to_string(senderId));
+    }
+}
+
+void ODC::AggregateTransitionTiming(const cc::TransitionTiming& cmd)
+{
+    lock_guard<mutex> lock{ fAggregationMutex };
+    fAggregation.Add(cmd);
+    ScheduleAggregationFlush();
+}
+
+// precondition: fAggregationMutex is locked
+void ODC::ScheduleAggregationFlush()
+{
+    if (!fAggregationFlushScheduled) {
+        fAggregationFlushScheduled = true;
+        fAggregationTimer.expires_after(fAggregationInterval);
+        fAggregationTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec) {
+                FlushAggregatedStateChanges();
+            }
+        });
+    }
+}
+
+void ODC::FlushAggregatedStateChanges()
+{
+    using namespace odc::cc;
+    Cmds outCmds;
+    {
+        lock_guard<mutex> lock{ fAggregationMutex };
+        fAggregationFlushScheduled = false;
+        if (fAggregation.Empty()) {
+            return;
+        }
+        outCmds = fAggregation.Take(GetProperty<string>("id"), fDDSTaskId);
+    }
+
+    if (outCmds.Size() == 0) {
+        return;
+    }
+
+    const string outCmdsStr(outCmds.Serialize());
+    lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
+    for (const auto& subscriber : fStateChangeSubscribers) {
+        LOG(debug) << "Forwarding " << outCmds.Size() << " aggregated command(s) to " << subscriber.first;
+        SendToController(outCmdsStr, subscriber.first);
+    }
+}
+
+// precondition: fStateChangeSubscriberMutex is locked
+bool ODC::SendToAggregator(const string& msg, uint64_t sequence)
+{
+    bool responsive = false;
+    string destination;
+    {
+        lock_guard<mutex> lock{ fAggregatorAckMutex };
+        // while the aggregator is unresponsive the changes are sent to it only to detect when it acknowledges again
+        responsive = fAggregatorAcks.Sent(sequence, msg, chrono::steady_clock::now());
+        if (responsive) {
+            ScheduleAggregatorAckCheck();
+        }
+        const uint64_t aggregatorTaskId = fAggregatorAcks.GetAggregatorTaskId();
+        destination = aggregatorTaskId == 0 ? fAggregatorPath : to_string(aggregatorTaskId);
+    }
+    fDDS.Send(msg, destination);
+    return responsive;
+}
+
+void ODC::HandleAggregatorAck(const cc::StateChangeAck& cmd)
+{
+    lock_guard<mutex> lock{ fAggregatorAckMutex };
+    const bool known = fAggregatorAcks.GetAggregatorTaskId() != 0;
+    if (fAggregatorAcks.Acknowledged(cmd.GetSequence(), cmd.GetTaskId())) {
+        LOG(info) << "Aggregator " << fAggregatorPath << " acknowledged again, reporting state changes via aggregator";
+    }
+    if (!known) {
+        LOG(debug) << "Aggregator " << fAggregatorPath << " is task " << fAggregatorAcks.GetAggregatorTaskId() << ", addressing it by task ID";
+    }
+}
+
+// precondition: fAggregatorAckMutex is locked
+void ODC::ScheduleAggregatorAckCheck()
+{
+    const auto expiry = fAggregatorAcks.NextExpiry();
+    if (!fAggregatorAckCheckScheduled && expiry.has_value()) {
+        fAggregatorAckCheckScheduled = true;
+        fAggregatorAckTimer.expires_at(expiry.value());
+        fAggregatorAckTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec) {
+                CheckAggregatorAcks();
+            }
+        });
+    }
+}
+
+void ODC::CheckAggregatorAcks()
+{
+    vector<string> unacknowledged;
+    {
+        lock_guard<mutex> lock{ fAggregatorAckMutex };
+        fAggregatorAckCheckScheduled = false;
+        unacknowledged = fAggregatorAcks.TakeExpired(chrono::steady_clock::now());
+        if (!unacknowledged.empty()) {
+            LOG(warn) << "Aggregator " << fAggregatorPath << " did not acknowledge state changes within " << fAggregatorAcks.GetTimeout().count() << " ms, reporting them directly";
+        }
+        ScheduleAggregatorAckCheck();
+    }
+
+    if (unacknowledged.empty()) {
+        return;
+    }
+    // changes that also reach the controller via the aggregator later are discarded there by their sequence
+    lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
+    for (const auto& msg : unacknowledged) {
+        for (const auto& subscriber : fStateChangeSubscribers) {
+            SendToController(msg, subscriber.first);
+        }
+    }
+}
+
+void ODC::ConnectDirectChannel(const string& id, const string& endpoint, const string& token, uint64_t controllerId)
+{
+    LOG(debug) << "Connecting to the direct channel of controller " << controllerId << " at " << endpoint;
+    cc::AsyncConnectDirectChannel(fWorkerQueue, endpoint, [this, id, endpoint, token, controllerId](const boost::system::error_code& ec, shared_ptr<cc::DirectChannelConnection> connection) {
+        if (ec) {
+            LOG(warn) << "Failed to connect to the direct channel at " << endpoint << ": " << ec.message() << ". Communicating with controller " << controllerId << " via DDS.";
+            return;
+        }
+
+        weak_ptr<cc::DirectChannelConnection> weakConnection = connection;
+        connection->Start(
+            [this, id, controllerId](const string& frame) {
+                try {
+                    odc::cc::Cmds inCmds;
+                    inCmds.Deserialize(frame);
+                    for (const auto& cmd : inCmds) {
+                        HandleCmd(id, *cmd, "", controllerId);
+                    }
+                } catch (exception& e) {
+                    LOG(error) << "Failed to handle direct channel frame: " << e.what();
+                }
+            },
+            [this, controllerId, weakConnection]() {
+                lock_guard<mutex> lock{ fDirectChannelsMutex };
+                auto it = fDirectChannels.find(controllerId);
+                if (it != fDirectChannels.end() && !it->second.owner_before(weakConnection) && !weakConnection.owner_before(it->second)) {
+                    fDirectChannels.erase(it);
+                    LOG(debug) << "Direct channel to controller " << controllerId << " closed, communicating via DDS";
+                }
+            });
+        // identify ourselves, the controller associates the connection with this task after checking the token
+        connection->Send(cc::Cmds(cc::make<cc::DirectChannel>(id, fDDSTaskId, "", token)).Serialize());
+
+        lock_guard<mutex> lock{ fDirectChannelsMutex };
+        if (fDeviceTerminationRequested) {
+            connection->Close();
+            return;
+        }
+        auto& channel = fDirectChannels[controllerId];
+        if (channel) {
+            channel->Close();
+        }
+        channel = move(connection);
+        LOG(debug) << "Connected to the direct channel of controller " << controllerId;
+    });
+}
+
+void ODC::CloseDirectChannels()
+{
+    lock_guard<mutex> lock{ fDirectChannelsMutex };
+    for (auto& channel : fDirectChannels) {
+        channel.second->Close();
+    }
+    fDirectChannels.clear();
+}
+
+void ODC::SendToController(const string& msg, uint64_t controllerId)
+{
+    {
+        lock_guard<mutex> lock{ fDirectChannelsMutex };
+        auto it = fDirectChannels.find(controllerId);
+        if (it != fDirectChannels.end() && it->second->IsOpen() && msg.size() <= cc::DirectChannelConnection::fMaxFrameSize) {
+            it->second->Send(msg);
+            return;
+        }
+    }
+    fDDS.Send(msg, to_string(controllerId));
+}
+
 ODC::~ODC()
 {
     UnsubscribeFromDeviceStateChange();
     ReleaseDeviceControl();
 
+    // open connections would keep the worker busy
+    fDeviceTerminationRequested = true;
+    CloseDirectChannels();
+
     fWorkGuard.reset();
     if (fWorkerThread.joinable()) {
         fWorkerThread.join();
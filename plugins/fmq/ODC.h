@@ -10,6 +10,8 @@
 #define __ODC__fairmq_odc
 
 #include <odc/cc/CustomCommands.h>
+#include <odc/cc/DirectChannel.h>
+#include <odc/cc/StateAggregation.h>
 
 #include <fairmq/Plugin.h>
 #include <fairmq/StateQueue.h>
@@ -20,15 +22,18 @@
 #include <boost/asio/executor.hpp>
 #include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <atomic>
 #include <cassert>
 #include <chrono>
 #include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <utility> // pair
 #include <vector>
@@ -142,6 +147,20 @@ class ODC : public fair::mq::Plugin
     void PublishBoundChannels();
     void SubscribeForCustomCommands();
     void HandleCmd(const std::string& id, cc::Cmd& cmd, const std::string& cond, uint64_t senderId);
+    void SendStateChangeSubscription(const std::string& id, uint64_t controllerId);
+
+    void AggregateStateChange(const std::string& id, const cc::StateChange& cmd, uint64_t senderId);
+    void AggregateTransitionTiming(const cc::TransitionTiming& cmd);
+    void ScheduleAggregationFlush();
+    void FlushAggregatedStateChanges();
+    bool SendToAggregator(const std::string& msg, uint64_t sequence);
+    void HandleAggregatorAck(const cc::StateChangeAck& cmd);
+    void ScheduleAggregatorAckCheck();
+    void CheckAggregatorAcks();
+
+    void ConnectDirectChannel(const std::string& id, const std::string& endpoint, const std::string& token, uint64_t controllerId);
+    void CloseDirectChannels();
+    void SendToController(const std::string& msg, uint64_t controllerId);
 
     DDSSubscription fDDS;
     size_t fDDSTaskId;
@@ -153,6 +172,12 @@ class ODC : public fair::mq::Plugin
     std::unordered_map<std::string, IofN> fIofN;
 
     DeviceState fCurrentState, fLastState;
+    std::atomic<uint64_t> fStateSequence; ///< number of state changes, sent along with the states so that the controller can order them
+
+    // transition currently executed by the device (Auto if none) and its start time, used for timing telemetry
+    fair::mq::Transition fPendingTransition;
+    std::chrono::steady_clock::time_point fTransitionStart;
+    std::mutex fTransitionMutex;
 
     std::atomic<bool> fDeviceTerminationRequested;
 
@@ -166,6 +191,25 @@ class ODC : public fair::mq::Plugin
     std::thread fWorkerThread;
     boost::asio::io_context fWorkerQueue;
     boost::asio::executor_work_guard<boost::asio::executor> fWorkGuard;
+
+    // state change aggregation: devices with an aggregator report to it instead of to the controller(s),
+    // the aggregator forwards the collected changes as one state_change_batch per interval
+    std::string fAggregatorPath; ///< DDS path of the aggregating device until it tells its task ID, empty if state changes are reported directly
+    std::chrono::milliseconds fAggregationInterval;
+    cc::StateChangeAggregation fAggregation; ///< changes collected from the devices that use this one as their aggregator
+    bool fAggregationFlushScheduled;
+    std::mutex fAggregationMutex;
+    boost::asio::steady_timer fAggregationTimer;
+    // the aggregator acknowledges each change, unacknowledged changes are reported directly after a timeout
+    cc::AggregatorAcks fAggregatorAcks;
+    bool fAggregatorAckCheckScheduled;
+    std::mutex fAggregatorAckMutex;
+    boost::asio::steady_timer fAggregatorAckTimer;
+
+    // direct channels to the controllers that offered one, replies and state changes to these controllers bypass DDS
+    bool fDirectChannelAllowed;
+    std::unordered_map<uint64_t, std::shared_ptr<cc::DirectChannelConnection>> fDirectChannels; ///< controller (DDS sender) id -> connection
+    std::mutex fDirectChannelsMutex;
 };
 
 inline fair::mq::Plugin::ProgOptions ODCPluginProgramOptions()
@@ -175,7 +219,11 @@ inline fair::mq::Plugin::ProgOptions ODCPluginProgramOptions()
     options.add_options()
         ("dds-i", value<std::vector<std::string>>()->multitoken()->composing(), "Task index for chosing connection target (single channel n to m). When all values come via same update.")
         ("dds-i-n",value<std::vector<std::string>>()->multitoken()->composing(),"Task index for chosing connection target (one out of n values to take). When values come as independent updates.")
-        ("wait-for-exiting-ack-timeout", value<unsigned int>()->default_value(1000), "Wait timeout for EXITING state-change acknowledgement by external controller in milliseconds.");
+        ("wait-for-exiting-ack-timeout", value<unsigned int>()->default_value(1000), "Wait timeout for EXITING state-change acknowledgement by external controller in milliseconds.")
+        ("aggregator-task", value<std::string>()->default_value(""), "Name of a task in the same collection that collects state changes of this device and forwards them to the controller. Empty: report directly.")
+        ("aggregation-interval", value<unsigned int>()->default_value(50), "Interval in milliseconds at which an aggregating device forwards the collected state changes.")
+        ("aggregator-ack-timeout", value<unsigned int>()->default_value(1000), "Time in milliseconds within which the aggregator has to acknowledge a state change. Otherwise the change, and the following ones until the aggregator acknowledges again, are reported directly.")
+        ("direct-channel", value<bool>()->default_value(true), "Connect to the direct channel offered by the controller. If false, or if the connection fails, communicate via DDS only.");
 
     return options;
 }
@@ -7,6 +7,7 @@
  ********************************************************************************/
 
 #include <odc/MiscUtils.h>
+#include <odc/PluginProtocol.h>
 #include <odc/Version.h>
 
 #include <boost/algorithm/string.hpp>
@@ -107,6 +108,33 @@ map<string, ZoneConfig> getZoneConfig(const vector<string>& zonesStr)
     return result;
 }
 
+string makeSubmitConfig(const string& resources, const map<string, ZoneConfig>& zones)
+{
+    Resources res(resources);
+    stringstream ss;
+
+    for (const auto& r : res.mResources) {
+        if (zones.find(r.mZone) == zones.end()) {
+            throw runtime_error(toString("Zone not found: ", r.mZone));
+        }
+        const auto& zone = zones.at(r.mZone);
+        ss << "<submit>"
+           << "<rms>slurm</rms>";
+        if (!zone.slurmCfgPath.empty()) {
+            ss << "<configFile>" << zone.slurmCfgPath << "</configFile>";
+        }
+        if (!zone.envCfgPath.empty()) {
+            ss << "<envFile>" << zone.envCfgPath << "</envFile>";
+        }
+        ss << "<agents>" << r.mN << "</agents>" // number of agents (assuming it is equals to number of nodes)
+           << "<zone>" << r.mZone << "</zone>" // zone
+           << "<slots>" << zone.numSlots << "</slots>" // number of slots per agent
+           << "</submit>" << endl;
+    }
+
+    return ss.str();
+}
+
 int main(int argc, char** argv)
 {
     try {
@@ -124,6 +152,7 @@ int main(int argc, char** argv)
             ("severity", bpo::value<string>(), "[DEPRECATED] Does nothing")
             ("infologger", bpo::bool_switch()->default_value(false), "[DEPRECATED] Does nothing")
             ("zones", bpo::value<vector<string>>(&zonesStr)->multitoken()->composing(), "Zones in <name>:<numSlots>:<slurmCfgPath>:<envCfgPath> format")
+            (rp::kPersistentOption, bpo::bool_switch()->default_value(false), "Keep running and serve requests of ODC over stdin/stdout")
             ("version,v", "Print version")
             ("help,h", "Help message");
 
@@ -141,31 +170,13 @@ int main(int argc, char** argv)
             return EXIT_SUCCESS;
         }
 
-        Resources res(resources);
         map<string, ZoneConfig> zones{getZoneConfig(zonesStr)};
 
-        for (const auto& r : res.mResources) {
-            stringstream ss;
-            if (zones.find(r.mZone) == zones.end()) {
-                cerr << "Zone not found: " << r.mZone;
-                return EXIT_FAILURE;
-            }
-            const auto& zone = zones.at(r.mZone);
-            ss << "<submit>"
-               << "<rms>slurm</rms>";
-            if (!zone.slurmCfgPath.empty()) {
-                ss << "<configFile>" << zone.slurmCfgPath << "</configFile>";
-            }
-            if (!zone.envCfgPath.empty()) {
-                ss << "<envFile>" << zone.envCfgPath << "</envFile>";
-            }
-            ss << "<agents>" << r.mN << "</agents>" // number of agents (assuming it is equals to number of nodes)
-               << "<zone>" << r.mZone << "</zone>" // zone
-               << "<slots>" << zone.numSlots << "</slots>" // number of slots per agent
-               << "</submit>";
-
-            cout << ss.str() << endl;
+        if (vm.at(rp::kPersistentOption).as<bool>()) {
+            return rp::servePersistent([&zones](const string& res, const string& /*partitionID*/) { return makeSubmitConfig(res, zones); });
         }
+
+        cout << makeSubmitConfig(resources, zones);
     } catch (exception& e) {
         cerr << e.what();
         return EXIT_FAILURE;
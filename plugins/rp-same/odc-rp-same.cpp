@@ -6,6 +6,7 @@
  *                  copied verbatim in the file "LICENSE"                       *
  ********************************************************************************/
 
+#include <odc/PluginProtocol.h>
 #include <odc/Version.h>
 
 #include <boost/program_options/options_description.hpp>
@@ -27,6 +28,7 @@ int main(int argc, char** argv)
         options.add_options()
             ("id", bpo::value<std::string>(&partitionID)->default_value(""), "Partition ID")
             ("res", bpo::value<string>(&res)->default_value(""), "Resource description")
+            (odc::core::rp::kPersistentOption, bpo::bool_switch()->default_value(false), "Keep running and serve requests of ODC over stdin/stdout")
             ("version,v", "Print version")
             ("help,h", "Print help");
 
@@ -44,6 +46,10 @@ int main(int argc, char** argv)
             return EXIT_SUCCESS;
         }
 
+        if (vm.at(odc::core::rp::kPersistentOption).as<bool>()) {
+            return odc::core::rp::servePersistent([](const string& resources, const string& /*partitionID*/) { return resources; });
+        }
+
         cout << res;
     } catch (exception& _e) {
         cerr << _e.what();
@@ -12,7 +12,14 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include <odc/cc/CustomCommands.h>
+#include <odc/cc/DirectChannel.h>
+#include <odc/cc/StateAggregation.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 using namespace boost::unit_test;
 
@@ -24,6 +31,7 @@ BOOST_AUTO_TEST_SUITE(format)
 BOOST_AUTO_TEST_CASE(construction)
 {
     auto const props(std::vector<std::pair<std::string, std::string>>({ { "k1", "v1" }, { "k2", "v2" } }));
+    auto const groups(std::vector<StateChangeGroup>({ { State::InitializingTask, State::Ready, { 1, 2, 3 }, { 7, 8, 9 } }, { State::Running, State::Error, { 4 }, {} } }));
 
     Cmds checkStateCmds(make<CheckState>());
     Cmds changeStateCmds(make<ChangeState>(fair::mq::Transition::Stop));
@@ -37,25 +45,34 @@ BOOST_AUTO_TEST_CASE(construction)
     Cmds configCmds(make<Config>("somedeviceid", "someconfig"));
     Cmds stateChangeSubscriptionCmds(make<StateChangeSubscription>("somedeviceid", 123456, Result::Ok));
     Cmds stateChangeUnsubscriptionCmds(make<StateChangeUnsubscription>("somedeviceid", 123456, Result::Ok));
-    Cmds stateChangeCmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready));
+    Cmds stateChangeCmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready, 42));
     Cmds propertiesCmds(make<Properties>("somedeviceid", 123456, 66, Result::Ok, props));
     Cmds propertiesSetCmds(make<PropertiesSet>("somedeviceid", 123456, 42, Result::Ok));
+    Cmds transitionTimingCmds(make<TransitionTiming>("somedeviceid", 123456, Transition::InitTask, 1500));
+    Cmds stateChangeBatchCmds(make<StateChangeBatch>("somedeviceid", 123456, groups));
+    Cmds directChannelCmds(make<DirectChannel>("somedeviceid", 123456, "somehost:12345", "sometoken"));
+    Cmds stateChangeAckCmds(make<StateChangeAck>("somedeviceid", 123456, 42));
 
     BOOST_TEST(checkStateCmds.At(0).GetType() == Type::check_state);
 
     BOOST_TEST(changeStateCmds.At(0).GetType() == Type::change_state);
     BOOST_TEST(static_cast<ChangeState&>(changeStateCmds.At(0)).GetTransition() == Transition::Stop);
+    BOOST_TEST(static_cast<ChangeState&>(changeStateCmds.At(0)).GetTaskIds().empty());
+    BOOST_TEST(static_cast<ChangeState&>(changeStateCmds.At(0)).IsAddressedTo(123456));
 
     BOOST_TEST(dumpConfigCmds.At(0).GetType() == Type::dump_config);
+    BOOST_TEST(static_cast<DumpConfig&>(dumpConfigCmds.At(0)).GetChunkSize() == 0);
 
     BOOST_TEST(subscribeToStateChangeCmds.At(0).GetType() == Type::subscribe_to_state_change);
     BOOST_TEST(static_cast<SubscribeToStateChange&>(subscribeToStateChangeCmds.At(0)).GetInterval() == 60000);
+    BOOST_TEST(static_cast<SubscribeToStateChange&>(subscribeToStateChangeCmds.At(0)).GetReplyWindow() == 0);
 
     BOOST_TEST(unsubscribeFromStateChangeCmds.At(0).GetType() == Type::unsubscribe_from_state_change);
 
     BOOST_TEST(getPropertiesCmds.At(0).GetType() == Type::get_properties);
     BOOST_TEST(static_cast<GetProperties&>(getPropertiesCmds.At(0)).GetRequestId() == 66);
     BOOST_TEST(static_cast<GetProperties&>(getPropertiesCmds.At(0)).GetQuery() == "k[12]");
+    BOOST_TEST(static_cast<GetProperties&>(getPropertiesCmds.At(0)).GetChunkSize() == 0);
 
     BOOST_TEST(setPropertiesCmds.At(0).GetType() == Type::set_properties);
     BOOST_TEST(static_cast<SetProperties&>(setPropertiesCmds.At(0)).GetRequestId() == 42);
@@ -74,6 +91,8 @@ BOOST_AUTO_TEST_CASE(construction)
     BOOST_TEST(configCmds.At(0).GetType() == Type::config);
     BOOST_TEST(static_cast<Config&>(configCmds.At(0)).GetDeviceId() == "somedeviceid");
     BOOST_TEST(static_cast<Config&>(configCmds.At(0)).GetConfig() == "someconfig");
+    BOOST_TEST(static_cast<Config&>(configCmds.At(0)).GetChunk() == 0);
+    BOOST_TEST(static_cast<Config&>(configCmds.At(0)).IsLastChunk() == true);
 
     BOOST_TEST(stateChangeSubscriptionCmds.At(0).GetType() == Type::state_change_subscription);
     BOOST_TEST(static_cast<StateChangeSubscription&>(stateChangeSubscriptionCmds.At(0)).GetDeviceId() == "somedeviceid");
@@ -90,6 +109,7 @@ BOOST_AUTO_TEST_CASE(construction)
     BOOST_TEST(static_cast<StateChange&>(stateChangeCmds.At(0)).GetTaskId() == 123456);
     BOOST_TEST(static_cast<StateChange&>(stateChangeCmds.At(0)).GetLastState() == State::Running);
     BOOST_TEST(static_cast<StateChange&>(stateChangeCmds.At(0)).GetCurrentState() == State::Ready);
+    BOOST_TEST(static_cast<StateChange&>(stateChangeCmds.At(0)).GetSequence() == 42);
 
     BOOST_TEST(propertiesCmds.At(0).GetType() == Type::properties);
     BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).GetDeviceId() == "somedeviceid");
@@ -97,41 +117,71 @@ BOOST_AUTO_TEST_CASE(construction)
     BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).GetRequestId() == 66);
     BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).GetResult() == Result::Ok);
     BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).GetProps() == props);
+    BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).GetChunk() == 0);
+    BOOST_TEST(static_cast<Properties&>(propertiesCmds.At(0)).IsLastChunk() == true);
 
     BOOST_TEST(propertiesSetCmds.At(0).GetType() == Type::properties_set);
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetDeviceId() == "somedeviceid");
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetTaskId() == 123456);
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetRequestId() == 42);
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetResult() == Result::Ok);
+
+    BOOST_TEST(transitionTimingCmds.At(0).GetType() == Type::transition_timing);
+    BOOST_TEST(static_cast<TransitionTiming&>(transitionTimingCmds.At(0)).GetDeviceId() == "somedeviceid");
+    BOOST_TEST(static_cast<TransitionTiming&>(transitionTimingCmds.At(0)).GetTaskId() == 123456);
+    BOOST_TEST(static_cast<TransitionTiming&>(transitionTimingCmds.At(0)).GetTransition() == Transition::InitTask);
+    BOOST_TEST(static_cast<TransitionTiming&>(transitionTimingCmds.At(0)).GetDuration() == 1500);
+
+    BOOST_TEST(stateChangeBatchCmds.At(0).GetType() == Type::state_change_batch);
+    BOOST_TEST(static_cast<StateChangeBatch&>(stateChangeBatchCmds.At(0)).GetDeviceId() == "somedeviceid");
+    BOOST_TEST(static_cast<StateChangeBatch&>(stateChangeBatchCmds.At(0)).GetTaskId() == 123456);
+    BOOST_TEST((static_cast<StateChangeBatch&>(stateChangeBatchCmds.At(0)).GetGroups() == groups));
+
+    BOOST_TEST(directChannelCmds.At(0).GetType() == Type::direct_channel);
+    BOOST_TEST(static_cast<DirectChannel&>(directChannelCmds.At(0)).GetDeviceId() == "somedeviceid");
+    BOOST_TEST(static_cast<DirectChannel&>(directChannelCmds.At(0)).GetTaskId() == 123456);
+    BOOST_TEST(static_cast<DirectChannel&>(directChannelCmds.At(0)).GetEndpoint() == "somehost:12345");
+    BOOST_TEST(static_cast<DirectChannel&>(directChannelCmds.At(0)).GetToken() == "sometoken");
+
+    BOOST_TEST(stateChangeAckCmds.At(0).GetType() == Type::state_change_ack);
+    BOOST_TEST(static_cast<StateChangeAck&>(stateChangeAckCmds.At(0)).GetDeviceId() == "somedeviceid");
+    BOOST_TEST(static_cast<StateChangeAck&>(stateChangeAckCmds.At(0)).GetTaskId() == 123456);
+    BOOST_TEST(static_cast<StateChangeAck&>(stateChangeAckCmds.At(0)).GetSequence() == 42);
 }
 
 void fillCommands(Cmds& cmds)
 {
     auto const props(std::vector<std::pair<std::string, std::string>>({ { "k1", "v1" }, { "k2", "v2" } }));
+    auto const groups(std::vector<StateChangeGroup>({ { State::InitializingTask, State::Ready, { 1, 2, 3 }, { 7, 8, 9 } }, { State::Running, State::Error, { 4 }, {} } }));
 
     cmds.Add<CheckState>();
-    cmds.Add<ChangeState>(Transition::Stop);
-    cmds.Add<DumpConfig>();
-    cmds.Add<SubscribeToStateChange>(60000);
+    cmds.Add<ChangeState>(Transition::Stop, std::vector<uint64_t>{ 1, 2, 3 });
+    cmds.Add<DumpConfig>(4096);
+    cmds.Add<SubscribeToStateChange>(60000, 250);
     cmds.Add<UnsubscribeFromStateChange>();
-    cmds.Add<GetProperties>(66, "k[12]");
+    cmds.Add<GetProperties>(66, "k[12]", 4096);
     cmds.Add<SetProperties>(42, props);
     cmds.Add<SubscriptionHeartbeat>(60000);
     cmds.Add<TransitionStatus>("somedeviceid", 123456, Result::Ok, Transition::Stop, State::Running);
-    cmds.Add<Config>("somedeviceid", "someconfig");
+    cmds.Add<Config>("somedeviceid", "someconfig", 3, false);
     cmds.Add<StateChangeSubscription>("somedeviceid", 123456, Result::Ok);
     cmds.Add<StateChangeUnsubscription>("somedeviceid", 123456, Result::Ok);
-    cmds.Add<StateChange>("somedeviceid", 123456, State::Running, State::Ready);
-    cmds.Add<Properties>("somedeviceid", 123456, 66, Result::Ok, props);
+    cmds.Add<StateChange>("somedeviceid", 123456, State::Running, State::Ready, 42);
+    cmds.Add<Properties>("somedeviceid", 123456, 66, Result::Ok, props, 2, false);
     cmds.Add<PropertiesSet>("somedeviceid", 123456, 42, Result::Ok);
+    cmds.Add<TransitionTiming>("somedeviceid", 123456, Transition::InitTask, 1500);
+    cmds.Add<StateChangeBatch>("somedeviceid", 123456, groups);
+    cmds.Add<DirectChannel>("somedeviceid", 123456, "somehost:12345", "sometoken");
+    cmds.Add<StateChangeAck>("somedeviceid", 123456, 42);
 }
 
 void checkCommands(Cmds& cmds)
 {
-    BOOST_TEST(cmds.Size() == 15);
+    BOOST_TEST(cmds.Size() == 19);
 
     int count = 0;
     auto const props(std::vector<std::pair<std::string, std::string>>({ { "k1", "v1" }, { "k2", "v2" } }));
+    auto const groups(std::vector<StateChangeGroup>({ { State::InitializingTask, State::Ready, { 1, 2, 3 }, { 7, 8, 9 } }, { State::Running, State::Error, { 4 }, {} } }));
 
     for (const auto& cmd : cmds) {
         switch (cmd->GetType()) {
@@ -141,13 +191,18 @@ void checkCommands(Cmds& cmds)
             case Type::change_state:
                 ++count;
                 BOOST_TEST(static_cast<ChangeState&>(*cmd).GetTransition() == Transition::Stop);
+                BOOST_TEST((static_cast<ChangeState&>(*cmd).GetTaskIds() == std::vector<uint64_t>{ 1, 2, 3 }));
+                BOOST_TEST(static_cast<ChangeState&>(*cmd).IsAddressedTo(2));
+                BOOST_TEST(!static_cast<ChangeState&>(*cmd).IsAddressedTo(4));
                 break;
             case Type::dump_config:
                 ++count;
+                BOOST_TEST(static_cast<DumpConfig&>(*cmd).GetChunkSize() == 4096);
                 break;
             case Type::subscribe_to_state_change:
                 ++count;
                 BOOST_TEST(static_cast<SubscribeToStateChange&>(*cmd).GetInterval() == 60000);
+                BOOST_TEST(static_cast<SubscribeToStateChange&>(*cmd).GetReplyWindow() == 250);
                 break;
             case Type::unsubscribe_from_state_change:
                 ++count;
@@ -156,6 +211,7 @@ void checkCommands(Cmds& cmds)
                 ++count;
                 BOOST_TEST(static_cast<GetProperties&>(*cmd).GetRequestId() == 66);
                 BOOST_TEST(static_cast<GetProperties&>(*cmd).GetQuery() == "k[12]");
+                BOOST_TEST(static_cast<GetProperties&>(*cmd).GetChunkSize() == 4096);
                 break;
             case Type::set_properties:
                 ++count;
@@ -178,6 +234,8 @@ void checkCommands(Cmds& cmds)
                 ++count;
                 BOOST_TEST(static_cast<Config&>(*cmd).GetDeviceId() == "somedeviceid");
                 BOOST_TEST(static_cast<Config&>(*cmd).GetConfig() == "someconfig");
+                BOOST_TEST(static_cast<Config&>(*cmd).GetChunk() == 3);
+                BOOST_TEST(static_cast<Config&>(*cmd).IsLastChunk() == false);
                 break;
             case Type::state_change_subscription:
                 ++count;
@@ -197,6 +255,7 @@ void checkCommands(Cmds& cmds)
                 BOOST_TEST(static_cast<StateChange&>(*cmd).GetTaskId() == 123456);
                 BOOST_TEST(static_cast<StateChange&>(*cmd).GetLastState() == State::Running);
                 BOOST_TEST(static_cast<StateChange&>(*cmd).GetCurrentState() == State::Ready);
+                BOOST_TEST(static_cast<StateChange&>(*cmd).GetSequence() == 42);
                 break;
             case Type::properties:
                 ++count;
@@ -205,6 +264,8 @@ void checkCommands(Cmds& cmds)
                 BOOST_TEST(static_cast<Properties&>(*cmd).GetRequestId() == 66);
                 BOOST_TEST(static_cast<Properties&>(*cmd).GetResult() == Result::Ok);
                 BOOST_TEST(static_cast<Properties&>(*cmd).GetProps() == props);
+                BOOST_TEST(static_cast<Properties&>(*cmd).GetChunk() == 2);
+                BOOST_TEST(static_cast<Properties&>(*cmd).IsLastChunk() == false);
                 break;
             case Type::properties_set:
                 ++count;
@@ -213,13 +274,39 @@ void checkCommands(Cmds& cmds)
                 BOOST_TEST(static_cast<PropertiesSet&>(*cmd).GetRequestId() == 42);
                 BOOST_TEST(static_cast<PropertiesSet&>(*cmd).GetResult() == Result::Ok);
                 break;
+            case Type::transition_timing:
+                ++count;
+                BOOST_TEST(static_cast<TransitionTiming&>(*cmd).GetDeviceId() == "somedeviceid");
+                BOOST_TEST(static_cast<TransitionTiming&>(*cmd).GetTaskId() == 123456);
+                BOOST_TEST(static_cast<TransitionTiming&>(*cmd).GetTransition() == Transition::InitTask);
+                BOOST_TEST(static_cast<TransitionTiming&>(*cmd).GetDuration() == 1500);
+                break;
+            case Type::state_change_batch:
+                ++count;
+                BOOST_TEST(static_cast<StateChangeBatch&>(*cmd).GetDeviceId() == "somedeviceid");
+                BOOST_TEST(static_cast<StateChangeBatch&>(*cmd).GetTaskId() == 123456);
+                BOOST_TEST((static_cast<StateChangeBatch&>(*cmd).GetGroups() == groups));
+                break;
+            case Type::direct_channel:
+                ++count;
+                BOOST_TEST(static_cast<DirectChannel&>(*cmd).GetDeviceId() == "somedeviceid");
+                BOOST_TEST(static_cast<DirectChannel&>(*cmd).GetTaskId() == 123456);
+                BOOST_TEST(static_cast<DirectChannel&>(*cmd).GetEndpoint() == "somehost:12345");
+                BOOST_TEST(static_cast<DirectChannel&>(*cmd).GetToken() == "sometoken");
+                break;
+            case Type::state_change_ack:
+                ++count;
+                BOOST_TEST(static_cast<StateChangeAck&>(*cmd).GetDeviceId() == "somedeviceid");
+                BOOST_TEST(static_cast<StateChangeAck&>(*cmd).GetTaskId() == 123456);
+                BOOST_TEST(static_cast<StateChangeAck&>(*cmd).GetSequence() == 42);
+                break;
             default:
                 BOOST_TEST(false);
                 break;
         }
     }
 
-    BOOST_TEST(count == 15);
+    BOOST_TEST(count == 19);
 }
 
 BOOST_AUTO_TEST_CASE(serialization)
@@ -233,6 +320,292 @@ BOOST_AUTO_TEST_CASE(serialization)
     checkCommands(inCmds);
 }
 
+BOOST_AUTO_TEST_CASE(malformed)
+{
+    std::string buffer(Cmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready, 42)).Serialize());
+
+    Cmds inCmds;
+    BOOST_CHECK_THROW(inCmds.Deserialize(buffer.substr(0, buffer.size() / 2)), Cmds::CommandFormatError);
+    BOOST_CHECK_THROW(inCmds.Deserialize(std::string(64, '\xff')), Cmds::CommandFormatError);
+    BOOST_CHECK_THROW(inCmds.Deserialize(""), Cmds::CommandFormatError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(direct_channel)
+
+// Stand-in controller endpoint and a device connecting to it, measures ChangeState -> StateChange round trips
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    using namespace std::chrono;
+    constexpr int numRoundTrips = 1000;
+    constexpr uint64_t taskId = 123456;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::shared_ptr<DirectChannelConnection> controllerSide;
+    uint64_t helloTaskId = 0;
+    int numReplies = 0;
+
+    DirectChannelServer server("127.0.0.1");
+    server.Start([&](std::shared_ptr<DirectChannelConnection> connection) {
+        connection->Start(
+            [&, connection](const std::string& frame) {
+                Cmds inCmds;
+                inCmds.Deserialize(frame);
+                std::lock_guard<std::mutex> lk(mtx);
+                if (inCmds.At(0).GetType() == Type::direct_channel) {
+                    helloTaskId = static_cast<DirectChannel&>(inCmds.At(0)).GetTaskId();
+                    controllerSide = connection;
+                } else if (inCmds.At(0).GetType() == Type::state_change) {
+                    ++numReplies;
+                }
+                cv.notify_one();
+            },
+            []() {});
+    });
+
+    boost::asio::io_context deviceContext;
+    auto work = boost::asio::make_work_guard(deviceContext);
+    std::thread deviceThread([&]() { deviceContext.run(); });
+    std::shared_ptr<DirectChannelConnection> deviceSide;
+
+    AsyncConnectDirectChannel(deviceContext, server.GetEndpoint(), [&](const boost::system::error_code& ec, std::shared_ptr<DirectChannelConnection> connection) {
+        if (ec) {
+            // reported by the timeout on the controller side
+            return;
+        }
+        connection->Start(
+            [connection](const std::string& frame) {
+                Cmds inCmds;
+                inCmds.Deserialize(frame);
+                auto transition = static_cast<ChangeState&>(inCmds.At(0)).GetTransition();
+                connection->Send(Cmds(make<StateChange>("somedeviceid", taskId, State::Ready, transition == Transition::Run ? State::Running : State::Ready)).Serialize());
+            },
+            []() {});
+        connection->Send(Cmds(make<DirectChannel>("somedeviceid", taskId, "")).Serialize());
+        std::lock_guard<std::mutex> lk(mtx);
+        deviceSide = connection;
+    });
+
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        BOOST_REQUIRE(cv.wait_for(lk, seconds(10), [&]() { return controllerSide != nullptr; }));
+    }
+    BOOST_TEST(helloTaskId == taskId);
+
+    auto maxRoundTrip = nanoseconds::zero();
+    auto start = steady_clock::now();
+    for (int i = 0; i < numRoundTrips; ++i) {
+        auto sent = steady_clock::now();
+        controllerSide->Send(Cmds(make<ChangeState>(i % 2 == 0 ? Transition::Run : Transition::Stop)).Serialize());
+        std::unique_lock<std::mutex> lk(mtx);
+        BOOST_REQUIRE(cv.wait_for(lk, seconds(10), [&]() { return numReplies == i + 1; }));
+        maxRoundTrip = std::max(maxRoundTrip, duration_cast<nanoseconds>(steady_clock::now() - sent));
+    }
+    auto total = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    BOOST_TEST_MESSAGE("direct channel round trip (Start/Stop): mean " << (total.count() / numRoundTrips) / 1000.0 << " us, max " << maxRoundTrip.count() / 1000.0 << " us");
+
+    controllerSide->Close();
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        controllerSide.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        deviceSide->Close();
+    }
+    work.reset();
+    deviceThread.join();
+    server.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(frame_size_limit)
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    int numFrames = 0;
+    bool closed = false;
+
+    DirectChannelServer server("127.0.0.1");
+    server.Start([&](std::shared_ptr<DirectChannelConnection> connection) {
+        connection->SetFrameSizeLimit(DirectChannelConnection::fMaxHelloFrameSize);
+        connection->Start(
+            [&](const std::string&) {
+                std::lock_guard<std::mutex> lk(mtx);
+                ++numFrames;
+                cv.notify_one();
+            },
+            [&]() {
+                std::lock_guard<std::mutex> lk(mtx);
+                closed = true;
+                cv.notify_one();
+            });
+    });
+
+    boost::asio::io_context deviceContext;
+    auto work = boost::asio::make_work_guard(deviceContext);
+    std::thread deviceThread([&]() { deviceContext.run(); });
+    std::shared_ptr<DirectChannelConnection> deviceSide;
+
+    AsyncConnectDirectChannel(deviceContext, server.GetEndpoint(), [&](const boost::system::error_code& ec, std::shared_ptr<DirectChannelConnection> connection) {
+        if (ec) {
+            return;
+        }
+        connection->Start([](const std::string&) {}, []() {});
+        connection->Send(std::string(DirectChannelConnection::fMaxHelloFrameSize, 'a'));
+        connection->Send(std::string(DirectChannelConnection::fMaxHelloFrameSize + 1, 'b'));
+        std::lock_guard<std::mutex> lk(mtx);
+        deviceSide = connection;
+    });
+
+    {
+        // the frame within the limit is received, the larger one closes the connection
+        std::unique_lock<std::mutex> lk(mtx);
+        BOOST_REQUIRE(cv.wait_for(lk, std::chrono::seconds(10), [&]() { return closed; }));
+        BOOST_TEST(numFrames == 1);
+        deviceSide->Close();
+    }
+    work.reset();
+    deviceThread.join();
+    server.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(token)
+{
+    BOOST_TEST(DirectChannelTokenMatches("0a1b2c3d", "0a1b2c3d"));
+    BOOST_TEST(!DirectChannelTokenMatches("0a1b2c3e", "0a1b2c3d"));
+    BOOST_TEST(!DirectChannelTokenMatches("0a1b2c3", "0a1b2c3d"));
+    BOOST_TEST(!DirectChannelTokenMatches("", "0a1b2c3d"));
+    // no token configured, nothing matches
+    BOOST_TEST(!DirectChannelTokenMatches("", ""));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(state_aggregation)
+
+BOOST_AUTO_TEST_CASE(aggregation)
+{
+    StateChangeAggregation aggregation;
+    BOOST_TEST(aggregation.Empty());
+
+    BOOST_TEST(aggregation.Add(StateChange("device1", 1, State::Idle, State::InitializingDevice, 1)));
+    BOOST_TEST(aggregation.Add(StateChange("device1", 1, State::InitializingDevice, State::Initialized, 2)));
+    // outdated, arrived out of order
+    BOOST_TEST(!aggregation.Add(StateChange("device1", 1, State::Idle, State::InitializingDevice, 1)));
+    // unknown sequence is always collected
+    BOOST_TEST(aggregation.Add(StateChange("device2", 2, State::Idle, State::InitializingDevice, 0)));
+    BOOST_TEST(aggregation.Add(StateChange("device2", 2, State::Idle, State::InitializingDevice, 0)));
+    BOOST_TEST(!aggregation.Empty());
+
+    aggregation.Add(TransitionTiming("device1", 1, Transition::InitDevice, 1500));
+    BOOST_TEST(!aggregation.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(summary)
+{
+    StateChangeAggregation aggregation;
+    BOOST_TEST(aggregation.Take("aggregator", 100).Size() == 0);
+
+    aggregation.Add(StateChange("device1", 1, State::Idle, State::InitializingDevice, 1));
+    aggregation.Add(StateChange("device1", 1, State::InitializingDevice, State::Initialized, 2));
+    aggregation.Add(StateChange("device2", 2, State::Idle, State::InitializingDevice, 5));
+    aggregation.Add(TransitionTiming("device1", 1, Transition::InitDevice, 1500));
+
+    Cmds cmds(aggregation.Take("aggregator", 100));
+    BOOST_TEST(aggregation.Empty());
+    BOOST_REQUIRE(cmds.Size() == 2);
+
+    // timings first
+    BOOST_REQUIRE(cmds.At(0).GetType() == Type::transition_timing);
+    BOOST_TEST(static_cast<TransitionTiming&>(cmds.At(0)).GetTaskId() == 1);
+    BOOST_TEST(static_cast<TransitionTiming&>(cmds.At(0)).GetDuration() == 1500);
+
+    BOOST_REQUIRE(cmds.At(1).GetType() == Type::state_change_batch);
+    const auto& batch = static_cast<StateChangeBatch&>(cmds.At(1));
+    BOOST_TEST(batch.GetDeviceId() == "aggregator");
+    BOOST_TEST(batch.GetTaskId() == 100);
+    std::vector<StateChangeGroup> expected{
+        { State::Idle, State::InitializingDevice, { 1, 2 }, { 1, 5 } },
+        { State::InitializingDevice, State::Initialized, { 1 }, { 2 } },
+    };
+    BOOST_TEST((batch.GetGroups() == expected));
+
+    // the summary survives the serialization
+    Cmds deserialized;
+    deserialized.Deserialize(cmds.Serialize());
+    BOOST_REQUIRE(deserialized.Size() == 2);
+    BOOST_TEST((static_cast<StateChangeBatch&>(deserialized.At(1)).GetGroups() == expected));
+
+    // the next interval starts empty, the controller discards changes older than the ones it applied
+    BOOST_TEST(aggregation.Add(StateChange("device1", 1, State::Idle, State::InitializingDevice, 1)));
+    Cmds next(aggregation.Take("aggregator", 100));
+    BOOST_REQUIRE(next.Size() == 1);
+    BOOST_TEST(static_cast<StateChangeBatch&>(next.At(0)).GetGroups().size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ack)
+{
+    const auto start = AggregatorAcks::Clock::now();
+    AggregatorAcks acks(std::chrono::milliseconds(100));
+    BOOST_TEST(acks.IsResponsive());
+    BOOST_TEST(acks.GetAggregatorTaskId() == 0);
+    BOOST_TEST(!acks.NextExpiry().has_value());
+
+    BOOST_TEST(acks.Sent(1, "change1", start));
+    BOOST_TEST(acks.Sent(2, "change2", start + std::chrono::milliseconds(10)));
+    BOOST_TEST(acks.Sent(3, "change3", start + std::chrono::milliseconds(20)));
+    BOOST_TEST(acks.NumUnacknowledged() == 3);
+    BOOST_TEST((acks.NextExpiry() == start + std::chrono::milliseconds(100)));
+
+    // an acknowledgement covers all changes up to its sequence and tells the task ID of the aggregator
+    BOOST_TEST(!acks.Acknowledged(2, 100));
+    BOOST_TEST(acks.GetAggregatorTaskId() == 100);
+    BOOST_TEST(acks.NumUnacknowledged() == 1);
+    BOOST_TEST((acks.NextExpiry() == start + std::chrono::milliseconds(120)));
+
+    // the task ID is learned once
+    BOOST_TEST(!acks.Acknowledged(3, 200));
+    BOOST_TEST(acks.GetAggregatorTaskId() == 100);
+    BOOST_TEST(acks.NumUnacknowledged() == 0);
+    BOOST_TEST(!acks.NextExpiry().has_value());
+    BOOST_TEST(acks.TakeExpired(start + std::chrono::seconds(10)).empty());
+    BOOST_TEST(acks.IsResponsive());
+}
+
+BOOST_AUTO_TEST_CASE(ack_timeout)
+{
+    const auto start = AggregatorAcks::Clock::now();
+    // --aggregator-ack-timeout
+    AggregatorAcks acks;
+    BOOST_TEST(acks.GetTimeout().count() == 1000);
+    acks.SetTimeout(std::chrono::milliseconds(100));
+
+    acks.Sent(1, "change1", start);
+    acks.Sent(2, "change2", start + std::chrono::milliseconds(50));
+    BOOST_TEST(acks.TakeExpired(start + std::chrono::milliseconds(99)).empty());
+    BOOST_TEST(acks.IsResponsive());
+
+    // the oldest change expired, all unacknowledged ones are reported directly
+    std::vector<std::string> expired(acks.TakeExpired(start + std::chrono::milliseconds(100)));
+    BOOST_TEST((expired == std::vector<std::string>{ "change1", "change2" }));
+    BOOST_TEST(!acks.IsResponsive());
+    BOOST_TEST(acks.NumUnacknowledged() == 0);
+
+    // while unresponsive the changes are not tracked, the caller reports them directly
+    BOOST_TEST(!acks.Sent(3, "change3", start + std::chrono::milliseconds(200)));
+    BOOST_TEST(acks.NumUnacknowledged() == 0);
+    BOOST_TEST(!acks.NextExpiry().has_value());
+
+    // the next acknowledgement restores reporting via the aggregator
+    BOOST_TEST(acks.Acknowledged(3, 100));
+    BOOST_TEST(acks.IsResponsive());
+    BOOST_TEST(acks.Sent(4, "change4", start + std::chrono::milliseconds(300)));
+    BOOST_TEST(acks.NumUnacknowledged() == 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 int main(int argc, char* argv[]) { return boost::unit_test::unit_test_main(init_unit_test, argc, argv); }
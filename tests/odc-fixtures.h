@@ -22,12 +22,14 @@
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test_log.hpp>
 
+#include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 struct AsyncOpFixture
 {
@@ -36,8 +38,10 @@ struct AsyncOpFixture
 
 struct TopologyFixture
 {
-    TopologyFixture(std::string topoXMLPath)
-        : mDDSTopo(std::move(topoXMLPath))
+    /// @param slots number of slots to submit, a topology update can use the slots left over by the activated topology
+    TopologyFixture(std::string topoXMLPath, std::size_t slots = 6)
+        : mSlots(slots)
+        , mDDSTopo(std::move(topoXMLPath))
     {
         using namespace dds::tools_api;
         using namespace odc::core;
@@ -80,16 +84,26 @@ struct TopologyFixture
             idleSlotsCount = res.m_idleSlotsCount;
         }
 
+        Activate(mDDSTopo, STopologyRequestData::EUpdateType::ACTIVATE);
+    }
+
+    /// Activate the given topology in the session, wait until its tasks are executing
+    void Activate(dds::topology_api::CTopology& topo, dds::tools_api::STopologyRequestData::EUpdateType updateType)
+    {
+        using namespace dds::tools_api;
+
         STopologyRequestData topologyInfo;
-        topologyInfo.m_updateType = STopologyRequestData::EUpdateType::ACTIVATE;
-        topologyInfo.m_topologyFile = mDDSTopo.getFilepath();
+        topologyInfo.m_updateType = updateType;
+        topologyInfo.m_topologyFile = topo.getFilepath();
 
         auto topologyRequest = STopologyRequest::makeRequest(topologyInfo);
         topologyRequest->setMessageCallback([](const SMessageResponseData& message) { BOOST_TEST_MESSAGE(message.m_msg); });
 
+        mSession.layoutTasks(topo);
         std::mutex mtx;
-        // fill the task/collection details
-        topologyRequest->setResponseCallback([this, &mtx](const dds::tools_api::STopologyResponseData& res) {
+        std::vector<STopologyResponseData> activated;
+        // collect the task/collection details
+        topologyRequest->setResponseCallback([&mtx, &activated](const dds::tools_api::STopologyResponseData& res) {
             std::cout << "DDS Activate Response: "
                 << "agentID: " << res.m_agentID
                 << "; slotID: " << res.m_slotID
@@ -103,31 +117,23 @@ struct TopologyFixture
 
             // We are not interested in stopped tasks
             if (res.m_activated) {
-                // response callbacks can be called in parallel - protect session access with a lock
+                // response callbacks can be called in parallel
                 std::lock_guard<std::mutex> lock(mtx);
-                mSession.mTaskDetails.emplace(res.m_taskID, TaskDetails{res.m_agentID, res.m_slotID, res.m_taskID, res.m_collectionID, res.m_path, res.m_host, res.m_wrkDir});
-
-                if (res.m_collectionID > 0) {
-                    if (mSession.mCollectionDetails.find(res.m_collectionID) == mSession.mCollectionDetails.end()) {
-                        std::string path = res.m_path;
-                        auto pos = path.rfind('/');
-                        if (pos != std::string::npos) {
-                            path.erase(pos);
-                        }
-                        mSession.mCollectionDetails.emplace(res.m_collectionID, CollectionDetails{res.m_agentID, res.m_collectionID, path, res.m_host, res.m_wrkDir});
-                        mSession.mRuntimeCollectionIndex.at(res.m_collectionID)->mRuntimeCollectionAgents[res.m_collectionID] = res.m_agentID;
-                    }
-                }
+                activated.push_back(res);
             }
         });
 
+        SharedSemaphore blocker;
         topologyRequest->setDoneCallback([blocker]() mutable { blocker.Signal(); });
         mSession.mDDSSession.sendRequest<STopologyRequest>(topologyRequest);
         blocker.Wait();
+        mSession.applyActivationResponses(topo, activated);
 
+        auto itPair = topo.getRuntimeTaskIterator(nullptr);
+        const std::size_t numTasks = std::distance(itPair.first, itPair.second);
         std::size_t execSlotsCount(0);
-        interval = 8;
-        while (execSlotsCount < mSlots) {
+        int interval(8);
+        while (execSlotsCount != numTasks) {
             std::this_thread::sleep_for(std::chrono::milliseconds(interval));
             interval = std::min(256, interval * 2);
             SAgentCountRequest::response_t res;
@@ -143,7 +149,7 @@ struct TopologyFixture
         }
     }
 
-    static constexpr int mSlots = 6;
+    const std::size_t mSlots;
     odc::core::Session mSession;
     dds::topology_api::CTopology mDDSTopo;
     boost::asio::io_context mIoContext;
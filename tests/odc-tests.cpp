@@ -8,13 +8,28 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include "odc-fixtures.h"
+#include <odc/AgentInventory.h>
 #include <odc/AsioAsyncOp.h>
 #include <odc/AsioBase.h>
+#include <odc/BatchQueue.h>
+#include <odc/Controller.h>
+#include <odc/SessionPool.h>
+#include <odc/StringTable.h>
+#include <odc/TopoScriptCache.h>
 #include <odc/Topology.h>
+#include <odc/TopologyStore.h>
+#include <odc/TransitionHistory.h>
 
 #include <array>
+#include <condition_variable>
+#include <cstdlib>
 #include <boost/asio.hpp>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
 
 using namespace boost::unit_test;
 using namespace odc::core;
@@ -101,6 +116,97 @@ BOOST_AUTO_TEST_CASE(timeout2)
 
 BOOST_AUTO_TEST_SUITE_END() // async_op
 
+BOOST_AUTO_TEST_SUITE(controller)
+
+BOOST_AUTO_TEST_CASE(status)
+{
+    Controller controller;
+    controller.setExecThreads(2);
+
+    auto future = controller.asyncExecStatus(StatusParams(false), boost::asio::use_future);
+    BOOST_CHECK(future.get().mPartitions.empty());
+
+    // completion handlers run on their associated executor
+    boost::asio::io_context ioContext;
+    size_t completed = 0;
+    const size_t numRequests = 100;
+    for (size_t i = 0; i < numRequests; ++i) {
+        controller.asyncExecStatus(StatusParams(true), boost::asio::bind_executor(ioContext, [&completed](StatusRequestResult result) {
+            BOOST_CHECK(result.mPartitions.empty());
+            ++completed;
+        }));
+    }
+    ioContext.run();
+    BOOST_CHECK_EQUAL(completed, numRequests);
+}
+
+BOOST_AUTO_TEST_CASE(device_requests)
+{
+    Controller controller;
+    controller.setExecThreads(1);
+
+    // requests of a partition complete in the order of their initiation
+    const CommonParams common("controller_device_requests", 0, 10);
+    std::vector<std::string> completed;
+    std::mutex mtx;
+    auto record = [&](RequestResult result) {
+        // the partition has no topology
+        BOOST_CHECK_EQUAL(result.mError.mCode, MakeErrorCode(ErrorCode::FairMQChangeStateFailed));
+        std::lock_guard<std::mutex> lk(mtx);
+        completed.push_back(result.mMsg);
+    };
+    controller.asyncExecConfigure(common, DeviceParams(), record);
+    controller.asyncExecStart(common, DeviceParams(), record);
+    controller.asyncExecStop(common, DeviceParams(), record);
+    // the synchronous request waits for the asynchronous one, queued after the others
+    RequestResult result = controller.execTerminate(common, DeviceParams());
+    BOOST_CHECK_EQUAL(result.mError.mCode, MakeErrorCode(ErrorCode::FairMQChangeStateFailed));
+
+    std::lock_guard<std::mutex> lk(mtx);
+    BOOST_CHECK_EQUAL(completed.size(), 3);
+    BOOST_CHECK_EQUAL(completed.at(0), "Configure done");
+    BOOST_CHECK_EQUAL(completed.at(1), "Start done");
+    BOOST_CHECK_EQUAL(completed.at(2), "Stop done");
+}
+
+BOOST_AUTO_TEST_CASE(session_requests)
+{
+    Controller controller;
+    controller.setExecThreads(1);
+
+    // the session requests of a partition are queued with its device requests, the synchronous ones included
+    const CommonParams common("controller_session_requests", 0, 10);
+    std::vector<RequestResult> completed;
+    std::mutex mtx;
+    auto record = [&](RequestResult result) {
+        std::lock_guard<std::mutex> lk(mtx);
+        completed.push_back(std::move(result));
+    };
+    controller.asyncExecConfigure(common, DeviceParams(), record);
+    // no DDS session
+    controller.asyncExecSubmit(common, SubmitParams("localhost", ""), record);
+    controller.asyncExecGetState(common, DeviceParams(), record);
+    // no topology given
+    controller.asyncExecUpdate(common, UpdateParams(), record);
+    RequestResult result = controller.execActivate(common, ActivateParams());
+    BOOST_CHECK_EQUAL(result.mMsg, "Activate done");
+    BOOST_CHECK_EQUAL(result.mError.mCode, MakeErrorCode(ErrorCode::TopologyFailed));
+
+    std::lock_guard<std::mutex> lk(mtx);
+    BOOST_REQUIRE_EQUAL(completed.size(), 4);
+    BOOST_CHECK_EQUAL(completed.at(0).mMsg, "Configure done");
+    BOOST_CHECK_EQUAL(completed.at(0).mError.mCode, MakeErrorCode(ErrorCode::FairMQChangeStateFailed));
+    BOOST_CHECK_EQUAL(completed.at(1).mMsg, "Submit done");
+    BOOST_CHECK_EQUAL(completed.at(1).mError.mCode, MakeErrorCode(ErrorCode::DDSSubmitAgentsFailed));
+    BOOST_CHECK_EQUAL(completed.at(2).mMsg, "GetState done");
+    BOOST_CHECK(!completed.at(2).mError.mCode);
+    BOOST_CHECK_EQUAL(completed.at(2).mTopologyState.aggregated, AggregatedState::Undefined);
+    BOOST_CHECK_EQUAL(completed.at(3).mMsg, "Update done");
+    BOOST_CHECK_EQUAL(completed.at(3).mError.mCode, MakeErrorCode(ErrorCode::TopologyFailed));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // controller
+
 template<typename Functor>
 void full_device_lifecycle(Functor&& functor)
 {
@@ -118,6 +224,12 @@ void full_device_lifecycle(Functor&& functor)
     }
 }
 
+// fixture topologies are installed next to the one given with --topo-file
+std::string siblingTopoFile(const std::string& topoFile, const std::string& name)
+{
+    return (std::filesystem::path(topoFile).parent_path() / name).string();
+}
+
 BOOST_AUTO_TEST_SUITE(topology)
 
 BOOST_AUTO_TEST_CASE(construction)
@@ -383,6 +495,198 @@ BOOST_AUTO_TEST_CASE(change_state_full_device_lifecycle2)
     }
 }
 
+BOOST_AUTO_TEST_CASE(change_state_pipelined)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    const std::vector<TopoTransition> configure{ TopoTransition::InitDevice, TopoTransition::CompleteInit, TopoTransition::Bind, TopoTransition::Connect, TopoTransition::InitTask };
+    const std::vector<TopoTransition> reset{ TopoTransition::ResetTask, TopoTransition::ResetDevice };
+    for (int i(0); i < 3; ++i) {
+        auto [ec1, state1, timings1] = topo.ChangeStateSequence(configure);
+        BOOST_REQUIRE_EQUAL(ec1, std::error_code());
+        BOOST_REQUIRE(topo.StateEqualsTo(DeviceState::Ready));
+        BOOST_REQUIRE_EQUAL(timings1.size(), configure.size());
+        for (size_t j(1); j < timings1.size(); ++j) {
+            BOOST_CHECK(timings1.at(j - 1).second <= timings1.at(j).second);
+        }
+        BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Run).first, std::error_code());
+        BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Stop).first, std::error_code());
+        auto [ec2, state2, timings2] = topo.ChangeStateSequence(reset);
+        BOOST_REQUIRE_EQUAL(ec2, std::error_code());
+        BOOST_REQUIRE(topo.StateEqualsTo(DeviceState::Idle));
+        BOOST_REQUIRE_EQUAL(timings2.size(), reset.size());
+    }
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::End).first, std::error_code());
+}
+
+BOOST_AUTO_TEST_CASE(apply_update_unchanged)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    dds::topology_api::CTopology updated(framework::master_test_suite().argv[2]);
+    const TopologyDiff diff = Topology::Diff(f.mDDSTopo, updated);
+    BOOST_REQUIRE(diff.removed.empty());
+    BOOST_REQUIRE(diff.added.empty());
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    const std::vector<TopoTransition> configure{ TopoTransition::InitDevice, TopoTransition::CompleteInit, TopoTransition::Bind, TopoTransition::Connect, TopoTransition::InitTask };
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence(configure)), std::error_code());
+    BOOST_REQUIRE_EQUAL(diff.unchanged, topo.GetCurrentState().size());
+
+    // unchanged devices keep their state and stay controllable
+    topo.ApplyUpdate(updated, diff);
+    BOOST_REQUIRE(topo.StateEqualsTo(DeviceState::Ready));
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Run).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Stop).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence({ TopoTransition::ResetTask, TopoTransition::ResetDevice })), std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::End).first, std::error_code());
+}
+
+BOOST_AUTO_TEST_CASE(apply_update_added_and_removed)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    // leave slots for the collection added by the update
+    TopologyFixture f(framework::master_test_suite().argv[2], 8);
+
+    dds::topology_api::CTopology updated(siblingTopoFile(framework::master_test_suite().argv[2], "odc-tests-topo-update.xml"));
+    const TopologyDiff diff = Topology::Diff(f.mDDSTopo, updated);
+    BOOST_REQUIRE(diff.removed.empty());
+    BOOST_REQUIRE_EQUAL(diff.added.size(), 2);
+    BOOST_REQUIRE_EQUAL(diff.unchanged, 6);
+
+    Topology topo(f.mDDSTopo, f.mSession, true);
+    const std::vector<TopoTransition> configure{ TopoTransition::InitDevice, TopoTransition::CompleteInit, TopoTransition::Bind, TopoTransition::Connect, TopoTransition::InitTask };
+    const std::vector<TopoTransition> reset{ TopoTransition::ResetTask, TopoTransition::ResetDevice };
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence(configure)), std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.GetNumStateChangePublishers(), 6);
+
+    auto waitForPublishers = [&topo](size_t number) {
+        for (int i = 0; i < 100 && topo.GetNumStateChangePublishers() != number; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return topo.GetNumStateChangePublishers();
+    };
+
+    // added devices are subscribed to and configured, unchanged devices keep their state
+    f.Activate(updated, dds::tools_api::STopologyRequestData::EUpdateType::UPDATE);
+    topo.ApplyUpdate(updated, diff);
+    BOOST_REQUIRE_EQUAL(topo.GetCurrentState().size(), 8);
+    BOOST_REQUIRE_EQUAL(topo.WaitForState(DeviceState::Undefined, DeviceState::Idle, diff.added).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(waitForPublishers(8), 8);
+    for (const auto& device : topo.GetCurrentState()) {
+        BOOST_CHECK_EQUAL(device.state, diff.added.count(device.taskId) > 0 ? DeviceState::Idle : DeviceState::Ready);
+    }
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence(configure, diff.added)), std::error_code());
+    BOOST_REQUIRE(topo.StateEqualsTo(DeviceState::Ready));
+
+    // removed devices are dropped from the state tracking
+    const TopologyDiff back = Topology::Diff(updated, f.mDDSTopo);
+    BOOST_REQUIRE(back.removed == diff.added);
+    BOOST_REQUIRE(back.added.empty());
+    BOOST_REQUIRE_EQUAL(back.unchanged, 6);
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence(reset, back.removed)), std::error_code());
+    f.Activate(f.mDDSTopo, dds::tools_api::STopologyRequestData::EUpdateType::UPDATE);
+    topo.ApplyUpdate(f.mDDSTopo, back);
+    const TopoState state = topo.GetCurrentState();
+    BOOST_REQUIRE_EQUAL(state.size(), 6);
+    for (const auto& device : state) {
+        BOOST_CHECK_EQUAL(back.removed.count(device.taskId), 0);
+    }
+    BOOST_REQUIRE_EQUAL(topo.GetNumStateChangePublishers(), 6);
+    BOOST_REQUIRE(topo.StateEqualsTo(DeviceState::Ready));
+
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Run).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Stop).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(std::get<0>(topo.ChangeStateSequence(reset)), std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::End).first, std::error_code());
+}
+
+BOOST_AUTO_TEST_CASE(apply_update_modified_task)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    dds::topology_api::CTopology current(framework::master_test_suite().argv[2]);
+    dds::topology_api::CTopology modified(siblingTopoFile(framework::master_test_suite().argv[2], "odc-tests-topo-modified.xml"));
+
+    // the Sink runs with a different command line
+    const TopologyDiff diff = Topology::Diff(current, modified);
+    BOOST_REQUIRE_EQUAL(diff.removed.size(), 1);
+    BOOST_REQUIRE_EQUAL(diff.added.size(), 1);
+    BOOST_REQUIRE_EQUAL(diff.unchanged, 5);
+    BOOST_CHECK_EQUAL(current.getRuntimeTaskById(*diff.removed.begin()).m_taskPath, modified.getRuntimeTaskById(*diff.added.begin()).m_taskPath);
+    BOOST_CHECK_NE(*diff.removed.begin(), *diff.added.begin());
+}
+
+BOOST_AUTO_TEST_CASE(apply_update_pending_ops)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    dds::topology_api::CTopology updated(framework::master_test_suite().argv[2]);
+    const TopologyDiff diff = Topology::Diff(f.mDDSTopo, updated);
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    std::promise<std::error_code> waited;
+    topo.AsyncWaitForState(DeviceState::Undefined, DeviceState::Running, "", std::chrono::milliseconds(500), [&waited](std::error_code ec, FailedDevices) {
+        waited.set_value(ec);
+    });
+    BOOST_CHECK_THROW(topo.ApplyUpdate(updated, diff), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(waited.get_future().get(), MakeErrorCode(ErrorCode::OperationTimeout));
+
+    topo.ApplyUpdate(updated, diff);
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::End).first, std::error_code());
+}
+
+BOOST_AUTO_TEST_CASE(start_stop_round_trip_latency)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    constexpr int numCycles = 10;
+    auto runStopCycles = [&](Topology& topo) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numCycles; ++i) {
+            BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Run).first, std::error_code());
+            BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::Stop).first, std::error_code());
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) / (2 * numCycles);
+    };
+
+    std::chrono::microseconds viaDDS;
+    {
+        Topology topo(f.mDDSTopo, f.mSession, true);
+        for (auto transition : { TopoTransition::InitDevice, TopoTransition::CompleteInit, TopoTransition::Bind, TopoTransition::Connect, TopoTransition::InitTask }) {
+            BOOST_REQUIRE_EQUAL(topo.ChangeState(transition).first, std::error_code());
+        }
+        viaDDS = runStopCycles(topo);
+    }
+
+    std::chrono::microseconds direct;
+    {
+        Topology topo(f.mDDSTopo, f.mSession, true);
+        topo.EnableDirectChannel("localhost");
+        const size_t numDevices = topo.GetCurrentState().size();
+        for (int i = 0; i < 100 && topo.GetNumDirectConnections() < numDevices; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        BOOST_REQUIRE_EQUAL(topo.GetNumDirectConnections(), numDevices);
+        direct = runStopCycles(topo);
+        for (auto transition : { TopoTransition::ResetTask, TopoTransition::ResetDevice, TopoTransition::End }) {
+            BOOST_REQUIRE_EQUAL(topo.ChangeState(transition).first, std::error_code());
+        }
+    }
+
+    BOOST_TEST_MESSAGE("Run/Stop round trip, mean over " << numCycles << " cycles: via DDS " << viaDDS.count() << " us, via direct channel " << direct.count() << " us");
+}
+
 BOOST_AUTO_TEST_CASE(set_properties)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -510,6 +814,33 @@ BOOST_AUTO_TEST_CASE(get_properties)
     BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::ResetDevice).first, std::error_code());
 }
 
+BOOST_AUTO_TEST_CASE(get_properties_chunked)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::InitDevice).first, std::error_code());
+
+    auto const all = topo.GetProperties(".*");
+    BOOST_REQUIRE_EQUAL(all.first, std::error_code());
+
+    // every property in its own chunk, the assembled result must be the same
+    topo.SetPropertiesChunkSize(1);
+    auto const chunked = topo.GetProperties(".*");
+    BOOST_REQUIRE_EQUAL(chunked.first, std::error_code());
+    BOOST_REQUIRE_EQUAL(chunked.second.failed.size(), 0);
+    BOOST_REQUIRE_EQUAL(chunked.second.devices.size(), all.second.devices.size());
+    for (auto const& d : chunked.second.devices) {
+        BOOST_REQUIRE(all.second.devices.at(d.first).props.size() > 1);
+        BOOST_REQUIRE_EQUAL(d.second.props.size(), all.second.devices.at(d.first).props.size());
+    }
+
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::CompleteInit).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopoTransition::ResetDevice).first, std::error_code());
+}
+
 BOOST_AUTO_TEST_CASE(set_and_get_properties)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -617,6 +948,43 @@ BOOST_AUTO_TEST_CASE(device_crashed)
     BOOST_TEST_CHECKPOINT("Topology destructed.");
 }
 
+BOOST_AUTO_TEST_CASE(fail_fast)
+{
+    using namespace std::chrono_literals;
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    topo.SetFailFast(true);
+    BOOST_CHECK_EQUAL(topo.ChangeState(TopoTransition::InitDevice).first, std::error_code());
+    BOOST_CHECK_EQUAL(topo.ChangeState(TopoTransition::CompleteInit).first, std::error_code());
+
+    // wait for a state that is never reached, only the first operation involves the processors
+    std::promise<std::error_code> processors;
+    std::promise<std::error_code> sink;
+    topo.AsyncWaitForState(DeviceState::Undefined, DeviceState::Running, ".*/Processor.*", 60s, [&](std::error_code ec, FailedDevices) { processors.set_value(ec); });
+    topo.AsyncWaitForState(DeviceState::Undefined, DeviceState::Running, ".*/Sink.*", 5s, [&](std::error_code ec, FailedDevices) { sink.set_value(ec); });
+    try {
+        topo.SetProperties({ { "crash", "yes" } }, ".*/Processor.*", 10ms);
+    } catch (std::system_error const& e) {
+        BOOST_TEST_MESSAGE("system_error >> code: " << e.code() << ", what: " << e.what());
+    }
+
+    // the operation involving the crashed processors completes right away, not after its timeout
+    auto processorsResult = processors.get_future();
+    BOOST_REQUIRE(processorsResult.wait_for(30s) == std::future_status::ready);
+    BOOST_CHECK_EQUAL(processorsResult.get(), MakeErrorCode(ErrorCode::TargetStateUnreachable));
+    BOOST_CHECK(!topo.GetUnignorableFailures().empty());
+
+    // the operation on the sink is not affected
+    BOOST_CHECK_EQUAL(sink.get_future().get(), MakeErrorCode(ErrorCode::OperationTimeout));
+
+    // the failures of the previous operations are forgotten when a new one starts
+    BOOST_CHECK_EQUAL(topo.ChangeState(TopoTransition::Bind, ".*/Sink.*").first, std::error_code());
+    BOOST_CHECK(topo.GetUnignorableFailures().empty());
+}
+
 BOOST_AUTO_TEST_CASE(underlying_session_terminated)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -737,4 +1105,757 @@ BOOST_AUTO_TEST_CASE(change_state_full_lifecycle_concurrent)
 
 BOOST_AUTO_TEST_SUITE_END() // multiple_topologies
 
+BOOST_AUTO_TEST_SUITE(topology_store)
+
+BOOST_AUTO_TEST_CASE(deduplication)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "odc-tests-topology-store";
+    TopologyStore store;
+    store.setDir(dir.string());
+
+    const std::string path1 = store.add("p1", "<topology name=\"a\"/>");
+    const std::string path2 = store.add("p2", "<topology name=\"a\"/>");
+    const std::string path3 = store.add("p1", "<topology name=\"b\"/>");
+    BOOST_REQUIRE_EQUAL(path1, path2);
+    BOOST_REQUIRE_NE(path1, path3);
+    BOOST_REQUIRE(std::filesystem::exists(path1));
+    BOOST_REQUIRE(std::filesystem::exists(path3));
+
+    // content referenced only by p1 is removed, content shared with p2 is kept
+    store.release("p1");
+    BOOST_REQUIRE(std::filesystem::exists(path1));
+    BOOST_REQUIRE(!std::filesystem::exists(path3));
+
+    store.release("p2");
+    BOOST_REQUIRE(!std::filesystem::exists(path1));
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(content_check_and_stale_files)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "odc-tests-topology-store-stale";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // left behind by a previous run
+    std::ofstream(dir / "topology_0123456789abcdef.xml") << "<topology name=\"stale\"/>";
+    std::ofstream(dir / "topology_0123456789abcdef.xml.tmp") << "<topology";
+    std::ofstream(dir / "notes.txt") << "kept";
+
+    TopologyStore store;
+    store.setDir(dir.string());
+    BOOST_TEST(!std::filesystem::exists(dir / "topology_0123456789abcdef.xml"));
+    BOOST_TEST(!std::filesystem::exists(dir / "topology_0123456789abcdef.xml.tmp"));
+    BOOST_TEST(std::filesystem::exists(dir / "notes.txt"));
+
+    // a hash hit is reused only if the stored content is identical
+    const std::string content = "<topology name=\"a\"/>";
+    const std::string path1 = store.add("p1", content);
+    std::ofstream(path1, std::ios::trunc) << "<topology name=\"b\"/>";
+    const std::string path2 = store.add("p2", content);
+    BOOST_TEST(path1 != path2);
+    std::ifstream file(path2);
+    BOOST_TEST(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) == content);
+    BOOST_TEST(store.add("p3", content) == path2);
+
+    store.release("p1");
+    store.release("p2");
+    store.release("p3");
+    BOOST_TEST(!std::filesystem::exists(path1));
+    BOOST_TEST(!std::filesystem::exists(path2));
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(replace)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "odc-tests-topology-store-replace";
+    TopologyStore store;
+    store.setDir(dir.string());
+
+    // p1 activates a, updates to b, p2 shares a
+    const std::string pathA = store.add("p1", "<topology name=\"a\"/>");
+    store.add("p2", "<topology name=\"a\"/>");
+    const std::string pathB = store.add("p1", "<topology name=\"b\"/>");
+    store.release("p1", pathA);
+    BOOST_TEST(store.refs("p1", pathA) == 0);
+    BOOST_TEST(std::filesystem::exists(pathA));
+
+    // p2 updates to b, a is not referenced anymore
+    store.add("p2", "<topology name=\"b\"/>");
+    store.release("p2", pathA);
+    BOOST_TEST(!std::filesystem::exists(pathA));
+
+    // p1 updates to identical content, the file is kept
+    BOOST_TEST(store.add("p1", "<topology name=\"b\"/>") == pathB);
+    BOOST_TEST(store.refs("p1", pathB) == 2);
+    store.release("p1", pathB);
+    BOOST_TEST(store.refs("p1", pathB) == 1);
+    BOOST_TEST(std::filesystem::exists(pathB));
+
+    // files outside of the store and unreferenced files are ignored
+    store.release("p1", (dir / "user-topology.xml").string());
+    store.release("p3", pathB);
+    BOOST_TEST(store.refs("p1", pathB) == 1);
+    BOOST_TEST(store.refs("p2", pathB) == 1);
+
+    store.release("p1");
+    store.release("p2");
+    BOOST_TEST(!std::filesystem::exists(pathB));
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // topology_store
+
+BOOST_AUTO_TEST_SUITE(topo_script_cache)
+
+BOOST_AUTO_TEST_CASE(key_and_limits)
+{
+    TopoScriptCache cache;
+    BOOST_REQUIRE(!cache.get("gen.sh").has_value()); // disabled by default
+    cache.setTTL(std::chrono::seconds(60));
+    cache.setMaxBytes(8);
+    cache.setEnvVars({ "ODC_TESTS_TOPO_SCRIPT_CACHE" });
+
+    setenv("ODC_TESTS_TOPO_SCRIPT_CACHE", "1", 1);
+    cache.put("gen.sh", "abcd");
+    BOOST_REQUIRE_EQUAL(cache.get("gen.sh").value_or(""), "abcd");
+    BOOST_REQUIRE(!cache.get("gen.sh --other").has_value());
+
+    // a different value of a key variable is a different result
+    setenv("ODC_TESTS_TOPO_SCRIPT_CACHE", "2", 1);
+    BOOST_REQUIRE(!cache.get("gen.sh").has_value());
+    cache.put("gen.sh", "efgh");
+    cache.put("gen.sh --other", "ijkl"); // exceeds the size limit, least recently used result is dropped
+    BOOST_REQUIRE_EQUAL(cache.get("gen.sh").value_or(""), "efgh");
+    setenv("ODC_TESTS_TOPO_SCRIPT_CACHE", "1", 1);
+    BOOST_REQUIRE(!cache.get("gen.sh").has_value());
+    unsetenv("ODC_TESTS_TOPO_SCRIPT_CACHE");
+
+    const auto stats = cache.getStats();
+    BOOST_REQUIRE_EQUAL(stats.mHits, 2U);
+    BOOST_REQUIRE_EQUAL(stats.mMisses, 3U);
+    BOOST_REQUIRE_EQUAL(stats.mEvictions, 1U);
+    BOOST_REQUIRE_EQUAL(stats.mEntries, 2U);
+    BOOST_REQUIRE_EQUAL(stats.mBytes, 8U);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // topo_script_cache
+
+BOOST_AUTO_TEST_SUITE(agent_inventory)
+
+BOOST_AUTO_TEST_CASE(changes)
+{
+    using namespace dds::tools_api;
+    auto agent = [](uint64_t id, uint32_t slots) {
+        SAgentInfoResponseData info;
+        info.m_agentID = id;
+        info.m_nSlots = slots;
+        return info;
+    };
+    auto count = [](uint32_t activeSlots, uint32_t executingSlots = 0) {
+        SAgentCountResponseData slots;
+        slots.m_activeSlotsCount = activeSlots;
+        slots.m_idleSlotsCount = activeSlots - executingSlots;
+        slots.m_executingSlotsCount = executingSlots;
+        return slots;
+    };
+
+    AgentInventory inventory;
+    BOOST_CHECK(!inventory.valid());
+
+    std::vector<uint64_t> added;
+    std::vector<uint64_t> removed;
+    inventory.setChangeCallback([&](const std::vector<uint64_t>& a, const std::vector<uint64_t>& r) {
+        added = a;
+        removed = r;
+    });
+
+    inventory.update({ agent(1, 4), agent(2, 8) }, count(12));
+    BOOST_CHECK(inventory.valid());
+    BOOST_CHECK_EQUAL(added.size(), 2);
+    BOOST_CHECK(removed.empty());
+    BOOST_CHECK_EQUAL(inventory.slots(2), 8);
+    BOOST_CHECK_EQUAL(inventory.slots(3), 0);
+
+    inventory.update({ agent(2, 8), agent(3, 2) }, count(10));
+    BOOST_CHECK(added == std::vector<uint64_t>{ 3 });
+    BOOST_CHECK(removed == std::vector<uint64_t>{ 1 });
+    BOOST_CHECK_EQUAL(inventory.slots().m_activeSlotsCount, 10);
+
+    // agents known to be gone are dropped, the next refresh lists the agents
+    inventory.remove({ 2, 42 }, 2);
+    BOOST_CHECK(removed == std::vector<uint64_t>{ 2 });
+    BOOST_CHECK_EQUAL(inventory.agents().size(), 1);
+    BOOST_CHECK_EQUAL(inventory.slots().m_activeSlotsCount, 2);
+    BOOST_CHECK(!inventory.valid());
+
+    inventory.update({ agent(3, 2) }, count(2));
+    BOOST_CHECK(inventory.valid());
+    inventory.invalidate();
+    BOOST_CHECK(!inventory.valid());
+}
+
+BOOST_AUTO_TEST_CASE(confirm)
+{
+    using namespace dds::tools_api;
+    auto agent = [](uint64_t id, uint32_t slots) {
+        SAgentInfoResponseData info;
+        info.m_agentID = id;
+        info.m_nSlots = slots;
+        return info;
+    };
+    auto count = [](uint32_t activeSlots, uint32_t executingSlots) {
+        SAgentCountResponseData slots;
+        slots.m_activeSlotsCount = activeSlots;
+        slots.m_idleSlotsCount = activeSlots - executingSlots;
+        slots.m_executingSlotsCount = executingSlots;
+        return slots;
+    };
+
+    AgentInventory inventory;
+    inventory.update({ agent(1, 4), agent(2, 4) }, count(8, 4));
+    BOOST_CHECK(inventory.confirm(count(8, 4)));
+
+    // the busy agent 1 was replaced by an idle agent with the same number of slots
+    BOOST_CHECK(!inventory.confirm(count(8, 0)));
+    BOOST_CHECK_EQUAL(inventory.slots().m_executingSlotsCount, 4);
+    inventory.update({ agent(2, 4), agent(3, 4) }, count(8, 0));
+    BOOST_CHECK_EQUAL(inventory.agents().count(1), 0);
+    BOOST_CHECK(inventory.confirm(count(8, 0)));
+
+    // the tasks on agent 3 started
+    BOOST_CHECK(!inventory.confirm(count(8, 4)));
+    // an agent is gone
+    BOOST_CHECK(!inventory.confirm(count(4, 0)));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // agent_inventory
+
+BOOST_AUTO_TEST_SUITE(batch_queue)
+
+BOOST_AUTO_TEST_CASE(ordering)
+{
+    BatchQueue<int> queue;
+    BOOST_TEST(queue.take().empty());
+    for (int i = 1; i <= 5; ++i) {
+        queue.push(i);
+    }
+    BOOST_TEST(queue.take() == std::vector<int>({ 1, 2, 3, 4, 5 }), boost::test_tools::per_element());
+    BOOST_TEST(queue.take().empty());
+
+    // concurrent producers, the items of each producer are taken in the order they were pushed
+    constexpr int numProducers = 4;
+    constexpr int numItems = 10000;
+    BatchQueue<std::pair<int, int>> pairs;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < numProducers; ++p) {
+        producers.emplace_back([&pairs, p]() {
+            for (int i = 0; i < numItems; ++i) {
+                pairs.push({ p, i });
+            }
+        });
+    }
+    std::array<int, numProducers> next{};
+    size_t numBatches = 0;
+    int numTaken = 0;
+    while (numTaken < numProducers * numItems) {
+        const auto batch = pairs.take();
+        numBatches += batch.empty() ? 0 : 1;
+        for (const auto& [p, i] : batch) {
+            BOOST_REQUIRE_EQUAL(i, next.at(p));
+            ++next.at(p);
+        }
+        numTaken += batch.size();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    BOOST_TEST(pairs.take().empty());
+    BOOST_TEST_MESSAGE("Took " << numTaken << " items in " << numBatches << " batches");
+}
+
+BOOST_AUTO_TEST_CASE(activation_responses)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    dds::topology_api::CTopology topo(framework::master_test_suite().argv[2]);
+
+    Session session;
+    session.layoutTasks(topo);
+
+    // responses of all tasks, followed by a repeated response of the first task from another host and one of an unknown task
+    std::vector<dds::tools_api::STopologyResponseData> responses;
+    auto itPair = topo.getRuntimeTaskIterator(nullptr);
+    for (auto it = itPair.first; it != itPair.second; ++it) {
+        dds::tools_api::STopologyResponseData res;
+        res.m_agentID = 1;
+        res.m_slotID = responses.size() + 1;
+        res.m_taskID = it->first;
+        res.m_collectionID = it->second.m_taskCollectionId;
+        res.m_path = it->second.m_taskPath;
+        res.m_host = "host1";
+        res.m_wrkDir = "/tmp/wrk";
+        res.m_activated = true;
+        responses.push_back(res);
+    }
+    BOOST_REQUIRE(!responses.empty());
+    auto repeated = responses.front();
+    repeated.m_host = "host2";
+    responses.push_back(repeated);
+    auto unknown = responses.front();
+    unknown.m_taskID = 42;
+    responses.push_back(unknown);
+
+    BatchQueue<dds::tools_api::STopologyResponseData> queue;
+    for (size_t i = 0; i < responses.size(); ++i) {
+        queue.push(responses[i]);
+        // apply in batches of varying size
+        if (i % 3 == 1) {
+            session.applyActivationResponses(topo, queue.take());
+        }
+    }
+    session.applyActivationResponses(topo, queue.take());
+
+    const size_t numTasks = responses.size() - 2;
+    BOOST_TEST(session.numTaskDetails() == numTasks);
+    BOOST_TEST(session.findTaskDetails(42) == nullptr);
+    for (size_t i = 0; i < numTasks; ++i) {
+        const auto& td = session.getTaskDetails(responses[i].m_taskID);
+        BOOST_TEST(td.mSlotID == responses[i].m_slotID);
+        BOOST_TEST(td.mPath.str() == responses[i].m_path);
+        // the later response of the first task is applied last
+        BOOST_TEST(td.mHost.str() == (i == 0 ? "host2" : "host1"));
+    }
+
+    std::unordered_set<uint64_t> collections;
+    for (size_t i = 0; i < numTasks; ++i) {
+        if (responses[i].m_collectionID > 0) {
+            collections.insert(responses[i].m_collectionID);
+        }
+    }
+    BOOST_TEST(session.numCollectionDetails() == collections.size());
+    for (const auto id : collections) {
+        const auto& cd = session.getCollectionDetails(id);
+        BOOST_TEST(cd.mCollectionID == id);
+        BOOST_TEST(cd.mPath.str() == topo.getRuntimeCollectionById(id).m_collectionPath);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END() // batch_queue
+
+BOOST_AUTO_TEST_SUITE(session)
+
+BOOST_AUTO_TEST_CASE(detailed_state)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    dds::topology_api::CTopology topo(framework::master_test_suite().argv[2]);
+
+    Session session;
+    session.layoutTasks(topo);
+
+    std::vector<dds::tools_api::STopologyResponseData> responses;
+    TopoState topoState;
+    auto itPair = topo.getRuntimeTaskIterator(nullptr);
+    for (auto it = itPair.first; it != itPair.second; ++it) {
+        dds::tools_api::STopologyResponseData res;
+        res.m_agentID = 1;
+        res.m_taskID = it->first;
+        res.m_collectionID = it->second.m_taskCollectionId;
+        res.m_path = it->second.m_taskPath;
+        res.m_host = "host1";
+        res.m_activated = true;
+        responses.push_back(res);
+        topoState.push_back(DeviceStatus(false, it->first, it->second.m_taskCollectionId));
+        topoState.back().state = DeviceState::Idle;
+    }
+    BOOST_REQUIRE(topoState.size() >= 3);
+    session.applyActivationResponses(topo, responses);
+
+    const DetailedState empty;
+    BOOST_TEST(empty.empty());
+    BOOST_TEST(empty.version() == 0);
+
+    DetailedState d1;
+    session.fillDetailedState(topoState, d1);
+    BOOST_TEST(d1.size() == topoState.size());
+    BOOST_TEST(d1.version() > 0);
+    for (size_t i = 0; i < d1.size(); ++i) {
+        BOOST_TEST(d1[i].mStatus == topoState[i]);
+        BOOST_TEST(d1[i].mPath.str() == responses[i].m_path);
+        BOOST_TEST(d1[i].mHost.str() == "host1");
+    }
+
+    // nothing changed: the same entries with the same version
+    DetailedState d2;
+    session.fillDetailedState(topoState, d2);
+    BOOST_TEST(d2.version() == d1.version());
+    BOOST_TEST(&d2[0] == &d1[0]);
+
+    // a state changed while the entries are handed out: they are copied, the handed out ones are not modified
+    topoState[1].state = DeviceState::Ready;
+    DetailedState d3;
+    session.fillDetailedState(topoState, d3);
+    BOOST_TEST(d3.version() > d1.version());
+    BOOST_TEST(&d3[0] != &d1[0]);
+    BOOST_TEST(d3[1].mStatus.state == DeviceState::Ready);
+    BOOST_TEST(d1[1].mStatus.state == DeviceState::Idle);
+    BOOST_TEST(d2[1].mStatus.state == DeviceState::Idle);
+    BOOST_TEST(d3[1].mPath == d1[1].mPath);
+
+    // a state changed while the entries are not handed out anymore: they are modified in place
+    const DetailedTaskStatus* entries = &d3[0];
+    const uint64_t version = d3.version();
+    d1 = DetailedState();
+    d2 = DetailedState();
+    d3 = DetailedState();
+    topoState[2].state = DeviceState::Ready;
+    DetailedState d4;
+    session.fillDetailedState(topoState, d4);
+    BOOST_TEST(d4.version() > version);
+    BOOST_TEST(&d4[0] == entries);
+    BOOST_TEST(d4[2].mStatus.state == DeviceState::Ready);
+
+    // the task details changed: the entries are rebuilt, although the states did not change
+    auto moved = responses.front();
+    moved.m_host = "host2";
+    session.applyActivationResponses(topo, { moved });
+    DetailedState d5;
+    session.fillDetailedState(topoState, d5);
+    BOOST_TEST(d5.version() > d4.version());
+    BOOST_TEST(d5[0].mHost.str() == "host2");
+    BOOST_TEST(d5[1].mHost.str() == "host1");
+    BOOST_TEST(d4[0].mHost.str() == "host1");
+
+    // tasks without details
+    session.clearDetails();
+    DetailedState d6;
+    session.fillDetailedState(topoState, d6);
+    BOOST_TEST(d6.version() > d5.version());
+    BOOST_TEST(d6[0].mPath.str() == "unknown");
+    BOOST_TEST(d6[0].mHost.str() == "unknown");
+    BOOST_TEST(d6[0].mStatus == topoState[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // session
+
+BOOST_AUTO_TEST_SUITE(session_pool)
+
+BOOST_AUTO_TEST_CASE(claim_and_adopt)
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    auto waitForIdle = [&](const SessionPool& pool, size_t numIdle) {
+        std::unique_lock<std::mutex> lk(mtx);
+        return cv.wait_for(lk, std::chrono::seconds(30), [&] { return pool.getSessionIDs().size() == numIdle; });
+    };
+
+    SessionPool empty;
+    BOOST_TEST(empty.claim() == nullptr);
+
+    SessionPool pool;
+    pool.setChangeCallback([&]() {
+        std::lock_guard<std::mutex> lk(mtx);
+        cv.notify_all();
+    });
+    pool.setSize(1);
+    BOOST_REQUIRE(waitForIdle(pool, 1));
+    const std::string pooledID = pool.getSessionIDs().front();
+
+    // the claimed session is the running pooled one, the pool is refilled in the background
+    auto claimed = pool.claim();
+    BOOST_REQUIRE(claimed != nullptr);
+    BOOST_TEST(boost::uuids::to_string(claimed->mDDSSession.getSessionID()) == pooledID);
+    BOOST_TEST(claimed->mDDSSession.IsRunning());
+    BOOST_REQUIRE(waitForIdle(pool, 1));
+    const std::string refilledID = pool.getSessionIDs().front();
+    BOOST_TEST(refilledID != pooledID);
+    claimed->mDDSSession.shutdown();
+
+    // stopped without shutting the idle sessions down, a restarted server adopts them
+    pool.stop(false);
+    BOOST_TEST(pool.getSessionIDs().empty());
+    SessionPool restarted;
+    BOOST_TEST(restarted.adopt(refilledID));
+    BOOST_TEST(restarted.getSessionIDs() == std::vector<std::string>{ refilledID });
+
+    // a session that stopped running in the meantime is dropped instead of claimed, and cannot be adopted
+    {
+        dds::tools_api::CSession other;
+        other.attach(refilledID);
+        other.shutdown();
+    }
+    BOOST_TEST(restarted.claim() == nullptr);
+    BOOST_TEST(restarted.getSessionIDs().empty());
+    BOOST_TEST(!restarted.adopt(refilledID));
+    restarted.stop(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // session_pool
+
+BOOST_AUTO_TEST_SUITE(string_table)
+
+BOOST_AUTO_TEST_CASE(intern)
+{
+    using namespace odc::core;
+
+    StringTable table;
+    InternedString a = table.intern("epn001");
+    InternedString b = table.intern(std::string("epn001"));
+    BOOST_CHECK_EQUAL(&a.str(), &b.str());
+    BOOST_CHECK_EQUAL(table.size(), 1);
+
+    InternedPath task1 = table.internPath("main/RecoGroup/RecoCollection_1/Task_0");
+    InternedPath task2 = table.internPath("main/RecoGroup/RecoCollection_2/Task_0");
+    BOOST_CHECK_EQUAL(task1.str(), "main/RecoGroup/RecoCollection_1/Task_0");
+    BOOST_CHECK_EQUAL(&task1.mName.str(), &task2.mName.str());
+    BOOST_CHECK(task1 != task2);
+    BOOST_CHECK_EQUAL(table.internPath("/tmp/wn/").str(), "/tmp/wn/");
+    BOOST_CHECK_EQUAL(table.internPath("task").str(), "task");
+    BOOST_CHECK_EQUAL(InternedString().str(), "");
+
+    // handles outlive the table content
+    table.clear();
+    BOOST_CHECK_EQUAL(table.size(), 0);
+    BOOST_CHECK_EQUAL(a.str(), "epn001");
+    BOOST_CHECK_EQUAL(toString(task2), "main/RecoGroup/RecoCollection_2/Task_0");
+}
+
+BOOST_AUTO_TEST_SUITE_END() // string_table
+
+BOOST_AUTO_TEST_SUITE(transition_stats)
+
+BOOST_AUTO_TEST_CASE(percentiles_and_slowest)
+{
+    TransitionTimings timings;
+    for (DDSTask::Id taskId = 1; taskId <= 200; ++taskId) {
+        timings.emplace_back(taskId, Duration(taskId * 10));
+    }
+    TransitionStats stats = ComputeTransitionStats(timings, 3);
+    BOOST_CHECK_EQUAL(stats.numDevices, 200);
+    BOOST_CHECK_EQUAL(stats.p50.count(), 1000);
+    BOOST_CHECK_EQUAL(stats.p99.count(), 1980);
+    BOOST_CHECK_EQUAL(stats.max.count(), 2000);
+    BOOST_CHECK(stats.slowest == TransitionTimings({ { 200, Duration(2000) }, { 199, Duration(1990) }, { 198, Duration(1980) } }));
+}
+
+BOOST_AUTO_TEST_CASE(single_device)
+{
+    TransitionStats stats = ComputeTransitionStats({ { 7, Duration(1500) } }, 5);
+    BOOST_CHECK_EQUAL(stats.numDevices, 1);
+    BOOST_CHECK_EQUAL(stats.p50.count(), 1500);
+    BOOST_CHECK_EQUAL(stats.p99.count(), 1500);
+    BOOST_CHECK_EQUAL(stats.max.count(), 1500);
+    BOOST_CHECK(stats.slowest == TransitionTimings({ { 7, Duration(1500) } }));
+}
+
+BOOST_AUTO_TEST_CASE(no_timings)
+{
+    TransitionStats stats = ComputeTransitionStats({}, 5);
+    BOOST_CHECK_EQUAL(stats.numDevices, 0);
+    BOOST_CHECK_EQUAL(stats.max.count(), 0);
+    BOOST_CHECK(stats.slowest.empty());
+
+    // devices that did not report a duration
+    TopoState topoState{ DeviceStatus(false, 1, 0), DeviceStatus(false, 2, 0) };
+    std::vector<TransitionDurations> durations(topoState.size(), TransitionDurations{});
+    BOOST_CHECK(CollectTransitionTimings(topoState, durations, TopoTransition::InitDevice).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ignored_devices)
+{
+    TopoState topoState{ DeviceStatus(false, 1, 0), DeviceStatus(true, 2, 0), DeviceStatus(false, 3, 0) };
+    topoState.at(1).ignored = true;
+    std::vector<TransitionDurations> durations(topoState.size(), TransitionDurations{});
+    for (size_t i = 0; i < durations.size(); ++i) {
+        durations.at(i).at(static_cast<size_t>(TopoTransition::InitDevice)) = 1000 * (i + 1);
+    }
+
+    TransitionTimings timings = CollectTransitionTimings(topoState, durations, TopoTransition::InitDevice);
+    BOOST_CHECK(timings == TransitionTimings({ { 1, Duration(1000) }, { 3, Duration(3000) } }));
+    TransitionStats stats = ComputeTransitionStats(timings, 5);
+    BOOST_CHECK_EQUAL(stats.numDevices, 2);
+    BOOST_CHECK_EQUAL(stats.max.count(), 3000);
+    BOOST_CHECK(stats.slowest == TransitionTimings({ { 3, Duration(3000) }, { 1, Duration(1000) } }));
+
+    // all devices ignored
+    for (auto& ds : topoState) {
+        ds.ignored = true;
+    }
+    BOOST_CHECK_EQUAL(ComputeTransitionStats(CollectTransitionTimings(topoState, durations, TopoTransition::InitDevice), 5).numDevices, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // transition_stats
+
+BOOST_AUTO_TEST_SUITE(transition_history)
+
+BOOST_AUTO_TEST_CASE(quantile_and_persistence)
+{
+    using namespace std::chrono_literals;
+
+    const auto file = std::filesystem::temp_directory_path() / "odc-tests-transition-history.json";
+    std::filesystem::remove(file);
+    const std::string key = TransitionHistory::key("p1", 42, "ChangeState(INIT DEVICE)");
+
+    TransitionHistory history;
+    history.setFile(file.string());
+    for (int i = 1; i < static_cast<int>(TransitionHistory::kMinSamples); ++i) {
+        history.record(key, i * 10ms);
+    }
+    BOOST_REQUIRE(!history.quantile(key, 0.99).has_value()); // not enough samples
+    history.record(key, 500ms);
+    BOOST_REQUIRE_EQUAL(history.quantile(key, 0.99).value().count(), 500);
+    BOOST_REQUIRE_EQUAL(history.quantile(key, 0.5).value().count(), 30);
+
+    // only the most recent samples are kept
+    for (size_t i = 0; i < TransitionHistory::kMaxSamples; ++i) {
+        history.record(key, 20ms);
+    }
+    BOOST_REQUIRE_EQUAL(history.numSamples(key), TransitionHistory::kMaxSamples);
+    BOOST_REQUIRE_EQUAL(history.quantile(key, 0.99).value().count(), 20);
+
+    // survives a restart
+    history.flush();
+    TransitionHistory restored;
+    restored.setFile(file.string());
+    BOOST_REQUIRE_EQUAL(restored.numSamples(key), TransitionHistory::kMaxSamples);
+    BOOST_REQUIRE_EQUAL(restored.quantile(key, 0.99).value().count(), 20);
+    BOOST_REQUIRE_EQUAL(restored.numSamples(TransitionHistory::key("p2", 42, "ChangeState(INIT DEVICE)")), 0);
+
+    std::filesystem::remove(file);
+}
+
+BOOST_AUTO_TEST_CASE(adaptive_deadline)
+{
+    using namespace std::chrono_literals;
+
+    TransitionHistory history;
+    const std::string key = TransitionHistory::key("p1", 42, "ChangeState(INIT DEVICE)");
+    for (size_t i = 0; i < TransitionHistory::kMinSamples; ++i) {
+        history.record(key, 2000ms);
+    }
+
+    // p99 * factor
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 3, 1000ms, 30000ms).value().count(), 6000);
+    // capped by the remaining request time
+    BOOST_REQUIRE(!history.adaptiveDeadline(key, 3, 1000ms, 6000ms).has_value());
+    BOOST_REQUIRE(!history.adaptiveDeadline(key, 3, 1000ms, 5000ms).has_value());
+    // not shorter than the minimum deadline
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 0.1, 1000ms, 30000ms).value().count(), 1000);
+    // disabled, or no history
+    BOOST_REQUIRE(!history.adaptiveDeadline(key, 0, 1000ms, 30000ms).has_value());
+    BOOST_REQUIRE(!history.adaptiveDeadline(TransitionHistory::key("p2", 42, "ChangeState(INIT DEVICE)"), 3, 1000ms, 30000ms).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(adaptive_deadline_recovery)
+{
+    using namespace std::chrono_literals;
+
+    TransitionHistory history;
+    const std::string key = TransitionHistory::key("p1", 42, "ChangeState(INIT DEVICE)");
+    for (size_t i = 0; i < TransitionHistory::kMinSamples; ++i) {
+        history.record(key, 1000ms);
+    }
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 2, 1000ms, 30000ms).value().count(), 2000);
+
+    // the step slowed down to 5 s, its deadline grows with each timeout
+    history.recordTimeout(key, 2000ms);
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 2, 1000ms, 30000ms).value().count(), 4000);
+    history.recordTimeout(key, 4000ms);
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 2, 1000ms, 30000ms).value().count(), 8000);
+    // the step completes within the grown deadline
+    history.record(key, 5000ms);
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 2, 1000ms, 30000ms).value().count(), 10000);
+
+    // a step that keeps timing out ends up with the remaining request time
+    history.recordTimeout(key, 10000ms);
+    BOOST_REQUIRE_EQUAL(history.adaptiveDeadline(key, 2, 1000ms, 30000ms).value().count(), 20000);
+    history.recordTimeout(key, 20000ms);
+    BOOST_REQUIRE(!history.adaptiveDeadline(key, 2, 1000ms, 30000ms).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(adaptive_deadline_timeout)
+{
+    using namespace std::chrono_literals;
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    // previous completions were much faster than the step can be now, the step times out long before the request would
+    TransitionHistory history;
+    const std::string key = TransitionHistory::key("p1", 42, "ChangeState(INIT DEVICE)");
+    for (size_t i = 0; i < TransitionHistory::kMinSamples; ++i) {
+        history.record(key, 0ms);
+    }
+    const auto deadline = history.adaptiveDeadline(key, 2, 1ms, 30000ms);
+    BOOST_REQUIRE(deadline.has_value());
+
+    Topology topo(f.mDDSTopo, f.mSession);
+    const auto start = std::chrono::steady_clock::now();
+    BOOST_CHECK_EQUAL(topo.ChangeState(TopoTransition::InitDevice, "", deadline.value()).first, MakeErrorCode(ErrorCode::OperationTimeout));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < 30000ms);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // transition_history
+
+BOOST_AUTO_TEST_SUITE(straggler_tracker)
+
+BOOST_AUTO_TEST_CASE(shedding)
+{
+    using namespace std::chrono_literals;
+    boost::asio::io_context ioContext;
+    std::mutex mtx;
+    bool completed = false;
+    FailedDevices remaining{ 1, 2, 3, 4 };
+    std::vector<FailedDevices> shed;
+    StragglerTracker tracker(StragglerPolicy{ 0.5, 2 }, remaining.size(), [&](FailedDevices stragglers) { shed.push_back(stragglers); }, ioContext.get_executor());
+    auto complete = [&](DDSTask::Id taskId) {
+        remaining.erase(taskId);
+        tracker.Completed();
+        tracker.Check(remaining.size(), mtx, [&]() { return completed; }, [&]() { return remaining; });
+    };
+
+    // not armed before the fraction of the devices completed
+    complete(1);
+    ioContext.run();
+    BOOST_CHECK(shed.empty());
+
+    // the remaining devices are shed once their time budget expired
+    complete(2);
+    ioContext.restart();
+    ioContext.run();
+    BOOST_REQUIRE_EQUAL(shed.size(), 1);
+    BOOST_CHECK(shed.at(0) == FailedDevices({ 3, 4 }));
+
+    // a new phase: a budget of the previous phase does not shed its devices
+    tracker.Restart(remaining.size());
+    complete(3);
+    tracker.Restart(remaining.size());
+    ioContext.restart();
+    ioContext.run();
+    BOOST_CHECK_EQUAL(shed.size(), 1);
+
+    // the budget of the new phase
+    remaining = { 5, 6 };
+    tracker.Restart(remaining.size());
+    complete(5);
+    ioContext.restart();
+    ioContext.run();
+    BOOST_REQUIRE_EQUAL(shed.size(), 2);
+    BOOST_CHECK(shed.at(1) == FailedDevices({ 6 }));
+
+    // nothing is shed after the operation completed
+    remaining = { 7, 8 };
+    tracker.Restart(remaining.size());
+    complete(7);
+    completed = true;
+    ioContext.restart();
+    ioContext.run();
+    BOOST_CHECK_EQUAL(shed.size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // straggler_tracker
+
 int main(int argc, char* argv[]) { return boost::unit_test::unit_test_main(init_unit_test, argc, argv); }
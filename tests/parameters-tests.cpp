@@ -19,6 +19,7 @@
 #include <odc/TopologyDefs.h>
 
 #include <chrono>
+#include <future>
 #include <iostream>
 #include <map>
 #include <string>
@@ -182,6 +183,49 @@ BOOST_AUTO_TEST_CASE(odc_rp_epn_slurm_zones)
     compareParameterSets(ddsParams.at(1), ddsParams2.at(1));
 }
 
+BOOST_AUTO_TEST_CASE(odc_rp_epn_slurm_persistent)
+{
+    string plugin = "epn";
+    string resources = "[{ \"zone\":\"online\", \"n\":4 }, { \"zone\":\"calib\", \"n\":1 }]";
+    string partitionId = "test_partition_" + uuid();
+    CommonParams common(partitionId, 0, 10);
+
+    Session session;
+    session.mPartitionID = partitionId;
+    session.mTopoFilePath = kODCDataDir + "/ex-topo-groupname-crashing.xml";
+    Controller::extractRequirements(common, session);
+
+    DDSSubmit oneShot;
+    oneShot.registerPlugin("epn", kODCBinDir + "/odc-rp-epn-slurm --zones online:2:/home/user/slurm-online.cfg: calib:2:/home/user/slurm-calib.cfg:");
+    vector<DDSSubmitParams> ddsParams = oneShot.makeParams(plugin, resources, common, session.mZoneInfo, session.mNinfo, seconds(10));
+
+    DDSSubmit persistent;
+    persistent.setPersistent(true);
+    persistent.registerPlugin("epn", kODCBinDir + "/odc-rp-epn-slurm --zones online:2:/home/user/slurm-online.cfg: calib:2:/home/user/slurm-calib.cfg:");
+    // the same plugin process serves repeated requests
+    for (int i = 0; i < 3; ++i) {
+        vector<DDSSubmitParams> ddsParams2 = persistent.makeParams(plugin, resources, common, session.mZoneInfo, session.mNinfo, seconds(10));
+        BOOST_TEST(ddsParams2.size() == 2);
+        compareParameterSets(ddsParams.at(0), ddsParams2.at(0));
+        compareParameterSets(ddsParams.at(1), ddsParams2.at(1));
+    }
+
+    // concurrent requests, e.g. of different partitions, are served by several processes or executed once, none of them waits for another
+    vector<std::future<vector<DDSSubmitParams>>> results;
+    for (int i = 0; i < 6; ++i) {
+        results.push_back(std::async(std::launch::async, [&]() { return persistent.makeParams(plugin, resources, common, session.mZoneInfo, session.mNinfo, seconds(10)); }));
+    }
+    for (auto& result : results) {
+        vector<DDSSubmitParams> ddsParams2 = result.get();
+        BOOST_TEST(ddsParams2.size() == 2);
+        compareParameterSets(ddsParams.at(0), ddsParams2.at(0));
+        compareParameterSets(ddsParams.at(1), ddsParams2.at(1));
+    }
+
+    // errors of the plugin are reported without falling back to one-shot execution
+    BOOST_CHECK_THROW(persistent.makeParams(plugin, "{ \"zone\":\"unknown\", \"n\":1 }", common, session.mZoneInfo, session.mNinfo, seconds(10)), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(odc_rp_epn_slurm_zones_group_without_n_with_tasks)
 {
     string rms = "slurm";
@@ -11,6 +11,7 @@
 #define BOOST_TEST_ALTERNATIVE_INIT_API
 #include <boost/test/included/unit_test.hpp>
 
+#include <odc/AgentInventory.h>
 #include <odc/BuildConstants.h>
 #include <odc/Controller.h>
 #include <odc/MiscUtils.h>
@@ -302,4 +303,64 @@ BOOST_AUTO_TEST_CASE(epn_2)
 
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE(reuse)
+
+BOOST_AUTO_TEST_CASE(agents_satisfy_requirements)
+{
+    using namespace dds::tools_api;
+    auto agent = [](uint64_t id, const string& groupName, uint32_t slots) {
+        SAgentInfoResponseData info;
+        info.m_agentID = id;
+        info.m_groupName = groupName;
+        info.m_nSlots = slots;
+        return info;
+    };
+    auto count = [](uint32_t activeSlots) {
+        SAgentCountResponseData slots;
+        slots.m_activeSlotsCount = activeSlots;
+        return slots;
+    };
+
+    string partitionId = "test_partition_" + uuid();
+    CommonParams common(partitionId, 0, 10);
+    Session session;
+    session.mPartitionID = partitionId;
+    // 2 tasks on 1 agent of the calib group, 8 tasks on 4 agents of the online group, 2 slots each
+    session.mTopoFilePath = kODCDataDir + "/ex-topo-groupname.xml";
+    Controller::extractRequirements(common, session);
+
+    const std::vector<SAgentInfoResponseData> agents{
+        agent(1, "calib", 2), agent(2, "online", 2), agent(3, "online", 2), agent(4, "online", 2), agent(5, "online", 2)
+    };
+
+    AgentInventory inventory;
+    inventory.update(agents, count(10));
+    BOOST_TEST(Controller::agentsSatisfyRequirements(common, session, inventory));
+
+    // more agents and slots than required
+    auto more = agents;
+    more.push_back(agent(6, "online", 4));
+    inventory.update(more, count(14));
+    BOOST_TEST(Controller::agentsSatisfyRequirements(common, session, inventory));
+
+    // not enough active slots for the tasks
+    inventory.update(agents, count(9));
+    BOOST_TEST(!Controller::agentsSatisfyRequirements(common, session, inventory));
+
+    // an agent of the online group is missing, the slots are taken by an agent of another group
+    auto missing = agents;
+    missing.back() = agent(5, "calib", 2);
+    inventory.update(missing, count(10));
+    BOOST_TEST(!Controller::agentsSatisfyRequirements(common, session, inventory));
+
+    // an agent of the calib group has too few slots for its collection
+    auto small = agents;
+    small.front() = agent(1, "calib", 1);
+    small.push_back(agent(6, "online", 1));
+    inventory.update(small, count(10));
+    BOOST_TEST(!Controller::agentsSatisfyRequirements(common, session, inventory));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 int main(int argc, char* argv[]) { return boost::unit_test::unit_test_main(init_unit_test, argc, argv); }